@@ -0,0 +1,116 @@
+/***************************************************
+ * @file		MainFunction.cpp
+ * @section		BatchExport
+ * @class		N/A
+ * @brief		export a cohort of dicom images to 16-bit png, tiff or raw
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "CommonMethod.h"
+#include "DicomExport.h"
+#include "IntlMsgAliasID.h"
+#include "Logger.h"
+
+using namespace std;
+
+/*
+ * @brief	print usage
+*/
+static void PrintUsage()
+{
+	printf("usage: BatchExport <input folder | list file | dicom file> <output folder> [options]\n");
+	printf("\t-f png|tiff|raw\toutput format, png by default\n");
+	printf("\t-r N\t\treader threads\n");
+	printf("\t-c N\t\tconverter threads\n");
+	printf("\t-w N\t\twriter threads\n");
+	printf("\t-q N\t\tdepth of queues between stages\n");
+	printf("\t-s WxH\t\tresize to W by H\n");
+	printf("\t-l\t\tapply window of dicom header\n");
+}
+
+int main(int argc, char** argv)
+{
+	// load property of log4cxx
+	log4cxx::PropertyConfigurator::configure("logcfg.properties");
+
+	__LOG_FUNC_START__;
+
+	if (argc < 3)
+	{
+		PrintUsage();
+		return 0;
+	}
+
+	ExportConfig oConfig;
+	CDicomExport::GetDefaultConfig(oConfig);
+	oConfig.strOutputFolder = argv[2];
+
+	for (int nArgIdx = 3; nArgIdx < argc; nArgIdx++)
+	{
+		string strArg = argv[nArgIdx];
+		bool hasValue = nArgIdx + 1 < argc;
+
+		if ("-f" == strArg && hasValue)
+		{
+			string strFormat = argv[++nArgIdx];
+			oConfig.nFormat = "tiff" == strFormat ? ExportTiff16 : ("raw" == strFormat ? ExportRaw : ExportPng16);
+		}
+		else if ("-r" == strArg && hasValue)
+		{
+			oConfig.unNumWorkers[StageRead] = atoi(argv[++nArgIdx]);
+		}
+		else if ("-c" == strArg && hasValue)
+		{
+			oConfig.unNumWorkers[StageConvert] = atoi(argv[++nArgIdx]);
+		}
+		else if ("-w" == strArg && hasValue)
+		{
+			oConfig.unNumWorkers[StageWrite] = atoi(argv[++nArgIdx]);
+		}
+		else if ("-q" == strArg && hasValue)
+		{
+			oConfig.unQueueDepth = atoi(argv[++nArgIdx]);
+		}
+		else if ("-s" == strArg && hasValue)
+		{
+			unsigned int unWidth = 0, unHeight = 0;
+			if (2 == sscanf_s(argv[++nArgIdx], "%ux%u", &unWidth, &unHeight))
+			{
+				oConfig.usOutWidth = (unsigned short)unWidth;
+				oConfig.usOutHeight = (unsigned short)unHeight;
+			}
+		}
+		else if ("-l" == strArg)
+		{
+			oConfig.isWindowApplied = true;
+		}
+		else
+		{
+			PrintUsage();
+			return 0;
+		}
+	}
+
+	vector<string> vecFileNames;
+	CollectInputFiles(argv[1], vecFileNames);
+	printf("%u file(s) to export\n", (unsigned int)vecFileNames.size());
+
+	CDicomExport oExport;
+	ExportReport oReport;
+	int nProcResult = oExport.Run(vecFileNames, oConfig, oReport);
+
+	CDicomExport::PrintReport(oReport);
+
+	__LOG_FUNC_END__;
+
+	return STATUS_OK == nProcResult ? 0 : 1;
+}
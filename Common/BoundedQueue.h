@@ -0,0 +1,109 @@
+/***************************************************
+ * @file		BoundedQueue.h
+ * @section		Common
+ * @class		CBoundedQueue
+ * @brief		blocking queue of limited capacity between pipeline stages
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#ifndef __BOUNDED_QUEUE_H__
+#define __BOUNDED_QUEUE_H__
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+/*
+ * @class	CBoundedQueue
+ * @brief	producers block while the queue is full, consumers block while it is empty
+*/
+template<typename T>
+class CBoundedQueue
+{
+public:
+	/*
+	 * @brief	constructor
+	 * @param	unCapacity: maximum items queued
+	*/
+	explicit CBoundedQueue(size_t unCapacity)
+	{
+		m_unCapacity = unCapacity > 0 ? unCapacity : 1;
+		m_isClosed = false;
+	}
+
+	/*
+	 * @brief	close the queue, blocked producers and consumers return, queued items can still be popped
+	*/
+	void Close()
+	{
+		std::unique_lock<std::mutex> oLock(m_oLock);
+		m_isClosed = true;
+		m_oNotFull.notify_all();
+		m_oNotEmpty.notify_all();
+	}
+
+	/*
+	 * @brief	take the front item, block while empty
+	 * @param	tItem: item popped
+	 * @return	false if the queue is closed and drained
+	*/
+	bool Pop(T& tItem)
+	{
+		std::unique_lock<std::mutex> oLock(m_oLock);
+		while (m_deqItems.empty() && !m_isClosed)
+		{
+			m_oNotEmpty.wait(oLock);
+		}
+
+		if (m_deqItems.empty())
+		{
+			return false;
+		}
+
+		tItem = m_deqItems.front();
+		m_deqItems.pop_front();
+		m_oNotFull.notify_one();
+
+		return true;
+	}
+
+	/*
+	 * @brief	append an item, block while full
+	 * @param	tItem: item pushed
+	 * @return	false if the queue is closed
+	*/
+	bool Push(const T& tItem)
+	{
+		std::unique_lock<std::mutex> oLock(m_oLock);
+		while (m_deqItems.size() >= m_unCapacity && !m_isClosed)
+		{
+			m_oNotFull.wait(oLock);
+		}
+
+		if (m_isClosed)
+		{
+			return false;
+		}
+
+		m_deqItems.push_back(tItem);
+		m_oNotEmpty.notify_one();
+
+		return true;
+	}
+
+private:
+	bool m_isClosed;
+
+	size_t m_unCapacity;
+
+	std::mutex m_oLock;
+	std::condition_variable m_oNotEmpty;
+	std::condition_variable m_oNotFull;
+
+	std::deque<T> m_deqItems;
+};
+
+#endif	// __BOUNDED_QUEUE_H__
@@ -0,0 +1,416 @@
+/***************************************************
+ * @file		CalibrationStore.cpp
+ * @section		Common
+ * @class		CCalibrationStore
+ * @brief		offset and gain maps of several exposure times in one memory mapped file
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#include <algorithm>
+#include <fstream>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "CalibrationStore.h"
+#include "CommonMethod.h"
+#include "ErrorMsg.h"
+#include "IntlMsgAliasID.h"
+
+using namespace std;
+
+#define CALIBRATION_STORE_VERSION	1
+#define CALIBRATION_STORE_ALIGN		4096
+
+/* header of a calibration store, entries follow at ullEntryOffset in native byte order */
+struct CalibrationStoreHeader
+{
+	char czMagic[8];
+	unsigned int unVersion;
+	unsigned int unHeight;
+	unsigned int unWidth;
+	unsigned int unNumEntries;
+	unsigned long long ullEntryOffset;
+};
+
+/* maps of one exposure time, offsets from the start of file and multiples of CALIBRATION_STORE_ALIGN */
+struct CalibrationStoreEntry
+{
+	float fExposureTime;
+	unsigned int unGainShift;			///< fraction bits of the fixed point gain map
+	unsigned long long ullOffsetMap;	///< float
+	unsigned long long ullGainMap;		///< float
+	unsigned long long ullFixedOffsetMap;	///< unsigned short
+	unsigned long long ullFixedGainMap;		///< unsigned short
+};
+
+static const char CALIBRATION_STORE_MAGIC[8] = { 'C', 'A', 'L', 'S', 'T', 'O', 'R', 'E' };
+
+/*
+ * @brief	first multiple of CALIBRATION_STORE_ALIGN not below an offset
+ * @param	ullOffset
+ * @return	aligned offset
+*/
+static unsigned long long AlignStoreOffset(unsigned long long ullOffset)
+{
+	return (ullOffset + CALIBRATION_STORE_ALIGN - 1) / CALIBRATION_STORE_ALIGN * CALIBRATION_STORE_ALIGN;
+}
+
+/*
+ * @brief	whether a map lies on a page boundary inside the file
+ * @param	ullMapOffset
+ * @param	ullMapSize: bytes
+ * @param	unFileSize
+ * @return	true if valid
+*/
+static bool IsValidStoreMap(unsigned long long ullMapOffset, unsigned long long ullMapSize, size_t unFileSize)
+{
+	// subtraction form, offsets come from the file and a sum could wrap around
+	return 0 != ullMapOffset && 0 == ullMapOffset % CALIBRATION_STORE_ALIGN && ullMapSize <= unFileSize && ullMapOffset <= unFileSize - ullMapSize;
+}
+
+/*
+ * @brief	whether two exposure times are the same calibration
+ * @param	fExposureTime
+ * @param	fStoredTime
+ * @return	true if within CALIBRATION_EXPOSURE_TOLERANCE
+*/
+static bool IsSameExposureTime(float fExposureTime, float fStoredTime)
+{
+	return fabs(fExposureTime - fStoredTime) <= CALIBRATION_EXPOSURE_TOLERANCE * fStoredTime;
+}
+
+/*
+ * @brief	constructor
+*/
+CCalibrationStore::CCalibrationStore()
+{
+	m_pHeader = nullptr;
+	m_pEntries = nullptr;
+	m_fBlendedExposureTime = -1.0f;
+	m_unBlendedGainShift = 16;
+	m_unBlendedIdx = 0;
+}
+
+/*
+ * @brief	destructor
+*/
+CCalibrationStore::~CCalibrationStore()
+{
+	Close();
+}
+
+/*
+ * @brief	unmap the file, flat fields using its maps must not correct frames any more
+*/
+void CCalibrationStore::Close()
+{
+	m_oFile.Close();
+	m_pHeader = nullptr;
+	m_pEntries = nullptr;
+
+	m_fBlendedExposureTime = -1.0f;
+	for (unsigned int unBufferIdx = 0; unBufferIdx < CALIBRATION_NUM_BLENDED; unBufferIdx++)
+	{
+		vector<float>().swap(m_vecBlendedOffset[unBufferIdx]);
+		vector<float>().swap(m_vecBlendedGain[unBufferIdx]);
+		vector<unsigned short>().swap(m_vecBlendedFixedOffset[unBufferIdx]);
+		vector<unsigned short>().swap(m_vecBlendedFixedGain[unBufferIdx]);
+	}
+}
+
+/*
+ * @brief	exposure time of an entry
+ * @param	unEntryIdx
+ * @return	exposure time, 0 if out of range
+*/
+float CCalibrationStore::GetExposureTime(unsigned int unEntryIdx) const
+{
+	return unEntryIdx < GetNumEntries() ? m_pEntries[unEntryIdx].fExposureTime : 0;
+}
+
+/*
+ * @brief	height of maps
+ * @return	rows, 0 if not open
+*/
+unsigned short CCalibrationStore::GetHeight() const
+{
+	return nullptr == m_pHeader ? 0 : (unsigned short)m_pHeader->unHeight;
+}
+
+/*
+ * @brief	exposure times in the store
+ * @return	number of entries, 0 if not open
+*/
+unsigned int CCalibrationStore::GetNumEntries() const
+{
+	return nullptr == m_pHeader ? 0 : m_pHeader->unNumEntries;
+}
+
+/*
+ * @brief	width of maps
+ * @return	columns, 0 if not open
+*/
+unsigned short CCalibrationStore::GetWidth() const
+{
+	return nullptr == m_pHeader ? 0 : (unsigned short)m_pHeader->unWidth;
+}
+
+/*
+ * @brief	map a store written by Save and check its layout, maps are paged in on first access
+ * @param	strFileName
+ * @return	error code
+*/
+int CCalibrationStore::Open(const std::string& strFileName)
+{
+	Close();
+
+	int nProcResult = m_oFile.Open(strFileName);
+	if (STATUS_OK != nProcResult)
+	{
+		return nProcResult;
+	}
+
+	// only the header and the entry table are read here
+	const CalibrationStoreHeader* pHeader = (const CalibrationStoreHeader*)m_oFile.GetData();
+	bool isValid = m_oFile.GetSize() >= sizeof(CalibrationStoreHeader) && 0 == memcmp(pHeader->czMagic, CALIBRATION_STORE_MAGIC, sizeof(CALIBRATION_STORE_MAGIC))
+		&& CALIBRATION_STORE_VERSION == pHeader->unVersion && pHeader->unHeight > 0 && pHeader->unHeight <= 65535 && pHeader->unWidth > 0 && pHeader->unWidth <= 65535
+		&& pHeader->unNumEntries > 0 && pHeader->ullEntryOffset >= sizeof(CalibrationStoreHeader) && 0 == pHeader->ullEntryOffset % sizeof(unsigned long long)
+		&& (unsigned long long)pHeader->unNumEntries * sizeof(CalibrationStoreEntry) <= m_oFile.GetSize()
+		&& pHeader->ullEntryOffset <= m_oFile.GetSize() - (unsigned long long)pHeader->unNumEntries * sizeof(CalibrationStoreEntry);
+
+	const CalibrationStoreEntry* pEntries = isValid ? (const CalibrationStoreEntry*)(m_oFile.GetData() + pHeader->ullEntryOffset) : nullptr;
+	unsigned long long ullNumPixels = isValid ? (unsigned long long)pHeader->unHeight * pHeader->unWidth : 0;
+	for (unsigned int unEntryIdx = 0; isValid && unEntryIdx < pHeader->unNumEntries; unEntryIdx++)
+	{
+		const CalibrationStoreEntry& oEntry = pEntries[unEntryIdx];
+		isValid = oEntry.fExposureTime > 0 && (0 == unEntryIdx || oEntry.fExposureTime > pEntries[unEntryIdx - 1].fExposureTime)
+			&& oEntry.unGainShift >= 1 && oEntry.unGainShift <= 16
+			&& IsValidStoreMap(oEntry.ullOffsetMap, ullNumPixels * sizeof(float), m_oFile.GetSize())
+			&& IsValidStoreMap(oEntry.ullGainMap, ullNumPixels * sizeof(float), m_oFile.GetSize())
+			&& IsValidStoreMap(oEntry.ullFixedOffsetMap, ullNumPixels * sizeof(unsigned short), m_oFile.GetSize())
+			&& IsValidStoreMap(oEntry.ullFixedGainMap, ullNumPixels * sizeof(unsigned short), m_oFile.GetSize());
+	}
+
+	if (!isValid)
+	{
+		m_oFile.Close();
+		vector<string> vecErrorReplacer(1, strFileName);
+		printf("%s\n", CErrorMsg::GetInstance()->GetMsgString(INVALID_FILE_FORMAT, vecErrorReplacer).c_str());
+		return INVALID_FILE_FORMAT;
+	}
+
+	m_pHeader = pHeader;
+	m_pEntries = pEntries;
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	write maps of several exposure times to a store
+ * @param	strFileName
+ * @param	usHeight
+ * @param	usWidth
+ * @param	vecExposureTimes: positive and distinct, any order
+ * @param	vecOffsetMaps: height x width each, one per exposure time
+ * @param	vecGainMaps: height x width each, in [0, 32768), one per exposure time
+ * @return	error code
+*/
+int CCalibrationStore::Save(const std::string& strFileName, unsigned short usHeight, unsigned short usWidth, const std::vector<float>& vecExposureTimes,
+	const std::vector<const float*>& vecOffsetMaps, const std::vector<const float*>& vecGainMaps)
+{
+	size_t unNumEntries = vecExposureTimes.size();
+	size_t unNumPixels = (size_t)usHeight * usWidth;
+	if (0 == unNumPixels || 0 == unNumEntries || vecOffsetMaps.size() != unNumEntries || vecGainMaps.size() != unNumEntries)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	// entries ascending, so that Select can bisect
+	vector<size_t> vecOrder(unNumEntries);
+	for (size_t unIdx = 0; unIdx < unNumEntries; unIdx++)
+	{
+		vecOrder[unIdx] = unIdx;
+	}
+	sort(vecOrder.begin(), vecOrder.end(), [&](size_t unLeft, size_t unRight) { return vecExposureTimes[unLeft] < vecExposureTimes[unRight]; });
+
+	for (size_t unIdx = 0; unIdx < unNumEntries; unIdx++)
+	{
+		size_t unEntryIdx = vecOrder[unIdx];
+		if (!(vecExposureTimes[unEntryIdx] > 0) || nullptr == vecOffsetMaps[unEntryIdx] || nullptr == vecGainMaps[unEntryIdx]
+			|| (unIdx > 0 && !(vecExposureTimes[unEntryIdx] > vecExposureTimes[vecOrder[unIdx - 1]])))
+		{
+			return INVALID_PARAMETER;
+		}
+	}
+
+	CalibrationStoreHeader oHeader;
+	memset(&oHeader, 0, sizeof(oHeader));
+	memcpy(oHeader.czMagic, CALIBRATION_STORE_MAGIC, sizeof(CALIBRATION_STORE_MAGIC));
+	oHeader.unVersion = CALIBRATION_STORE_VERSION;
+	oHeader.unHeight = usHeight;
+	oHeader.unWidth = usWidth;
+	oHeader.unNumEntries = (unsigned int)unNumEntries;
+	oHeader.ullEntryOffset = sizeof(CalibrationStoreHeader);
+
+	// fixed point maps are computed here once, not at each Select
+	vector<CalibrationStoreEntry> vecEntries(unNumEntries);
+	vector<vector<unsigned short> > vecFixedMaps(2 * unNumEntries, vector<unsigned short>(unNumPixels));
+	unsigned long long ullFloatMapSize = AlignStoreOffset(unNumPixels * sizeof(float));
+	unsigned long long ullFixedMapSize = AlignStoreOffset(unNumPixels * sizeof(unsigned short));
+	unsigned long long ullMapOffset = AlignStoreOffset(oHeader.ullEntryOffset + unNumEntries * sizeof(CalibrationStoreEntry));
+	for (size_t unIdx = 0; unIdx < unNumEntries; unIdx++)
+	{
+		size_t unEntryIdx = vecOrder[unIdx];
+		CalibrationStoreEntry& oEntry = vecEntries[unIdx];
+		memset(&oEntry, 0, sizeof(oEntry));
+		oEntry.fExposureTime = vecExposureTimes[unEntryIdx];
+
+		int nProcResult = CFlatField::QuantizeMaps(vecOffsetMaps[unEntryIdx], vecGainMaps[unEntryIdx], unNumPixels, vecFixedMaps[2 * unIdx].data(), vecFixedMaps[2 * unIdx + 1].data(),
+			oEntry.unGainShift);
+		if (STATUS_OK != nProcResult)
+		{
+			return nProcResult;
+		}
+
+		oEntry.ullOffsetMap = ullMapOffset;
+		oEntry.ullGainMap = oEntry.ullOffsetMap + ullFloatMapSize;
+		oEntry.ullFixedOffsetMap = oEntry.ullGainMap + ullFloatMapSize;
+		oEntry.ullFixedGainMap = oEntry.ullFixedOffsetMap + ullFixedMapSize;
+		ullMapOffset = oEntry.ullFixedGainMap + ullFixedMapSize;
+	}
+
+	// written aside and renamed, a reader never maps a partial file
+	string strTempFile = strFileName + ".tmp";
+	vector<string> vecErrorReplacer(1, strFileName);
+
+	ofstream oStoreFile(strTempFile.c_str(), ios::out | ios::binary);
+	if (!oStoreFile.good())
+	{
+		printf("%s\n", CErrorMsg::GetInstance()->GetMsgString(OPEN_FILE_ERR, vecErrorReplacer).c_str());
+		return OPEN_FILE_ERR;
+	}
+
+	vector<char> vecPadding(CALIBRATION_STORE_ALIGN, 0);
+	unsigned long long ullWritten = 0;
+	auto funcWrite = [&](const void* pData, unsigned long long ullSize, unsigned long long ullAlignedSize)
+	{
+		oStoreFile.write((const char*)pData, ullSize);
+		oStoreFile.write(vecPadding.data(), ullAlignedSize - ullSize);
+		ullWritten += ullAlignedSize;
+	};
+
+	funcWrite(&oHeader, sizeof(oHeader), sizeof(oHeader));
+	unsigned long long ullTableSize = unNumEntries * sizeof(CalibrationStoreEntry);
+	funcWrite(vecEntries.data(), ullTableSize, AlignStoreOffset(ullWritten + ullTableSize) - ullWritten);
+	for (size_t unIdx = 0; unIdx < unNumEntries; unIdx++)
+	{
+		size_t unEntryIdx = vecOrder[unIdx];
+		funcWrite(vecOffsetMaps[unEntryIdx], unNumPixels * sizeof(float), ullFloatMapSize);
+		funcWrite(vecGainMaps[unEntryIdx], unNumPixels * sizeof(float), ullFloatMapSize);
+		funcWrite(vecFixedMaps[2 * unIdx].data(), unNumPixels * sizeof(unsigned short), ullFixedMapSize);
+		funcWrite(vecFixedMaps[2 * unIdx + 1].data(), unNumPixels * sizeof(unsigned short), ullFixedMapSize);
+	}
+	oStoreFile.close();
+
+	// the previous file stays in place unless the new one is complete
+	if (oStoreFile.fail() || !RenameFile(strTempFile, strFileName))
+	{
+		remove(strTempFile.c_str());
+		printf("%s\n", CErrorMsg::GetInstance()->GetMsgString(WRITE_FILE_ERR, vecErrorReplacer).c_str());
+		return WRITE_FILE_ERR;
+	}
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	point a flat field at the maps of an exposure time. a calibrated exposure time, or one outside the calibrated range,
+ *			uses the maps of the nearest entry in place. between two entries maps are interpolated linearly once and kept
+ *			until another exposure time between entries is selected, into the other of CALIBRATION_NUM_BLENDED buffers
+ * @param	fExposureTime: e.g. exptime of acquire
+ * @param	oFlatField: output, valid until Close or the second Select interpolating another exposure time, so that
+ *			a frame may still be corrected with the previous maps while the next ones are selected
+ * @param	isFixedPoint: false to compute 16-bit output in float
+ * @return	error code
+*/
+int CCalibrationStore::Select(float fExposureTime, CFlatField& oFlatField, bool isFixedPoint)
+{
+	if (nullptr == m_pHeader || !(fExposureTime > 0))
+	{
+		return INVALID_PARAMETER;
+	}
+
+	// first entry above the exposure time, the table is tiny and sorted
+	unsigned int unNumEntries = m_pHeader->unNumEntries;
+	const CalibrationStoreEntry* pAbove = upper_bound(m_pEntries, m_pEntries + unNumEntries, fExposureTime,
+		[](float fTime, const CalibrationStoreEntry& oEntry) { return fTime < oEntry.fExposureTime; });
+
+	const CalibrationStoreEntry* pEntry = nullptr;
+	if (m_pEntries == pAbove)
+	{
+		pEntry = m_pEntries;
+	}
+	else if (m_pEntries + unNumEntries == pAbove || IsSameExposureTime(fExposureTime, pAbove[-1].fExposureTime))
+	{
+		pEntry = pAbove - 1;
+	}
+	else if (IsSameExposureTime(fExposureTime, pAbove->fExposureTime))
+	{
+		pEntry = pAbove;
+	}
+
+	unsigned short usHeight = (unsigned short)m_pHeader->unHeight;
+	unsigned short usWidth = (unsigned short)m_pHeader->unWidth;
+	const char* pData = m_oFile.GetData();
+	if (nullptr != pEntry)
+	{
+		return oFlatField.AttachMaps((const float*)(pData + pEntry->ullOffsetMap), (const float*)(pData + pEntry->ullGainMap),
+			isFixedPoint ? (const unsigned short*)(pData + pEntry->ullFixedOffsetMap) : nullptr, isFixedPoint ? (const unsigned short*)(pData + pEntry->ullFixedGainMap) : nullptr,
+			pEntry->unGainShift, usHeight, usWidth);
+	}
+
+	if (fExposureTime != m_fBlendedExposureTime)
+	{
+		const CalibrationStoreEntry* pBelow = pAbove - 1;
+		float fWeightAbove = (fExposureTime - pBelow->fExposureTime) / (pAbove->fExposureTime - pBelow->fExposureTime);
+		const float* pOffsetBelow = (const float*)(pData + pBelow->ullOffsetMap);
+		const float* pOffsetAbove = (const float*)(pData + pAbove->ullOffsetMap);
+		const float* pGainBelow = (const float*)(pData + pBelow->ullGainMap);
+		const float* pGainAbove = (const float*)(pData + pAbove->ullGainMap);
+
+		// the buffer not attached by the last Select, a flat field may still be correcting with the current one
+		unsigned int unBufferIdx = (m_unBlendedIdx + 1) % CALIBRATION_NUM_BLENDED;
+		vector<float>& vecOffset = m_vecBlendedOffset[unBufferIdx];
+		vector<float>& vecGain = m_vecBlendedGain[unBufferIdx];
+		size_t unNumPixels = (size_t)usHeight * usWidth;
+		vecOffset.resize(unNumPixels);
+		vecGain.resize(unNumPixels);
+		m_vecBlendedFixedOffset[unBufferIdx].resize(unNumPixels);
+		m_vecBlendedFixedGain[unBufferIdx].resize(unNumPixels);
+		for (size_t unIdx = 0; unIdx < unNumPixels; unIdx++)
+		{
+			vecOffset[unIdx] = pOffsetBelow[unIdx] + fWeightAbove * (pOffsetAbove[unIdx] - pOffsetBelow[unIdx]);
+			vecGain[unIdx] = pGainBelow[unIdx] + fWeightAbove * (pGainAbove[unIdx] - pGainBelow[unIdx]);
+		}
+
+		unsigned int unGainShift = 16;
+		int nProcResult = CFlatField::QuantizeMaps(vecOffset.data(), vecGain.data(), unNumPixels, m_vecBlendedFixedOffset[unBufferIdx].data(),
+			m_vecBlendedFixedGain[unBufferIdx].data(), unGainShift);
+		if (STATUS_OK != nProcResult)
+		{
+			return nProcResult;
+		}
+		m_unBlendedIdx = unBufferIdx;
+		m_unBlendedGainShift = unGainShift;
+		m_fBlendedExposureTime = fExposureTime;
+	}
+
+	return oFlatField.AttachMaps(m_vecBlendedOffset[m_unBlendedIdx].data(), m_vecBlendedGain[m_unBlendedIdx].data(),
+		isFixedPoint ? m_vecBlendedFixedOffset[m_unBlendedIdx].data() : nullptr, isFixedPoint ? m_vecBlendedFixedGain[m_unBlendedIdx].data() : nullptr,
+		m_unBlendedGainShift, usHeight, usWidth);
+}
@@ -0,0 +1,141 @@
+/***************************************************
+ * @file		CalibrationStore.h
+ * @section		Common
+ * @class		CCalibrationStore
+ * @brief		offset and gain maps of several exposure times in one memory mapped file
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#ifndef __CALIBRATION_STORE_H__
+#define __CALIBRATION_STORE_H__
+
+#include <string>
+#include <vector>
+
+#include "FlatField.h"
+#include "MacroDeclSpec.h"
+#include "MappedFile.h"
+
+// relative difference of exposure times taken as the same calibration
+#define CALIBRATION_EXPOSURE_TOLERANCE	1e-3f
+
+// interpolated maps kept, a new interpolation never overwrites the maps of the last Select
+#define CALIBRATION_NUM_BLENDED	2
+
+struct CalibrationStoreHeader;
+struct CalibrationStoreEntry;
+
+/*
+ * @class	CCalibrationStore
+ * @brief	the file holds, for each exposure time in ascending order, float offset and gain maps and their fixed point versions,
+ *			each map on a page boundary. maps are used in place from the mapping, selecting a calibrated exposure time copies nothing
+*/
+class _DLL_EXPORT_ CCalibrationStore
+{
+public:
+	/*
+	 * @brief	constructor
+	*/
+	CCalibrationStore();
+
+	/*
+	 * @brief	destructor
+	*/
+	~CCalibrationStore();
+
+	/*
+	 * @brief	unmap the file, flat fields using its maps must not correct frames any more
+	*/
+	void Close();
+
+	/*
+	 * @brief	exposure time of an entry
+	 * @param	unEntryIdx
+	 * @return	exposure time, 0 if out of range
+	*/
+	float GetExposureTime(unsigned int unEntryIdx) const;
+
+	/*
+	 * @brief	height of maps
+	 * @return	rows, 0 if not open
+	*/
+	unsigned short GetHeight() const;
+
+	/*
+	 * @brief	exposure times in the store
+	 * @return	number of entries, 0 if not open
+	*/
+	unsigned int GetNumEntries() const;
+
+	/*
+	 * @brief	width of maps
+	 * @return	columns, 0 if not open
+	*/
+	unsigned short GetWidth() const;
+
+	/*
+	 * @brief	map a store written by Save and check its layout, maps are paged in on first access
+	 * @param	strFileName
+	 * @return	error code
+	*/
+	int Open(const std::string& strFileName);
+
+	/*
+	 * @brief	write maps of several exposure times to a store
+	 * @param	strFileName
+	 * @param	usHeight
+	 * @param	usWidth
+	 * @param	vecExposureTimes: positive and distinct, any order
+	 * @param	vecOffsetMaps: height x width each, one per exposure time
+	 * @param	vecGainMaps: height x width each, in [0, 32768), one per exposure time
+	 * @return	error code
+	*/
+	static int Save(const std::string& strFileName, unsigned short usHeight, unsigned short usWidth, const std::vector<float>& vecExposureTimes,
+		const std::vector<const float*>& vecOffsetMaps, const std::vector<const float*>& vecGainMaps);
+
+	/*
+	 * @brief	point a flat field at the maps of an exposure time. a calibrated exposure time, or one outside the calibrated range,
+	 *			uses the maps of the nearest entry in place. between two entries maps are interpolated linearly once and kept
+	 *			until another exposure time between entries is selected, into the other of CALIBRATION_NUM_BLENDED buffers
+	 * @param	fExposureTime: e.g. exptime of acquire
+	 * @param	oFlatField: output, valid until Close or the second Select interpolating another exposure time, so that
+	 *			a frame may still be corrected with the previous maps while the next ones are selected
+	 * @param	isFixedPoint: false to compute 16-bit output in float
+	 * @return	error code
+	*/
+	int Select(float fExposureTime, CFlatField& oFlatField, bool isFixedPoint = true);
+
+private:
+	// not copyable, mapping is owned
+	CCalibrationStore(const CCalibrationStore&);
+	CCalibrationStore& operator=(const CCalibrationStore&);
+
+	CMappedFile m_oFile;
+
+	const CalibrationStoreHeader* m_pHeader;
+	const CalibrationStoreEntry* m_pEntries;
+
+	// maps of index m_unBlendedIdx interpolated for m_fBlendedExposureTime, negative if none
+	float m_fBlendedExposureTime;
+	unsigned int m_unBlendedGainShift;
+	unsigned int m_unBlendedIdx;
+	std::vector<float> m_vecBlendedOffset[CALIBRATION_NUM_BLENDED];
+	std::vector<float> m_vecBlendedGain[CALIBRATION_NUM_BLENDED];
+	std::vector<unsigned short> m_vecBlendedFixedOffset[CALIBRATION_NUM_BLENDED];
+	std::vector<unsigned short> m_vecBlendedFixedGain[CALIBRATION_NUM_BLENDED];
+};
+
+//#ifdef __cplusplus
+//extern "C"
+//{
+//#endif // __cplusplus
+//
+//
+//#ifdef __cplusplus
+//};
+//#endif // __cplusplus
+
+#endif	// __CALIBRATION_STORE_H__
@@ -0,0 +1,173 @@
+/***************************************************
+ * @file		Checksum.cpp
+ * @section		Common
+ * @class		N/A
+ * @brief		checksum of data blocks
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#include <string.h>
+
+#include "Checksum.h"
+#include "MacroSimd.h"
+
+// reflected polynomial of CRC-32C
+#define CRC32C_POLY	0x82F63B78
+
+/*
+ * @class	CCrc32cTable
+ * @brief	lookup tables of slicing-by-8, built once when the library is loaded
+*/
+class CCrc32cTable
+{
+public:
+	CCrc32cTable()
+	{
+		for (unsigned int unIdx = 0; unIdx < 256; unIdx++)
+		{
+			unsigned int unCrc = unIdx;
+			for (int nBit = 0; nBit < 8; nBit++)
+			{
+				unCrc = (unCrc >> 1) ^ ((unCrc & 1) ? CRC32C_POLY : 0);
+			}
+			m_unTable[0][unIdx] = unCrc;
+		}
+
+		for (unsigned int unIdx = 0; unIdx < 256; unIdx++)
+		{
+			for (int nSlice = 1; nSlice < 8; nSlice++)
+			{
+				m_unTable[nSlice][unIdx] = (m_unTable[nSlice - 1][unIdx] >> 8) ^ m_unTable[0][m_unTable[nSlice - 1][unIdx] & 0xFF];
+			}
+		}
+	}
+
+	unsigned int m_unTable[8][256];
+};
+
+static const CCrc32cTable s_oCrc32cTable;
+
+/*
+ * @brief	check whether crc32 instruction of SSE4.2 is supported
+ * @return	true if supported
+*/
+static bool IsSse42Supported()
+{
+#if (defined _MSC_VER) && (defined _M_X64 || defined _M_IX86)
+	int nCpuInfo[4] = { 0 };
+	__cpuid(nCpuInfo, 1);
+	return 0 != (nCpuInfo[2] & (1 << 20));
+#elif (defined __x86_64__ || defined __i386__)
+	unsigned int unEax = 0, unEbx = 0, unEcx = 0, unEdx = 0;
+	if (0 == __get_cpuid(1, &unEax, &unEbx, &unEcx, &unEdx))
+	{
+		return false;
+	}
+	return 0 != (unEcx & bit_SSE4_2);
+#else
+	return false;
+#endif
+}
+
+static const bool s_isSse42Supported = IsSse42Supported();
+
+/*
+ * @brief	CRC-32C by slicing-by-8 tables
+ * @param	unCrc: inverted CRC
+ * @param	pData
+ * @param	unDataLen
+ * @return	inverted CRC
+*/
+static unsigned int UpdateCrc32cSoftware(unsigned int unCrc, const unsigned char* pData, size_t unDataLen)
+{
+	const unsigned int (*pTable)[256] = s_oCrc32cTable.m_unTable;
+
+	// little endian is assumed in the 8-byte path
+	while (unDataLen >= 8)
+	{
+		unsigned int unLow = 0, unHigh = 0;
+		::memcpy(&unLow, pData, 4);
+		::memcpy(&unHigh, pData + 4, 4);
+		unLow ^= unCrc;
+
+		unCrc = pTable[7][unLow & 0xFF] ^ pTable[6][(unLow >> 8) & 0xFF] ^ pTable[5][(unLow >> 16) & 0xFF] ^ pTable[4][unLow >> 24] ^ \
+			pTable[3][unHigh & 0xFF] ^ pTable[2][(unHigh >> 8) & 0xFF] ^ pTable[1][(unHigh >> 16) & 0xFF] ^ pTable[0][unHigh >> 24];
+
+		pData += 8;
+		unDataLen -= 8;
+	}
+
+	while (unDataLen-- > 0)
+	{
+		unCrc = (unCrc >> 8) ^ pTable[0][(unCrc ^ *pData++) & 0xFF];
+	}
+
+	return unCrc;
+}
+
+#if (defined _M_X64 || defined _M_IX86 || defined __x86_64__ || defined __i386__)
+/*
+ * @brief	CRC-32C by crc32 instruction of SSE4.2
+ * @param	unCrc: inverted CRC
+ * @param	pData
+ * @param	unDataLen
+ * @return	inverted CRC
+*/
+_TARGET_SSE42_ static unsigned int UpdateCrc32cHardware(unsigned int unCrc, const unsigned char* pData, size_t unDataLen)
+{
+#if (defined _M_X64 || defined __x86_64__)
+	unsigned long long ullCrc = unCrc;
+	while (unDataLen >= 8)
+	{
+		unsigned long long ullVal = 0;
+		::memcpy(&ullVal, pData, 8);
+		ullCrc = _mm_crc32_u64(ullCrc, ullVal);
+
+		pData += 8;
+		unDataLen -= 8;
+	}
+	unCrc = (unsigned int)ullCrc;
+#else
+	while (unDataLen >= 4)
+	{
+		unsigned int unVal = 0;
+		::memcpy(&unVal, pData, 4);
+		unCrc = _mm_crc32_u32(unCrc, unVal);
+
+		pData += 4;
+		unDataLen -= 4;
+	}
+#endif
+
+	while (unDataLen-- > 0)
+	{
+		unCrc = _mm_crc32_u8(unCrc, *pData++);
+	}
+
+	return unCrc;
+}
+#endif
+
+/*
+ * @brief	update CRC-32C (Castagnoli) with a data block, crc32 instruction of SSE4.2 used if supported
+ * @param	unCrc: CRC of previous blocks, 0 for the first block
+ * @param	pData: data block
+ * @param	unDataLen: bytes of data block
+ * @return	CRC of all blocks so far
+*/
+unsigned int UpdateCrc32c(unsigned int unCrc, const void* pData, size_t unDataLen)
+{
+	const unsigned char* pBytes = (const unsigned char*)pData;
+
+#if (defined _M_X64 || defined _M_IX86 || defined __x86_64__ || defined __i386__)
+	if (s_isSse42Supported)
+	{
+		return ~UpdateCrc32cHardware(~unCrc, pBytes, unDataLen);
+	}
+#endif
+
+	return ~UpdateCrc32cSoftware(~unCrc, pBytes, unDataLen);
+}
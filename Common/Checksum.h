@@ -0,0 +1,38 @@
+/***************************************************
+ * @file		Checksum.h
+ * @section		Common
+ * @class		N/A
+ * @brief		checksum of data blocks
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#ifndef __CHECKSUM_H__
+#define __CHECKSUM_H__
+
+#include <stddef.h>
+
+#include "MacroDeclSpec.h"
+
+/*
+ * @brief	update CRC-32C (Castagnoli) with a data block, crc32 instruction of SSE4.2 used if supported
+ * @param	unCrc: CRC of previous blocks, 0 for the first block
+ * @param	pData: data block
+ * @param	unDataLen: bytes of data block
+ * @return	CRC of all blocks so far
+*/
+_DLL_EXPORT_ unsigned int UpdateCrc32c(unsigned int unCrc, const void* pData, size_t unDataLen);
+
+//#ifdef __cplusplus
+//extern "C"
+//{
+//#endif // __cplusplus
+//
+//
+//#ifdef __cplusplus
+//};
+//#endif // __cplusplus
+
+#endif	// __CHECKSUM_H__
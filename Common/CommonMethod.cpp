@@ -23,11 +23,92 @@ namespace sf = std::experimental::filesystem;
 
 #include <fstream>
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#if (defined _MSC_VER)
+#include <malloc.h>
+#endif
+
 #include "CommonMethod.h"
+#include "ImageFilter.h"
 #include "Logger.h"
+#include "ThreadPool.h"
 
 using namespace std;
 
+/*
+ * @brief	free a buffer allocated by AlignedMalloc
+ * @param	pBuff, nullptr allowed
+*/
+void AlignedFree(void* pBuff)
+{
+#if (defined _MSC_VER)
+	_aligned_free(pBuff);
+#else
+	free(pBuff);
+#endif
+}
+
+/*
+ * @brief	allocate a buffer aligned for SIMD and cache lines
+ * @param	unNumBytes, size of buffer
+ * @param	unAlignment, power of 2
+ * @return	pointer, nullptr if failed, free it with AlignedFree
+*/
+void* AlignedMalloc(size_t unNumBytes, size_t unAlignment)
+{
+#if (defined _MSC_VER)
+	return _aligned_malloc(unNumBytes, unAlignment);
+#else
+	void* pBuff = nullptr;
+	if (0 != posix_memalign(&pBuff, unAlignment < sizeof(void*) ? sizeof(void*) : unAlignment, unNumBytes))
+	{
+		return nullptr;
+	}
+
+	return pBuff;
+#endif
+}
+
+/*
+ * @brief	collect input files from a folder (recursively), a list file (one path per line) or a single file
+ * @param	strInput
+ * @param	vecFileNames: output, files appended
+*/
+void CollectInputFiles(const string& strInput, vector<string>& vecFileNames)
+{
+	sf::path oInputPath = sf::complete(sf::path(strInput));
+
+	if (sf::is_directory(oInputPath))
+	{
+		for (sf::recursive_directory_iterator iterFile(oInputPath), iterEnd; iterFile != iterEnd; ++iterFile)
+		{
+			if (sf::is_regular_file(iterFile->status()))
+			{
+				vecFileNames.push_back(iterFile->path().string());
+			}
+		}
+	}
+	else if (strInput.size() > 4 && 0 == strInput.compare(strInput.size() - 4, 4, ".txt"))
+	{
+		ifstream oListFile(oInputPath.string().c_str());
+		string strLine;
+		while (getline(oListFile, strLine))
+		{
+			if (!strLine.empty())
+			{
+				vecFileNames.push_back(strLine);
+			}
+		}
+	}
+	else
+	{
+		vecFileNames.push_back(oInputPath.string());
+	}
+}
+
 /*
  * @brief	convert a hexadecimal string into unsigned int
  * @param	strHexVal
@@ -69,6 +150,104 @@ unsigned int ConvertHexStrToUint(std::string strHexVal)
 	return unRetVal;
 }
 
+/*
+ * @brief	filter image in place with a kernel of any odd size, pixels beyond the border repeat the border.
+ *			rank 1 kernels are applied as a row and a column, bands of rows are filtered in parallel
+ *			and each band keeps only kernel height rows in scratch memory. defined in CommonMethod.cpp for unsigned char,
+ *			short, unsigned short and float only, the pixel types of LoadFilterRow and StoreFilterRow
+ * @param	pImgPtr, pointer of image, overwritten by the filtered image
+ * @param	usImgHeight, height of image
+ * @param	usImgWidth, width of image
+ * @param	pFilterKernel, usKernelHeight * usKernelWidth weights, row major
+ * @param	usKernelHeight, odd
+ * @param	usKernelWidth, odd
+ * @return	error code, results are rounded and clamped to the range of T
+*/
+template<typename T>
+int FilterImage(T* pImgPtr, unsigned short usImgHeight, unsigned short usImgWidth, const float* pFilterKernel, unsigned short usKernelHeight, unsigned short usKernelWidth)
+{
+	FilterKernel oKernel;
+	int nProcResult = PrepareFilterKernel(pFilterKernel, usKernelHeight, usKernelWidth, oKernel);
+	if (STATUS_OK != nProcResult || nullptr == pImgPtr)
+	{
+		return nullptr == pImgPtr ? INVALID_PARAMETER : nProcResult;
+	}
+
+	int nHeight = usImgHeight;
+	int nRadiusY = usKernelHeight / 2;
+
+	// bands overwrite their own rows only, so the rows around each band are saved before any band starts
+	std::vector<T> vecHaloRows;
+	size_t unNumBands = SaveFilterHalo(pImgPtr, usImgHeight, usImgWidth, nRadiusY, vecHaloRows);
+
+	CThreadPool::GetInstance()->ParallelFor(unNumBands, [&](size_t unBandBegin, size_t unBandEnd)
+	{
+		CFilterWindow oWindow(oKernel, usImgWidth);
+		std::vector<float> vecFiltered(usImgWidth);
+
+		for (size_t unBandIdx = unBandBegin; unBandIdx < unBandEnd; unBandIdx++)
+		{
+			int nBandBegin = (int)unBandIdx * FILTER_BAND_HEIGHT;
+			int nBandEnd = (std::min)(nBandBegin + FILTER_BAND_HEIGHT, nHeight);
+			const T* pHaloRows = GetFilterHaloRows(vecHaloRows, unBandIdx, usImgWidth, nRadiusY);
+
+			// rows of the band are read before being overwritten, the others come from the saved halo
+			auto funcPushRow = [&](int nRowIdx)
+			{
+				const T* pRow = GetFilterSourceRow<T>(pImgPtr, pHaloRows, usImgWidth, nBandBegin, nBandEnd, nRadiusY, nRowIdx);
+				LoadFilterRow(pRow, usImgWidth, oWindow.GetLoadRow());
+				oWindow.PushRow();
+			};
+
+			oWindow.Reset();
+			for (int nRowIdx = nBandBegin - nRadiusY; nRowIdx < nBandBegin + nRadiusY; nRowIdx++)
+			{
+				funcPushRow(nRowIdx);
+			}
+
+			for (int nRowIdx = nBandBegin; nRowIdx < nBandEnd; nRowIdx++)
+			{
+				funcPushRow(nRowIdx + nRadiusY);
+				oWindow.FilterRow(vecFiltered.data());
+				StoreFilterRow(vecFiltered.data(), usImgWidth, pImgPtr + (size_t)nRowIdx * usImgWidth);
+			}
+		}
+	}, 1);
+
+	return STATUS_OK;
+}
+
+template int FilterImage<unsigned char>(unsigned char*, unsigned short, unsigned short, const float*, unsigned short, unsigned short);
+template int FilterImage<short>(short*, unsigned short, unsigned short, const float*, unsigned short, unsigned short);
+template int FilterImage<unsigned short>(unsigned short*, unsigned short, unsigned short, const float*, unsigned short, unsigned short);
+template int FilterImage<float>(float*, unsigned short, unsigned short, const float*, unsigned short, unsigned short);
+
+/*
+ * @brief	size and last modification time of a file, to detect changes of the file
+ * @param	strFileName
+ * @param	ullFileSize: output size in bytes
+ * @param	llModifyTime: output seconds since epoch
+ * @return	false if file does not exist
+*/
+bool GetFileStamp(const std::string& strFileName, unsigned long long& ullFileSize, long long& llModifyTime)
+{
+#if (defined _MSC_VER)
+	struct _stat64 oFileStat;
+	if (0 != _stat64(strFileName.c_str(), &oFileStat))
+#else
+	struct stat oFileStat;
+	if (0 != stat(strFileName.c_str(), &oFileStat))
+#endif
+	{
+		return false;
+	}
+
+	ullFileSize = (unsigned long long)oFileStat.st_size;
+	llModifyTime = (long long)oFileStat.st_mtime;
+
+	return true;
+}
+
 /*
  * @brief	get the full path of the running program
  * @return	full path of the running program
@@ -156,6 +335,21 @@ bool ReadFromDisk(const string strFileName, char*& pDataBuff, size_t unByteToRea
 	return true;
 }
 
+/*
+ * @brief	rename a file, an existing destination is replaced atomically so that readers see either file whole
+ * @param	strSrcName
+ * @param	strDstName
+ * @return	false if the file could not be renamed, the destination is then unchanged
+*/
+bool RenameFile(const string& strSrcName, const string& strDstName)
+{
+#if (defined WIN32 || defined _WIN32 || defined _W64 || defined WINCE)
+	return 0 != MoveFileExA(strSrcName.c_str(), strDstName.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+	return 0 == rename(strSrcName.c_str(), strDstName.c_str());
+#endif
+}
+
 /*
  * @brief	split string according pointed splitter
  * @param	string to be split
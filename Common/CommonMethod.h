@@ -12,10 +12,13 @@
 #ifndef __COMMON_METHOD_H__
 #define __COMMON_METHOD_H__
 
+#include <algorithm>
 #include <functional>
+#include <string>
 #include <string.h>
 #include <vector>
 
+#include "IntlMsgAliasID.h"
 #include "MacroDeclSpec.h"
 
 /* enum */
@@ -25,6 +28,27 @@
 //};
 
 
+/*
+ * @brief	free a buffer allocated by AlignedMalloc
+ * @param	pBuff, nullptr allowed
+*/
+_DLL_EXPORT_ void AlignedFree(void* pBuff);
+
+/*
+ * @brief	allocate a buffer aligned for SIMD and cache lines
+ * @param	unNumBytes, size of buffer
+ * @param	unAlignment, power of 2
+ * @return	pointer, nullptr if failed, free it with AlignedFree
+*/
+_DLL_EXPORT_ void* AlignedMalloc(size_t unNumBytes, size_t unAlignment = 64);
+
+/*
+ * @brief	collect input files from a folder (recursively), a list file (one path per line) or a single file
+ * @param	strInput
+ * @param	vecFileNames: output, files appended
+*/
+_DLL_EXPORT_ void CollectInputFiles(const std::string& strInput, std::vector<std::string>& vecFileNames);
+
 /*
  * @brief	convert a value to string
  * @param	tInVal, input value
@@ -99,6 +123,15 @@ _DLL_EXPORT_ std::string ConvertValToString(T tInVal, size_t ullFloatPrecision =
 */
 _DLL_EXPORT_ unsigned int ConvertHexStrToUint(std::string strHexVal);
 
+/*
+ * @brief	size and last modification time of a file, to detect changes of the file
+ * @param	strFileName
+ * @param	ullFileSize: output size in bytes
+ * @param	llModifyTime: output seconds since epoch
+ * @return	false if file does not exist
+*/
+_DLL_EXPORT_ bool GetFileStamp(const std::string& strFileName, unsigned long long& ullFileSize, long long& llModifyTime);
+
 /*
  * @brief	get the full path of the running program
  * @return	full path of the running program
@@ -106,101 +139,20 @@ _DLL_EXPORT_ unsigned int ConvertHexStrToUint(std::string strHexVal);
 _DLL_EXPORT_ std::string GetInitialPath();
 
 /*
- * @brief	filter image using C
- * @param	pImgPtr, pointer of input image
- * @param	usImgWidth, width of input image
- * @param	usImgHeight, height of input image
- * @param	pFilterKernel, pointer of input kernel, temporarily 3 * 3
- * @bug		only unsigned short supported
- * @return	
+ * @brief	filter image in place with a kernel of any odd size, pixels beyond the border repeat the border.
+ *			rank 1 kernels are applied as a row and a column, bands of rows are filtered in parallel
+ *			and each band keeps only kernel height rows in scratch memory. defined in CommonMethod.cpp for unsigned char,
+ *			short, unsigned short and float only, the pixel types of LoadFilterRow and StoreFilterRow
+ * @param	pImgPtr, pointer of image, overwritten by the filtered image
+ * @param	usImgHeight, height of image
+ * @param	usImgWidth, width of image
+ * @param	pFilterKernel, usKernelHeight * usKernelWidth weights, row major
+ * @param	usKernelHeight, odd
+ * @param	usKernelWidth, odd
+ * @return	error code, results are rounded and clamped to the range of T
  */
 template<typename T>
-_DLL_EXPORT_ void FilterImage(const T* pImgPtr, unsigned short usImgHeight, unsigned short usImgWidth, const float* pFilterKernel)
-{
-	// kernel
-	// k1, k2, k3
-	// k4, k5, k6
-	// k7, k8, k9
-	float fKernelVal1 = *(pFilterKernel);
-	float fKernelVal2 = *(pFilterKernel + 1);
-	float fKernelVal3 = *(pFilterKernel + 2);
-	float fKernelVal4 = *(pFilterKernel + 3);
-	float fKernelVal5 = *(pFilterKernel + 4);
-	float fKernelVal6 = *(pFilterKernel + 5);
-	float fKernelVal7 = *(pFilterKernel + 6);
-	float fKernelVal8 = *(pFilterKernel + 7);
-	float fKernelVal9 = *(pFilterKernel + 8);
-
-	T* pDstImg = new T[usImgWidth * usImgHeight * sizeof(T)];
-
-	T* pTempPtr = pDstImg;
-	
-	T* pImgPtr1 = 0;
-	T* pImgPtr2 = 0;
-	T* pImgPtr3 = 0;
-	T* pImgPtr4 = 0;
-	T* pImgPtr5 = 0;
-	T* pImgPtr6 = 0;
-	T* pImgPtr7 = 0;
-	T* pImgPtr8 = 0;
-	T* pImgPtr9 = 0;
-
-	uint32_t unPixelOffset = 0;
-
-	float dTempSum = 0;
-
-	for (uint16_t usRowIdx = 0; usRowIdx < usImgHeight; usRowIdx++)
-	{
-		// offset of pixel multiplied with k6
-		unPixelOffset = usRowIdx * usImgWidth;
-		pImgPtr6 = pImgPtr + unPixelOffset;
-
-		// offset of pixel multiplied with k3 and k9
-		pImgPtr3 = pImgPtr6 - (usRowIdx > 0 ? usImgWidth : 0);
-		pImgPtr9 = pImgPtr6 + (usRowIdx < usImgHeight - 1 ? usImgWidth : 0);
-
-		// k2, k5, k8
-		pImgPtr2 = pImgPtr3;
-		pImgPtr5 = pImgPtr6;
-		pImgPtr8 = pImgPtr9;
-
-		for (uint16_t usColIdx = 0; usColIdx < usImgWidth; usColIdx++)
-		{
-			pImgPtr1 = pImgPtr2;
-			pImgPtr4 = pImgPtr5;
-			pImgPtr7 = pImgPtr8;
-
-			pImgPtr2 = pImgPtr3;
-			pImgPtr5 = pImgPtr6;
-			pImgPtr8 = pImgPtr9;
-
-			if (usColIdx < usImgWidth - 1)
-			{
-				pImgPtr3++;
-				pImgPtr6++;
-				pImgPtr9++;
-			}
-
-			dTempSum = *pImgPtr1 * fKernelVal1 + \
-				*pImgPtr2 * fKernelVal2 + \
-				*pImgPtr3 * fKernelVal3 + \
-				*pImgPtr4 * fKernelVal4 + \
-				*pImgPtr5 * fKernelVal5 + \
-				*pImgPtr6 * fKernelVal6 + \
-				*pImgPtr7 * fKernelVal7 + \
-				*pImgPtr8 * fKernelVal8 + \
-				*pImgPtr9 * fKernelVal9;
-
-			*(pTempPtr) = dTempSum > 0 ? (dTempSum > 65535 ? 65535 : (T)(dTempSum + 0.5)) : 0;
-			pTempPtr++;
-		}
-	}
-
-	memcpy((uint8_t*)pImgPtr, pDstImg, usImgHeight * usImgWidth * sizeof(T));
-
-	delete[] pDstImg;
-	pDstImg = nullptr;
-}
+_DLL_EXPORT_ int FilterImage(T* pImgPtr, unsigned short usImgHeight, unsigned short usImgWidth, const float* pFilterKernel, unsigned short usKernelHeight = 3, unsigned short usKernelWidth = 3);
 
 /*
  * @brief	read data from disk
@@ -212,6 +164,14 @@ _DLL_EXPORT_ void FilterImage(const T* pImgPtr, unsigned short usImgHeight, unsi
 */
 _DLL_EXPORT_ bool ReadFromDisk(const std::string strFileName, char*&pDataBuff, size_t unByteToRead, const size_t unByteToSkip = 0);
 
+/*
+ * @brief	rename a file, an existing destination is replaced atomically so that readers see either file whole
+ * @param	strSrcName
+ * @param	strDstName
+ * @return	false if the file could not be renamed, the destination is then unchanged
+*/
+_DLL_EXPORT_ bool RenameFile(const std::string& strSrcName, const std::string& strDstName);
+
 /*
  * @brief	split string according pointed splitter
  * @param	string to be split
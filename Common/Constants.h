@@ -16,6 +16,6 @@
 #define INFO_BUFF_LEN	256
 
 // math
-#define PI	3.141592654
+#define PI	3.14159265358979323846
  
 #endif	// __CONSTANTS_H__
\ No newline at end of file
@@ -1,33 +1,253 @@
 /***************************************************
- * @file		
- * @section		
- * @class		
- * @brief		
+ * @file		CvFFT2D.cpp
+ * @section		Common
+ * @class		CCvFFTContext, CCvFFT2D
+ * @brief		2D discrete Fourier transforms with OpenCV
  * @author		bqrmtao@gmail.com
- * @date		
+ * @date		2026/10/19
  * @version		1.0
  * @copyright	bqrmtao@gmail.com
 ***************************************************/
 
 #include <mutex>
 
+#include <limits.h>
+#include <string.h>
+
 #include "opencv/cv.h"
 
 #include "CvFFT2D.h"
+#include "IntlMsgAliasID.h"
 
 using namespace std;
 
 CCvFFT2D* CCvFFT2D::m_pInstance = nullptr;
 mutex m_oFFTLock;
 
+/*
+ * @brief	constructor
+*/
+CCvFFTContext::CCvFFTContext()
+{
+	m_unNumRow = 0;
+	m_unNumCol = 0;
+	m_isReal = false;
+	m_isPadded = false;
+	m_isRowWise = false;
+	m_pSpectrum = new cv::Mat();
+}
+
+/*
+ * @brief	destructor
+*/
+CCvFFTContext::~CCvFFTContext()
+{
+	delete m_pSpectrum;
+	m_pSpectrum = nullptr;
+}
+
+/*
+ * @brief	transform an image, zero padded to the size of the spectrum
+ * @param	pReal: rows x columns
+ * @param	pImag: rows x columns, nullptr for zeros, unused by real transforms
+ * @return	error code
+*/
+int CCvFFTContext::Forward(const float* pReal, const float* pImag)
+{
+	if (nullptr == pReal || m_pSpectrum->empty())
+	{
+		return INVALID_PARAMETER;
+	}
+
+	// written straight into the spectrum buffer, interleaved for complex transforms
+	int nNumChannels = m_isReal ? 1 : 2;
+	for (unsigned int unRowIdx = 0; unRowIdx < m_unNumRow; unRowIdx++)
+	{
+		float* pDst = m_pSpectrum->ptr<float>(unRowIdx);
+		const float* pRealRow = pReal + (size_t)unRowIdx * m_unNumCol;
+		if (m_isReal)
+		{
+			memcpy(pDst, pRealRow, m_unNumCol * sizeof(float));
+		}
+		else
+		{
+			const float* pImagRow = nullptr == pImag ? nullptr : pImag + (size_t)unRowIdx * m_unNumCol;
+			for (unsigned int unColIdx = 0; unColIdx < m_unNumCol; unColIdx++)
+			{
+				pDst[2 * unColIdx] = pRealRow[unColIdx];
+				pDst[2 * unColIdx + 1] = nullptr == pImagRow ? 0 : pImagRow[unColIdx];
+			}
+		}
+		memset(pDst + nNumChannels * m_unNumCol, 0, nNumChannels * (m_pSpectrum->cols - m_unNumCol) * sizeof(float));
+	}
+	if ((int)m_unNumRow < m_pSpectrum->rows)
+	{
+		m_pSpectrum->rowRange(m_unNumRow, m_pSpectrum->rows).setTo(0);
+	}
+
+	Transform(false);
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	columns of images
+ * @return	columns, 0 if not prepared
+*/
+unsigned int CCvFFTContext::GetNumCol() const
+{
+	return m_unNumCol;
+}
+
+/*
+ * @brief	rows of images
+ * @return	rows, 0 if not prepared
+*/
+unsigned int CCvFFTContext::GetNumRow() const
+{
+	return m_unNumRow;
+}
+
+/*
+ * @brief	spectrum after Forward, padded size, CV_32FC1 in CCS layout for real transforms and CV_32FC2 otherwise
+ * @return	buffer, may be modified before Inverse
+*/
+cv::Mat& CCvFFTContext::GetSpectrum()
+{
+	return *m_pSpectrum;
+}
+
+/*
+ * @brief	spectrum after Forward
+ * @return	buffer
+*/
+const cv::Mat& CCvFFTContext::GetSpectrum() const
+{
+	return *m_pSpectrum;
+}
+
+/*
+ * @brief	inverse transform of the spectrum, scaled so that it undoes Forward, and crop to the image size.
+ *			the spectrum is overwritten
+ * @param	pReal: output, rows x columns
+ * @param	pImag: output, rows x columns, nullptr to drop, unused by real transforms
+ * @return	error code
+*/
+int CCvFFTContext::Inverse(float* pReal, float* pImag)
+{
+	if (nullptr == pReal || m_pSpectrum->empty())
+	{
+		return INVALID_PARAMETER;
+	}
+
+	Transform(true);
+
+	for (unsigned int unRowIdx = 0; unRowIdx < m_unNumRow; unRowIdx++)
+	{
+		const float* pSrc = m_pSpectrum->ptr<float>(unRowIdx);
+		float* pRealRow = pReal + (size_t)unRowIdx * m_unNumCol;
+		if (m_isReal)
+		{
+			memcpy(pRealRow, pSrc, m_unNumCol * sizeof(float));
+			continue;
+		}
+
+		float* pImagRow = nullptr == pImag ? nullptr : pImag + (size_t)unRowIdx * m_unNumCol;
+		for (unsigned int unColIdx = 0; unColIdx < m_unNumCol; unColIdx++)
+		{
+			pRealRow[unColIdx] = pSrc[2 * unColIdx];
+			if (nullptr != pImagRow)
+			{
+				pImagRow[unColIdx] = pSrc[2 * unColIdx + 1];
+			}
+		}
+	}
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	whether inputs and outputs are real
+ * @return	true for real transforms
+*/
+bool CCvFFTContext::IsReal() const
+{
+	return m_isReal;
+}
+
+/*
+ * @brief	set the shape of transforms, nothing is done if it is unchanged
+ * @param	unNumRow
+ * @param	unNumCol
+ * @param	isReal: real input and output, spectrum in CCS layout
+ * @param	isPadded: pad to sizes fast for cv::dft, with zeros, false for transforms of the exact size
+ * @param	isRowWise: batch of independent 1D transforms of each row, rows are not padded
+ * @return	error code
+*/
+int CCvFFTContext::Prepare(unsigned int unNumRow, unsigned int unNumCol, bool isReal, bool isPadded, bool isRowWise)
+{
+	if (0 == unNumRow || 0 == unNumCol || unNumRow > INT_MAX || unNumCol > INT_MAX)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	if (unNumRow == m_unNumRow && unNumCol == m_unNumCol && isReal == m_isReal && isPadded == m_isPadded && isRowWise == m_isRowWise && !m_pSpectrum->empty())
+	{
+		return STATUS_OK;
+	}
+
+	m_unNumRow = unNumRow;
+	m_unNumCol = unNumCol;
+	m_isReal = isReal;
+	m_isPadded = isPadded;
+	m_isRowWise = isRowWise;
+
+	int nNumRow = isPadded && !isRowWise ? cv::getOptimalDFTSize(unNumRow) : (int)unNumRow;
+	int nNumCol = isPadded ? cv::getOptimalDFTSize(unNumCol) : (int)unNumCol;
+	m_pSpectrum->create(nNumRow, nNumCol, isReal ? CV_32FC1 : CV_32FC2);
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	transform the spectrum buffer in place, for callers filling it directly, e.g. converting pixels on the fly.
+ *			padding must hold zeros or whatever the caller wants to transform
+ * @param	isInverse: inverse transform scaled like Inverse
+*/
+void CCvFFTContext::Transform(bool isInverse)
+{
+	if (m_pSpectrum->empty())
+	{
+		return;
+	}
+
+	// padding rows are known to be zero, their row transforms are skipped, and only the rows of the image are needed back
+	int nFlags = m_isRowWise ? cv::DFT_ROWS : 0;
+	if (isInverse)
+	{
+		nFlags |= cv::DFT_INVERSE | cv::DFT_SCALE | (m_isReal ? cv::DFT_REAL_OUTPUT : 0);
+	}
+	cv::dft(*m_pSpectrum, *m_pSpectrum, nFlags, m_unNumRow);
+}
+
+/*
+ * @brief	constructor
+*/
 CCvFFT2D::CCvFFT2D()
 {
 }
 
+/*
+ * @brief	destructor
+*/
 CCvFFT2D::~CCvFFT2D()
 {
 }
 
+/*
+ * @brief	instance of singleton
+ * @return	pointer
+*/
 CCvFFT2D* CCvFFT2D::GetInstance()
 {
 	if (nullptr == m_pInstance)
@@ -43,21 +263,55 @@ CCvFFT2D* CCvFFT2D::GetInstance()
 	return m_pInstance;
 }
 
+/*
+ * @brief	forward transform in place
+ * @param	pReal: rows x columns
+ * @param	pImag: rows x columns
+ * @param	unNumRow
+ * @param	unNumCol
+*/
 void CCvFFT2D::FFT2D(float* pReal, float *pImag, unsigned int unNumRow, unsigned int unNumCol)
 {
-	cv::Mat cvPlanes[] = { cv::Mat(unNumRow, unNumCol, CV_32F, pReal), cv::Mat(unNumRow, unNumCol, CV_32F, pImag) };	
-	cv::Mat cvComplexI;
-	cv::merge(cvPlanes, 2, cvComplexI);	// Add to the expanded another plane with zeros
-	cv::dft(cvComplexI, cvComplexI);	// this way the result may fit in the source matrix
-	cv::split(cvComplexI, cvPlanes);
+	// a context per call, concurrent transforms share nothing
+	CCvFFTContext oContext;
+	if (STATUS_OK == oContext.Prepare(unNumRow, unNumCol, false, false) && STATUS_OK == oContext.Forward(pReal, pImag))
+	{
+		cv::Mat& cvSpectrum = oContext.GetSpectrum();
+		for (unsigned int unRowIdx = 0; unRowIdx < unNumRow; unRowIdx++)
+		{
+			const float* pSrc = cvSpectrum.ptr<float>(unRowIdx);
+			for (unsigned int unColIdx = 0; unColIdx < unNumCol; unColIdx++)
+			{
+				pReal[(size_t)unRowIdx * unNumCol + unColIdx] = pSrc[2 * unColIdx];
+				pImag[(size_t)unRowIdx * unNumCol + unColIdx] = pSrc[2 * unColIdx + 1];
+			}
+		}
+	}
 }
 
+/*
+ * @brief	inverse transform in place, scaled by 1 / (rows x columns)
+ * @param	pReal: rows x columns
+ * @param	pImag: rows x columns
+ * @param	unNumRow
+ * @param	unNumCol
+*/
 void CCvFFT2D::iFFT2D(float* pReal, float *pImag, unsigned int unNumRow, unsigned int unNumCol)
 {
-	cv::Mat cvPlanes[] = { cv::Mat(unNumRow, unNumCol, CV_32F, pReal), cv::Mat(unNumRow, unNumCol, CV_32F, pImag) };	
-	cv::Mat cvComplexI;
-	cv::merge(cvPlanes, 2, cvComplexI);	// Add to the expanded another plane with zeros
-	cv::idft(cvComplexI, cvComplexI);	// this way the result may fit in the source matrix
-	cvComplexI /= (unNumRow * unNumCol);
-	cv::split(cvComplexI, cvPlanes);
-}
\ No newline at end of file
+	CCvFFTContext oContext;
+	if (STATUS_OK == oContext.Prepare(unNumRow, unNumCol, false, false))
+	{
+		// input interleaved into the spectrum buffer, then transformed back in it
+		cv::Mat& cvSpectrum = oContext.GetSpectrum();
+		for (unsigned int unRowIdx = 0; unRowIdx < unNumRow; unRowIdx++)
+		{
+			float* pDst = cvSpectrum.ptr<float>(unRowIdx);
+			for (unsigned int unColIdx = 0; unColIdx < unNumCol; unColIdx++)
+			{
+				pDst[2 * unColIdx] = pReal[(size_t)unRowIdx * unNumCol + unColIdx];
+				pDst[2 * unColIdx + 1] = pImag[(size_t)unRowIdx * unNumCol + unColIdx];
+			}
+		}
+		oContext.Inverse(pReal, pImag);
+	}
+}
@@ -1,10 +1,10 @@
 /***************************************************
- * @file		
- * @section		
- * @class		
- * @brief		
+ * @file		CvFFT2D.h
+ * @section		Common
+ * @class		CCvFFTContext, CCvFFT2D
+ * @brief		2D discrete Fourier transforms with OpenCV
  * @author		bqrmtao@gmail.com
- * @date		
+ * @date		2026/10/19
  * @version		1.0
  * @copyright	bqrmtao@gmail.com
 ***************************************************/
@@ -15,22 +15,141 @@
 
 #include "MacroDeclSpec.h"
 
-/* enum */
-//enum 
-//{
-//	,   ///< 
-//};
+// only referred to here, includers using the spectrum include opencv themselves
+namespace cv
+{
+	class Mat;
+}
+
+/*
+ * @class	CCvFFTContext
+ * @brief	transforms of one shape. the padded size and the spectrum buffer are kept between calls, so repeated
+ *			transforms allocate nothing, and the spectrum stays in the buffer between Forward and Inverse to be
+ *			filtered in place. real inputs are transformed to the packed CCS layout of cv::dft, half the work of a complex transform.
+ *			row-wise contexts transform many rows at once, each independently. a context is used by one thread at a time
+*/
+class _DLL_EXPORT_ CCvFFTContext
+{
+public:
+	/*
+	 * @brief	constructor
+	*/
+	CCvFFTContext();
+
+	/*
+	 * @brief	destructor
+	*/
+	~CCvFFTContext();
+
+	/*
+	 * @brief	transform an image, zero padded to the size of the spectrum
+	 * @param	pReal: rows x columns
+	 * @param	pImag: rows x columns, nullptr for zeros, unused by real transforms
+	 * @return	error code
+	*/
+	int Forward(const float* pReal, const float* pImag = nullptr);
+
+	/*
+	 * @brief	columns of images
+	 * @return	columns, 0 if not prepared
+	*/
+	unsigned int GetNumCol() const;
+
+	/*
+	 * @brief	rows of images
+	 * @return	rows, 0 if not prepared
+	*/
+	unsigned int GetNumRow() const;
+
+	/*
+	 * @brief	spectrum after Forward, padded size, CV_32FC1 in CCS layout for real transforms and CV_32FC2 otherwise
+	 * @return	buffer, may be modified before Inverse
+	*/
+	cv::Mat& GetSpectrum();
+
+	/*
+	 * @brief	spectrum after Forward
+	 * @return	buffer
+	*/
+	const cv::Mat& GetSpectrum() const;
+
+	/*
+	 * @brief	inverse transform of the spectrum, scaled so that it undoes Forward, and crop to the image size.
+	 *			the spectrum is overwritten
+	 * @param	pReal: output, rows x columns
+	 * @param	pImag: output, rows x columns, nullptr to drop, unused by real transforms
+	 * @return	error code
+	*/
+	int Inverse(float* pReal, float* pImag = nullptr);
+
+	/*
+	 * @brief	whether inputs and outputs are real
+	 * @return	true for real transforms
+	*/
+	bool IsReal() const;
+
+	/*
+	 * @brief	set the shape of transforms, nothing is done if it is unchanged
+	 * @param	unNumRow
+	 * @param	unNumCol
+	 * @param	isReal: real input and output, spectrum in CCS layout
+	 * @param	isPadded: pad to sizes fast for cv::dft, with zeros, false for transforms of the exact size
+	 * @param	isRowWise: batch of independent 1D transforms of each row, rows are not padded
+	 * @return	error code
+	*/
+	int Prepare(unsigned int unNumRow, unsigned int unNumCol, bool isReal, bool isPadded = true, bool isRowWise = false);
+
+	/*
+	 * @brief	transform the spectrum buffer in place, for callers filling it directly, e.g. converting pixels on the fly.
+	 *			padding must hold zeros or whatever the caller wants to transform
+	 * @param	isInverse: inverse transform scaled like Inverse
+	*/
+	void Transform(bool isInverse);
+
+private:
+	unsigned int m_unNumRow;
+	unsigned int m_unNumCol;
+
+	bool m_isReal;
+	bool m_isPadded;
+	bool m_isRowWise;
+
+	cv::Mat* m_pSpectrum;		///< owned
+
+	// not copyable, spectrum is owned
+	CCvFFTContext(const CCvFFTContext&);
+	CCvFFTContext& operator=(const CCvFFTContext&);
+};
 
 /*
- * @class	
- * @brief	
+ * @class	CCvFFT2D
+ * @brief	in place complex transforms of planar images, exact size, safe to call from several threads
 */
 class _DLL_EXPORT_ CCvFFT2D
 {
 public:
+	/*
+	 * @brief	instance of singleton
+	 * @return	pointer
+	*/
 	static CCvFFT2D* GetInstance();
 
+	/*
+	 * @brief	forward transform in place
+	 * @param	pReal: rows x columns
+	 * @param	pImag: rows x columns
+	 * @param	unNumRow
+	 * @param	unNumCol
+	*/
 	void FFT2D(float* pReal, float *pImag, unsigned int unNumRow, unsigned int unNumCol);
+
+	/*
+	 * @brief	inverse transform in place, scaled by 1 / (rows x columns)
+	 * @param	pReal: rows x columns
+	 * @param	pImag: rows x columns
+	 * @param	unNumRow
+	 * @param	unNumCol
+	*/
 	void iFFT2D(float* pReal, float *pImag, unsigned int unNumRow, unsigned int unNumCol);
 
 private:
@@ -57,12 +176,6 @@ private:
 	static CGarbo oGarbo;
 };
 
-/*
- * @brief	
- * @param	
- * @return	
-*/
-
 //#ifdef __cplusplus
 //extern "C"
 //{
@@ -73,4 +186,4 @@ private:
 //};
 //#endif // __cplusplus
 
-#endif	// __CV_FFT_2D_H__
\ No newline at end of file
+#endif	// __CV_FFT_2D_H__
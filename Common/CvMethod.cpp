@@ -9,14 +9,17 @@
  * @copyright	bqrmtao@gmail.com
 ***************************************************/
 
+#include <algorithm>
 #include <mutex>
 
 #include "CvMethod.h"
+#include "IntlMsgAliasID.h"
 
 using namespace std;
 
 CCvMethod* CCvMethod::m_pInstance = nullptr;
 mutex m_oShowImageLock;
+mutex m_oWindowLevelLock;
 
 /*
  * @brief	constructor
@@ -112,6 +115,16 @@ int16_t CCvMethod::GetCVType(std::type_info oInputType, uint8_t ucNumChannel)
 */
 void CCvMethod::ShowImage(string strWindowName, char* pImgPtr, int nImgHeight, int nImgWidth, size_t unImgType, bool bIsDestroyWindow)
 {
+	// 16-bit frames are stretched from their minimum to their maximum in one table lookup per pixel
+	if (CV_16UC1 == unImgType)
+	{
+		unsigned short usMinVal = 0;
+		unsigned short usMaxVal = 0;
+		GetPixelRange((const unsigned short*)pImgPtr, (size_t)nImgHeight * nImgWidth, usMinVal, usMaxVal);
+		ShowImage(strWindowName, (const unsigned short*)pImgPtr, nImgHeight, nImgWidth, (usMinVal + usMaxVal + 1) / 2.0f, usMaxVal - usMinVal + 1.0f, 16, bIsDestroyWindow);
+		return;
+	}
+
 	cv::Mat cvMatSrc = cv::Mat(nImgHeight, nImgWidth, unImgType, pImgPtr);
 	cv::Mat cvMatTmp;
 	cvMatSrc.convertTo(cvMatTmp, CV_32FC1);
@@ -137,6 +150,48 @@ void CCvMethod::ShowImage(string strWindowName, char* pImgPtr, int nImgHeight, i
 	cvMatSrc.release();
 }
 
+/*
+ * @brief	show 16-bit image with given window, mapped through the lookup table of CWindowLevel
+ * @param	strWindowName : window's name
+ * @param	pImgPtr: image pointer
+ * @param	nImgHeight
+ * @param	nImgWidth
+ * @param	fWindowCenter
+ * @param	fWindowWidth: at least 1
+ * @param	unBitDepth: stored bits of pixels
+ * @param	bIsDestroyWindow: whether to destroy the pop-up
+ * @return	void
+*/
+void CCvMethod::ShowImage(string strWindowName, const unsigned short* pImgPtr, int nImgHeight, int nImgWidth, float fWindowCenter, float fWindowWidth,
+	unsigned int unBitDepth, bool bIsDestroyWindow)
+{
+	if (nullptr == pImgPtr || nImgHeight <= 0 || nImgWidth <= 0)
+	{
+		return;
+	}
+
+	// imshow copies the buffer into the window, the lock is released before waiting for keys
+	{
+		lock_guard<mutex> oGuard(m_oWindowLevelLock);
+		if (STATUS_OK != m_oWindowLevel.SetWindow(fWindowCenter, max(fWindowWidth, 1.0f), unBitDepth))
+		{
+			return;
+		}
+
+		m_cvMatShow.create(nImgHeight, nImgWidth, CV_8UC1);
+		m_oWindowLevel.Apply(pImgPtr, (size_t)nImgHeight * nImgWidth, m_cvMatShow.data);
+
+		cv::namedWindow(strWindowName.c_str(), 0);
+		cv::imshow(strWindowName.c_str(), m_cvMatShow);
+	}
+	cv::waitKey(0);
+
+	if (bIsDestroyWindow)
+	{
+		cv::destroyWindow(strWindowName.c_str());
+	}
+}
+
 void CCvMethod::MouseTipCallback(int nEventID, int nRowIdx, int nColIdx, int flags, void *param)
 {
 }
\ No newline at end of file
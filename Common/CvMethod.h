@@ -19,6 +19,7 @@
 #include "opencv2/highgui/highgui.hpp"
 
 #include "MacroDeclSpec.h"
+#include "WindowLevel.h"
 
 /* enum */
 //enum 
@@ -59,6 +60,21 @@ public:
 	*/
 	void ShowImage(std::string strWindowName, char* pImgPtr, int nImgHeight, int nImgWidth, size_t unImgType, bool bIsDestroyWindow = true);
 
+	/*
+	 * @brief	show 16-bit image with given window, mapped through the lookup table of CWindowLevel
+	 * @param	strWindowName : window's name
+	 * @param	pImgPtr: image pointer
+	 * @param	nImgHeight
+	 * @param	nImgWidth
+	 * @param	fWindowCenter
+	 * @param	fWindowWidth: at least 1
+	 * @param	unBitDepth: stored bits of pixels
+	 * @param	bIsDestroyWindow: whether to destroy the pop-up
+	 * @return	void
+	*/
+	void ShowImage(std::string strWindowName, const unsigned short* pImgPtr, int nImgHeight, int nImgWidth, float fWindowCenter, float fWindowWidth,
+		unsigned int unBitDepth = 16, bool bIsDestroyWindow = true);
+
 private:
 	/*
 	 * @brief	constructor
@@ -92,6 +108,10 @@ private:
 
 	cv::Point m_cvMouseCoord;
 
+	CWindowLevel m_oWindowLevel;	///< table kept while the window does not change
+
+	cv::Mat m_cvMatShow;			///< 8-bit display buffer, reused while the size does not change
+
 	static CCvMethod* m_pInstance;
 	static CGarbo m_oGarbo;
 };
@@ -0,0 +1,404 @@
+/***************************************************
+ * @file		DefectCorrection.cpp
+ * @section		Common
+ * @class		CDefectCorrection
+ * @brief		replacement of defective detector pixels, rows and columns by interpolation from good neighbours
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#include <algorithm>
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "DefectCorrection.h"
+#include "ImageFilter.h"
+#include "IntlMsgAliasID.h"
+
+using namespace std;
+
+/*
+ * @brief	constructor
+*/
+CDefectCorrection::CDefectCorrection()
+{
+	m_usHeight = 0;
+	m_usWidth = 0;
+	m_unNumUnresolved = 0;
+}
+
+/*
+ * @brief	destructor
+*/
+CDefectCorrection::~CDefectCorrection()
+{
+}
+
+/*
+ * @brief	correct a frame in place, pixels first, then rows, then columns
+ * @param	pFrame: height x width pixels of the compiled map
+ * @return	error code
+*/
+int CDefectCorrection::Apply(unsigned short* pFrame) const
+{
+	if (nullptr == pFrame || 0 == m_usHeight)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	// neighbours are never defective, so pixels do not depend on each other
+	for (size_t unDefectIdx = 0; unDefectIdx < m_vecPixelIdx.size(); unDefectIdx++)
+	{
+		unsigned short* pPixel = pFrame + m_vecPixelIdx[unDefectIdx];
+		float fValue = 0.5f;
+		for (unsigned int unIdx = m_vecNeighbourBegin[unDefectIdx]; unIdx < m_vecNeighbourBegin[unDefectIdx + 1]; unIdx++)
+		{
+			fValue += m_vecNeighbourWeight[unIdx] * pPixel[m_vecNeighbourOffset[unIdx]];
+		}
+		*pPixel = (unsigned short)fValue;
+	}
+
+	// rows blend two good rows with SIMD over their extent
+	vector<float> vecBefore(m_usWidth);
+	vector<float> vecAfter(m_usWidth);
+	for (size_t unLineIdx = 0; unLineIdx < m_vecBadRows.size(); unLineIdx++)
+	{
+		const DefectLine& oRow = m_vecBadRows[unLineIdx];
+		size_t unLen = oRow.usLast - oRow.usFirst + 1;
+		LoadFilterRow(pFrame + (size_t)oRow.usBefore * m_usWidth + oRow.usFirst, unLen, vecBefore.data());
+		LoadFilterRow(pFrame + (size_t)oRow.usAfter * m_usWidth + oRow.usFirst, unLen, vecAfter.data());
+		for (size_t unIdx = 0; unIdx < unLen; unIdx++)
+		{
+			vecBefore[unIdx] *= oRow.fWeightBefore;
+		}
+		AccumulateScaledRow(vecAfter.data(), unLen, 1.0f - oRow.fWeightBefore, vecBefore.data());
+		StoreFilterRow(vecBefore.data(), unLen, pFrame + (size_t)oRow.usIdx * m_usWidth + oRow.usFirst);
+	}
+
+	// columns are strided, all bad columns of a row are corrected while the row is in cache
+	if (!m_vecBadColumns.empty())
+	{
+		for (unsigned short usRowIdx = 0; usRowIdx < m_usHeight; usRowIdx++)
+		{
+			unsigned short* pRow = pFrame + (size_t)usRowIdx * m_usWidth;
+			for (size_t unLineIdx = 0; unLineIdx < m_vecBadColumns.size(); unLineIdx++)
+			{
+				const DefectLine& oColumn = m_vecBadColumns[unLineIdx];
+				if (usRowIdx < oColumn.usFirst || usRowIdx > oColumn.usLast)
+				{
+					continue;
+				}
+
+				float fValue = oColumn.fWeightBefore * pRow[oColumn.usBefore] + (1.0f - oColumn.fWeightBefore) * pRow[oColumn.usAfter];
+				pRow[oColumn.usIdx] = (unsigned short)(fValue + 0.5f);
+			}
+		}
+	}
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	compile a defect map. rows and columns with at least fLineFraction defective pixels become line defects,
+ *			other defective pixels take the inverse distance weighted mean of the good pixels in the nearest ring holding any
+ * @param	pDefectMap: height x width, non zero for defective pixels
+ * @param	usHeight
+ * @param	usWidth
+ * @param	fLineFraction: in (0, 1]
+ * @return	error code
+*/
+int CDefectCorrection::Compile(const unsigned char* pDefectMap, unsigned short usHeight, unsigned short usWidth, float fLineFraction)
+{
+	if (nullptr == pDefectMap || 0 == usHeight || 0 == usWidth || !(fLineFraction > 0 && fLineFraction <= 1))
+	{
+		return INVALID_PARAMETER;
+	}
+
+	m_usHeight = usHeight;
+	m_usWidth = usWidth;
+
+	// line defects
+	vector<unsigned int> vecRowCount(usHeight, 0);
+	vector<unsigned int> vecColumnCount(usWidth, 0);
+	for (unsigned short usRowIdx = 0; usRowIdx < usHeight; usRowIdx++)
+	{
+		for (unsigned short usColIdx = 0; usColIdx < usWidth; usColIdx++)
+		{
+			if (0 != pDefectMap[(size_t)usRowIdx * usWidth + usColIdx])
+			{
+				vecRowCount[usRowIdx]++;
+				vecColumnCount[usColIdx]++;
+			}
+		}
+	}
+
+	vector<bool> vecIsBadRow(usHeight);
+	vector<bool> vecIsBadColumn(usWidth);
+	for (unsigned short usRowIdx = 0; usRowIdx < usHeight; usRowIdx++)
+	{
+		vecIsBadRow[usRowIdx] = vecRowCount[usRowIdx] >= fLineFraction * usWidth;
+	}
+	for (unsigned short usColIdx = 0; usColIdx < usWidth; usColIdx++)
+	{
+		vecIsBadColumn[usColIdx] = vecColumnCount[usColIdx] >= fLineFraction * usHeight;
+	}
+
+	// without any good line, line defects fall back to pixel defects
+	PlanLines(vecIsBadRow, usWidth, m_vecBadRows);
+	PlanLines(vecIsBadColumn, usHeight, m_vecBadColumns);
+	if (m_vecBadRows.empty())
+	{
+		vecIsBadRow.assign(usHeight, false);
+	}
+	if (m_vecBadColumns.empty())
+	{
+		vecIsBadColumn.assign(usWidth, false);
+	}
+
+	vector<bool> vecIsOnLine((size_t)usHeight * usWidth);
+	for (unsigned short usRowIdx = 0; usRowIdx < usHeight; usRowIdx++)
+	{
+		for (unsigned short usColIdx = 0; usColIdx < usWidth; usColIdx++)
+		{
+			vecIsOnLine[(size_t)usRowIdx * usWidth + usColIdx] = vecIsBadRow[usRowIdx] || vecIsBadColumn[usColIdx];
+		}
+	}
+	PlanPixels(pDefectMap, vecIsOnLine);
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	compile labeled defects, e.g. from LabelDefectClusters. ShapeLine clusters become line defects over the extent of
+ *			their bounding box, interpolated between the rows or columns just outside it, other clusters are pixel defects
+ * @param	vecLabels: height x width, 0 for good pixels, cluster index + 1 otherwise
+ * @param	vecClusters
+ * @param	usHeight
+ * @param	usWidth
+ * @return	error code
+*/
+int CDefectCorrection::Compile(const std::vector<unsigned int>& vecLabels, const std::vector<DefectCluster>& vecClusters, unsigned short usHeight, unsigned short usWidth)
+{
+	size_t unNumPixels = (size_t)usHeight * usWidth;
+	if (0 == unNumPixels || vecLabels.size() != unNumPixels)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	m_usHeight = usHeight;
+	m_usWidth = usWidth;
+	m_vecBadRows.clear();
+	m_vecBadColumns.clear();
+
+	// segments of line clusters, between the lines just outside the bounding box
+	vector<bool> vecIsLineCluster(vecClusters.size(), false);
+	for (size_t unClusterIdx = 0; unClusterIdx < vecClusters.size(); unClusterIdx++)
+	{
+		const DefectCluster& oCluster = vecClusters[unClusterIdx];
+		if (ShapeLine != oCluster.nShape || oCluster.usBottom >= usHeight || oCluster.usRight >= usWidth)
+		{
+			continue;
+		}
+
+		bool isRow = oCluster.usRight - oCluster.usLeft >= oCluster.usBottom - oCluster.usTop;
+		int nFirstLine = isRow ? oCluster.usTop : oCluster.usLeft;
+		int nLastLine = isRow ? oCluster.usBottom : oCluster.usRight;
+		int nNumLines = isRow ? usHeight : usWidth;
+		int nBefore = nFirstLine - 1;
+		int nAfter = nLastLine + 1;
+
+		// a segment touching both borders has nothing to interpolate from, its pixels stay pixel defects
+		if (nBefore < 0 && nAfter >= nNumLines)
+		{
+			continue;
+		}
+
+		vecIsLineCluster[unClusterIdx] = true;
+		vector<DefectLine>& vecLines = isRow ? m_vecBadRows : m_vecBadColumns;
+		for (int nLineIdx = nFirstLine; nLineIdx <= nLastLine; nLineIdx++)
+		{
+			DefectLine oLine;
+			oLine.usIdx = (unsigned short)nLineIdx;
+			oLine.usFirst = isRow ? oCluster.usLeft : oCluster.usTop;
+			oLine.usLast = isRow ? oCluster.usRight : oCluster.usBottom;
+			oLine.usBefore = (unsigned short)(nBefore < 0 ? nAfter : nBefore);
+			oLine.usAfter = (unsigned short)(nAfter >= nNumLines ? nBefore : nAfter);
+			oLine.fWeightBefore = nBefore < 0 ? 0 : (nAfter >= nNumLines ? 1.0f : (float)(nAfter - nLineIdx) / (nAfter - nBefore));
+			vecLines.push_back(oLine);
+		}
+	}
+
+	auto funcLineOrder = [](const DefectLine& oLeft, const DefectLine& oRight)
+	{
+		return oLeft.usIdx != oRight.usIdx ? oLeft.usIdx < oRight.usIdx : oLeft.usFirst < oRight.usFirst;
+	};
+	sort(m_vecBadRows.begin(), m_vecBadRows.end(), funcLineOrder);
+	sort(m_vecBadColumns.begin(), m_vecBadColumns.end(), funcLineOrder);
+
+	vector<unsigned char> vecDefectMap(unNumPixels, 0);
+	vector<bool> vecIsOnLine(unNumPixels, false);
+	for (size_t unIdx = 0; unIdx < unNumPixels; unIdx++)
+	{
+		unsigned int unLabel = vecLabels[unIdx];
+		if (0 == unLabel || unLabel > vecClusters.size())
+		{
+			continue;
+		}
+
+		vecDefectMap[unIdx] = 1;
+		vecIsOnLine[unIdx] = vecIsLineCluster[unLabel - 1];
+	}
+	PlanPixels(vecDefectMap.data(), vecIsOnLine);
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	defective columns of the plan
+ * @return	columns sorted by index
+*/
+const std::vector<DefectLine>& CDefectCorrection::GetBadColumns() const
+{
+	return m_vecBadColumns;
+}
+
+/*
+ * @brief	defective rows of the plan
+ * @return	rows sorted by index
+*/
+const std::vector<DefectLine>& CDefectCorrection::GetBadRows() const
+{
+	return m_vecBadRows;
+}
+
+/*
+ * @brief	defective pixels corrected from their neighbours, pixels of bad lines excluded
+ * @return	number of pixels
+*/
+size_t CDefectCorrection::GetNumDefectPixels() const
+{
+	return m_vecPixelIdx.size();
+}
+
+/*
+ * @brief	defective pixels without any good pixel within DEFECT_MAX_RADIUS, left untouched
+ * @return	number of pixels
+*/
+size_t CDefectCorrection::GetNumUnresolved() const
+{
+	return m_unNumUnresolved;
+}
+
+/*
+ * @brief	nearest good lines around each bad line
+ * @param	vecIsBad: one flag per line
+ * @param	usLength: pixels of each line
+ * @param	vecLines: output
+*/
+void CDefectCorrection::PlanLines(const std::vector<bool>& vecIsBad, unsigned short usLength, std::vector<DefectLine>& vecLines)
+{
+	vecLines.clear();
+
+	int nNumLines = (int)vecIsBad.size();
+	int nBefore = -1;
+	for (int nLineIdx = 0; nLineIdx < nNumLines; nLineIdx++)
+	{
+		if (!vecIsBad[nLineIdx])
+		{
+			nBefore = nLineIdx;
+			continue;
+		}
+
+		int nAfter = nLineIdx + 1;
+		while (nAfter < nNumLines && vecIsBad[nAfter])
+		{
+			nAfter++;
+		}
+
+		// all lines bad, nothing to interpolate from
+		if (-1 == nBefore && nNumLines == nAfter)
+		{
+			vecLines.clear();
+			return;
+		}
+
+		DefectLine oLine;
+		oLine.usIdx = (unsigned short)nLineIdx;
+		oLine.usFirst = 0;
+		oLine.usLast = usLength - 1;
+		oLine.usBefore = (unsigned short)(-1 == nBefore ? nAfter : nBefore);
+		oLine.usAfter = (unsigned short)(nNumLines == nAfter ? nBefore : nAfter);
+		oLine.fWeightBefore = -1 == nBefore ? 0 : (nNumLines == nAfter ? 1.0f : (float)(nAfter - nLineIdx) / (nAfter - nBefore));
+		vecLines.push_back(oLine);
+	}
+}
+
+/*
+ * @brief	neighbours and weights of defective pixels not corrected by lines
+ * @param	pDefectMap: height x width, non zero for defective pixels
+ * @param	vecIsOnLine: height x width, pixels corrected by lines, neither planned nor used as neighbours
+*/
+void CDefectCorrection::PlanPixels(const unsigned char* pDefectMap, const std::vector<bool>& vecIsOnLine)
+{
+	unsigned short usHeight = m_usHeight;
+	unsigned short usWidth = m_usWidth;
+	m_unNumUnresolved = 0;
+	m_vecPixelIdx.clear();
+	m_vecNeighbourBegin.assign(1, 0);
+	m_vecNeighbourOffset.clear();
+	m_vecNeighbourWeight.clear();
+
+	// pixel defects, scanned in memory order so the plan is sorted
+	auto funcIsGood = [&](int nRowIdx, int nColIdx)
+	{
+		return nRowIdx >= 0 && nRowIdx < usHeight && nColIdx >= 0 && nColIdx < usWidth && !vecIsOnLine[(size_t)nRowIdx * usWidth + nColIdx] &&
+			0 == pDefectMap[(size_t)nRowIdx * usWidth + nColIdx];
+	};
+
+	for (int nRowIdx = 0; nRowIdx < usHeight; nRowIdx++)
+	{
+		for (int nColIdx = 0; nColIdx < usWidth; nColIdx++)
+		{
+			if (0 == pDefectMap[(size_t)nRowIdx * usWidth + nColIdx] || vecIsOnLine[(size_t)nRowIdx * usWidth + nColIdx])
+			{
+				continue;
+			}
+
+			size_t unFirst = m_vecNeighbourOffset.size();
+			for (int nRadius = 1; nRadius <= DEFECT_MAX_RADIUS && unFirst == m_vecNeighbourOffset.size(); nRadius++)
+			{
+				float fSum = 0;
+				for (int nDeltaY = -nRadius; nDeltaY <= nRadius; nDeltaY++)
+				{
+					for (int nDeltaX = -nRadius; nDeltaX <= nRadius; nDeltaX++)
+					{
+						if (funcIsGood(nRowIdx + nDeltaY, nColIdx + nDeltaX) && max(abs(nDeltaY), abs(nDeltaX)) == nRadius)
+						{
+							float fWeight = 1.0f / sqrt((float)(nDeltaY * nDeltaY + nDeltaX * nDeltaX));
+							m_vecNeighbourOffset.push_back(nDeltaY * usWidth + nDeltaX);
+							m_vecNeighbourWeight.push_back(fWeight);
+							fSum += fWeight;
+						}
+					}
+				}
+
+				for (size_t unIdx = unFirst; unIdx < m_vecNeighbourWeight.size(); unIdx++)
+				{
+					m_vecNeighbourWeight[unIdx] /= fSum;
+				}
+			}
+
+			if (unFirst == m_vecNeighbourOffset.size())
+			{
+				m_unNumUnresolved++;
+				continue;
+			}
+
+			m_vecPixelIdx.push_back(nRowIdx * usWidth + nColIdx);
+			m_vecNeighbourBegin.push_back((unsigned int)m_vecNeighbourOffset.size());
+		}
+	}
+}
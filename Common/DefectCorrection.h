@@ -0,0 +1,147 @@
+/***************************************************
+ * @file		DefectCorrection.h
+ * @section		Common
+ * @class		CDefectCorrection
+ * @brief		replacement of defective detector pixels, rows and columns by interpolation from good neighbours
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#ifndef __DEFECT_CORRECTION_H__
+#define __DEFECT_CORRECTION_H__
+
+#include <vector>
+
+#include <stddef.h>
+
+#include "DefectDetection.h"
+#include "MacroDeclSpec.h"
+
+// farthest ring searched for good neighbours of a defective pixel
+#define DEFECT_MAX_RADIUS	3
+
+/* a defective row or column, or a segment of it, interpolated linearly between the nearest good ones */
+struct DefectLine
+{
+	unsigned short usIdx;
+	unsigned short usFirst;		///< first pixel along the line
+	unsigned short usLast;		///< last pixel along the line, inclusive
+	unsigned short usBefore;	///< nearest good line before, usAfter if none
+	unsigned short usAfter;		///< nearest good line after, usBefore if none
+	float fWeightBefore;		///< weight of usBefore, 1 - fWeightBefore for usAfter
+};
+
+/*
+ * @class	CDefectCorrection
+ * @brief	a defect map is compiled once into a plan: sorted defective pixels with offsets and weights of their good neighbours,
+ *			and lists of defective rows and columns. applying the plan touches defective pixels and their neighbours only
+*/
+class _DLL_EXPORT_ CDefectCorrection
+{
+public:
+	/*
+	 * @brief	constructor
+	*/
+	CDefectCorrection();
+
+	/*
+	 * @brief	destructor
+	*/
+	~CDefectCorrection();
+
+	/*
+	 * @brief	correct a frame in place, pixels first, then rows, then columns
+	 * @param	pFrame: height x width pixels of the compiled map
+	 * @return	error code
+	*/
+	int Apply(unsigned short* pFrame) const;
+
+	/*
+	 * @brief	compile a defect map. rows and columns with at least fLineFraction defective pixels become line defects,
+	 *			other defective pixels take the inverse distance weighted mean of the good pixels in the nearest ring holding any
+	 * @param	pDefectMap: height x width, non zero for defective pixels
+	 * @param	usHeight
+	 * @param	usWidth
+	 * @param	fLineFraction: in (0, 1]
+	 * @return	error code
+	*/
+	int Compile(const unsigned char* pDefectMap, unsigned short usHeight, unsigned short usWidth, float fLineFraction = 0.5f);
+
+	/*
+	 * @brief	compile labeled defects, e.g. from LabelDefectClusters. ShapeLine clusters become line defects over the extent of
+	 *			their bounding box, interpolated between the rows or columns just outside it, other clusters are pixel defects
+	 * @param	vecLabels: height x width, 0 for good pixels, cluster index + 1 otherwise
+	 * @param	vecClusters
+	 * @param	usHeight
+	 * @param	usWidth
+	 * @return	error code
+	*/
+	int Compile(const std::vector<unsigned int>& vecLabels, const std::vector<DefectCluster>& vecClusters, unsigned short usHeight, unsigned short usWidth);
+
+	/*
+	 * @brief	defective columns of the plan, whole or segments
+	 * @return	columns sorted by index, then first row
+	*/
+	const std::vector<DefectLine>& GetBadColumns() const;
+
+	/*
+	 * @brief	defective rows of the plan, whole or segments
+	 * @return	rows sorted by index, then first column
+	*/
+	const std::vector<DefectLine>& GetBadRows() const;
+
+	/*
+	 * @brief	defective pixels corrected from their neighbours, pixels of bad lines excluded
+	 * @return	number of pixels
+	*/
+	size_t GetNumDefectPixels() const;
+
+	/*
+	 * @brief	defective pixels without any good pixel within DEFECT_MAX_RADIUS, left untouched
+	 * @return	number of pixels
+	*/
+	size_t GetNumUnresolved() const;
+
+private:
+	/*
+	 * @brief	nearest good lines around each bad line
+	 * @param	vecIsBad: one flag per line
+	 * @param	usLength: pixels of each line
+	 * @param	vecLines: output
+	*/
+	static void PlanLines(const std::vector<bool>& vecIsBad, unsigned short usLength, std::vector<DefectLine>& vecLines);
+
+	/*
+	 * @brief	neighbours and weights of defective pixels not corrected by lines
+	 * @param	pDefectMap: height x width, non zero for defective pixels
+	 * @param	vecIsOnLine: height x width, pixels corrected by lines, neither planned nor used as neighbours
+	*/
+	void PlanPixels(const unsigned char* pDefectMap, const std::vector<bool>& vecIsOnLine);
+
+	unsigned short m_usHeight;
+	unsigned short m_usWidth;
+
+	size_t m_unNumUnresolved;
+
+	std::vector<unsigned int> m_vecPixelIdx;			///< sorted defective pixels
+	std::vector<unsigned int> m_vecNeighbourBegin;		///< first neighbour of each pixel, one more entry than pixels
+	std::vector<int> m_vecNeighbourOffset;				///< relative to the defective pixel
+	std::vector<float> m_vecNeighbourWeight;			///< sum to 1 for each pixel
+
+	std::vector<DefectLine> m_vecBadRows;
+	std::vector<DefectLine> m_vecBadColumns;
+};
+
+//#ifdef __cplusplus
+//extern "C"
+//{
+//#endif // __cplusplus
+//
+//
+//#ifdef __cplusplus
+//};
+//#endif // __cplusplus
+
+#endif	// __DEFECT_CORRECTION_H__
@@ -0,0 +1,354 @@
+/***************************************************
+ * @file		DefectDetection.cpp
+ * @section		Common
+ * @class		N/A
+ * @brief		defect map from dark and flat statistics, defects grouped into single pixels, clusters and lines
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#include <algorithm>
+
+#include <math.h>
+
+#include "DefectDetection.h"
+#include "IntlMsgAliasID.h"
+#include "MacroSimd.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+// pixels sampled for robust statistics
+#define DEFECT_NUM_SAMPLES	65536
+
+// rows of maps tested by one task
+#define DEFECT_BAND_HEIGHT	32
+
+// smallest robust deviation, half a gray level. the deviation of integer valued maps is often 0, flagging every pixel off the median
+#define DEFECT_MIN_DEVIATION	0.5f
+
+/* thresholds of the outlier tests, a test is skipped when its map is nullptr */
+struct OutlierLimits
+{
+	float fDarkLow;
+	float fDarkHigh;
+	float fNoiseLow;
+	float fNoiseHigh;
+	float fResponseLow;
+	float fResponseHigh;
+};
+
+/*
+ * @brief	root of a provisional label, halving the path on the way
+ * @param	vecParents
+ * @param	unLabel
+ * @return	root label
+*/
+static unsigned int FindRoot(std::vector<unsigned int>& vecParents, unsigned int unLabel)
+{
+	while (vecParents[unLabel] != unLabel)
+	{
+		vecParents[unLabel] = vecParents[vecParents[unLabel]];
+		unLabel = vecParents[unLabel];
+	}
+
+	return unLabel;
+}
+
+/*
+ * @brief	median and median absolute deviation of a subsample of values
+ * @param	pValues
+ * @param	unNumValues
+ * @param	fMedian: output
+ * @param	fDeviation: output, scaled to a standard deviation for gaussian values, at least DEFECT_MIN_DEVIATION
+*/
+static void GetRobustStatistics(const float* pValues, size_t unNumValues, float& fMedian, float& fDeviation)
+{
+	size_t unStep = max((size_t)1, unNumValues / DEFECT_NUM_SAMPLES);
+	vector<float> vecSamples;
+	for (size_t unIdx = 0; unIdx < unNumValues; unIdx += unStep)
+	{
+		vecSamples.push_back(pValues[unIdx]);
+	}
+
+	size_t unMiddle = vecSamples.size() / 2;
+	nth_element(vecSamples.begin(), vecSamples.begin() + unMiddle, vecSamples.end());
+	fMedian = vecSamples[unMiddle];
+
+	for (size_t unIdx = 0; unIdx < vecSamples.size(); unIdx++)
+	{
+		vecSamples[unIdx] = fabs(vecSamples[unIdx] - fMedian);
+	}
+	nth_element(vecSamples.begin(), vecSamples.begin() + unMiddle, vecSamples.end());
+	fDeviation = max(1.4826f * vecSamples[unMiddle], DEFECT_MIN_DEVIATION);
+}
+
+/*
+ * @brief	flag outliers of a run of pixels
+ * @param	pDarkMean: nullable
+ * @param	pDarkNoise: nullable
+ * @param	pFlatMean: nullable
+ * @param	unLen
+ * @param	oLimits
+ * @param	pDefectMap: output
+*/
+static void FlagOutliers(const float* pDarkMean, const float* pDarkNoise, const float* pFlatMean, size_t unLen, const OutlierLimits& oLimits, unsigned char* pDefectMap)
+{
+	size_t unIdx = 0;
+
+#ifdef _SIMD_SSE2_
+	__m128 fDarkLow = _mm_set1_ps(oLimits.fDarkLow);
+	__m128 fDarkHigh = _mm_set1_ps(oLimits.fDarkHigh);
+	__m128 fNoiseLow = _mm_set1_ps(oLimits.fNoiseLow);
+	__m128 fNoiseHigh = _mm_set1_ps(oLimits.fNoiseHigh);
+	__m128 fResponseLow = _mm_set1_ps(oLimits.fResponseLow);
+	__m128 fResponseHigh = _mm_set1_ps(oLimits.fResponseHigh);
+	for (; unIdx + 8 <= unLen; unIdx += 8)
+	{
+		__m128i nFlags[2];
+		for (size_t unHalf = 0; unHalf < 2; unHalf++)
+		{
+			size_t unFirst = unIdx + 4 * unHalf;
+			__m128i nFlag = _mm_setzero_si128();
+
+			// comparisons give all ones lanes, masked down to the bit of each test
+			if (nullptr != pDarkMean)
+			{
+				__m128 fDark = _mm_loadu_ps(pDarkMean + unFirst);
+				__m128 fOutside = _mm_or_ps(_mm_cmplt_ps(fDark, fDarkLow), _mm_cmpgt_ps(fDark, fDarkHigh));
+				nFlag = _mm_or_si128(nFlag, _mm_and_si128(_mm_castps_si128(fOutside), _mm_set1_epi32(DEFECT_DARK_OUTLIER)));
+
+				if (nullptr != pFlatMean)
+				{
+					__m128 fResponse = _mm_sub_ps(_mm_loadu_ps(pFlatMean + unFirst), fDark);
+					fOutside = _mm_or_ps(_mm_cmplt_ps(fResponse, fResponseLow), _mm_cmpgt_ps(fResponse, fResponseHigh));
+					nFlag = _mm_or_si128(nFlag, _mm_and_si128(_mm_castps_si128(fOutside), _mm_set1_epi32(DEFECT_GAIN_OUTLIER)));
+				}
+			}
+
+			if (nullptr != pDarkNoise)
+			{
+				__m128 fNoise = _mm_loadu_ps(pDarkNoise + unFirst);
+				__m128 fOutside = _mm_or_ps(_mm_cmplt_ps(fNoise, fNoiseLow), _mm_cmpgt_ps(fNoise, fNoiseHigh));
+				nFlag = _mm_or_si128(nFlag, _mm_and_si128(_mm_castps_si128(fOutside), _mm_set1_epi32(DEFECT_NOISE_OUTLIER)));
+			}
+
+			nFlags[unHalf] = nFlag;
+		}
+
+		__m128i nPacked = _mm_packs_epi32(nFlags[0], nFlags[1]);
+		_mm_storel_epi64((__m128i*)(pDefectMap + unIdx), _mm_packus_epi16(nPacked, nPacked));
+	}
+#endif	// _SIMD_SSE2_
+
+	for (; unIdx < unLen; unIdx++)
+	{
+		unsigned char ucFlag = 0;
+		if (nullptr != pDarkMean)
+		{
+			ucFlag |= pDarkMean[unIdx] < oLimits.fDarkLow || pDarkMean[unIdx] > oLimits.fDarkHigh ? DEFECT_DARK_OUTLIER : 0;
+			if (nullptr != pFlatMean)
+			{
+				float fResponse = pFlatMean[unIdx] - pDarkMean[unIdx];
+				ucFlag |= fResponse < oLimits.fResponseLow || fResponse > oLimits.fResponseHigh ? DEFECT_GAIN_OUTLIER : 0;
+			}
+		}
+
+		if (nullptr != pDarkNoise)
+		{
+			ucFlag |= pDarkNoise[unIdx] < oLimits.fNoiseLow || pDarkNoise[unIdx] > oLimits.fNoiseHigh ? DEFECT_NOISE_OUTLIER : 0;
+		}
+
+		pDefectMap[unIdx] = ucFlag;
+	}
+}
+
+/*
+ * @brief	flag pixels whose calibration statistics are outliers with respect to the whole detector, robust statistics
+ *			(median and median absolute deviation) are estimated on a subsample. nullptr maps skip their test
+ * @param	pDarkMean: height x width, mean of dark frames, flagged beyond fOutlierSigma robust sigmas from the median
+ * @param	pDarkNoise: height x width, temporal noise of dark frames, flagged above or below the median by fNoiseFactor times
+ * @param	pFlatMean: height x width, mean of flat frames, response flat - dark flagged beyond fGainTolerance of its median, needs pDarkMean
+ * @param	usHeight
+ * @param	usWidth
+ * @param	pDefectMap: output, height x width, or of DEFECT_XXX_OUTLIER, 0 for good pixels
+ * @param	fOutlierSigma
+ * @param	fNoiseFactor: > 1
+ * @param	fGainTolerance: in (0, 1)
+ * @return	error code
+*/
+int DetectDefectPixels(const float* pDarkMean, const float* pDarkNoise, const float* pFlatMean, unsigned short usHeight, unsigned short usWidth, unsigned char* pDefectMap,
+	float fOutlierSigma, float fNoiseFactor, float fGainTolerance)
+{
+	size_t unNumPixels = (size_t)usHeight * usWidth;
+	if (nullptr == pDefectMap || 0 == unNumPixels || (nullptr != pFlatMean && nullptr == pDarkMean) || !(fOutlierSigma > 0) || !(fNoiseFactor > 1) ||
+		!(fGainTolerance > 0 && fGainTolerance < 1))
+	{
+		return INVALID_PARAMETER;
+	}
+
+	OutlierLimits oLimits = {0, 0, 0, 0, 0, 0};
+	float fMedian = 0;
+	float fDeviation = 0;
+	if (nullptr != pDarkMean)
+	{
+		GetRobustStatistics(pDarkMean, unNumPixels, fMedian, fDeviation);
+		oLimits.fDarkLow = fMedian - fOutlierSigma * fDeviation;
+		oLimits.fDarkHigh = fMedian + fOutlierSigma * fDeviation;
+	}
+
+	if (nullptr != pDarkNoise)
+	{
+		GetRobustStatistics(pDarkNoise, unNumPixels, fMedian, fDeviation);
+		oLimits.fNoiseLow = fMedian / fNoiseFactor;
+		oLimits.fNoiseHigh = fMedian * fNoiseFactor;
+	}
+
+	if (nullptr != pFlatMean)
+	{
+		vector<float> vecResponse(min(unNumPixels, (size_t)DEFECT_NUM_SAMPLES));
+		size_t unStep = unNumPixels / vecResponse.size();
+		for (size_t unIdx = 0; unIdx < vecResponse.size(); unIdx++)
+		{
+			vecResponse[unIdx] = pFlatMean[unIdx * unStep] - pDarkMean[unIdx * unStep];
+		}
+
+		GetRobustStatistics(vecResponse.data(), vecResponse.size(), fMedian, fDeviation);
+		oLimits.fResponseLow = fMedian * (1 - fGainTolerance);
+		oLimits.fResponseHigh = fMedian * (1 + fGainTolerance);
+	}
+
+	size_t unWidth = usWidth;
+	CThreadPool::GetInstance()->ParallelFor(usHeight, [&](size_t unBegin, size_t unEnd)
+	{
+		size_t unFirst = unBegin * unWidth;
+		FlagOutliers(nullptr == pDarkMean ? nullptr : pDarkMean + unFirst, nullptr == pDarkNoise ? nullptr : pDarkNoise + unFirst,
+			nullptr == pFlatMean ? nullptr : pFlatMean + unFirst, (unEnd - unBegin) * unWidth, oLimits, pDefectMap + unFirst);
+	}, DEFECT_BAND_HEIGHT);
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	label connected defects with union-find and classify each group
+ * @param	pDefectMap: height x width, non zero for defective pixels
+ * @param	usHeight
+ * @param	usWidth
+ * @param	vecLabels: output, height x width, 0 for good pixels, cluster index + 1 otherwise
+ * @param	vecClusters: output, ordered by first pixel in memory
+ * @param	usMinLineLength: shortest group classified as a line
+ * @return	error code
+*/
+int LabelDefectClusters(const unsigned char* pDefectMap, unsigned short usHeight, unsigned short usWidth, std::vector<unsigned int>& vecLabels,
+	std::vector<DefectCluster>& vecClusters, unsigned short usMinLineLength)
+{
+	size_t unNumPixels = (size_t)usHeight * usWidth;
+	if (nullptr == pDefectMap || 0 == unNumPixels)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	vecLabels.assign(unNumPixels, 0);
+	vecClusters.clear();
+
+	// first pass, provisional labels from the 4 neighbours already visited, equivalences merged in the forest
+	vector<unsigned int> vecParents(1, 0);
+	for (int nRowIdx = 0; nRowIdx < usHeight; nRowIdx++)
+	{
+		const unsigned char* pRow = pDefectMap + (size_t)nRowIdx * usWidth;
+		unsigned int* pLabelRow = vecLabels.data() + (size_t)nRowIdx * usWidth;
+		for (int nColIdx = 0; nColIdx < usWidth; nColIdx++)
+		{
+			if (0 == pRow[nColIdx])
+			{
+				continue;
+			}
+
+			unsigned int unNeighbours[4] = {
+				nColIdx > 0 ? pLabelRow[nColIdx - 1] : 0,
+				nRowIdx > 0 && nColIdx > 0 ? pLabelRow[nColIdx - 1 - usWidth] : 0,
+				nRowIdx > 0 ? pLabelRow[nColIdx - usWidth] : 0,
+				nRowIdx > 0 && nColIdx + 1 < usWidth ? pLabelRow[nColIdx + 1 - usWidth] : 0
+			};
+
+			unsigned int unLabel = 0;
+			for (size_t unIdx = 0; unIdx < 4; unIdx++)
+			{
+				if (0 == unNeighbours[unIdx])
+				{
+					continue;
+				}
+
+				unsigned int unRoot = FindRoot(vecParents, unNeighbours[unIdx]);
+				if (0 == unLabel)
+				{
+					unLabel = unRoot;
+				}
+				else if (unRoot != unLabel)
+				{
+					// the smaller label stays root so that roots keep the memory order of first pixels
+					vecParents[max(unRoot, unLabel)] = min(unRoot, unLabel);
+					unLabel = min(unRoot, unLabel);
+				}
+			}
+
+			if (0 == unLabel)
+			{
+				unLabel = (unsigned int)vecParents.size();
+				vecParents.push_back(unLabel);
+			}
+
+			pLabelRow[nColIdx] = unLabel;
+		}
+	}
+
+	// second pass, roots renumbered to cluster index + 1
+	vector<unsigned int> vecFinal(vecParents.size(), 0);
+	for (size_t unIdx = 0; unIdx < unNumPixels; unIdx++)
+	{
+		if (0 == vecLabels[unIdx])
+		{
+			continue;
+		}
+
+		unsigned int unRoot = FindRoot(vecParents, vecLabels[unIdx]);
+		unsigned short usRowIdx = (unsigned short)(unIdx / usWidth);
+		unsigned short usColIdx = (unsigned short)(unIdx % usWidth);
+		if (0 == vecFinal[unRoot])
+		{
+			DefectCluster oCluster;
+			oCluster.unNumPixels = 0;
+			oCluster.usTop = oCluster.usBottom = usRowIdx;
+			oCluster.usLeft = oCluster.usRight = usColIdx;
+			oCluster.nShape = ShapeSingle;
+			vecClusters.push_back(oCluster);
+			vecFinal[unRoot] = (unsigned int)vecClusters.size();
+		}
+
+		DefectCluster& oCluster = vecClusters[vecFinal[unRoot] - 1];
+		oCluster.unNumPixels++;
+		oCluster.usBottom = usRowIdx;
+		oCluster.usLeft = min(oCluster.usLeft, usColIdx);
+		oCluster.usRight = max(oCluster.usRight, usColIdx);
+		vecLabels[unIdx] = vecFinal[unRoot];
+	}
+
+	for (size_t unIdx = 0; unIdx < vecClusters.size(); unIdx++)
+	{
+		DefectCluster& oCluster = vecClusters[unIdx];
+		unsigned int unHeight = oCluster.usBottom - oCluster.usTop + 1;
+		unsigned int unWidth = oCluster.usRight - oCluster.usLeft + 1;
+		if (min(unHeight, unWidth) <= 2 && max(unHeight, unWidth) >= usMinLineLength)
+		{
+			oCluster.nShape = ShapeLine;
+		}
+		else if (oCluster.unNumPixels > 1)
+		{
+			oCluster.nShape = ShapeCluster;
+		}
+	}
+
+	return STATUS_OK;
+}
@@ -0,0 +1,83 @@
+/***************************************************
+ * @file		DefectDetection.h
+ * @section		Common
+ * @class		N/A
+ * @brief		defect map from dark and flat statistics, defects grouped into single pixels, clusters and lines
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#ifndef __DEFECT_DETECTION_H__
+#define __DEFECT_DETECTION_H__
+
+#include <vector>
+
+#include "MacroDeclSpec.h"
+
+// reasons of a defect, or-ed in the defect map
+#define DEFECT_DARK_OUTLIER		0x01
+#define DEFECT_NOISE_OUTLIER	0x02
+#define DEFECT_GAIN_OUTLIER		0x04
+
+/* shape of a connected group of defects */
+enum DefectShape
+{
+	ShapeSingle,	///< isolated pixel
+	ShapeCluster,	///< several pixels
+	ShapeLine		///< at most 2 pixels thick and long, part of a row or a column
+};
+
+/* connected group of defects, 8-connectivity */
+struct DefectCluster
+{
+	unsigned int unNumPixels;
+	unsigned short usTop;
+	unsigned short usLeft;
+	unsigned short usBottom;	///< inclusive
+	unsigned short usRight;		///< inclusive
+	DefectShape nShape;
+};
+
+/*
+ * @brief	flag pixels whose calibration statistics are outliers with respect to the whole detector, robust statistics
+ *			(median and median absolute deviation) are estimated on a subsample. nullptr maps skip their test
+ * @param	pDarkMean: height x width, mean of dark frames, flagged beyond fOutlierSigma robust sigmas from the median
+ * @param	pDarkNoise: height x width, temporal noise of dark frames, flagged above or below the median by fNoiseFactor times
+ * @param	pFlatMean: height x width, mean of flat frames, response flat - dark flagged beyond fGainTolerance of its median, needs pDarkMean
+ * @param	usHeight
+ * @param	usWidth
+ * @param	pDefectMap: output, height x width, or of DEFECT_XXX_OUTLIER, 0 for good pixels
+ * @param	fOutlierSigma
+ * @param	fNoiseFactor: > 1
+ * @param	fGainTolerance: in (0, 1)
+ * @return	error code
+*/
+_DLL_EXPORT_ int DetectDefectPixels(const float* pDarkMean, const float* pDarkNoise, const float* pFlatMean, unsigned short usHeight, unsigned short usWidth, unsigned char* pDefectMap,
+	float fOutlierSigma = 6.0f, float fNoiseFactor = 3.0f, float fGainTolerance = 0.3f);
+
+/*
+ * @brief	label connected defects with union-find and classify each group
+ * @param	pDefectMap: height x width, non zero for defective pixels
+ * @param	usHeight
+ * @param	usWidth
+ * @param	vecLabels: output, height x width, 0 for good pixels, cluster index + 1 otherwise
+ * @param	vecClusters: output, ordered by first pixel in memory
+ * @param	usMinLineLength: shortest group classified as a line
+ * @return	error code
+*/
+_DLL_EXPORT_ int LabelDefectClusters(const unsigned char* pDefectMap, unsigned short usHeight, unsigned short usWidth, std::vector<unsigned int>& vecLabels,
+	std::vector<DefectCluster>& vecClusters, unsigned short usMinLineLength = 16);
+
+//#ifdef __cplusplus
+//extern "C"
+//{
+//#endif // __cplusplus
+//
+//
+//#ifdef __cplusplus
+//};
+//#endif // __cplusplus
+
+#endif	// __DEFECT_DETECTION_H__
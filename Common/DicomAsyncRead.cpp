@@ -0,0 +1,210 @@
+/***************************************************
+ * @file		DicomAsyncRead.cpp
+ * @section		Common
+ * @class		CDicomLoadRequest
+ * @brief		read dicom image asynchronously on the shared thread pool
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#include <mutex>
+#include <vector>
+
+#include <string.h>
+
+#include "DicomAsyncRead.h"
+#include "IntlMsgAliasID.h"
+
+using namespace std;
+
+// readers are reused, building the dictionary of CDicomRead is not free
+mutex m_oDicomReaderLock;
+vector<CDicomRead*> g_vecIdleDicomReaders;
+
+/*
+ * @brief	take an idle reader or create one
+ * @return	reader
+*/
+static CDicomRead* AcquireDicomReader()
+{
+	m_oDicomReaderLock.lock();
+	if (!g_vecIdleDicomReaders.empty())
+	{
+		CDicomRead* pReader = g_vecIdleDicomReaders.back();
+		g_vecIdleDicomReaders.pop_back();
+		m_oDicomReaderLock.unlock();
+
+		return pReader;
+	}
+	m_oDicomReaderLock.unlock();
+
+	return new CDicomRead();
+}
+
+/*
+ * @brief	give a reader back for later requests
+ * @param	pReader
+*/
+static void ReleaseDicomReader(CDicomRead* pReader)
+{
+	pReader->SetCancelFlag(nullptr);
+
+	lock_guard<mutex> oGuard(m_oDicomReaderLock);
+	g_vecIdleDicomReaders.push_back(pReader);
+}
+
+/*
+ * @brief	constructor, use GetInfoAndDataAsync to create and start a request
+*/
+CDicomLoadRequest::CDicomLoadRequest(std::string strFileName, char* pDataBuf, size_t unBuffLen, TaskPriority nPriority)
+{
+	m_isCancelled = false;
+	m_isFinished = false;
+
+	m_pDataBuf = pDataBuf;
+	m_unBuffLen = unBuffLen;
+	m_nPriority = nPriority;
+	m_strFileName = strFileName;
+
+	::memset(&m_oDcmInfo, 0, sizeof(DicomInfo));
+
+	m_oFuture = m_oPromise.get_future().share();
+}
+
+/*
+ * @brief	destructor
+*/
+CDicomLoadRequest::~CDicomLoadRequest()
+{
+}
+
+/*
+ * @brief	cancel the request, a running one stops after its current block
+*/
+void CDicomLoadRequest::Cancel()
+{
+	m_isCancelled = true;
+}
+
+/*
+ * @brief	future of error code
+ * @return	shared future
+*/
+std::shared_future<int> CDicomLoadRequest::GetFuture() const
+{
+	return m_oFuture;
+}
+
+/*
+ * @brief	image information, valid once the request is ready with STATUS_OK
+ * @return	dicom information
+*/
+const DicomInfo& CDicomLoadRequest::GetInfo() const
+{
+	return m_oDcmInfo;
+}
+
+/*
+ * @brief	priority the request was queued with
+ * @return	priority
+*/
+TaskPriority CDicomLoadRequest::GetPriority() const
+{
+	return m_nPriority;
+}
+
+/*
+ * @brief	whether Cancel() has been called
+ * @return	true if cancelled
+*/
+bool CDicomLoadRequest::IsCancelled() const
+{
+	return m_isCancelled.load();
+}
+
+/*
+ * @brief	whether the request has finished, successfully or not
+ * @return	true if finished
+*/
+bool CDicomLoadRequest::IsReady() const
+{
+	return m_oFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+/*
+ * @brief	block until the request finishes
+ * @return	error code, READ_CANCELLED if cancelled
+*/
+int CDicomLoadRequest::Wait() const
+{
+	return m_oFuture.get();
+}
+
+/*
+ * @brief	complete the request, only the first result is kept
+ * @param	nResult: error code
+*/
+void CDicomLoadRequest::Finish(int nResult)
+{
+	bool isFinished = false;
+	if (m_isFinished.compare_exchange_strong(isFinished, true))
+	{
+		m_oPromise.set_value(nResult);
+	}
+}
+
+/*
+ * @brief	load on worker thread
+*/
+void CDicomLoadRequest::Run()
+{
+	// cancelled while queued, the file is never opened
+	if (m_isCancelled.load())
+	{
+		Finish(READ_CANCELLED);
+		return;
+	}
+
+	CDicomRead* pReader = nullptr;
+	int nProcResult = READ_FILE_ERR;
+	try
+	{
+		pReader = AcquireDicomReader();
+		pReader->SetCancelFlag(&m_isCancelled);
+
+		nProcResult = pReader->GetInfoAndData(m_strFileName, &m_oDcmInfo, m_pDataBuf, m_unBuffLen);
+
+		ReleaseDicomReader(pReader);
+	}
+	catch (...)
+	{
+		// a reader interrupted by an exception may hold an open file, it is not reused
+		delete pReader;
+		nProcResult = READ_FILE_ERR;
+	}
+
+	Finish(nProcResult);
+}
+
+/*
+ * @brief	get image information and data from a dicom file without blocking the caller
+ * @param	strFileName
+ * @param	pDataBuf: buffer of image data, must stay valid until the request is ready
+ * @param	unBuffLen: size of buffer
+ * @param	nPriority: PriorityVisible for images on screen, PriorityBackground for prefetch
+ * @return	handle of the request
+*/
+std::shared_ptr<CDicomLoadRequest> GetInfoAndDataAsync(std::string strFileName, char* pDataBuf, size_t unBuffLen, TaskPriority nPriority)
+{
+	shared_ptr<CDicomLoadRequest> pRequest = make_shared<CDicomLoadRequest>(strFileName, pDataBuf, unBuffLen, nPriority);
+
+	// a task dropped by the pool without running still completes the request, as cancelled
+	shared_ptr<void> pFinisher(nullptr, [pRequest](void*) { pRequest->Finish(READ_CANCELLED); });
+
+	// the task holds a reference, so the handle may be dropped by the caller
+	CThreadPool::GetInstance()->Submit([pRequest, pFinisher]() { pRequest->Run(); }, nPriority);
+
+	return pRequest;
+}
@@ -0,0 +1,124 @@
+/***************************************************
+ * @file		DicomAsyncRead.h
+ * @section		Common
+ * @class		CDicomLoadRequest
+ * @brief		read dicom image asynchronously on the shared thread pool
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#ifndef __DICOM_ASYNC_READ_H__
+#define __DICOM_ASYNC_READ_H__
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <string>
+
+#include "DicomRead.h"
+#include "MacroDeclSpec.h"
+#include "ThreadPool.h"
+
+class CDicomLoadRequest;
+
+/*
+ * @brief	get image information and data from a dicom file without blocking the caller
+ * @param	strFileName
+ * @param	pDataBuf: buffer of image data, must stay valid until the request is ready
+ * @param	unBuffLen: size of buffer
+ * @param	nPriority: PriorityVisible for images on screen, PriorityBackground for prefetch
+ * @return	handle of the request
+*/
+_DLL_EXPORT_ std::shared_ptr<CDicomLoadRequest> GetInfoAndDataAsync(std::string strFileName, char* pDataBuf, size_t unBuffLen, TaskPriority nPriority = PriorityNormal);
+
+/*
+ * @class	CDicomLoadRequest
+ * @brief	handle of an asynchronous load, pDataBuf must stay valid until the request is ready
+*/
+class _DLL_EXPORT_ CDicomLoadRequest
+{
+public:
+	/*
+	 * @brief	constructor, use GetInfoAndDataAsync to create and start a request
+	*/
+	CDicomLoadRequest(std::string strFileName, char* pDataBuf, size_t unBuffLen, TaskPriority nPriority);
+
+	/*
+	 * @brief	destructor
+	*/
+	~CDicomLoadRequest();
+
+	/*
+	 * @brief	cancel the request, a running one stops after its current block
+	*/
+	void Cancel();
+
+	/*
+	 * @brief	future of error code
+	 * @return	shared future
+	*/
+	std::shared_future<int> GetFuture() const;
+
+	/*
+	 * @brief	image information, valid once the request is ready with STATUS_OK
+	 * @return	dicom information
+	*/
+	const DicomInfo& GetInfo() const;
+
+	/*
+	 * @brief	priority the request was queued with
+	 * @return	priority
+	*/
+	TaskPriority GetPriority() const;
+
+	/*
+	 * @brief	whether Cancel() has been called
+	 * @return	true if cancelled
+	*/
+	bool IsCancelled() const;
+
+	/*
+	 * @brief	whether the request has finished, successfully or not
+	 * @return	true if finished
+	*/
+	bool IsReady() const;
+
+	/*
+	 * @brief	block until the request finishes
+	 * @return	error code, READ_CANCELLED if cancelled
+	*/
+	int Wait() const;
+
+private:
+	friend std::shared_ptr<CDicomLoadRequest> GetInfoAndDataAsync(std::string strFileName, char* pDataBuf, size_t unBuffLen, TaskPriority nPriority);
+
+	/*
+	 * @brief	complete the request, only the first result is kept
+	 * @param	nResult: error code
+	*/
+	void Finish(int nResult);
+
+	/*
+	 * @brief	load on worker thread
+	*/
+	void Run();
+
+	std::atomic<bool> m_isCancelled;
+	std::atomic<bool> m_isFinished;		///< promise set, by Run or by a dropped task
+
+	char* m_pDataBuf;
+	size_t m_unBuffLen;
+
+	TaskPriority m_nPriority;
+
+	DicomInfo m_oDcmInfo;
+
+	std::string m_strFileName;
+
+	std::promise<int> m_oPromise;
+	std::shared_future<int> m_oFuture;
+};
+
+#endif	// __DICOM_ASYNC_READ_H__
@@ -0,0 +1,454 @@
+/***************************************************
+ * @file		DicomExport.cpp
+ * @section		Common
+ * @class		CDicomExport
+ * @brief		export dicom images to 16-bit png, tiff or raw in a three-stage pipeline
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#if (defined WIN32 || defined _WIN32 || defined _W64 || defined WINCE)
+#include <filesystem>
+namespace sf = std::tr2::sys;
+#else
+#include <experimental/filesystem>
+namespace sf = std::experimental::filesystem;
+#endif
+
+#include <thread>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "opencv/cv.h"
+#include "opencv2/highgui/highgui.hpp"
+#include "opencv2/imgproc/imgproc.hpp"
+
+#include "CommonMethod.h"
+#include "DicomExport.h"
+#include "DicomRead.h"
+#include "HiResTimer.h"
+#include "IntlMsgAliasID.h"
+#include "Logger.h"
+
+#define DEFAULT_MAX_IMAGE_BYTES	(4096 * 4096 * 2)
+#define DEFAULT_QUEUE_DEPTH		4
+
+using namespace std;
+
+/*
+ * @brief	an image travelling through the pipeline
+*/
+struct CDicomExport::ExportItem
+{
+	size_t unFileIdx;
+	vector<char>* pRawBuff;
+	DicomInfo oDcmInfo;
+	cv::Mat cvImage;
+};
+
+static const char* STAGE_NAMES[NumExportStages] = { "read", "convert", "write" };
+
+/*
+ * @brief	name of output file, index keeps files of different folders apart
+ * @param	strFileName: input file
+ * @param	unFileIdx: index of input file
+ * @param	nFormat: output format
+ * @return	name of output file without folder
+*/
+static string GetExportFileName(const string& strFileName, size_t unFileIdx, ExportFormat nFormat)
+{
+	size_t unNamePos = strFileName.find_last_of("/\\");
+	string strStem = string::npos == unNamePos ? strFileName : strFileName.substr(unNamePos + 1);
+
+	size_t unDotPos = strStem.find_last_of('.');
+	if (string::npos != unDotPos && unDotPos > 0)
+	{
+		strStem = strStem.substr(0, unDotPos);
+	}
+
+	string strIdx = to_string((unsigned long long)unFileIdx);
+	if (strIdx.size() < 6)
+	{
+		strIdx.insert(0, 6 - strIdx.size(), '0');
+	}
+	strIdx += "_";
+
+	switch (nFormat)
+	{
+	case ExportTiff16:
+		return strIdx + strStem + ".tif";
+	case ExportRaw:
+		return strIdx + strStem + ".raw";
+	default:
+		return strIdx + strStem + ".png";
+	}
+}
+
+/*
+ * @brief	constructor
+*/
+CDicomExport::CDicomExport()
+{
+	m_pFileNames = nullptr;
+	m_pFreeBuffers = nullptr;
+	m_pDecodedItems = nullptr;
+	m_pConvertedItems = nullptr;
+}
+
+/*
+ * @brief	destructor
+*/
+CDicomExport::~CDicomExport()
+{
+}
+
+/*
+ * @brief	default configuration, 2 readers, 1 converter per core, 2 writers, png output
+ * @param	oConfig
+*/
+void CDicomExport::GetDefaultConfig(ExportConfig& oConfig)
+{
+	unsigned int unNumCores = thread::hardware_concurrency();
+
+	oConfig.isWindowApplied = false;
+	oConfig.nPngCompression = 1;
+	oConfig.unNumWorkers[StageRead] = 2;
+	oConfig.unNumWorkers[StageConvert] = unNumCores > 0 ? unNumCores : 2;
+	oConfig.unNumWorkers[StageWrite] = 2;
+	oConfig.unQueueDepth = DEFAULT_QUEUE_DEPTH;
+	oConfig.unMaxImageBytes = DEFAULT_MAX_IMAGE_BYTES;
+	oConfig.usOutHeight = 0;
+	oConfig.usOutWidth = 0;
+	oConfig.nFormat = ExportPng16;
+	oConfig.strOutputFolder = "./export";
+}
+
+/*
+ * @brief	print throughput of each stage
+ * @param	oReport
+*/
+void CDicomExport::PrintReport(const ExportReport& oReport)
+{
+	double dWallSec = oReport.ullWallMicroSec / 1e6;
+	if (dWallSec <= 0)
+	{
+		dWallSec = 1e-6;
+	}
+
+	printf("%u file(s) exported, %u failed, %.3f s\n", oReport.unNumFiles - oReport.unNumFailed, oReport.unNumFailed, dWallSec);
+
+	for (int nStage = 0; nStage < NumExportStages; nStage++)
+	{
+		const ExportStageReport& oStage = oReport.oStages[nStage];
+		double dBusySec = oStage.ullBusyMicroSec / 1e6;
+
+		// utilization close to 100% marks the stage limiting the pipeline
+		double dUtilization = oStage.unNumWorkers > 0 ? 100.0 * dBusySec / (oStage.unNumWorkers * dWallSec) : 0;
+
+		printf("\t%-8s %2u worker(s)\t%8.1f files/s\t%8.1f MB/s\tutilization %5.1f%%\n", STAGE_NAMES[nStage], oStage.unNumWorkers, \
+			oStage.ullNumItems / dWallSec, oStage.ullNumBytes / dWallSec / (1024.0 * 1024.0), dUtilization);
+	}
+}
+
+/*
+ * @brief	export files, returns when all of them are written
+ * @param	vecFileNames: dicom files
+ * @param	oConfig: configuration
+ * @param	oReport: throughput report
+ * @return	error code, STATUS_OK if every file is exported
+*/
+int CDicomExport::Run(const std::vector<std::string>& vecFileNames, const ExportConfig& oConfig, ExportReport& oReport)
+{
+	m_oConfig = oConfig;
+	m_pFileNames = &vecFileNames;
+	m_unNextFileIdx = 0;
+	m_unNumFailed = 0;
+
+	::memset(&m_oReport, 0, sizeof(ExportReport));
+	m_oReport.unNumFiles = (unsigned int)vecFileNames.size();
+
+	for (int nStage = 0; nStage < NumExportStages; nStage++)
+	{
+		if (0 == m_oConfig.unNumWorkers[nStage])
+		{
+			m_oConfig.unNumWorkers[nStage] = 1;
+		}
+		m_oReport.oStages[nStage].unNumWorkers = m_oConfig.unNumWorkers[nStage];
+	}
+
+	sf::path oOutputFolder = sf::system_complete(sf::path(m_oConfig.strOutputFolder));
+	if (!sf::exists(oOutputFolder) && !sf::create_directories(oOutputFolder))
+	{
+		__LOG_ERROR__("failed to create folder " + oOutputFolder.string());
+		return OPEN_FILE_ERR;
+	}
+	m_oConfig.strOutputFolder = oOutputFolder.string();
+
+	CHiResTimer oWallTimer(MicroSecond);
+	oWallTimer.Start();
+
+	// raw buffers are recycled, memory is bounded whatever the number of files
+	unsigned int unNumBuffers = m_oConfig.unQueueDepth + m_oConfig.unNumWorkers[StageRead] + m_oConfig.unNumWorkers[StageConvert];
+	vector<vector<char>*> vecBuffers;
+	m_pFreeBuffers = new CBoundedQueue<vector<char>*>(unNumBuffers);
+	for (unsigned int unIdx = 0; unIdx < unNumBuffers; unIdx++)
+	{
+		vecBuffers.push_back(new vector<char>());
+		m_pFreeBuffers->Push(vecBuffers.back());
+	}
+
+	m_pDecodedItems = new CBoundedQueue<ExportItem*>(m_oConfig.unQueueDepth);
+	m_pConvertedItems = new CBoundedQueue<ExportItem*>(m_oConfig.unQueueDepth);
+
+	vector<thread> vecWorkers[NumExportStages];
+	for (unsigned int unIdx = 0; unIdx < m_oConfig.unNumWorkers[StageRead]; unIdx++)
+	{
+		vecWorkers[StageRead].push_back(thread(&CDicomExport::ReadStage, this));
+	}
+	for (unsigned int unIdx = 0; unIdx < m_oConfig.unNumWorkers[StageConvert]; unIdx++)
+	{
+		vecWorkers[StageConvert].push_back(thread(&CDicomExport::ConvertStage, this));
+	}
+	for (unsigned int unIdx = 0; unIdx < m_oConfig.unNumWorkers[StageWrite]; unIdx++)
+	{
+		vecWorkers[StageWrite].push_back(thread(&CDicomExport::WriteStage, this));
+	}
+
+	// drain stage by stage, closing a queue lets the next stage finish once it is empty
+	for (size_t unIdx = 0; unIdx < vecWorkers[StageRead].size(); unIdx++)
+	{
+		vecWorkers[StageRead][unIdx].join();
+	}
+	m_pDecodedItems->Close();
+
+	for (size_t unIdx = 0; unIdx < vecWorkers[StageConvert].size(); unIdx++)
+	{
+		vecWorkers[StageConvert][unIdx].join();
+	}
+	m_pConvertedItems->Close();
+
+	for (size_t unIdx = 0; unIdx < vecWorkers[StageWrite].size(); unIdx++)
+	{
+		vecWorkers[StageWrite][unIdx].join();
+	}
+
+	delete m_pConvertedItems;
+	m_pConvertedItems = nullptr;
+	delete m_pDecodedItems;
+	m_pDecodedItems = nullptr;
+	delete m_pFreeBuffers;
+	m_pFreeBuffers = nullptr;
+
+	for (size_t unIdx = 0; unIdx < vecBuffers.size(); unIdx++)
+	{
+		delete vecBuffers[unIdx];
+	}
+
+	m_oReport.unNumFailed = m_unNumFailed;
+	m_oReport.ullWallMicroSec = oWallTimer.Stop();
+	oReport = m_oReport;
+
+	m_pFileNames = nullptr;
+
+	return 0 == m_oReport.unNumFailed ? STATUS_OK : READ_FILE_ERR;
+}
+
+/*
+ * @brief	worker of convert stage
+*/
+void CDicomExport::ConvertStage()
+{
+	ExportStageReport oWorkerReport;
+	::memset(&oWorkerReport, 0, sizeof(ExportStageReport));
+
+	CHiResTimer oTimer(MicroSecond);
+
+	ExportItem* pItem = nullptr;
+	while (m_pDecodedItems->Pop(pItem))
+	{
+		oTimer.Start();
+
+		const DicomInfo& oInfo = pItem->oDcmInfo;
+		cv::Mat cvSrc(oInfo.usImageHeight, oInfo.usImageWidth, 8 == oInfo.usPixelDepth ? CV_8UC1 : CV_16UC1, pItem->pRawBuff->data());
+
+		// window and depth conversion in one saturating pass, which also copies out of the raw buffer
+		double dAlpha = 8 == oInfo.usPixelDepth ? 257.0 : 1.0;
+		double dBeta = 0;
+		if (m_oConfig.isWindowApplied && oInfo.fWinWidth > 0)
+		{
+			// the header window is in rescaled units, while CDicomRead has stored rescaled values shifted by the signed
+			// offset and inverted for MONOCHROME1, so move the center into the same space before building the ramp
+			double dMaxStored = 8 == oInfo.usPixelDepth ? 255.0 : 65535.0;
+			double dCenter = oInfo.fWinCenter + (oInfo.isSignedData ? (dMaxStored + 1) / 2 : 0);
+			if (0 == memcmp("MONOCHROME1", oInfo.czPhotoInterpretation, strlen("MONOCHROME1")))
+			{
+				dCenter = dMaxStored - dCenter;
+			}
+
+			dAlpha = 65535.0 / oInfo.fWinWidth;
+			dBeta = -(dCenter - oInfo.fWinWidth / 2.0) * dAlpha;
+		}
+		cvSrc.convertTo(pItem->cvImage, CV_16UC1, dAlpha, dBeta);
+
+		m_pFreeBuffers->Push(pItem->pRawBuff);
+		pItem->pRawBuff = nullptr;
+
+		if (m_oConfig.usOutHeight > 0 && m_oConfig.usOutWidth > 0 && \
+			(m_oConfig.usOutHeight != oInfo.usImageHeight || m_oConfig.usOutWidth != oInfo.usImageWidth))
+		{
+			cv::Mat cvResized;
+			cv::resize(pItem->cvImage, cvResized, cv::Size(m_oConfig.usOutWidth, m_oConfig.usOutHeight), 0, 0, cv::INTER_AREA);
+			pItem->cvImage = cvResized;
+		}
+
+		oWorkerReport.ullBusyMicroSec += oTimer.Stop();
+		oWorkerReport.ullNumItems++;
+		oWorkerReport.ullNumBytes += pItem->cvImage.total() * pItem->cvImage.elemSize();
+
+		m_pConvertedItems->Push(pItem);
+	}
+
+	MergeReport(StageConvert, oWorkerReport);
+}
+
+/*
+ * @brief	add statistics of a worker to report
+ * @param	nStage
+ * @param	oWorkerReport
+*/
+void CDicomExport::MergeReport(ExportStage nStage, const ExportStageReport& oWorkerReport)
+{
+	m_oReportLock.lock();
+	m_oReport.oStages[nStage].ullNumItems += oWorkerReport.ullNumItems;
+	m_oReport.oStages[nStage].ullNumBytes += oWorkerReport.ullNumBytes;
+	m_oReport.oStages[nStage].ullBusyMicroSec += oWorkerReport.ullBusyMicroSec;
+	m_oReportLock.unlock();
+}
+
+/*
+ * @brief	worker of read stage
+*/
+void CDicomExport::ReadStage()
+{
+	ExportStageReport oWorkerReport;
+	::memset(&oWorkerReport, 0, sizeof(ExportStageReport));
+
+	CHiResTimer oTimer(MicroSecond);
+	CDicomRead oReadDicom;
+
+	size_t unFileIdx = 0;
+	while ((unFileIdx = m_unNextFileIdx++) < m_pFileNames->size())
+	{
+		vector<char>* pRawBuff = nullptr;
+		if (!m_pFreeBuffers->Pop(pRawBuff))
+		{
+			break;
+		}
+
+		oTimer.Start();
+
+		ExportItem* pItem = new ExportItem();
+		pItem->unFileIdx = unFileIdx;
+		pItem->pRawBuff = pRawBuff;
+
+		// header first, so that a pooled buffer grows to the image read, not to the largest image accepted
+		const DicomInfo& oInfo = pItem->oDcmInfo;
+		int nProcResult = oReadDicom.GetInfo((*m_pFileNames)[unFileIdx], &pItem->oDcmInfo);
+		size_t unImageBytes = (size_t)oInfo.usImageHeight * oInfo.usImageWidth * (oInfo.usPixelDepth / 8) * oInfo.usSamplesPerPixel;
+
+		// colour images are not exported, nor images above unMaxImageBytes
+		if (STATUS_OK == nProcResult && 1 == oInfo.usSamplesPerPixel && 0 < unImageBytes && unImageBytes <= m_oConfig.unMaxImageBytes)
+		{
+			if (pRawBuff->size() < unImageBytes)
+			{
+				pRawBuff->resize(unImageBytes);
+			}
+			nProcResult = oReadDicom.GetInfoAndData((*m_pFileNames)[unFileIdx], &pItem->oDcmInfo, pRawBuff->data(), pRawBuff->size());
+		}
+		else if (STATUS_OK == nProcResult)
+		{
+			nProcResult = BUFF_ALLOCATED_SHORT;
+		}
+
+		if (STATUS_OK != nProcResult)
+		{
+			__LOG_ERROR__("failed to export " + (*m_pFileNames)[unFileIdx]);
+			m_unNumFailed++;
+
+			m_pFreeBuffers->Push(pRawBuff);
+			delete pItem;
+
+			oTimer.Stop();
+			continue;
+		}
+
+		oWorkerReport.ullBusyMicroSec += oTimer.Stop();
+		oWorkerReport.ullNumItems++;
+		oWorkerReport.ullNumBytes += (unsigned long long)pItem->oDcmInfo.usImageHeight * pItem->oDcmInfo.usImageWidth * pItem->oDcmInfo.usPixelDepth / 8;
+
+		m_pDecodedItems->Push(pItem);
+	}
+
+	MergeReport(StageRead, oWorkerReport);
+}
+
+/*
+ * @brief	worker of write stage
+*/
+void CDicomExport::WriteStage()
+{
+	ExportStageReport oWorkerReport;
+	::memset(&oWorkerReport, 0, sizeof(ExportStageReport));
+
+	CHiResTimer oTimer(MicroSecond);
+
+	vector<int> vecPngParams;
+	vecPngParams.push_back(cv::IMWRITE_PNG_COMPRESSION);
+	vecPngParams.push_back(m_oConfig.nPngCompression);
+
+	ExportItem* pItem = nullptr;
+	while (m_pConvertedItems->Pop(pItem))
+	{
+		oTimer.Start();
+
+		string strExportName = GetExportFileName((*m_pFileNames)[pItem->unFileIdx], pItem->unFileIdx, m_oConfig.nFormat);
+		size_t unNumBytes = pItem->cvImage.total() * pItem->cvImage.elemSize();
+
+		bool isWritten = false;
+		switch (m_oConfig.nFormat)
+		{
+		case ExportRaw:
+			{
+				char* pDataPtr = (char*)pItem->cvImage.data;
+				isWritten = WriteToDisk(m_oConfig.strOutputFolder, strExportName, pDataPtr, unNumBytes);
+			}
+			break;
+		case ExportTiff16:
+			isWritten = cv::imwrite((sf::path(m_oConfig.strOutputFolder) / strExportName).string(), pItem->cvImage);
+			break;
+		default:
+			isWritten = cv::imwrite((sf::path(m_oConfig.strOutputFolder) / strExportName).string(), pItem->cvImage, vecPngParams);
+			break;
+		}
+
+		if (isWritten)
+		{
+			oWorkerReport.ullBusyMicroSec += oTimer.Stop();
+			oWorkerReport.ullNumItems++;
+			oWorkerReport.ullNumBytes += unNumBytes;
+		}
+		else
+		{
+			oTimer.Stop();
+			__LOG_ERROR__("failed to write " + strExportName);
+			m_unNumFailed++;
+		}
+
+		delete pItem;
+	}
+
+	MergeReport(StageWrite, oWorkerReport);
+}
@@ -0,0 +1,156 @@
+/***************************************************
+ * @file		DicomExport.h
+ * @section		Common
+ * @class		CDicomExport
+ * @brief		export dicom images to 16-bit png, tiff or raw in a three-stage pipeline
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#ifndef __DICOM_EXPORT_H__
+#define __DICOM_EXPORT_H__
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "BoundedQueue.h"
+#include "MacroDeclSpec.h"
+
+/* enum for output format */
+enum ExportFormat
+{
+	ExportPng16 = 0,	///< 16-bit png
+	ExportTiff16,		///< 16-bit tiff
+	ExportRaw			///< 16-bit little endian raw, no header
+};
+
+/* enum for pipeline stage */
+enum ExportStage
+{
+	StageRead = 0,		///< read and decode dicom
+	StageConvert,		///< window and resize
+	StageWrite,			///< encode and write
+	NumExportStages
+};
+
+/*
+ * @brief	configuration of export
+*/
+struct ExportConfig
+{
+	bool isWindowApplied;			///< map window of dicom header to full 16-bit range
+	int nPngCompression;			///< 0 - 9, lower is faster
+	unsigned int unNumWorkers[NumExportStages];	///< threads of each stage
+	unsigned int unQueueDepth;		///< capacity of queue between two stages
+	unsigned int unMaxImageBytes;	///< largest image accepted, read buffers grow only to the images actually read
+	unsigned short usOutHeight;		///< 0 keeps original size
+	unsigned short usOutWidth;		///< 0 keeps original size
+	ExportFormat nFormat;
+	std::string strOutputFolder;
+};
+
+/*
+ * @brief	throughput of a stage
+*/
+struct ExportStageReport
+{
+	unsigned int unNumWorkers;
+	unsigned long long ullNumItems;
+	unsigned long long ullNumBytes;
+	unsigned long long ullBusyMicroSec;	///< summed over workers
+};
+
+/*
+ * @brief	throughput of an export
+*/
+struct ExportReport
+{
+	unsigned int unNumFiles;
+	unsigned int unNumFailed;
+	unsigned long long ullWallMicroSec;
+	ExportStageReport oStages[NumExportStages];
+};
+
+/*
+ * @class	CDicomExport
+ * @brief	read/decode, convert/window/resize and encode/write run concurrently with bounded queues in between
+*/
+class _DLL_EXPORT_ CDicomExport
+{
+public:
+	/*
+	 * @brief	constructor
+	*/
+	CDicomExport();
+
+	/*
+	 * @brief	destructor
+	*/
+	~CDicomExport();
+
+	/*
+	 * @brief	default configuration, 2 readers, 1 converter per core, 2 writers, png output
+	 * @param	oConfig
+	*/
+	static void GetDefaultConfig(ExportConfig& oConfig);
+
+	/*
+	 * @brief	print throughput of each stage
+	 * @param	oReport
+	*/
+	static void PrintReport(const ExportReport& oReport);
+
+	/*
+	 * @brief	export files, returns when all of them are written
+	 * @param	vecFileNames: dicom files
+	 * @param	oConfig: configuration
+	 * @param	oReport: throughput report
+	 * @return	error code, STATUS_OK if every file is exported
+	*/
+	int Run(const std::vector<std::string>& vecFileNames, const ExportConfig& oConfig, ExportReport& oReport);
+
+private:
+	struct ExportItem;
+
+	/*
+	 * @brief	worker of convert stage
+	*/
+	void ConvertStage();
+
+	/*
+	 * @brief	add statistics of a worker to report
+	 * @param	nStage
+	 * @param	oWorkerReport
+	*/
+	void MergeReport(ExportStage nStage, const ExportStageReport& oWorkerReport);
+
+	/*
+	 * @brief	worker of read stage
+	*/
+	void ReadStage();
+
+	/*
+	 * @brief	worker of write stage
+	*/
+	void WriteStage();
+
+	std::atomic<size_t> m_unNextFileIdx;
+	std::atomic<unsigned int> m_unNumFailed;
+
+	const std::vector<std::string>* m_pFileNames;
+
+	ExportConfig m_oConfig;
+	ExportReport m_oReport;
+
+	std::mutex m_oReportLock;
+
+	CBoundedQueue<std::vector<char>*>* m_pFreeBuffers;
+	CBoundedQueue<ExportItem*>* m_pDecodedItems;
+	CBoundedQueue<ExportItem*>* m_pConvertedItems;
+};
+
+#endif	// __DICOM_EXPORT_H__
@@ -17,17 +17,26 @@ namespace sf = std::tr2::sys;
 namespace sf = std::experimental::filesystem;
 #endif
 
+#include <algorithm>
+#include <sstream>
+
+#include <math.h>
 #include <string.h>
 
+#include "Checksum.h"
 #include "DicomRead.h"
 #include "ErrorMsg.h"
 #include "Exception.h"
 
 #define ID_OFFSET	128
 #define IMPLICIT_VR	0x2D2D
+#define READ_BLOCK_LEN	(256 * 1024)
 
 using namespace std;
 
+// progress messages of every reader
+static atomic<bool> g_isDicomReadVerbose(true);
+
 const int AE = 0x4145;
 const int AS = 0x4153;
 const int AT = 0x4154;
@@ -84,6 +93,136 @@ const string ITEM                     = "FFFEE000";
 const string ITEM_DELIMITATION        = "FFFEE00D";
 const string SEQUENCE_DELIMITATION    = "FFFEE0DD";
 
+// exact powers of ten representable by double
+static const double POW10_TABLE[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+	1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/*
+ * @brief	parse a decimal number like std::from_chars, locale free and allocation free
+ * @param	pBegin: first character
+ * @param	pEnd: one past the last character
+ * @param	dVal: parsed value, untouched if nothing parsed
+ * @return	pointer to the first character not consumed, pBegin if nothing parsed
+*/
+static const char* ParseDecimal(const char* pBegin, const char* pEnd, double& dVal)
+{
+	const char* pCur = pBegin;
+
+	bool isNegative = false;
+	if (pCur < pEnd && ('-' == *pCur || '+' == *pCur))
+	{
+		isNegative = ('-' == *pCur++);
+	}
+
+	// keep 19 significant digits in mantissa, the rest only shifts the exponent
+	unsigned long long ullMantissa = 0;
+	int nNumDigits = 0;
+	int nExponent = 0;
+	bool isDigitFound = false;
+
+	for (; pCur < pEnd && *pCur >= '0' && *pCur <= '9'; pCur++)
+	{
+		isDigitFound = true;
+		if (nNumDigits < 19)
+		{
+			ullMantissa = ullMantissa * 10 + (*pCur - '0');
+			nNumDigits += (0 != ullMantissa);
+		}
+		else
+		{
+			nExponent++;
+		}
+	}
+
+	if (pCur < pEnd && '.' == *pCur)
+	{
+		for (pCur++; pCur < pEnd && *pCur >= '0' && *pCur <= '9'; pCur++)
+		{
+			isDigitFound = true;
+			if (nNumDigits < 19)
+			{
+				ullMantissa = ullMantissa * 10 + (*pCur - '0');
+				nNumDigits += (0 != ullMantissa);
+				nExponent--;
+			}
+		}
+	}
+
+	if (!isDigitFound)
+	{
+		return pBegin;
+	}
+
+	if (pCur < pEnd && ('e' == *pCur || 'E' == *pCur))
+	{
+		const char* pExp = pCur + 1;
+		bool isExpNegative = false;
+		if (pExp < pEnd && ('-' == *pExp || '+' == *pExp))
+		{
+			isExpNegative = ('-' == *pExp++);
+		}
+
+		if (pExp < pEnd && *pExp >= '0' && *pExp <= '9')
+		{
+			int nExpVal = 0;
+			for (; pExp < pEnd && *pExp >= '0' && *pExp <= '9'; pExp++)
+			{
+				if (nExpVal < 10000)
+				{
+					nExpVal = nExpVal * 10 + (*pExp - '0');
+				}
+			}
+
+			nExponent += isExpNegative ? -nExpVal : nExpVal;
+			pCur = pExp;
+		}
+	}
+
+	double dResult = (double)ullMantissa;
+	if (0 != ullMantissa)
+	{
+		while (nExponent > 22)
+		{
+			dResult *= 1e22;
+			nExponent -= 22;
+		}
+		while (nExponent < -22)
+		{
+			dResult /= 1e22;
+			nExponent += 22;
+		}
+
+		dResult = nExponent >= 0 ? dResult * POW10_TABLE[nExponent] : dResult / POW10_TABLE[-nExponent];
+	}
+
+	dVal = isNegative ? -dResult : dResult;
+
+	return pCur;
+}
+
+/*
+ * @brief	load a binary value stored in file's byte order
+ * @param	pSrc: bytes of value
+ * @param	isBigEndian: byte order of file
+ * @return	value in host order
+*/
+template<typename T>
+static T LoadBinaryValue(const char* pSrc, bool isBigEndian)
+{
+	char czBytes[sizeof(T)];
+	for (size_t unIdx = 0; unIdx < sizeof(T); unIdx++)
+	{
+		czBytes[unIdx] = isBigEndian ? pSrc[sizeof(T) - unIdx - 1] : pSrc[unIdx];
+	}
+
+	T tVal;
+	::memcpy(&tVal, czBytes, sizeof(T));
+
+	return tVal;
+}
+
 /*
  * @brief	default constructor
 */
@@ -91,7 +230,10 @@ CDicomRead::CDicomRead()
 {
 	InitDictionary();
 
+	m_isChecksumEnabled = false;
 	m_pDataPtr = nullptr;
+	m_pIsCancelled = nullptr;
+	m_pReadStream = nullptr;
 }
 
 /*
@@ -101,6 +243,41 @@ CDicomRead::~CDicomRead()
 {
 }
 
+/*
+ * @brief	enable checksum of pixel data, computed while loading
+ * @param	isEnabled
+*/
+void CDicomRead::EnableChecksum(bool isEnabled)
+{
+	m_isChecksumEnabled = isEnabled;
+}
+
+/*
+ * @brief	get image information from a dicom file, pixel data is not read
+ * @param	strFileName
+ * @param	pDcmInfo
+ * @return	error code
+*/
+int CDicomRead::GetInfo(std::string strFileName, DicomInfo *pDcmInfo)
+{
+	m_strFileName = strFileName;
+	m_pDataPtr = nullptr;
+
+	InitData();
+	m_isHeaderOnly = true;
+
+	m_nProcResult = ReadDicom(0);
+	if (STATUS_OK != m_nProcResult)
+	{
+		::memset(pDcmInfo, 0, sizeof(DicomInfo));
+		return READ_FILE_ERR;
+	}
+
+	::memcpy(pDcmInfo, &m_oDcmInfo, sizeof(DicomInfo));
+
+	return m_nProcResult;
+}
+
 /*
  * @brief	get image information and data from a dicom file
  * @param	strFileName
@@ -120,7 +297,8 @@ int CDicomRead::GetInfoAndData(std::string strFileName, DicomInfo *pDcmInfo, cha
 	if (STATUS_OK != m_nProcResult)
 	{
 		::memset(pDcmInfo, 0, sizeof(DicomInfo));
-		return READ_FILE_ERR;
+		m_pDataPtr = nullptr;
+		return READ_CANCELLED == m_nProcResult ? READ_CANCELLED : READ_FILE_ERR;
 	}
 	else
 	{
@@ -132,6 +310,57 @@ int CDicomRead::GetInfoAndData(std::string strFileName, DicomInfo *pDcmInfo, cha
 	return m_nProcResult;
 }
 
+/*
+ * @brief	get image information from a dicom file held in memory, pixel data is not read
+ * @param	pFileData: content of the file
+ * @param	unFileLen: size of content
+ * @param	pDcmInfo
+ * @return	error code
+*/
+int CDicomRead::GetInfoFromMemory(const char *pFileData, size_t unFileLen, DicomInfo *pDcmInfo)
+{
+	m_strFileName = "memory buffer";
+	m_pDataPtr = nullptr;
+
+	InitData();
+	m_isHeaderOnly = true;
+
+	istringstream oMemStream(string(pFileData, unFileLen), ios::in | ios::binary);
+	m_pReadStream = &oMemStream;
+
+	m_nProcResult = ReadStream(0);
+
+	m_pReadStream = nullptr;
+
+	if (STATUS_OK != m_nProcResult)
+	{
+		::memset(pDcmInfo, 0, sizeof(DicomInfo));
+		return READ_FILE_ERR;
+	}
+
+	::memcpy(pDcmInfo, &m_oDcmInfo, sizeof(DicomInfo));
+
+	return m_nProcResult;
+}
+
+/*
+ * @brief	set flag polled between blocks of pixel data, reading stops with READ_CANCELLED once it is set
+ * @param	pIsCancelled: nullptr to disable cancellation
+*/
+void CDicomRead::SetCancelFlag(const std::atomic<bool>* pIsCancelled)
+{
+	m_pIsCancelled = pIsCancelled;
+}
+
+/*
+ * @brief	print progress of each file, shared by all readers, errors are printed anyway
+ * @param	isVerbose: false while benchmarking
+*/
+void CDicomRead::SetVerbose(bool isVerbose)
+{
+	g_isDicomReadVerbose = isVerbose;
+}
+
 /*
  * @brief	add a tag to dicom information
  * @param	strTag
@@ -151,6 +380,64 @@ void CDicomRead::AddTag(std::string strTagInfo)
 	}
 }
 
+/*
+ * @brief	rescale and convert pixels loaded at m_pDataPtr in place, clamped to the range of stored pixels
+ * @param	unNumPixels: pixels to convert
+*/
+void CDicomRead::ConvertPixels(unsigned int unNumPixels)
+{
+	bool isMonochrome1 = (0 == memcmp("MONOCHROME1", m_oDcmInfo.czPhotoInterpretation, strlen("MONOCHROME1")));
+
+	if (8 == m_oDcmInfo.usPixelDepth)
+	{
+		int nOffset = m_oDcmInfo.isSignedData ? 128 : 0;
+		for (unsigned int unIdx = 0; unIdx < unNumPixels; unIdx++)
+		{
+			m_ucPixelValLower = *((unsigned char*)m_pDataPtr);
+			m_nPixVal = m_oDcmInfo.usPixelRepresentation ? (int)(signed char)m_ucPixelValLower : (int)m_ucPixelValLower;
+			m_nPixVal = (int)floor(m_nPixVal * m_oDcmInfo.fRescaleSlope + m_oDcmInfo.fRescaleIntercept + 0.5) + nOffset;
+			m_nPixVal = m_nPixVal < 0 ? 0 : (m_nPixVal > 255 ? 255 : m_nPixVal);
+
+			if (isMonochrome1)
+			{
+				m_nPixVal = 255 - m_nPixVal;
+			}
+
+			*m_pDataPtr++ = (char)m_nPixVal;
+		}
+	}
+
+	if (16 == m_oDcmInfo.usPixelDepth)
+	{
+		int nOffset = m_oDcmInfo.isSignedData ? 32768 : 0;
+		for (unsigned int unIdx = 0; unIdx < unNumPixels; unIdx++)
+		{
+			// explicit VR big endian stores the higher byte first
+			m_ucPixelValLower = *(unsigned char*)(m_pDataPtr + (m_oDcmInfo.isBigEndian ? 1 : 0));
+			m_ucPixelValHigher = *(unsigned char*)(m_pDataPtr + (m_oDcmInfo.isBigEndian ? 0 : 1));
+
+			// pixel representation 1 is a 2s complement image
+			m_nPixVal = m_ucPixelValHigher << 8 | m_ucPixelValLower;
+			if (m_oDcmInfo.usPixelRepresentation)
+			{
+				m_nPixVal = (short)m_nPixVal;
+			}
+
+			m_nPixVal = (int)floor(m_nPixVal * m_oDcmInfo.fRescaleSlope + m_oDcmInfo.fRescaleIntercept + 0.5) + nOffset;
+			m_nPixVal = m_nPixVal < 0 ? 0 : (m_nPixVal > 65535 ? 65535 : m_nPixVal);
+
+			if (isMonochrome1)
+			{
+				m_nPixVal = 65535 - m_nPixVal;
+			}
+
+			*(unsigned short*)m_pDataPtr = (unsigned short)m_nPixVal;
+
+			m_pDataPtr += 2;
+		}
+	}
+}
+
 /*
  * @brief	convert string to number
 */
@@ -162,13 +449,103 @@ T CDicomRead::ConvertStr2Num(size_t unStrLen)
 	T tVal = 0;
 	for (size_t unIdx = 0; unIdx < unStrLen; unIdx++)
 	{
-		tVal |= m_czStreamBuff[unIdx];
-		tVal << 8;
+		tVal = (T)(tVal << 8) | (unsigned char)m_czStreamBuff[unIdx];
 	}
 
 	return tVal;
 }
 
+/*
+ * @brief	decode numeric value(s) of current element, backslash-separated multi-values supported
+ * @param	pVals: buffer of decoded values
+ * @param	unMaxVals: capacity of pVals, surplus values are skipped
+ * @param	nDefaultVR: VR used if current element is implicit VR
+ * @return	number of values decoded
+*/
+template<typename T>
+size_t CDicomRead::DecodeNumericValues(T* pVals, size_t unMaxVals, int nDefaultVR)
+{
+	int nVR = (IMPLICIT_VR == m_nVR) ? nDefaultVR : m_nVR;
+
+	// values never exceed stream buffer in practice, the rest is skipped if they do
+	unsigned int unBytesRead = m_unElementLen < STR_BUF_LEN ? m_unElementLen : STR_BUF_LEN;
+	ReadBuf(m_unElementLen);
+
+	const char* pCur = m_czStreamBuff;
+	const char* pEnd = m_czStreamBuff + unBytesRead;
+	size_t unNumVals = 0;
+
+	switch (nVR)
+	{
+	case DS:
+	case IS:
+		while (pCur < pEnd && unNumVals < unMaxVals)
+		{
+			// leading and trailing spaces are allowed around each value
+			while (pCur < pEnd && (' ' == *pCur || 0 == *pCur))
+			{
+				pCur++;
+			}
+
+			double dVal = 0;
+			const char* pNext = ParseDecimal(pCur, pEnd, dVal);
+			if (pNext == pCur)
+			{
+				break;
+			}
+			pVals[unNumVals++] = (T)dVal;
+
+			// step over the delimiter of multi-values, never beyond the end of values
+			for (pCur = pNext; pCur < pEnd && '\\' != *pCur; pCur++);
+			if (pCur < pEnd)
+			{
+				pCur++;
+			}
+		}
+		break;
+	case US:
+		for (; pCur + 2 <= pEnd && unNumVals < unMaxVals; pCur += 2)
+		{
+			pVals[unNumVals++] = (T)LoadBinaryValue<unsigned short>(pCur, m_oDcmInfo.isBigEndian);
+		}
+		break;
+	case SS:
+		for (; pCur + 2 <= pEnd && unNumVals < unMaxVals; pCur += 2)
+		{
+			pVals[unNumVals++] = (T)LoadBinaryValue<short>(pCur, m_oDcmInfo.isBigEndian);
+		}
+		break;
+	case UL:
+		for (; pCur + 4 <= pEnd && unNumVals < unMaxVals; pCur += 4)
+		{
+			pVals[unNumVals++] = (T)LoadBinaryValue<unsigned int>(pCur, m_oDcmInfo.isBigEndian);
+		}
+		break;
+	case SL:
+		for (; pCur + 4 <= pEnd && unNumVals < unMaxVals; pCur += 4)
+		{
+			pVals[unNumVals++] = (T)LoadBinaryValue<int>(pCur, m_oDcmInfo.isBigEndian);
+		}
+		break;
+	case FL:
+		for (; pCur + 4 <= pEnd && unNumVals < unMaxVals; pCur += 4)
+		{
+			pVals[unNumVals++] = (T)LoadBinaryValue<float>(pCur, m_oDcmInfo.isBigEndian);
+		}
+		break;
+	case FD:
+		for (; pCur + 8 <= pEnd && unNumVals < unMaxVals; pCur += 8)
+		{
+			pVals[unNumVals++] = (T)LoadBinaryValue<double>(pCur, m_oDcmInfo.isBigEndian);
+		}
+		break;
+	default:
+		break;
+	}
+
+	return unNumVals;
+}
+
 /*
  * @brief	read next tag' length
 */
@@ -176,7 +553,7 @@ void CDicomRead::GetElementLen()
 {
 	ReadBuf(4);
 
-	m_nVR = m_czStreamBuff[0] << 8 | m_czStreamBuff[1];
+	m_nVR = (unsigned char)m_czStreamBuff[0] << 8 | (unsigned char)m_czStreamBuff[1];
 
 	// Cannot know whether the VR is implicit or explicit without the complete Dicom Data Dictionary
 	switch (m_nVR)
@@ -190,13 +567,11 @@ void CDicomRead::GetElementLen()
 		if (0 == (unsigned char)m_czStreamBuff[2] || 0 == (unsigned char)m_czStreamBuff[3])
 		{
 			ReadBuf(4);
-			ReverseCopy(4);
-			m_unElementLen = *((unsigned int*)m_czStreamBuff);
+			m_unElementLen = LoadBinaryValue<unsigned int>(m_czStreamBuff, m_oDcmInfo.isBigEndian);
 			return;
 		}
 		m_nVR = IMPLICIT_VR;
-		ReverseCopy(4);
-		m_unElementLen = *((unsigned int*)m_czStreamBuff);
+		m_unElementLen = LoadBinaryValue<unsigned int>(m_czStreamBuff, m_oDcmInfo.isBigEndian);
 		return;
 	case AE:
 	case AS:
@@ -222,9 +597,7 @@ void CDicomRead::GetElementLen()
 	case QQ:
 	case RT:
 		// Explicit vr with 16-bit length
-		::memcpy(m_czStreamBuff, m_czStreamBuff + 2, 2);
-		ReverseCopy(2);
-		m_unElementLen = *((unsigned short*)m_czStreamBuff);
+		m_unElementLen = LoadBinaryValue<unsigned short>(m_czStreamBuff + 2, m_oDcmInfo.isBigEndian);
 		return;
 	default:
 		m_nVR = IMPLICIT_VR;
@@ -289,24 +662,14 @@ std::string CDicomRead::GetHeaderInfo(std::string strTagInfo)
 	case TM:
 	case UI:
 		ReadBuf(m_unElementLen);
-		strTagInfo = std::string(m_czStreamBuff, m_unElementLen);
+		strTagInfo = std::string(m_czStreamBuff, m_unElementLen < STR_BUF_LEN ? m_unElementLen : STR_BUF_LEN);
 		break;
 	case US:
-		if (2 == m_unElementLen)
-		{
-			ReadBuf(2);
-			ReverseCopy(2);
-			strTagInfo = Int2Str(*((unsigned short*)m_czStreamBuff), 10, 2);
-		}
-		else
+		// only the first value is shown if several are given
+		ReadBuf(m_unElementLen);
+		if (m_unElementLen >= 2)
 		{
-			for (int nIdx = 0; nIdx < m_unElementLen / 2; nIdx++)
-			{
-				strTagInfo = "";
-				ReadBuf(2);
-				ReverseCopy(2);
-				strTagInfo += Int2Str(*((unsigned short*)m_czStreamBuff), 10, 2);
-			}
+			strTagInfo = Int2Str(LoadBinaryValue<unsigned short>(m_czStreamBuff, m_oDcmInfo.isBigEndian));
 		}
 		break;
 	case IMPLICIT_VR:
@@ -324,12 +687,12 @@ std::string CDicomRead::GetHeaderInfo(std::string strTagInfo)
 		strTagInfo = "";
 		if (m_unTagVal == ICON_IMAGE_SEQUENCE || ((m_unTagVal >> 16) & 1) != 0)
 		{
-			m_unStreamLocation += m_unElementLen;
+			SkipBuf(m_unElementLen);
 		}
 		break;
 	default:
 		strTagInfo = "";
-		m_unStreamLocation += m_unElementLen;
+		SkipBuf(m_unElementLen);
 		break;
 	}
 
@@ -412,6 +775,7 @@ void CDicomRead::InitData()
 {
 	m_unStreamLocation = 0;
 	m_isDcmTagFound = false;
+	m_isHeaderOnly = false;
 	m_isBigEndianSyntax = false;
 	m_isOddIdx = false;
 	m_isInSequence = false;
@@ -1225,21 +1589,27 @@ void CDicomRead::InitDictionary()
 template<typename T>
 std::string CDicomRead::Int2Str(T tInVal, unsigned char ucBase, size_t unStrValLen)
 {
+	static const char DIGITS[] = "0123456789ABCDEF";
+
 	::memset(m_czHexBuff, '0', unStrValLen);
 
 	if (0 == unStrValLen)
 	{
 		do 
 		{
-			m_czHexBuff[unStrValLen++] = tInVal % ucBase + 48;
+			m_czHexBuff[unStrValLen++] = DIGITS[tInVal % ucBase];
 			tInVal /= ucBase;
 		} while (tInVal > 0);
+
+		// digits are generated from the least significant one
+		std::reverse(m_czHexBuff, m_czHexBuff + unStrValLen);
 	} 
 	else
 	{
-		for (size_t ullIdx = unStrValLen - 1; ullIdx > 1, tInVal > 0; ullIdx--)
+		// higher digits beyond the width are dropped
+		for (size_t ullIdx = unStrValLen; ullIdx > 0 && tInVal > 0; ullIdx--)
 		{
-			m_czHexBuff[ullIdx] = tInVal % ucBase + 48;
+			m_czHexBuff[ullIdx - 1] = DIGITS[tInVal % ucBase];
 			tInVal /= ucBase;
 		}
 	}
@@ -1253,7 +1623,17 @@ std::string CDicomRead::Int2Str(T tInVal, unsigned char ucBase, size_t unStrValL
 */
 void CDicomRead::ReadBuf(unsigned int unBytesRead)
 {
-	m_oReadFile.read(m_czStreamBuff, unBytesRead);
+	// bytes beyond stream buffer are skipped, a corrupted length must not overflow it
+	if (unBytesRead > STR_BUF_LEN)
+	{
+		m_pReadStream->read(m_czStreamBuff, STR_BUF_LEN);
+		m_pReadStream->seekg(unBytesRead - STR_BUF_LEN, ios::cur);
+	}
+	else
+	{
+		m_pReadStream->read(m_czStreamBuff, unBytesRead);
+	}
+
 	m_unStreamLocation += unBytesRead;
 }
 
@@ -1285,45 +1665,16 @@ int CDicomRead::ReadDicom(size_t unBuffLen)
 		return OPEN_FILE_ERR;
 	}
 
-	m_nProcResult = ReadInfo();
-	if (STATUS_OK != m_nProcResult)
-	{
-		m_oReadFile.close();
+	m_pReadStream = &m_oReadFile;
 
-		m_vecErrorReplacer.clear();
-		m_vecErrorReplacer.push_back(oFileName.string());
-		printf("%s\n", CErrorMsg::GetInstance()->GetMsgString(READ_FILE_ERR, m_vecErrorReplacer).c_str());
-
-		return READ_FILE_ERR;
-	}
-
-	printf("\timage height = %d\timage width = %d\tpixel depth = %d\n", m_oDcmInfo.usImageHeight, m_oDcmInfo.usImageWidth, m_oDcmInfo.usPixelDepth);
-
-	if (m_isPixelDataTagFound && m_oDcmInfo.usImageHeight > 0 && m_oDcmInfo.usImageWidth > 0 && m_oDcmInfo.usPixelDepth > 0)
-	{
-		ReadImageData(unBuffLen);
-
-		if (m_isDcmTagFound)
-		{
-			printf("a DICOM 3.0 file\n");
-			m_oDcmInfo.nDicomVersion = Dicom3File;
-		}
-		else
-		{
-			printf("an old version of DICOM\n");
-			m_oDcmInfo.nDicomVersion = DicomOldType;
-		}
-	}
-	else
-	{
-		m_oReadFile.close();
-		printf("%s parameters wrong.\n", oFileName.string().c_str());
-		return READ_FILE_ERR;
-	}
+	m_nProcResult = ReadStream(unBuffLen);
 
+	// state of a failed read must not leak into the next file
 	m_oReadFile.close();
-	
-	return STATUS_OK;
+	m_oReadFile.clear();
+	m_pReadStream = nullptr;
+
+	return m_nProcResult;
 }
 
 /*
@@ -1334,7 +1685,14 @@ int CDicomRead::ReadDicom(size_t unBuffLen)
 int CDicomRead::ReadImageData(size_t unBuffLen)
 {
 	unsigned unNumPixels = m_oDcmInfo.usImageHeight * m_oDcmInfo.usImageWidth;
-	unsigned unBytesToRead = unNumPixels * m_oDcmInfo.usPixelDepth / 8 * m_oDcmInfo.usSamplesPerPixel;
+	unsigned unBytesPerPixel = m_oDcmInfo.usPixelDepth / 8 * m_oDcmInfo.usSamplesPerPixel;
+	unsigned unBytesToRead = unNumPixels * unBytesPerPixel;
+
+	// bit-packed pixels are not supported
+	if (0 == unBytesPerPixel)
+	{
+		return READ_FILE_ERR;
+	}
 
 	if (unBuffLen < unBytesToRead)
 	{
@@ -1342,64 +1700,50 @@ int CDicomRead::ReadImageData(size_t unBuffLen)
 		return BUFF_ALLOCATED_SHORT;
 	}
 
-	m_oReadFile.seekg(m_oDcmInfo.unDataOffset, ios::beg);
-	m_oReadFile.read(m_pDataPtr, unBytesToRead);
-	printf("%d bytes loaded\n", unBytesToRead);
+	m_pReadStream->seekg(m_oDcmInfo.unDataOffset, ios::beg);
 
-	if (1 == m_oDcmInfo.usSamplesPerPixel)
+	// load block by block, checksum and conversion run on each block while it is still in cache
+	unsigned unPixelsPerBlock = READ_BLOCK_LEN / unBytesPerPixel;
+	unsigned int unCrc = 0;
+	char* pBlockPtr = m_pDataPtr;
+	for (unsigned unPixelIdx = 0; unPixelIdx < unNumPixels; unPixelIdx += unPixelsPerBlock)
 	{
-		if (8 == m_oDcmInfo.usPixelDepth)
-		{
-			for (int nIdx = 0; nIdx < unNumPixels; nIdx++)
-			{
-				m_ucPixelValLower = *((unsigned char*)m_pDataPtr);
-				m_nPixVal = (int)(m_ucPixelValLower * m_oDcmInfo.fRescaleSlope + m_oDcmInfo.fRescaleIntercept + 0.5);
-
-				if (0 == memcmp("MONOCHROME1", m_oDcmInfo.czPhotoInterpretation, strlen("MONOCHROME1")))
-				{
-					m_nPixVal = 255 - m_nPixVal;
-				}
+		unsigned unBlockPixels = unNumPixels - unPixelIdx < unPixelsPerBlock ? unNumPixels - unPixelIdx : unPixelsPerBlock;
+		unsigned unBlockBytes = unBlockPixels * unBytesPerPixel;
 
-				*m_pDataPtr++ = m_nPixVal;
-			}
+		// a stale request stops after its current block
+		if (nullptr != m_pIsCancelled && m_pIsCancelled->load())
+		{
+			return READ_CANCELLED;
 		}
 
-		if (16 == m_oDcmInfo.usPixelDepth)
+		m_pReadStream->read(pBlockPtr, unBlockBytes);
+		if ((unsigned)m_pReadStream->gcount() != unBlockBytes)
 		{
-			for (int nIdx = 0; nIdx < unNumPixels; nIdx++)
-			{
-				if (m_oDcmInfo.usPixelRepresentation)
-				{
-					// Pixel representation is 1, indicating a 2s complement image
-					ReverseCopy(2);
-				}
-
-				m_ucPixelValLower = *(unsigned char*)(m_pDataPtr);
-				m_ucPixelValHigher = *(unsigned char*)(m_pDataPtr + 1);
-
-				m_nPixVal = m_ucPixelValHigher << 8 | m_ucPixelValLower;
-
-				m_nPixVal = (int)(m_nPixVal * m_oDcmInfo.fRescaleSlope + m_oDcmInfo.fRescaleIntercept + 0.5);
-
-				if (0 == memcmp("MONOCHROME1", m_oDcmInfo.czPhotoInterpretation, strlen("MONOCHROME1")))
-				{
-					m_nPixVal = 65535 - m_nPixVal;
-				}
+			// pixel data truncated
+			return READ_FILE_ERR;
+		}
 
-				if (m_oDcmInfo.usPixelDepth)
-				{
-					*(unsigned short*)m_pDataPtr = m_nPixVal;
-				}
-				else
-				{
-					*(unsigned short*)m_pDataPtr = m_nPixVal+ 32768;
-				}
+		if (m_isChecksumEnabled)
+		{
+			unCrc = UpdateCrc32c(unCrc, pBlockPtr, unBlockBytes);
+		}
 
-				m_pDataPtr += 2;
-			}
+		if (1 == m_oDcmInfo.usSamplesPerPixel)
+		{
+			m_pDataPtr = pBlockPtr;
+			ConvertPixels(unBlockPixels);
 		}
+
+		pBlockPtr += unBlockBytes;
+	}
+	if (g_isDicomReadVerbose)
+	{
+		printf("%d bytes loaded\n", unBytesToRead);
 	}
 
+	m_oDcmInfo.unPixelCrc32c = unCrc;
+
 	return STATUS_OK;
 }
 
@@ -1412,7 +1756,7 @@ int CDicomRead::ReadInfo()
 	m_isPixelDataTagFound = false;
 	m_oDcmInfo.usPixelDepth = 16;
 
-	m_oReadFile.seekg(ID_OFFSET, ios::beg);
+	m_pReadStream->seekg(ID_OFFSET, ios::beg);
 	
 	ReadBuf(4);
 
@@ -1425,8 +1769,10 @@ int CDicomRead::ReadInfo()
 	else
 	{
 		// not Dicom 3.0
+		// a file shorter than the preamble fails the read above
 		m_unStreamLocation = 0;
-		m_oReadFile.seekg(0, ios::beg);
+		m_pReadStream->clear();
+		m_pReadStream->seekg(0, ios::beg);
 
 		m_isDcmTagFound = false;
 	}
@@ -1436,13 +1782,21 @@ int CDicomRead::ReadInfo()
 	{
 		GetNextTag();
 
+		// truncated or corrupted file, stop before pixel data is found
+		if (!m_pReadStream->good())
+		{
+			return READ_FILE_ERR;
+		}
+
 		if ((m_unStreamLocation & 1) != 0)
 		{
 			m_isOddIdx = true;
 		}
 
+		// items of sequences are not decoded, but their values are consumed
 		if (m_isInSequence)
 		{
+			AddTag("");
 			continue;
 		}
 
@@ -1451,14 +1805,15 @@ int CDicomRead::ReadInfo()
 		{
 		case (int)(TRANSFER_SYNTAX_UID):
 			ReadBuf(m_unElementLen);
-			::memcpy(&m_strTag, m_czStreamBuff, m_unElementLen);
+			m_strTag.assign(m_czStreamBuff, m_unElementLen < STR_BUF_LEN ? m_unElementLen : STR_BUF_LEN);
 			AddTag(m_strTag);
-			if (m_strTag.find("1.2.4") > -1 || m_strTag.find("1.2.5") > -1)
+			// compressed pixel data (jpeg, rle) is not supported
+			if (m_strTag.find("1.2.840.10008.1.2.4") != string::npos || m_strTag.find("1.2.840.10008.1.2.5") != string::npos)
 			{
 				m_oDcmInfo.nDicomVersion = DicomUnknow;
 				return READ_FILE_ERR;
 			}
-			if (m_strTag.find("1.2.840.10008.1.2.2") >= 0)
+			if (m_strTag.find("1.2.840.10008.1.2.2") != string::npos)
 			{
 				m_isBigEndianSyntax = true;
 			}
@@ -1469,7 +1824,8 @@ int CDicomRead::ReadInfo()
 			AddTag(string(m_oDcmInfo.czModality, 2));
 			break;
 		case (int)(NUMBER_OF_FRAMES):
-			ReadBuf(m_unElementLen);
+			DecodeNumericValues<unsigned int>(&m_oDcmInfo.unNumFrames, 1, IS);
+			AddTag(string(m_czStreamBuff, m_unElementLen < STR_BUF_LEN ? m_unElementLen : STR_BUF_LEN));
 			break;
 		case (int)(SAMPLES_PER_PIXEL):
 			m_oDcmInfo.usSamplesPerPixel = GetStreamValue<unsigned short>(2);
@@ -1477,8 +1833,8 @@ int CDicomRead::ReadInfo()
 			break;
 		case (int)PHOTOMETRIC_INTERPRETATION:
 			ReadBuf(m_unElementLen);
-			::memcpy(m_oDcmInfo.czPhotoInterpretation, m_czStreamBuff, m_unElementLen);
-			AddTag(string(m_czStreamBuff, m_unElementLen));
+			::memcpy(m_oDcmInfo.czPhotoInterpretation, m_czStreamBuff, m_unElementLen < sizeof(m_oDcmInfo.czPhotoInterpretation) ? m_unElementLen : sizeof(m_oDcmInfo.czPhotoInterpretation));
+			AddTag(string(m_czStreamBuff, m_unElementLen < STR_BUF_LEN ? m_unElementLen : STR_BUF_LEN));
 			break;
 		case (int)(PLANAR_CONFIGURATION):
 			m_oDcmInfo.usPlanarConfiguration = GetStreamValue<unsigned short>(2);
@@ -1493,9 +1849,16 @@ int CDicomRead::ReadInfo()
 			AddTag(string(m_czStreamBuff, 2));
 			break;
 		case (int)PIXEL_SPACING:
-			break;;
+			DecodeNumericValues<float>(m_oDcmInfo.fPixelSpacing, 2, DS);
+			AddTag(string(m_czStreamBuff, m_unElementLen < STR_BUF_LEN ? m_unElementLen : STR_BUF_LEN));
+			break;
 		case (int)SLICE_SPACING:
+			DecodeNumericValues<float>(&m_oDcmInfo.fSliceSpacing, 1, DS);
+			AddTag(string(m_czStreamBuff, m_unElementLen < STR_BUF_LEN ? m_unElementLen : STR_BUF_LEN));
+			break;
 		case (int)SLICE_THICKNESS:
+			DecodeNumericValues<float>(&m_oDcmInfo.fSliceThickness, 1, DS);
+			AddTag(string(m_czStreamBuff, m_unElementLen < STR_BUF_LEN ? m_unElementLen : STR_BUF_LEN));
 			break;
 		case (int)BITS_ALLOCATED:
 			m_oDcmInfo.usPixelDepth = GetStreamValue<unsigned short>(2);
@@ -1506,20 +1869,23 @@ int CDicomRead::ReadInfo()
 			AddTag(string(m_czStreamBuff, 2));
 			break;
 		case (int)WINDOW_CENTER:
-			ReadBuf(4);
-			m_czStreamBuff[4] = 0;
-			m_oDcmInfo.usWinCenter = atoi(m_czStreamBuff);
-			AddTag(string(m_czStreamBuff, 4));
+			// only the first window is used if several are given
+			DecodeNumericValues<float>(&m_oDcmInfo.fWinCenter, 1, DS);
+			m_oDcmInfo.usWinCenter = (unsigned short)(m_oDcmInfo.fWinCenter < 0 ? 0 : (m_oDcmInfo.fWinCenter > 65535 ? 65535 : m_oDcmInfo.fWinCenter + 0.5));
+			AddTag(string(m_czStreamBuff, m_unElementLen < STR_BUF_LEN ? m_unElementLen : STR_BUF_LEN));
 			break;
 		case (int)WINDOW_WIDTH:
-			ReadBuf(4);
-			m_czStreamBuff[4] = 0;
-			m_oDcmInfo.usWinWidth = atoi(m_czStreamBuff);
-			AddTag(string(m_czStreamBuff, 4));
+			DecodeNumericValues<float>(&m_oDcmInfo.fWinWidth, 1, DS);
+			m_oDcmInfo.usWinWidth = (unsigned short)(m_oDcmInfo.fWinWidth < 0 ? 0 : (m_oDcmInfo.fWinWidth > 65535 ? 65535 : m_oDcmInfo.fWinWidth + 0.5));
+			AddTag(string(m_czStreamBuff, m_unElementLen < STR_BUF_LEN ? m_unElementLen : STR_BUF_LEN));
 			break;
 		case (int)(RESCALE_INTERCEPT):
+			DecodeNumericValues<float>(&m_oDcmInfo.fRescaleIntercept, 1, DS);
+			AddTag(string(m_czStreamBuff, m_unElementLen < STR_BUF_LEN ? m_unElementLen : STR_BUF_LEN));
 			break;
 		case (int)(RESCALE_SLOPE):
+			DecodeNumericValues<float>(&m_oDcmInfo.fRescaleSlope, 1, DS);
+			AddTag(string(m_czStreamBuff, m_unElementLen < STR_BUF_LEN ? m_unElementLen : STR_BUF_LEN));
 			break;
 		case (int)(RED_PALETTE):
 			break;
@@ -1545,6 +1911,65 @@ int CDicomRead::ReadInfo()
 	return STATUS_OK;
 }
 
+/*
+ * @brief	read dicom info and, unless header only, image data from m_pReadStream
+ * @param	unBuffLen: size of buffer
+ * @return	process result
+*/
+int CDicomRead::ReadStream(size_t unBuffLen)
+{
+	m_nProcResult = ReadInfo();
+	if (STATUS_OK != m_nProcResult)
+	{
+		m_vecErrorReplacer.clear();
+		m_vecErrorReplacer.push_back(m_strFileName);
+		printf("%s\n", CErrorMsg::GetInstance()->GetMsgString(READ_FILE_ERR, m_vecErrorReplacer).c_str());
+
+		return READ_FILE_ERR;
+	}
+
+	// signed stored values or a negative rescale give negative values, they are stored with an offset of half the range
+	m_oDcmInfo.isSignedData = 0 != m_oDcmInfo.usPixelRepresentation || m_oDcmInfo.fRescaleIntercept < 0 || m_oDcmInfo.fRescaleSlope < 0;
+
+	if (g_isDicomReadVerbose)
+	{
+		printf("\timage height = %d\timage width = %d\tpixel depth = %d\n", m_oDcmInfo.usImageHeight, m_oDcmInfo.usImageWidth, m_oDcmInfo.usPixelDepth);
+	}
+
+	if (m_isPixelDataTagFound && m_oDcmInfo.usImageHeight > 0 && m_oDcmInfo.usImageWidth > 0 && m_oDcmInfo.usPixelDepth > 0)
+	{
+		if (!m_isHeaderOnly)
+		{
+			m_nProcResult = ReadImageData(unBuffLen);
+			if (STATUS_OK != m_nProcResult)
+			{
+				return m_nProcResult;
+			}
+		}
+
+		if (m_isDcmTagFound)
+		{
+			m_oDcmInfo.nDicomVersion = Dicom3File;
+		}
+		else
+		{
+			m_oDcmInfo.nDicomVersion = DicomOldType;
+		}
+
+		if (g_isDicomReadVerbose)
+		{
+			printf(Dicom3File == m_oDcmInfo.nDicomVersion ? "a DICOM 3.0 file\n" : "an old version of DICOM\n");
+		}
+	}
+	else
+	{
+		printf("%s parameters wrong.\n", m_strFileName.c_str());
+		return READ_FILE_ERR;
+	}
+
+	return STATUS_OK;
+}
+
 /*
  * @brief	little endian to big endian
  * @param	unBufLen: bytes to Reverse
@@ -1562,3 +1987,13 @@ void CDicomRead::ReverseCopy(unsigned int unBufLen)
 		swap(m_czStreamBuff[m_nStreamIdx], m_czStreamBuff[unBufLen - m_nStreamIdx - 1]);
 	}
 }
+
+/*
+ * @brief	skip bytes of stream
+ * @param	unBytesSkipped: bytes to skip
+*/
+void CDicomRead::SkipBuf(unsigned int unBytesSkipped)
+{
+	m_pReadStream->seekg(unBytesSkipped, ios::cur);
+	m_unStreamLocation += unBytesSkipped;
+}
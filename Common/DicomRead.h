@@ -12,7 +12,9 @@
 #ifndef __DICOM_READ_H__
 #define __DICOM_READ_H__
 
+#include <atomic>
 #include <fstream>
+#include <istream>
 #include <map>
 #include <string>
 #include <vector>
@@ -38,7 +40,7 @@ enum DicomVersion
 struct DicomInfo
 {
 	bool isBigEndian;
-	bool isSignedData;
+	bool isSignedData;			///< rescaled values may be negative, pixels are stored as value + 32768 (+ 128 for 8 bits)
 	char czModality[2];
 	char czPhotoInterpretation[12];
 	unsigned short usSamplesPerPixel;
@@ -54,6 +56,12 @@ struct DicomInfo
 	DicomVersion nDicomVersion;
 	float fRescaleIntercept;
 	float fRescaleSlope;
+	float fWinCenter;
+	float fWinWidth;
+	float fPixelSpacing[2];		///< row spacing, column spacing, in mm
+	float fSliceThickness;
+	float fSliceSpacing;
+	unsigned int unPixelCrc32c;	///< CRC-32C of stored pixel data, valid if checksum enabled
 };
 
 /*
@@ -73,6 +81,20 @@ public:
 	*/
 	~CDicomRead();
 	
+	/*
+	 * @brief	enable checksum of pixel data, computed while loading
+	 * @param	isEnabled
+	*/
+	void EnableChecksum(bool isEnabled);
+	
+	/*
+	 * @brief	get image information from a dicom file, pixel data is not read
+	 * @param	strFileName
+	 * @param	pDcmInfo
+	 * @return	error code
+	*/
+	int GetInfo(std::string strFileName, DicomInfo *pDcmInfo);
+
 	/*
 	 * @brief	get image information and data from a dicom file
 	 * @param	strFileName
@@ -83,6 +105,27 @@ public:
 	*/
 	int GetInfoAndData(std::string strFileName, DicomInfo *pDcmInfo, char *pDataBuf, size_t unBuffLen);
 
+	/*
+	 * @brief	get image information from a dicom file held in memory, pixel data is not read
+	 * @param	pFileData: content of the file
+	 * @param	unFileLen: size of content
+	 * @param	pDcmInfo
+	 * @return	error code
+	*/
+	int GetInfoFromMemory(const char *pFileData, size_t unFileLen, DicomInfo *pDcmInfo);
+
+	/*
+	 * @brief	set flag polled between blocks of pixel data, reading stops with READ_CANCELLED once it is set
+	 * @param	pIsCancelled: nullptr to disable cancellation
+	*/
+	void SetCancelFlag(const std::atomic<bool>* pIsCancelled);
+
+	/*
+	 * @brief	print progress of each file, shared by all readers, errors are printed anyway
+	 * @param	isVerbose: false while benchmarking
+	*/
+	static void SetVerbose(bool isVerbose);
+
 private:
 	/*
 	 * @brief	add a tag to dicom information
@@ -90,12 +133,28 @@ private:
 	*/
 	void AddTag(std::string strTagInfo);
 	
+	/*
+	 * @brief	rescale and convert pixels loaded at m_pDataPtr in place, clamped to the range of stored pixels
+	 * @param	unNumPixels: pixels to convert
+	*/
+	void ConvertPixels(unsigned int unNumPixels);
+
 	/*
 	 * @brief	convert string to number
 	*/
 	template<typename T>
 	T ConvertStr2Num(size_t unStrLen);
 
+	/*
+	 * @brief	decode numeric value(s) of current element, backslash-separated multi-values supported
+	 * @param	pVals: buffer of decoded values
+	 * @param	unMaxVals: capacity of pVals, surplus values are skipped
+	 * @param	nDefaultVR: VR used if current element is implicit VR
+	 * @return	number of values decoded
+	*/
+	template<typename T>
+	size_t DecodeNumericValues(T* pVals, size_t unMaxVals, int nDefaultVR);
+
 	/*
 	 * @brief	read next tag' length
 	*/
@@ -155,6 +214,13 @@ private:
 	 * @param	unBuffLen: size of buffer
 	*/
 	int ReadImageData(size_t unBuffLen);
+
+	/*
+	 * @brief	read dicom info and, unless header only, image data from m_pReadStream
+	 * @param	unBuffLen: size of buffer
+	 * @return	process result
+	*/
+	int ReadStream(size_t unBuffLen);
 	
 	/*
 	 * @brief	read dicom info
@@ -168,8 +234,16 @@ private:
 	*/
 	void ReverseCopy(unsigned int unBufLen);
 
+	/*
+	 * @brief	skip bytes of stream
+	 * @param	unBytesSkipped: bytes to skip
+	*/
+	void SkipBuf(unsigned int unBytesSkipped);
+
 	bool m_isBigEndianSyntax;
+	bool m_isChecksumEnabled;
 	bool m_isDcmTagFound;
+	bool m_isHeaderOnly;
 	bool m_isInSequence;
 	bool m_isOddIdx;
 	bool m_isPixelDataTagFound;
@@ -192,6 +266,8 @@ private:
 
 	char *m_pDataPtr;
 
+	const std::atomic<bool>* m_pIsCancelled;
+
 	char m_czStreamBuff[STR_BUF_LEN];
 	char m_czHeaderBuf[STR_BUF_LEN];
 	char m_czTagBuff[STR_BUF_LEN];
@@ -201,6 +277,7 @@ private:
 	std::string m_strFileName;
 
 	std::fstream m_oReadFile;
+	std::istream* m_pReadStream;	///< m_oReadFile or a stream over memory
 
 	std::map<std::string, std::string> m_mapDicomDictionary;
 
@@ -0,0 +1,489 @@
+/***************************************************
+ * @file		DicomSynth.cpp
+ * @section		Common
+ * @class		CDicomSynth
+ * @brief		generate synthetic dicom files for benchmarks and fuzzing of CDicomRead
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#include <fstream>
+
+#include <string.h>
+
+#include "DicomSynth.h"
+#include "ErrorMsg.h"
+#include "IntlMsgAliasID.h"
+
+#define PREAMBLE_LEN		128
+#define UNDEFINED_LEN		0xFFFFFFFF
+#define MAX_PRIVATE_BLOCKS	240
+
+using namespace std;
+
+static const int VR_CS = 0x4353;
+static const int VR_DS = 0x4453;
+static const int VR_FD = 0x4644;
+static const int VR_LO = 0x4C4F;
+static const int VR_OB = 0x4F42;
+static const int VR_OW = 0x4F57;
+static const int VR_PN = 0x504E;
+static const int VR_SH = 0x5348;
+static const int VR_SQ = 0x5351;
+static const int VR_UI = 0x5549;
+static const int VR_UL = 0x554C;
+static const int VR_UN = 0x554E;
+static const int VR_US = 0x5553;
+static const int VR_UT = 0x5554;
+
+static const char* SOP_CLASS_UID = "1.2.840.10008.5.1.4.1.1.1";
+static const char* INSTANCE_UID_ROOT = "1.2.826.0.1.3680043.2.1143.";
+static const char* IMPLEMENTATION_UID = "1.2.826.0.1.3680043.2.1143.1";
+
+static const char* TRANSFER_SYNTAX_UIDS[NumSynthSyntaxes] = {
+	"1.2.840.10008.1.2",
+	"1.2.840.10008.1.2.1",
+	"1.2.840.10008.1.2.2",
+	"1.2.840.10008.1.2"
+};
+
+static const char* SYNTAX_NAMES[NumSynthSyntaxes] = {
+	"implicit-le",
+	"explicit-le",
+	"explicit-be",
+	"old-implicit-le"
+};
+
+/*
+ * @brief	store an integer in given byte order
+ * @param	pDst: destination
+ * @param	unVal: value
+ * @param	unNumBytes: 2 or 4
+ * @param	isBigEndian: byte order
+*/
+static void StoreInteger(char* pDst, unsigned int unVal, size_t unNumBytes, bool isBigEndian)
+{
+	for (size_t unIdx = 0; unIdx < unNumBytes; unIdx++)
+	{
+		size_t unShift = 8 * (isBigEndian ? unNumBytes - 1 - unIdx : unIdx);
+		pDst[unIdx] = (char)((unVal >> unShift) & 0xFF);
+	}
+}
+
+/*
+ * @brief	constructor
+*/
+CDicomSynth::CDicomSynth()
+{
+	m_isBigEndian = false;
+	m_isExplicitVR = true;
+
+	GetDefaultConfig(m_oConfig);
+
+	m_pFileData = nullptr;
+}
+
+/*
+ * @brief	destructor
+*/
+CDicomSynth::~CDicomSynth()
+{
+}
+
+/*
+ * @brief	build a file in memory
+ * @param	oConfig: configuration
+ * @param	vecFileData: content of file
+ * @return	error code
+*/
+int CDicomSynth::Generate(const SynthConfig& oConfig, std::vector<char>& vecFileData)
+{
+	if (oConfig.nSyntax < SynthImplicitLittle || oConfig.nSyntax >= NumSynthSyntaxes || 0 == oConfig.usImageHeight || 0 == oConfig.usImageWidth
+		|| (8 != oConfig.usPixelDepth && 16 != oConfig.usPixelDepth) || oConfig.unNumExtraTags > MAX_PRIVATE_BLOCKS * 256)
+	{
+		vector<string> vecErrorReplacer(1, "synthetic dicom configuration");
+		printf("%s\n", CErrorMsg::GetInstance()->GetMsgString(INVALID_PARAMETER, vecErrorReplacer).c_str());
+		return INVALID_PARAMETER;
+	}
+
+	m_oConfig = oConfig;
+	m_oRandEngine.seed(oConfig.unSeed);
+
+	m_pFileData = &vecFileData;
+	m_pFileData->clear();
+	m_pFileData->reserve((size_t)oConfig.usImageHeight * oConfig.usImageWidth * oConfig.usPixelDepth / 8 + oConfig.unNumExtraTags * 64 + 4096);
+
+	string strInstanceUID = INSTANCE_UID_ROOT + to_string((unsigned long long)oConfig.unSeed);
+
+	// meta information is explicit VR little endian whatever the transfer syntax
+	m_isBigEndian = false;
+	m_isExplicitVR = true;
+
+	if (SynthOldImplicitLittle != oConfig.nSyntax)
+	{
+		m_pFileData->resize(PREAMBLE_LEN, 0);
+		m_pFileData->insert(m_pFileData->end(), "DICM", "DICM" + 4);
+
+		AppendHeader(0x0002, 0x0000, VR_UL, 4);
+		size_t unGroupLenOffset = m_pFileData->size();
+		AppendInteger(0, 4);
+
+		AppendHeader(0x0002, 0x0001, VR_OB, 2);
+		m_pFileData->push_back(0);
+		m_pFileData->push_back(1);
+
+		AppendText(0x0002, 0x0002, VR_UI, SOP_CLASS_UID);
+		AppendText(0x0002, 0x0003, VR_UI, strInstanceUID);
+		AppendText(0x0002, 0x0010, VR_UI, TRANSFER_SYNTAX_UIDS[oConfig.nSyntax]);
+		AppendText(0x0002, 0x0012, VR_UI, IMPLEMENTATION_UID);
+
+		// group length counts bytes following its own value
+		StoreInteger(&(*m_pFileData)[unGroupLenOffset], (unsigned int)(m_pFileData->size() - unGroupLenOffset - 4), 4, false);
+	}
+
+	m_isBigEndian = (SynthExplicitBig == oConfig.nSyntax);
+	m_isExplicitVR = (SynthExplicitLittle == oConfig.nSyntax || SynthExplicitBig == oConfig.nSyntax);
+
+	// elements in ascending order of tag, as the standard requires
+	AppendText(0x0008, 0x0008, VR_CS, "ORIGINAL\\PRIMARY");
+	AppendText(0x0008, 0x0016, VR_UI, SOP_CLASS_UID);
+	AppendText(0x0008, 0x0018, VR_UI, strInstanceUID);
+	AppendText(0x0008, 0x0060, VR_CS, "CR");
+	if (oConfig.unSequenceDepth > 0)
+	{
+		AppendSequence(0x0008, 0x1032, oConfig.unSequenceDepth);
+	}
+	AppendPrivateTags();
+	AppendText(0x0010, 0x0010, VR_PN, "SYNTHETIC^PHANTOM");
+	AppendText(0x0010, 0x0020, VR_LO, to_string((unsigned long long)oConfig.unSeed));
+	AppendText(0x0018, 0x0050, VR_DS, "1.0");
+	AppendText(0x0018, 0x0088, VR_DS, "1.0");
+	AppendUShort(0x0028, 0x0002, 1);
+	AppendText(0x0028, 0x0004, VR_CS, "MONOCHROME2");
+	AppendUShort(0x0028, 0x0010, oConfig.usImageHeight);
+	AppendUShort(0x0028, 0x0011, oConfig.usImageWidth);
+	AppendText(0x0028, 0x0030, VR_DS, "0.2\\0.2");
+	AppendUShort(0x0028, 0x0100, oConfig.usPixelDepth);
+	AppendUShort(0x0028, 0x0101, oConfig.usPixelDepth);
+	AppendUShort(0x0028, 0x0102, oConfig.usPixelDepth - 1);
+	AppendUShort(0x0028, 0x0103, 0);
+	AppendText(0x0028, 0x1050, VR_DS, to_string((unsigned long long)(1 << (oConfig.usPixelDepth - 1))));
+	AppendText(0x0028, 0x1051, VR_DS, to_string((unsigned long long)(1 << oConfig.usPixelDepth)));
+	AppendText(0x0028, 0x1052, VR_DS, "0");
+	AppendText(0x0028, 0x1053, VR_DS, "1");
+	AppendPixelData();
+
+	m_pFileData = nullptr;
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	default configuration, 512 x 512 16-bit explicit little endian, 16 extra tags, one level of sequence
+ * @param	oConfig
+*/
+void CDicomSynth::GetDefaultConfig(SynthConfig& oConfig)
+{
+	oConfig.isUndefinedLength = false;
+	oConfig.usImageHeight = 512;
+	oConfig.usImageWidth = 512;
+	oConfig.usPixelDepth = 16;
+	oConfig.unNumExtraTags = 16;
+	oConfig.unSequenceDepth = 1;
+	oConfig.unSeed = 0;
+	oConfig.nSyntax = SynthExplicitLittle;
+}
+
+/*
+ * @brief	name of transfer syntax
+ * @param	nSyntax
+ * @return	short name
+*/
+const char* CDicomSynth::GetSyntaxName(SynthSyntax nSyntax)
+{
+	if (nSyntax < SynthImplicitLittle || nSyntax >= NumSynthSyntaxes)
+	{
+		return "unknown";
+	}
+
+	return SYNTAX_NAMES[nSyntax];
+}
+
+/*
+ * @brief	build a file and write it to disk
+ * @param	oConfig: configuration
+ * @param	strFileName
+ * @return	error code
+*/
+int CDicomSynth::WriteFile(const SynthConfig& oConfig, std::string strFileName)
+{
+	vector<char> vecFileData;
+	int nProcResult = Generate(oConfig, vecFileData);
+	if (STATUS_OK != nProcResult)
+	{
+		return nProcResult;
+	}
+
+	ofstream oOutFile(strFileName.c_str(), ios::out | ios::binary);
+	if (!oOutFile.good())
+	{
+		vector<string> vecErrorReplacer(1, strFileName);
+		printf("%s\n", CErrorMsg::GetInstance()->GetMsgString(OPEN_FILE_ERR, vecErrorReplacer).c_str());
+		return OPEN_FILE_ERR;
+	}
+
+	oOutFile.write(vecFileData.data(), vecFileData.size());
+	oOutFile.close();
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	append tag, VR and length of an element, VR is omitted for implicit VR
+ * @param	usGroup
+ * @param	usElement
+ * @param	nVR
+ * @param	unValueLen
+ * @return	offset of length field, for patching
+*/
+size_t CDicomSynth::AppendHeader(unsigned short usGroup, unsigned short usElement, int nVR, unsigned int unValueLen)
+{
+	AppendInteger(usGroup, 2);
+	AppendInteger(usElement, 2);
+
+	size_t unLenOffset = 0;
+	if (!m_isExplicitVR)
+	{
+		unLenOffset = m_pFileData->size();
+		AppendInteger(unValueLen, 4);
+		return unLenOffset;
+	}
+
+	m_pFileData->push_back((char)(nVR >> 8));
+	m_pFileData->push_back((char)(nVR & 0xFF));
+
+	// these VRs have 2 reserved bytes and a 32-bit length
+	if (VR_OB == nVR || VR_OW == nVR || VR_SQ == nVR || VR_UN == nVR || VR_UT == nVR)
+	{
+		m_pFileData->push_back(0);
+		m_pFileData->push_back(0);
+
+		unLenOffset = m_pFileData->size();
+		AppendInteger(unValueLen, 4);
+	}
+	else
+	{
+		unLenOffset = m_pFileData->size();
+		AppendInteger(unValueLen, 2);
+	}
+
+	return unLenOffset;
+}
+
+/*
+ * @brief	append an integer in current byte order
+ * @param	unVal
+ * @param	unNumBytes: 2 or 4
+*/
+void CDicomSynth::AppendInteger(unsigned int unVal, size_t unNumBytes)
+{
+	size_t unOffset = m_pFileData->size();
+	m_pFileData->resize(unOffset + unNumBytes);
+
+	StoreInteger(&(*m_pFileData)[unOffset], unVal, unNumBytes, m_isBigEndian);
+}
+
+/*
+ * @brief	append item or delimitation tag, always without VR
+ * @param	usElement: 0xE000 item, 0xE00D item delimitation, 0xE0DD sequence delimitation
+ * @param	unValueLen
+ * @return	offset of length field, for patching
+*/
+size_t CDicomSynth::AppendItemTag(unsigned short usElement, unsigned int unValueLen)
+{
+	AppendInteger(0xFFFE, 2);
+	AppendInteger(usElement, 2);
+
+	size_t unLenOffset = m_pFileData->size();
+	AppendInteger(unValueLen, 4);
+
+	return unLenOffset;
+}
+
+/*
+ * @brief	append pixel data element
+*/
+void CDicomSynth::AppendPixelData()
+{
+	size_t unBytesPerPixel = m_oConfig.usPixelDepth / 8;
+	size_t unNumBytes = (size_t)m_oConfig.usImageHeight * m_oConfig.usImageWidth * unBytesPerPixel;
+	size_t unPaddedBytes = (unNumBytes + 1) & ~(size_t)1;
+
+	AppendHeader(0x7FE0, 0x0010, 16 == m_oConfig.usPixelDepth ? VR_OW : VR_OB, (unsigned int)unPaddedBytes);
+
+	size_t unPixelOffset = m_pFileData->size();
+	m_pFileData->resize(unPixelOffset + unPaddedBytes, 0);
+	char* pPixel = &(*m_pFileData)[unPixelOffset];
+
+	// diagonal ramp with noise, neither constant nor random, like a real image
+	int nMaxVal = (1 << m_oConfig.usPixelDepth) - 1;
+	int nNoiseAmp = nMaxVal / 64;
+	unsigned int unRampLen = m_oConfig.usImageHeight + m_oConfig.usImageWidth - 1;
+	uniform_int_distribution<int> oNoise(-nNoiseAmp, nNoiseAmp);
+
+	for (unsigned short usRowIdx = 0; usRowIdx < m_oConfig.usImageHeight; usRowIdx++)
+	{
+		for (unsigned short usColIdx = 0; usColIdx < m_oConfig.usImageWidth; usColIdx++)
+		{
+			int nPixVal = (int)((long long)(usRowIdx + usColIdx) * nMaxVal / unRampLen) + oNoise(m_oRandEngine);
+			nPixVal = nPixVal < 0 ? 0 : (nPixVal > nMaxVal ? nMaxVal : nPixVal);
+
+			StoreInteger(pPixel, nPixVal, unBytesPerPixel, m_isBigEndian);
+			pPixel += unBytesPerPixel;
+		}
+	}
+}
+
+/*
+ * @brief	append private tags of mixed VR
+*/
+void CDicomSynth::AppendPrivateTags()
+{
+	if (0 == m_oConfig.unNumExtraTags)
+	{
+		return;
+	}
+
+	// each private creator reserves 256 elements, creators precede their blocks
+	unsigned int unNumBlocks = (m_oConfig.unNumExtraTags + 255) / 256;
+	for (unsigned int unBlockIdx = 0; unBlockIdx < unNumBlocks; unBlockIdx++)
+	{
+		AppendText(0x0009, (unsigned short)(0x0010 + unBlockIdx), VR_LO, "SYNTHETIC " + to_string((unsigned long long)unBlockIdx));
+	}
+
+	for (unsigned int unTagIdx = 0; unTagIdx < m_oConfig.unNumExtraTags; unTagIdx++)
+	{
+		unsigned short usElement = (unsigned short)(((0x10 + unTagIdx / 256) << 8) | (unTagIdx % 256));
+
+		switch (unTagIdx % 6)
+		{
+		case 0:
+			AppendText(0x0009, usElement, VR_LO, "value " + to_string((unsigned long long)unTagIdx));
+			break;
+		case 1:
+			AppendText(0x0009, usElement, VR_DS, "12.5\\-3.25e1");
+			break;
+		case 2:
+			AppendUShort(0x0009, usElement, (unsigned short)unTagIdx);
+			break;
+		case 3:
+			AppendHeader(0x0009, usElement, VR_UL, 4);
+			AppendInteger(unTagIdx, 4);
+			break;
+		case 4:
+		{
+			double dVal = unTagIdx * 0.5;
+			char czBytes[sizeof(double)];
+			::memcpy(czBytes, &dVal, sizeof(double));
+
+			AppendHeader(0x0009, usElement, VR_FD, sizeof(double));
+			for (size_t unIdx = 0; unIdx < sizeof(double); unIdx++)
+			{
+				m_pFileData->push_back(czBytes[m_isBigEndian ? sizeof(double) - 1 - unIdx : unIdx]);
+			}
+			break;
+		}
+		default:
+		{
+			// blobs up to 398 bytes, longer than any buffer of the tag walker
+			unsigned int unBlobLen = 2 * (unTagIdx % 200);
+			AppendHeader(0x0009, usElement, VR_OB, unBlobLen);
+			for (unsigned int unIdx = 0; unIdx < unBlobLen; unIdx++)
+			{
+				m_pFileData->push_back((char)m_oRandEngine());
+			}
+			break;
+		}
+		}
+	}
+}
+
+/*
+ * @brief	append a sequence of one item, nested unDepth levels
+ * @param	usGroup
+ * @param	usElement
+ * @param	unDepth: levels left
+*/
+void CDicomSynth::AppendSequence(unsigned short usGroup, unsigned short usElement, unsigned int unDepth)
+{
+	unsigned int unLen = m_oConfig.isUndefinedLength ? UNDEFINED_LEN : 0;
+
+	size_t unSeqLenOffset = AppendHeader(usGroup, usElement, VR_SQ, unLen);
+	size_t unItemLenOffset = AppendItemTag(0xE000, unLen);
+
+	AppendText(0x0008, 0x0100, VR_SH, "SYN" + to_string((unsigned long long)unDepth));
+	AppendText(0x0008, 0x0102, VR_SH, "99SYN");
+	AppendText(0x0008, 0x0104, VR_LO, "synthetic level " + to_string((unsigned long long)unDepth));
+	if (unDepth > 1)
+	{
+		// content sequence nests in each item
+		AppendSequence(0x0040, 0xA730, unDepth - 1);
+	}
+
+	if (m_oConfig.isUndefinedLength)
+	{
+		AppendItemTag(0xE00D, 0);
+		AppendItemTag(0xE0DD, 0);
+	}
+	else
+	{
+		PatchLength(unItemLenOffset);
+		PatchLength(unSeqLenOffset);
+	}
+}
+
+/*
+ * @brief	append a text element, padded to even length
+ * @param	usGroup
+ * @param	usElement
+ * @param	nVR
+ * @param	strValue
+*/
+void CDicomSynth::AppendText(unsigned short usGroup, unsigned short usElement, int nVR, const std::string& strValue)
+{
+	size_t unValueLen = (strValue.size() + 1) & ~(size_t)1;
+
+	AppendHeader(usGroup, usElement, nVR, (unsigned int)unValueLen);
+
+	m_pFileData->insert(m_pFileData->end(), strValue.begin(), strValue.end());
+	if (unValueLen > strValue.size())
+	{
+		// UIDs are padded with null, other strings with space
+		m_pFileData->push_back(VR_UI == nVR ? '\0' : ' ');
+	}
+}
+
+/*
+ * @brief	append an US element
+ * @param	usGroup
+ * @param	usElement
+ * @param	usValue
+*/
+void CDicomSynth::AppendUShort(unsigned short usGroup, unsigned short usElement, unsigned short usValue)
+{
+	AppendHeader(usGroup, usElement, VR_US, 2);
+	AppendInteger(usValue, 2);
+}
+
+/*
+ * @brief	overwrite a 32-bit length field written earlier with size of what follows it
+ * @param	unLenOffset: offset of length field
+*/
+void CDicomSynth::PatchLength(size_t unLenOffset)
+{
+	unsigned int unValueLen = (unsigned int)(m_pFileData->size() - unLenOffset - 4);
+
+	StoreInteger(&(*m_pFileData)[unLenOffset], unValueLen, 4, m_isBigEndian);
+}
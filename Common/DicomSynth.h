@@ -0,0 +1,179 @@
+/***************************************************
+ * @file		DicomSynth.h
+ * @section		Common
+ * @class		CDicomSynth
+ * @brief		generate synthetic dicom files for benchmarks and fuzzing of CDicomRead
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#ifndef __DICOM_SYNTH_H__
+#define __DICOM_SYNTH_H__
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "MacroDeclSpec.h"
+
+/* enum for transfer syntax and layout of synthetic file */
+enum SynthSyntax
+{
+	SynthImplicitLittle = 0,	///< 1.2.840.10008.1.2
+	SynthExplicitLittle,		///< 1.2.840.10008.1.2.1
+	SynthExplicitBig,			///< 1.2.840.10008.1.2.2
+	SynthOldImplicitLittle,		///< implicit little endian without preamble and meta information, as old versions
+	NumSynthSyntaxes
+};
+
+/*
+ * @brief	configuration of a synthetic file
+*/
+struct SynthConfig
+{
+	bool isUndefinedLength;			///< sequences and items of undefined length, delimited by delimitation items
+	unsigned short usImageHeight;
+	unsigned short usImageWidth;
+	unsigned short usPixelDepth;	///< 8 or 16
+	unsigned int unNumExtraTags;	///< private tags of mixed VR between standard ones
+	unsigned int unSequenceDepth;	///< nesting depth of sequences, 0 for none
+	unsigned int unSeed;			///< seed of pixel noise
+	SynthSyntax nSyntax;
+};
+
+/*
+ * @class	CDicomSynth
+ * @brief	build uncompressed single frame monochrome files of given syntax, size, tag count and sequence nesting
+*/
+class _DLL_EXPORT_ CDicomSynth
+{
+public:
+	/*
+	 * @brief	constructor
+	*/
+	CDicomSynth();
+
+	/*
+	 * @brief	destructor
+	*/
+	~CDicomSynth();
+
+	/*
+	 * @brief	build a file in memory
+	 * @param	oConfig: configuration
+	 * @param	vecFileData: content of file
+	 * @return	error code
+	*/
+	int Generate(const SynthConfig& oConfig, std::vector<char>& vecFileData);
+
+	/*
+	 * @brief	default configuration, 512 x 512 16-bit explicit little endian, 16 extra tags, one level of sequence
+	 * @param	oConfig
+	*/
+	static void GetDefaultConfig(SynthConfig& oConfig);
+
+	/*
+	 * @brief	name of transfer syntax
+	 * @param	nSyntax
+	 * @return	short name
+	*/
+	static const char* GetSyntaxName(SynthSyntax nSyntax);
+
+	/*
+	 * @brief	build a file and write it to disk
+	 * @param	oConfig: configuration
+	 * @param	strFileName
+	 * @return	error code
+	*/
+	int WriteFile(const SynthConfig& oConfig, std::string strFileName);
+
+private:
+	/*
+	 * @brief	append tag, VR and length of an element, VR is omitted for implicit VR
+	 * @param	usGroup
+	 * @param	usElement
+	 * @param	nVR
+	 * @param	unValueLen
+	 * @return	offset of length field, for patching
+	*/
+	size_t AppendHeader(unsigned short usGroup, unsigned short usElement, int nVR, unsigned int unValueLen);
+
+	/*
+	 * @brief	append an integer in current byte order
+	 * @param	unVal
+	 * @param	unNumBytes: 2 or 4
+	*/
+	void AppendInteger(unsigned int unVal, size_t unNumBytes);
+
+	/*
+	 * @brief	append item or delimitation tag, always without VR
+	 * @param	usElement: 0xE000 item, 0xE00D item delimitation, 0xE0DD sequence delimitation
+	 * @param	unValueLen
+	 * @return	offset of length field, for patching
+	*/
+	size_t AppendItemTag(unsigned short usElement, unsigned int unValueLen);
+
+	/*
+	 * @brief	append pixel data element
+	*/
+	void AppendPixelData();
+
+	/*
+	 * @brief	append private tags of mixed VR
+	*/
+	void AppendPrivateTags();
+
+	/*
+	 * @brief	append a sequence of one item, nested unDepth levels
+	 * @param	usGroup
+	 * @param	usElement
+	 * @param	unDepth: levels left
+	*/
+	void AppendSequence(unsigned short usGroup, unsigned short usElement, unsigned int unDepth);
+
+	/*
+	 * @brief	append a text element, padded to even length
+	 * @param	usGroup
+	 * @param	usElement
+	 * @param	nVR
+	 * @param	strValue
+	*/
+	void AppendText(unsigned short usGroup, unsigned short usElement, int nVR, const std::string& strValue);
+
+	/*
+	 * @brief	append an US element
+	 * @param	usGroup
+	 * @param	usElement
+	 * @param	usValue
+	*/
+	void AppendUShort(unsigned short usGroup, unsigned short usElement, unsigned short usValue);
+
+	/*
+	 * @brief	overwrite a 32-bit length field written earlier with size of what follows it
+	 * @param	unLenOffset: offset of length field
+	*/
+	void PatchLength(size_t unLenOffset);
+
+	bool m_isBigEndian;
+	bool m_isExplicitVR;
+
+	SynthConfig m_oConfig;
+
+	std::mt19937 m_oRandEngine;
+
+	std::vector<char>* m_pFileData;
+};
+
+//#ifdef __cplusplus
+//extern "C"
+//{
+//#endif // __cplusplus
+//
+//
+//#ifdef __cplusplus
+//};
+//#endif // __cplusplus
+
+#endif	// __DICOM_SYNTH_H__
@@ -0,0 +1,316 @@
+/***************************************************
+ * @file		FFTConvolution.cpp
+ * @section		Common
+ * @class		CFFTConvolver
+ * @brief		2D convolution with large kernels by overlap-save on FFT tiles
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#include <algorithm>
+#include <vector>
+
+#include <math.h>
+#include <string.h>
+
+#include "CommonMethod.h"
+#include "FFTConvolution.h"
+#include "IntlMsgAliasID.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+/*
+ * @brief	smallest even size not below a length that cv::dft transforms fast
+ * @param	nLen
+ * @return	size
+*/
+static int GetEvenDFTSize(int nLen)
+{
+	int nSize = cv::getOptimalDFTSize(nLen);
+	while (0 != nSize % 2)
+	{
+		nSize = cv::getOptimalDFTSize(nSize + 1);
+	}
+
+	return nSize;
+}
+
+/*
+ * @brief	tile sides worth trying for one axis, from twice the kernel up to the whole image
+ * @param	nKernelLen
+ * @param	nImgLen
+ * @param	vecSizes: output, ascending
+*/
+static void GetTileCandidates(int nKernelLen, int nImgLen, vector<int>& vecSizes)
+{
+	vecSizes.clear();
+
+	// beyond one tile covering the image, larger tiles only transform more padding
+	int nLargest = GetEvenDFTSize(nImgLen + nKernelLen - 1);
+	for (int nLen = 2 * nKernelLen; ; nLen = nLen * 3 / 2)
+	{
+		int nSize = min(GetEvenDFTSize(nLen), nLargest);
+		if (!vecSizes.empty() && (nSize <= vecSizes.back() || nSize > FFT_CONVOLUTION_MAX_TILE))
+		{
+			break;
+		}
+		vecSizes.push_back(nSize);
+		if (nSize == nLargest)
+		{
+			break;
+		}
+	}
+}
+
+/*
+ * @brief	constructor
+*/
+CFFTConvolver::CFFTConvolver()
+{
+	m_oKernel.usHeight = 0;
+	m_oKernel.usWidth = 0;
+	m_oKernel.isSeparable = false;
+	m_dDirectCost = 0;
+}
+
+/*
+ * @brief	destructor
+*/
+CFFTConvolver::~CFFTConvolver()
+{
+}
+
+/*
+ * @brief	filter an image in place with the kernel of SetKernel, results rounded and clamped to the pixel type
+ * @param	pImgPtr: height x width
+ * @param	usImgHeight
+ * @param	usImgWidth
+ * @return	error code
+*/
+int CFFTConvolver::Apply(unsigned char* pImgPtr, unsigned short usImgHeight, unsigned short usImgWidth)
+{
+	return ApplyKernel(pImgPtr, usImgHeight, usImgWidth);
+}
+
+int CFFTConvolver::Apply(short* pImgPtr, unsigned short usImgHeight, unsigned short usImgWidth)
+{
+	return ApplyKernel(pImgPtr, usImgHeight, usImgWidth);
+}
+
+int CFFTConvolver::Apply(unsigned short* pImgPtr, unsigned short usImgHeight, unsigned short usImgWidth)
+{
+	return ApplyKernel(pImgPtr, usImgHeight, usImgWidth);
+}
+
+int CFFTConvolver::Apply(float* pImgPtr, unsigned short usImgHeight, unsigned short usImgWidth)
+{
+	return ApplyKernel(pImgPtr, usImgHeight, usImgWidth);
+}
+
+/*
+ * @brief	set the kernel, cached spectra of the previous one are dropped
+ * @param	pKernel: usKernelHeight x usKernelWidth weights, row major
+ * @param	usKernelHeight: odd
+ * @param	usKernelWidth: odd
+ * @return	error code
+*/
+int CFFTConvolver::SetKernel(const float* pKernel, unsigned short usKernelHeight, unsigned short usKernelWidth)
+{
+	m_mapKernelSpectra.clear();
+
+	int nProcResult = PrepareFilterKernel(pKernel, usKernelHeight, usKernelWidth, m_oKernel);
+	if (STATUS_OK != nProcResult)
+	{
+		m_oKernel.usHeight = 0;
+		m_oKernel.usWidth = 0;
+		return nProcResult;
+	}
+
+	// direct filtering skips zero weights of a full kernel
+	if (m_oKernel.isSeparable)
+	{
+		m_dDirectCost = (double)usKernelHeight + usKernelWidth;
+	}
+	else
+	{
+		m_dDirectCost = (double)(m_oKernel.vecWeights.size() - count(m_oKernel.vecWeights.begin(), m_oKernel.vecWeights.end(), 0.0f));
+	}
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	whether Apply filters an image of a size by FFT rather than directly
+ * @param	usImgHeight
+ * @param	usImgWidth
+ * @return	true for FFT
+*/
+bool CFFTConvolver::UsesFFT(unsigned short usImgHeight, unsigned short usImgWidth) const
+{
+	if (0 == m_oKernel.usHeight || 0 == usImgHeight || 0 == usImgWidth)
+	{
+		return false;
+	}
+
+	int nTileHeight = 0;
+	int nTileWidth = 0;
+	return ChooseTile(usImgHeight, usImgWidth, nTileHeight, nTileWidth) < m_dDirectCost * usImgHeight * usImgWidth;
+}
+
+/*
+ * @brief	filter with FilterImage or by FFT, whichever is cheaper
+ * @param	pImgPtr
+ * @param	usImgHeight
+ * @param	usImgWidth
+ * @return	error code
+*/
+template<typename T>
+int CFFTConvolver::ApplyKernel(T* pImgPtr, unsigned short usImgHeight, unsigned short usImgWidth)
+{
+	if (nullptr == pImgPtr || 0 == m_oKernel.usHeight || 0 == usImgHeight || 0 == usImgWidth)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	int nTileHeight = 0;
+	int nTileWidth = 0;
+	if (ChooseTile(usImgHeight, usImgWidth, nTileHeight, nTileWidth) >= m_dDirectCost * usImgHeight * usImgWidth)
+	{
+		return FilterImage(pImgPtr, usImgHeight, usImgWidth, m_oKernel.vecWeights.data(), m_oKernel.usHeight, m_oKernel.usWidth);
+	}
+
+	const cv::Mat& cvKernelSpectrum = GetKernelSpectrum(nTileHeight, nTileWidth);
+
+	int nHeight = usImgHeight;
+	int nWidth = usImgWidth;
+	int nRadiusY = m_oKernel.usHeight / 2;
+	int nRadiusX = m_oKernel.usWidth / 2;
+	int nValidHeight = nTileHeight - m_oKernel.usHeight + 1;
+	int nValidWidth = nTileWidth - m_oKernel.usWidth + 1;
+	size_t unNumTilesX = (nWidth + nValidWidth - 1) / nValidWidth;
+	size_t unNumTiles = unNumTilesX * ((nHeight + nValidHeight - 1) / nValidHeight);
+
+	// tiles read around themselves, so the image is converted once before any tile is written
+	vector<float> vecSource((size_t)nHeight * nWidth);
+	CThreadPool::GetInstance()->ParallelFor(nHeight, [&](size_t unBegin, size_t unEnd)
+	{
+		LoadFilterRow(pImgPtr + unBegin * nWidth, (unEnd - unBegin) * nWidth, &vecSource[unBegin * nWidth]);
+	}, FILTER_BAND_HEIGHT);
+
+	CThreadPool::GetInstance()->ParallelFor(unNumTiles, [&](size_t unTileBegin, size_t unTileEnd)
+	{
+		CCvFFTContext oContext;
+		oContext.Prepare(nTileHeight, nTileWidth, true, false);
+		vector<float> vecTile((size_t)nTileHeight * nTileWidth);
+
+		for (size_t unTileIdx = unTileBegin; unTileIdx < unTileEnd; unTileIdx++)
+		{
+			int nTop = (int)(unTileIdx / unNumTilesX) * nValidHeight;
+			int nLeft = (int)(unTileIdx % unNumTilesX) * nValidWidth;
+
+			// rows and columns beyond the border repeat the border
+			int nFirstX = nLeft - nRadiusX;
+			int nCopyBegin = max(0, -nFirstX);
+			int nCopyEnd = min(nTileWidth, nWidth - nFirstX);
+			for (int nRowIdx = 0; nRowIdx < nTileHeight; nRowIdx++)
+			{
+				int nSourceY = min(max(nTop - nRadiusY + nRowIdx, 0), nHeight - 1);
+				const float* pSource = &vecSource[(size_t)nSourceY * nWidth];
+				float* pTileRow = &vecTile[(size_t)nRowIdx * nTileWidth];
+				if (nCopyEnd > nCopyBegin)
+				{
+					memcpy(pTileRow + nCopyBegin, pSource + nFirstX + nCopyBegin, (nCopyEnd - nCopyBegin) * sizeof(float));
+				}
+				fill(pTileRow, pTileRow + min(nCopyBegin, nTileWidth), pSource[0]);
+				fill(pTileRow + max(nCopyEnd, nCopyBegin), pTileRow + nTileWidth, pSource[nWidth - 1]);
+			}
+
+			oContext.Forward(vecTile.data());
+			cv::mulSpectrums(oContext.GetSpectrum(), cvKernelSpectrum, oContext.GetSpectrum(), 0);
+			oContext.Inverse(vecTile.data());
+
+			// circular wrap spoils the first kernel size - 1 rows and columns, the rest is the linear convolution
+			int nNumRows = min(nValidHeight, nHeight - nTop);
+			int nNumCols = min(nValidWidth, nWidth - nLeft);
+			for (int nRowIdx = 0; nRowIdx < nNumRows; nRowIdx++)
+			{
+				StoreFilterRow(&vecTile[(size_t)(nRowIdx + m_oKernel.usHeight - 1) * nTileWidth + m_oKernel.usWidth - 1], nNumCols,
+					pImgPtr + (size_t)(nTop + nRowIdx) * nWidth + nLeft);
+			}
+		}
+	}, FFT_CONVOLUTION_BATCH_SIZE);
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	tile size of least estimated cost
+ * @param	usImgHeight
+ * @param	usImgWidth
+ * @param	nTileHeight: output
+ * @param	nTileWidth: output
+ * @return	estimated cost of the image, in multiply-adds of direct filtering
+*/
+double CFFTConvolver::ChooseTile(unsigned short usImgHeight, unsigned short usImgWidth, int& nTileHeight, int& nTileWidth) const
+{
+	vector<int> vecHeights;
+	vector<int> vecWidths;
+	GetTileCandidates(m_oKernel.usHeight, usImgHeight, vecHeights);
+	GetTileCandidates(m_oKernel.usWidth, usImgWidth, vecWidths);
+
+	// whole tiles are paid for, including the part beyond the image
+	double dBestCost = -1;
+	for (size_t unHeightIdx = 0; unHeightIdx < vecHeights.size(); unHeightIdx++)
+	{
+		for (size_t unWidthIdx = 0; unWidthIdx < vecWidths.size(); unWidthIdx++)
+		{
+			int nHeight = vecHeights[unHeightIdx];
+			int nWidth = vecWidths[unWidthIdx];
+			int nValidHeight = nHeight - m_oKernel.usHeight + 1;
+			int nValidWidth = nWidth - m_oKernel.usWidth + 1;
+			double dNumTiles = (double)((usImgHeight + nValidHeight - 1) / nValidHeight) * ((usImgWidth + nValidWidth - 1) / nValidWidth);
+			double dElements = (double)nHeight * nWidth;
+			double dCost = dNumTiles * dElements * (FFT_CONVOLUTION_FFT_COST * log(dElements) / log(2.0) + 1);
+			if (dBestCost < 0 || dCost < dBestCost)
+			{
+				dBestCost = dCost;
+				nTileHeight = nHeight;
+				nTileWidth = nWidth;
+			}
+		}
+	}
+
+	return dBestCost;
+}
+
+/*
+ * @brief	spectrum of the flipped kernel zero padded to a tile, computed on first use
+ * @param	nTileHeight
+ * @param	nTileWidth
+ * @return	CCS spectrum
+*/
+const cv::Mat& CFFTConvolver::GetKernelSpectrum(int nTileHeight, int nTileWidth)
+{
+	cv::Mat& cvSpectrum = m_mapKernelSpectra[make_pair(nTileHeight, nTileWidth)];
+	if (!cvSpectrum.empty())
+	{
+		return cvSpectrum;
+	}
+
+	// flipped so that the convolution of the transforms weights pixels like FilterImage does
+	cvSpectrum = cv::Mat::zeros(nTileHeight, nTileWidth, CV_32FC1);
+	for (int nTapY = 0; nTapY < m_oKernel.usHeight; nTapY++)
+	{
+		float* pRow = cvSpectrum.ptr<float>(m_oKernel.usHeight - 1 - nTapY);
+		for (int nTapX = 0; nTapX < m_oKernel.usWidth; nTapX++)
+		{
+			pRow[m_oKernel.usWidth - 1 - nTapX] = m_oKernel.vecWeights[(size_t)nTapY * m_oKernel.usWidth + nTapX];
+		}
+	}
+	cv::dft(cvSpectrum, cvSpectrum, 0, m_oKernel.usHeight);
+
+	return cvSpectrum;
+}
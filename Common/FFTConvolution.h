@@ -0,0 +1,129 @@
+/***************************************************
+ * @file		FFTConvolution.h
+ * @section		Common
+ * @class		CFFTConvolver
+ * @brief		2D convolution with large kernels by overlap-save on FFT tiles
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#ifndef __FFT_CONVOLUTION_H__
+#define __FFT_CONVOLUTION_H__
+
+#include <map>
+#include <utility>
+
+#include "opencv/cv.h"
+
+#include "CvFFT2D.h"
+#include "ImageFilter.h"
+#include "MacroDeclSpec.h"
+
+// largest side of a tile, beyond it tiles only add work and cache misses
+#define FFT_CONVOLUTION_MAX_TILE	1024
+
+// tiles transformed by one task, sharing its transform buffers
+#define FFT_CONVOLUTION_BATCH_SIZE	4
+
+// cost of a forward and inverse real transform per element and per log2 of elements, in multiply-adds of direct filtering
+#define FFT_CONVOLUTION_FFT_COST	3.0f
+
+/*
+ * @class	CFFTConvolver
+ * @brief	same results as FilterImage, pixels beyond the border repeat the border. the image is cut into tiles overlapping by
+ *			the kernel size minus 1, each tile is transformed, multiplied by the kernel spectrum and transformed back, and its
+ *			valid part is kept. tile size minimizes the estimated cost, and small or separable kernels are filtered directly
+ *			when that is cheaper. kernel spectra are kept per tile size
+*/
+class _DLL_EXPORT_ CFFTConvolver
+{
+public:
+	/*
+	 * @brief	constructor
+	*/
+	CFFTConvolver();
+
+	/*
+	 * @brief	destructor
+	*/
+	~CFFTConvolver();
+
+	/*
+	 * @brief	filter an image in place with the kernel of SetKernel, results rounded and clamped to the pixel type
+	 * @param	pImgPtr: height x width
+	 * @param	usImgHeight
+	 * @param	usImgWidth
+	 * @return	error code
+	*/
+	int Apply(unsigned char* pImgPtr, unsigned short usImgHeight, unsigned short usImgWidth);
+	int Apply(short* pImgPtr, unsigned short usImgHeight, unsigned short usImgWidth);
+	int Apply(unsigned short* pImgPtr, unsigned short usImgHeight, unsigned short usImgWidth);
+	int Apply(float* pImgPtr, unsigned short usImgHeight, unsigned short usImgWidth);
+
+	/*
+	 * @brief	set the kernel, cached spectra of the previous one are dropped
+	 * @param	pKernel: usKernelHeight x usKernelWidth weights, row major
+	 * @param	usKernelHeight: odd
+	 * @param	usKernelWidth: odd
+	 * @return	error code
+	*/
+	int SetKernel(const float* pKernel, unsigned short usKernelHeight, unsigned short usKernelWidth);
+
+	/*
+	 * @brief	whether Apply filters an image of a size by FFT rather than directly
+	 * @param	usImgHeight
+	 * @param	usImgWidth
+	 * @return	true for FFT
+	*/
+	bool UsesFFT(unsigned short usImgHeight, unsigned short usImgWidth) const;
+
+private:
+	/*
+	 * @brief	filter with FilterImage or by FFT, whichever is cheaper
+	 * @param	pImgPtr
+	 * @param	usImgHeight
+	 * @param	usImgWidth
+	 * @return	error code
+	*/
+	template<typename T>
+	int ApplyKernel(T* pImgPtr, unsigned short usImgHeight, unsigned short usImgWidth);
+
+	/*
+	 * @brief	tile size of least estimated cost
+	 * @param	usImgHeight
+	 * @param	usImgWidth
+	 * @param	nTileHeight: output
+	 * @param	nTileWidth: output
+	 * @return	estimated cost of the image, in multiply-adds of direct filtering
+	*/
+	double ChooseTile(unsigned short usImgHeight, unsigned short usImgWidth, int& nTileHeight, int& nTileWidth) const;
+
+	/*
+	 * @brief	spectrum of the flipped kernel zero padded to a tile, computed on first use
+	 * @param	nTileHeight
+	 * @param	nTileWidth
+	 * @return	CCS spectrum
+	*/
+	const cv::Mat& GetKernelSpectrum(int nTileHeight, int nTileWidth);
+
+	FilterKernel m_oKernel;
+
+	// multiply-adds per pixel of direct filtering
+	double m_dDirectCost;
+
+	std::map<std::pair<int, int>, cv::Mat> m_mapKernelSpectra;
+};
+
+//#ifdef __cplusplus
+//extern "C"
+//{
+//#endif // __cplusplus
+//
+//
+//#ifdef __cplusplus
+//};
+//#endif // __cplusplus
+
+#endif	// __FFT_CONVOLUTION_H__
@@ -0,0 +1,376 @@
+/***************************************************
+ * @file		FixedFilter.h
+ * @section		Common
+ * @class		FixedKernel3x3
+ * @brief		3 x 3 integer kernels whose weights are template parameters, zero weights cost nothing,
+ *				other weights become shifts and adds in integer SIMD, results saturate to the pixel type
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#ifndef __FIXED_FILTER_H__
+#define __FIXED_FILTER_H__
+
+#include <limits>
+#include <vector>
+
+#include <math.h>
+
+#include "ImageFilter.h"
+#include "IntlMsgAliasID.h"
+#include "MacroDeclSpec.h"
+#include "MacroSimd.h"
+#include "ThreadPool.h"
+
+/* floor of log2 of a positive compile-time integer */
+template<int N>
+struct StaticLog2
+{
+	enum { VALUE = 1 + StaticLog2<N / 2>::VALUE };
+};
+
+template<>
+struct StaticLog2<1>
+{
+	enum { VALUE = 0 };
+};
+
+/* x * W for a compile-time W, scalar and SIMD */
+template<int W, bool IS_NEGATIVE = (W < 0)>
+struct ConstMul
+{
+	static int Apply(int nValue)
+	{
+		return -ConstMul<-W>::Apply(nValue);
+	}
+
+#ifdef _SIMD_SSE2_
+	static __m128i Apply(__m128i nValue)
+	{
+		return _mm_sub_epi32(_mm_setzero_si128(), ConstMul<-W>::Apply(nValue));
+	}
+#endif	// _SIMD_SSE2_
+};
+
+template<int W>
+struct ConstMul<W, false>
+{
+	static int Apply(int nValue)
+	{
+		return W * nValue;
+	}
+
+#ifdef _SIMD_SSE2_
+	// SSE2 has no 32-bit multiply, binary digits of W become shifts and adds
+	static __m128i Apply(__m128i nValue)
+	{
+		__m128i nHalf = _mm_slli_epi32(ConstMul<W / 2>::Apply(nValue), 1);
+		return (W & 1) ? _mm_add_epi32(nHalf, nValue) : nHalf;
+	}
+#endif	// _SIMD_SSE2_
+};
+
+template<>
+struct ConstMul<0, false>
+{
+	static int Apply(int nValue)
+	{
+		return 0;
+	}
+
+#ifdef _SIMD_SSE2_
+	static __m128i Apply(__m128i nValue)
+	{
+		return _mm_setzero_si128();
+	}
+#endif	// _SIMD_SSE2_
+};
+
+template<>
+struct ConstMul<1, false>
+{
+	static int Apply(int nValue)
+	{
+		return nValue;
+	}
+
+#ifdef _SIMD_SSE2_
+	static __m128i Apply(__m128i nValue)
+	{
+		return nValue;
+	}
+#endif	// _SIMD_SSE2_
+};
+
+/* conversion of 8 pixels to and from 32-bit lanes, saturating to the range of the pixel type */
+template<typename T>
+struct FixedFilterPixel;
+
+template<>
+struct FixedFilterPixel<unsigned char>
+{
+#ifdef _SIMD_SSE2_
+	static void Load(const unsigned char* pSrc, __m128i& nLow, __m128i& nHigh)
+	{
+		__m128i nZero = _mm_setzero_si128();
+		__m128i nValue = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)pSrc), nZero);
+		nLow = _mm_unpacklo_epi16(nValue, nZero);
+		nHigh = _mm_unpackhi_epi16(nValue, nZero);
+	}
+
+	static void Store(__m128i nLow, __m128i nHigh, unsigned char* pDst)
+	{
+		__m128i nValue = _mm_packs_epi32(nLow, nHigh);
+		_mm_storel_epi64((__m128i*)pDst, _mm_packus_epi16(nValue, nValue));
+	}
+#endif	// _SIMD_SSE2_
+};
+
+template<>
+struct FixedFilterPixel<short>
+{
+#ifdef _SIMD_SSE2_
+	static void Load(const short* pSrc, __m128i& nLow, __m128i& nHigh)
+	{
+		__m128i nValue = _mm_loadu_si128((const __m128i*)pSrc);
+		__m128i nSign = _mm_srai_epi16(nValue, 15);
+		nLow = _mm_unpacklo_epi16(nValue, nSign);
+		nHigh = _mm_unpackhi_epi16(nValue, nSign);
+	}
+
+	static void Store(__m128i nLow, __m128i nHigh, short* pDst)
+	{
+		_mm_storeu_si128((__m128i*)pDst, _mm_packs_epi32(nLow, nHigh));
+	}
+#endif	// _SIMD_SSE2_
+};
+
+template<>
+struct FixedFilterPixel<unsigned short>
+{
+#ifdef _SIMD_SSE2_
+	static void Load(const unsigned short* pSrc, __m128i& nLow, __m128i& nHigh)
+	{
+		__m128i nZero = _mm_setzero_si128();
+		__m128i nValue = _mm_loadu_si128((const __m128i*)pSrc);
+		nLow = _mm_unpacklo_epi16(nValue, nZero);
+		nHigh = _mm_unpackhi_epi16(nValue, nZero);
+	}
+
+	// no unsigned saturating pack before SSE4.1, values are biased into the signed range and back
+	static void Store(__m128i nLow, __m128i nHigh, unsigned short* pDst)
+	{
+		__m128i nBias = _mm_set1_epi32(0x8000);
+		__m128i nValue = _mm_packs_epi32(_mm_sub_epi32(nLow, nBias), _mm_sub_epi32(nHigh, nBias));
+		_mm_storeu_si128((__m128i*)pDst, _mm_add_epi16(nValue, _mm_set1_epi16((short)0x8000)));
+	}
+#endif	// _SIMD_SSE2_
+};
+
+/*
+ * @class	FixedKernel3x3
+ * @brief	weights W00 .. W22 row major, the weighted sum is divided by DIVISOR and rounded half up.
+ *			power of 2 divisors are shifts, others a float multiply
+*/
+template<int W00, int W01, int W02, int W10, int W11, int W12, int W20, int W21, int W22, int DIVISOR>
+struct FixedKernel3x3
+{
+	/*
+	 * @brief	filter one pixel
+	 * @param	pRows: 3 rows around the pixel, each pointing at the pixel left of it
+	 * @return	unclamped result
+	*/
+	template<typename T>
+	static int FilterPixel(const T* const* pRows)
+	{
+		int nSum = ConstMul<W00>::Apply(pRows[0][0]) + ConstMul<W01>::Apply(pRows[0][1]) + ConstMul<W02>::Apply(pRows[0][2]) +
+			ConstMul<W10>::Apply(pRows[1][0]) + ConstMul<W11>::Apply(pRows[1][1]) + ConstMul<W12>::Apply(pRows[1][2]) +
+			ConstMul<W20>::Apply(pRows[2][0]) + ConstMul<W21>::Apply(pRows[2][1]) + ConstMul<W22>::Apply(pRows[2][2]);
+
+		if (1 == DIVISOR)
+		{
+			return nSum;
+		}
+
+		if (0 == (DIVISOR & (DIVISOR - 1)))
+		{
+			return (nSum + DIVISOR / 2) >> StaticLog2<DIVISOR>::VALUE;
+		}
+
+		return (int)floor(nSum * (1.0f / DIVISOR) + 0.5f);
+	}
+
+#ifdef _SIMD_SSE2_
+	/*
+	 * @brief	filter 8 pixels
+	 * @param	pRows: 3 rows around the pixels, each pointing at the pixel left of the first one
+	 * @param	pDst: 8 pixels
+	*/
+	template<typename T>
+	static void FilterPixels(const T* const* pRows, T* pDst)
+	{
+		__m128i nLow = _mm_setzero_si128();
+		__m128i nHigh = _mm_setzero_si128();
+
+		AccumulateTap<W00>(pRows[0], nLow, nHigh);
+		AccumulateTap<W01>(pRows[0] + 1, nLow, nHigh);
+		AccumulateTap<W02>(pRows[0] + 2, nLow, nHigh);
+		AccumulateTap<W10>(pRows[1], nLow, nHigh);
+		AccumulateTap<W11>(pRows[1] + 1, nLow, nHigh);
+		AccumulateTap<W12>(pRows[1] + 2, nLow, nHigh);
+		AccumulateTap<W20>(pRows[2], nLow, nHigh);
+		AccumulateTap<W21>(pRows[2] + 1, nLow, nHigh);
+		AccumulateTap<W22>(pRows[2] + 2, nLow, nHigh);
+
+		FixedFilterPixel<T>::Store(Normalize(nLow), Normalize(nHigh), pDst);
+	}
+
+private:
+	/*
+	 * @brief	add W times 8 pixels, zero weights load nothing and negative weights subtract
+	*/
+	template<int W, typename T>
+	static void AccumulateTap(const T* pSrc, __m128i& nLow, __m128i& nHigh)
+	{
+		if (0 == W)
+		{
+			return;
+		}
+
+		__m128i nValueLow, nValueHigh;
+		FixedFilterPixel<T>::Load(pSrc, nValueLow, nValueHigh);
+		if (W < 0)
+		{
+			nLow = _mm_sub_epi32(nLow, ConstMul<W < 0 ? -W : 0>::Apply(nValueLow));
+			nHigh = _mm_sub_epi32(nHigh, ConstMul<W < 0 ? -W : 0>::Apply(nValueHigh));
+		}
+		else
+		{
+			nLow = _mm_add_epi32(nLow, ConstMul<W < 0 ? 0 : W>::Apply(nValueLow));
+			nHigh = _mm_add_epi32(nHigh, ConstMul<W < 0 ? 0 : W>::Apply(nValueHigh));
+		}
+	}
+
+	/*
+	 * @brief	divide by DIVISOR rounding half up, as FilterPixel does
+	*/
+	static __m128i Normalize(__m128i nSum)
+	{
+		if (1 == DIVISOR)
+		{
+			return nSum;
+		}
+
+		if (0 == (DIVISOR & (DIVISOR - 1)))
+		{
+			return _mm_srai_epi32(_mm_add_epi32(nSum, _mm_set1_epi32(DIVISOR / 2)), StaticLog2<DIVISOR>::VALUE);
+		}
+
+		// floor from truncation, one less where truncation went up
+		__m128 fValue = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(nSum), _mm_set1_ps(1.0f / DIVISOR)), _mm_set1_ps(0.5f));
+		__m128i nValue = _mm_cvttps_epi32(fValue);
+		return _mm_add_epi32(nValue, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(nValue), fValue)));
+	}
+#endif	// _SIMD_SSE2_
+};
+
+typedef FixedKernel3x3<1, 1, 1, 1, 1, 1, 1, 1, 1, 9> BoxKernel3x3;
+typedef FixedKernel3x3<1, 2, 1, 2, 4, 2, 1, 2, 1, 16> GaussianKernel3x3;
+typedef FixedKernel3x3<-1, 0, 1, -2, 0, 2, -1, 0, 1, 1> SobelXKernel3x3;
+typedef FixedKernel3x3<-1, -2, -1, 0, 0, 0, 1, 2, 1, 1> SobelYKernel3x3;
+typedef FixedKernel3x3<0, 1, 0, 1, -4, 1, 0, 1, 0, 1> LaplacianKernel3x3;
+typedef FixedKernel3x3<0, -1, 0, -1, 5, -1, 0, -1, 0, 1> SharpenKernel3x3;
+
+/*
+ * @brief	filter image in place with a compile-time kernel, e.g. FilterImageFixed<SobelXKernel3x3>(pImg, usHeight, usWidth).
+ *			pixels beyond the border repeat the border, results saturate to the range of T
+ * @param	pImgPtr, unsigned char, short or unsigned short pixels, overwritten by the filtered image
+ * @param	usImgHeight
+ * @param	usImgWidth
+ * @return	error code
+ */
+template<typename Kernel, typename T>
+int FilterImageFixed(T* pImgPtr, unsigned short usImgHeight, unsigned short usImgWidth)
+{
+	if (nullptr == pImgPtr || 0 == usImgWidth)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	int nHeight = usImgHeight;
+	size_t unPaddedWidth = usImgWidth + 2;
+
+	std::vector<T> vecHaloRows;
+	size_t unNumBands = SaveFilterHalo(pImgPtr, usImgHeight, usImgWidth, 1, vecHaloRows);
+
+	CThreadPool::GetInstance()->ParallelFor(unNumBands, [&](size_t unBandBegin, size_t unBandEnd)
+	{
+		// the 3 source rows of the current output row, padded by one pixel on each side
+		std::vector<T> vecPaddedRows(3 * unPaddedWidth);
+
+		for (size_t unBandIdx = unBandBegin; unBandIdx < unBandEnd; unBandIdx++)
+		{
+			int nBandBegin = (int)unBandIdx * FILTER_BAND_HEIGHT;
+			int nBandEnd = (std::min)(nBandBegin + FILTER_BAND_HEIGHT, nHeight);
+			const T* pHaloRows = GetFilterHaloRows(vecHaloRows, unBandIdx, usImgWidth, 1);
+
+			auto funcLoadRow = [&](int nRowIdx)
+			{
+				T* pPadded = &vecPaddedRows[(size_t)((nRowIdx + 3) % 3) * unPaddedWidth];
+				const T* pRow = GetFilterSourceRow<T>(pImgPtr, pHaloRows, usImgWidth, nBandBegin, nBandEnd, 1, nRowIdx);
+				memcpy(pPadded + 1, pRow, usImgWidth * sizeof(T));
+				pPadded[0] = pRow[0];
+				pPadded[usImgWidth + 1] = pRow[usImgWidth - 1];
+			};
+
+			funcLoadRow(nBandBegin - 1);
+			funcLoadRow(nBandBegin);
+
+			for (int nRowIdx = nBandBegin; nRowIdx < nBandEnd; nRowIdx++)
+			{
+				funcLoadRow(nRowIdx + 1);
+
+				const T* pRows[3] = {
+					&vecPaddedRows[(size_t)((nRowIdx + 2) % 3) * unPaddedWidth],
+					&vecPaddedRows[(size_t)(nRowIdx % 3) * unPaddedWidth],
+					&vecPaddedRows[(size_t)((nRowIdx + 1) % 3) * unPaddedWidth]
+				};
+				T* pDst = pImgPtr + (size_t)nRowIdx * usImgWidth;
+
+				unsigned short usColIdx = 0;
+
+#ifdef _SIMD_SSE2_
+				for (; usColIdx + 8 <= usImgWidth; usColIdx += 8)
+				{
+					const T* pShiftedRows[3] = { pRows[0] + usColIdx, pRows[1] + usColIdx, pRows[2] + usColIdx };
+					Kernel::FilterPixels(pShiftedRows, pDst + usColIdx);
+				}
+#endif	// _SIMD_SSE2_
+
+				for (; usColIdx < usImgWidth; usColIdx++)
+				{
+					const T* pShiftedRows[3] = { pRows[0] + usColIdx, pRows[1] + usColIdx, pRows[2] + usColIdx };
+					int nValue = Kernel::FilterPixel(pShiftedRows);
+					nValue = nValue < (int)(std::numeric_limits<T>::min)() ? (int)(std::numeric_limits<T>::min)() : nValue;
+					pDst[usColIdx] = (T)(nValue > (int)(std::numeric_limits<T>::max)() ? (int)(std::numeric_limits<T>::max)() : nValue);
+				}
+			}
+		}
+	}, 1);
+
+	return STATUS_OK;
+}
+
+//#ifdef __cplusplus
+//extern "C"
+//{
+//#endif // __cplusplus
+//
+//
+//#ifdef __cplusplus
+//};
+//#endif // __cplusplus
+
+#endif	// __FIXED_FILTER_H__
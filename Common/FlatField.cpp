@@ -0,0 +1,378 @@
+/***************************************************
+ * @file		FlatField.cpp
+ * @section		Common
+ * @class		CFlatField
+ * @brief		offset and gain correction of detector frames, (raw - offset) * gain per pixel
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#include <algorithm>
+
+#include <math.h>
+
+#include "FlatField.h"
+#include "IntlMsgAliasID.h"
+#include "MacroSimd.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+/*
+ * @brief	(raw - offset) * gain in fixed point, negative differences become 0
+ * @param	pRaw
+ * @param	pOffset
+ * @param	pGain: unGainShift fraction bits
+ * @param	unGainShift: in [1, 16]
+ * @param	unLen
+ * @param	pDst
+*/
+static void CorrectRowFixed(const unsigned short* pRaw, const unsigned short* pOffset, const unsigned short* pGain, unsigned int unGainShift, size_t unLen, unsigned short* pDst)
+{
+	unsigned int unRound = 1 << (unGainShift - 1);
+	size_t unIdx = 0;
+
+#ifdef _SIMD_SSE2_
+	__m128i nRound = _mm_set1_epi32(unRound);
+	__m128i nShift = _mm_cvtsi32_si128(unGainShift);
+	__m128i nBias = _mm_set1_epi32(0x8000);
+	for (; unIdx + 8 <= unLen; unIdx += 8)
+	{
+		// 16 x 16 bit products are assembled from their low and high halves
+		__m128i nDiff = _mm_subs_epu16(_mm_loadu_si128((const __m128i*)(pRaw + unIdx)), _mm_loadu_si128((const __m128i*)(pOffset + unIdx)));
+		__m128i nGain = _mm_loadu_si128((const __m128i*)(pGain + unIdx));
+		__m128i nProductLow = _mm_mullo_epi16(nDiff, nGain);
+		__m128i nProductHigh = _mm_mulhi_epu16(nDiff, nGain);
+
+		__m128i nLow = _mm_srl_epi32(_mm_add_epi32(_mm_unpacklo_epi16(nProductLow, nProductHigh), nRound), nShift);
+		__m128i nHigh = _mm_srl_epi32(_mm_add_epi32(_mm_unpackhi_epi16(nProductLow, nProductHigh), nRound), nShift);
+
+		// no unsigned saturating pack before SSE4.1, values are biased into the signed range and back
+		__m128i nValue = _mm_packs_epi32(_mm_sub_epi32(nLow, nBias), _mm_sub_epi32(nHigh, nBias));
+		_mm_storeu_si128((__m128i*)(pDst + unIdx), _mm_add_epi16(nValue, _mm_set1_epi16((short)0x8000)));
+	}
+#endif	// _SIMD_SSE2_
+
+	for (; unIdx < unLen; unIdx++)
+	{
+		unsigned int unDiff = pRaw[unIdx] > pOffset[unIdx] ? pRaw[unIdx] - pOffset[unIdx] : 0;
+		unsigned int unValue = (unDiff * pGain[unIdx] + unRound) >> unGainShift;
+		pDst[unIdx] = (unsigned short)min(unValue, 65535u);
+	}
+}
+
+/*
+ * @brief	(raw - offset) * gain in float, rounded and clamped to [0, 65535]
+ * @param	pRaw
+ * @param	pOffset
+ * @param	pGain
+ * @param	unLen
+ * @param	pDst
+*/
+static void CorrectRowFloat(const unsigned short* pRaw, const float* pOffset, const float* pGain, size_t unLen, unsigned short* pDst)
+{
+	size_t unIdx = 0;
+
+#ifdef _SIMD_SSE2_
+	__m128i nZero = _mm_setzero_si128();
+	__m128 fZero = _mm_setzero_ps();
+	__m128 fMax = _mm_set1_ps(65535.0f);
+	__m128 fHalf = _mm_set1_ps(0.5f);
+	__m128i nBias = _mm_set1_epi32(0x8000);
+	for (; unIdx + 8 <= unLen; unIdx += 8)
+	{
+		__m128i nRaw = _mm_loadu_si128((const __m128i*)(pRaw + unIdx));
+		__m128 fLow = _mm_sub_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(nRaw, nZero)), _mm_loadu_ps(pOffset + unIdx));
+		__m128 fHigh = _mm_sub_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(nRaw, nZero)), _mm_loadu_ps(pOffset + unIdx + 4));
+		fLow = _mm_min_ps(_mm_max_ps(_mm_mul_ps(fLow, _mm_loadu_ps(pGain + unIdx)), fZero), fMax);
+		fHigh = _mm_min_ps(_mm_max_ps(_mm_mul_ps(fHigh, _mm_loadu_ps(pGain + unIdx + 4)), fZero), fMax);
+
+		__m128i nLow = _mm_sub_epi32(_mm_cvttps_epi32(_mm_add_ps(fLow, fHalf)), nBias);
+		__m128i nHigh = _mm_sub_epi32(_mm_cvttps_epi32(_mm_add_ps(fHigh, fHalf)), nBias);
+		_mm_storeu_si128((__m128i*)(pDst + unIdx), _mm_add_epi16(_mm_packs_epi32(nLow, nHigh), _mm_set1_epi16((short)0x8000)));
+	}
+#endif	// _SIMD_SSE2_
+
+	for (; unIdx < unLen; unIdx++)
+	{
+		float fValue = (pRaw[unIdx] - pOffset[unIdx]) * pGain[unIdx];
+		fValue = fValue < 0 ? 0 : (fValue > 65535.0f ? 65535.0f : fValue);
+		pDst[unIdx] = (unsigned short)(fValue + 0.5f);
+	}
+}
+
+/*
+ * @brief	(raw - offset) * gain in float
+ * @param	pRaw
+ * @param	pOffset
+ * @param	pGain
+ * @param	unLen
+ * @param	pDst
+*/
+static void CorrectRowFloat(const unsigned short* pRaw, const float* pOffset, const float* pGain, size_t unLen, float* pDst)
+{
+	size_t unIdx = 0;
+
+#ifdef _SIMD_SSE2_
+	__m128i nZero = _mm_setzero_si128();
+	for (; unIdx + 8 <= unLen; unIdx += 8)
+	{
+		__m128i nRaw = _mm_loadu_si128((const __m128i*)(pRaw + unIdx));
+		__m128 fLow = _mm_sub_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(nRaw, nZero)), _mm_loadu_ps(pOffset + unIdx));
+		__m128 fHigh = _mm_sub_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(nRaw, nZero)), _mm_loadu_ps(pOffset + unIdx + 4));
+		_mm_storeu_ps(pDst + unIdx, _mm_mul_ps(fLow, _mm_loadu_ps(pGain + unIdx)));
+		_mm_storeu_ps(pDst + unIdx + 4, _mm_mul_ps(fHigh, _mm_loadu_ps(pGain + unIdx + 4)));
+	}
+#endif	// _SIMD_SSE2_
+
+	for (; unIdx < unLen; unIdx++)
+	{
+		pDst[unIdx] = (pRaw[unIdx] - pOffset[unIdx]) * pGain[unIdx];
+	}
+}
+
+/*
+ * @brief	constructor
+*/
+CFlatField::CFlatField()
+{
+	m_usHeight = 0;
+	m_usWidth = 0;
+	m_isFixedPoint = false;
+	m_unGainShift = 16;
+	m_pOffset = nullptr;
+	m_pGain = nullptr;
+	m_pFixedOffset = nullptr;
+	m_pFixedGain = nullptr;
+}
+
+/*
+ * @brief	destructor
+*/
+CFlatField::~CFlatField()
+{
+}
+
+/*
+ * @brief	use maps held elsewhere, e.g. mapped from a file, without copying them
+ * @param	pOffset: height x width, must outlive their use
+ * @param	pGain: height x width
+ * @param	pFixedOffset: height x width, from QuantizeMaps, nullptr to compute 16-bit output in float
+ * @param	pFixedGain: height x width, from QuantizeMaps, nullptr to compute 16-bit output in float
+ * @param	unGainShift: fraction bits of pFixedGain, from QuantizeMaps
+ * @param	usHeight
+ * @param	usWidth
+ * @return	error code
+*/
+int CFlatField::AttachMaps(const float* pOffset, const float* pGain, const unsigned short* pFixedOffset, const unsigned short* pFixedGain, unsigned int unGainShift,
+	unsigned short usHeight, unsigned short usWidth)
+{
+	if (nullptr == pOffset || nullptr == pGain || 0 == usHeight || 0 == usWidth || (nullptr == pFixedOffset) != (nullptr == pFixedGain) || unGainShift < 1 || unGainShift > 16)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	m_usHeight = usHeight;
+	m_usWidth = usWidth;
+	m_isFixedPoint = nullptr != pFixedOffset;
+	m_unGainShift = unGainShift;
+	m_pOffset = pOffset;
+	m_pGain = pGain;
+	m_pFixedOffset = pFixedOffset;
+	m_pFixedGain = pFixedGain;
+
+	vector<float>().swap(m_vecOffset);
+	vector<float>().swap(m_vecGain);
+	vector<unsigned short>().swap(m_vecFixedOffset);
+	vector<unsigned short>().swap(m_vecFixedGain);
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	correct a frame to 16-bit, in fixed point if enabled by SetMaps or AttachMaps, results clamped to [0, 65535]
+ * @param	pRaw: height x width pixels
+ * @param	pDst: height x width pixels, may be pRaw
+ * @return	error code
+*/
+int CFlatField::Correct(const unsigned short* pRaw, unsigned short* pDst) const
+{
+	if (nullptr == pRaw || nullptr == pDst || 0 == m_usHeight)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	size_t unWidth = m_usWidth;
+	CThreadPool::GetInstance()->ParallelFor(m_usHeight, [&](size_t unBegin, size_t unEnd)
+	{
+		// rows of a band are contiguous, corrected as one long row
+		size_t unFirst = unBegin * unWidth;
+		size_t unLen = (unEnd - unBegin) * unWidth;
+		if (m_isFixedPoint)
+		{
+			CorrectRowFixed(pRaw + unFirst, m_pFixedOffset + unFirst, m_pFixedGain + unFirst, m_unGainShift, unLen, pDst + unFirst);
+		}
+		else
+		{
+			CorrectRowFloat(pRaw + unFirst, m_pOffset + unFirst, m_pGain + unFirst, unLen, pDst + unFirst);
+		}
+	}, FLAT_FIELD_BAND_HEIGHT);
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	correct a frame to float, not clamped
+ * @param	pRaw: height x width pixels
+ * @param	pDst: height x width values
+ * @return	error code
+*/
+int CFlatField::Correct(const unsigned short* pRaw, float* pDst) const
+{
+	if (nullptr == pRaw || nullptr == pDst || 0 == m_usHeight)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	size_t unWidth = m_usWidth;
+	CThreadPool::GetInstance()->ParallelFor(m_usHeight, [&](size_t unBegin, size_t unEnd)
+	{
+		size_t unFirst = unBegin * unWidth;
+		CorrectRowFloat(pRaw + unFirst, m_pOffset + unFirst, m_pGain + unFirst, (unEnd - unBegin) * unWidth, pDst + unFirst);
+	}, FLAT_FIELD_BAND_HEIGHT);
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	height of maps
+ * @return	rows, 0 if no maps
+*/
+unsigned short CFlatField::GetHeight() const
+{
+	return m_usHeight;
+}
+
+/*
+ * @brief	width of maps
+ * @return	columns, 0 if no maps
+*/
+unsigned short CFlatField::GetWidth() const
+{
+	return m_usWidth;
+}
+
+/*
+ * @brief	whether 16-bit output is computed in fixed point
+ * @return	true if fixed point
+*/
+bool CFlatField::IsFixedPoint() const
+{
+	return m_isFixedPoint;
+}
+
+/*
+ * @brief	fixed point maps, offsets rounded to integers and gains with as many fraction bits as a robust maximum
+ *			(FLAT_FIELD_GAIN_PERCENTILE times FLAT_FIELD_GAIN_HEADROOM) leaves in 16 bits, gains above saturate
+ * @param	pOffset
+ * @param	pGain: in [0, 32768)
+ * @param	unNumPixels
+ * @param	pFixedOffset: output
+ * @param	pFixedGain: output
+ * @param	unGainShift: output, fraction bits of pFixedGain
+ * @return	error code
+*/
+int CFlatField::QuantizeMaps(const float* pOffset, const float* pGain, size_t unNumPixels, unsigned short* pFixedOffset, unsigned short* pFixedGain, unsigned int& unGainShift)
+{
+	if (nullptr == pOffset || nullptr == pGain || nullptr == pFixedOffset || nullptr == pFixedGain)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	for (size_t unIdx = 0; unIdx < unNumPixels; unIdx++)
+	{
+		if (!(pGain[unIdx] >= 0 && pGain[unIdx] < 32768.0f))
+		{
+			return INVALID_PARAMETER;
+		}
+	}
+
+	// a few hot or dead pixels with huge gains would cost every other pixel its fraction bits
+	float fMaxGain = 0;
+	if (0 != unNumPixels)
+	{
+		size_t unStep = max((size_t)1, unNumPixels / FLAT_FIELD_NUM_SAMPLES);
+		vector<float> vecSamples;
+		for (size_t unIdx = 0; unIdx < unNumPixels; unIdx += unStep)
+		{
+			vecSamples.push_back(pGain[unIdx]);
+		}
+
+		size_t unRank = (size_t)(FLAT_FIELD_GAIN_PERCENTILE / 100 * (vecSamples.size() - 1) + 0.5f);
+		nth_element(vecSamples.begin(), vecSamples.begin() + unRank, vecSamples.end());
+		fMaxGain = vecSamples[unRank] * FLAT_FIELD_GAIN_HEADROOM;
+	}
+
+	// largest shift keeping the robust maximum below 65536, products stay below 2^32
+	unGainShift = 16;
+	while (unGainShift > 1 && fMaxGain * (1 << unGainShift) > 65535.0f)
+	{
+		unGainShift--;
+	}
+
+	for (size_t unIdx = 0; unIdx < unNumPixels; unIdx++)
+	{
+		float fOffset = pOffset[unIdx] < 0 ? 0 : (pOffset[unIdx] > 65535.0f ? 65535.0f : pOffset[unIdx]);
+		pFixedOffset[unIdx] = (unsigned short)(fOffset + 0.5f);
+		pFixedGain[unIdx] = (unsigned short)min(pGain[unIdx] * (1 << unGainShift) + 0.5f, 65535.0f);
+	}
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	copy and prepare maps. fixed point rounds offsets to integers and keeps gains with
+ *			as many fraction bits as a robust maximum leaves in 16 bits, outliers saturate
+ * @param	pOffset: height x width, dark level
+ * @param	pGain: height x width, in [0, 32768)
+ * @param	usHeight
+ * @param	usWidth
+ * @param	isFixedPoint: false to compute 16-bit output in float too
+ * @return	error code
+*/
+int CFlatField::SetMaps(const float* pOffset, const float* pGain, unsigned short usHeight, unsigned short usWidth, bool isFixedPoint)
+{
+	size_t unNumPixels = (size_t)usHeight * usWidth;
+	if (nullptr == pOffset || nullptr == pGain || 0 == unNumPixels)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	// quantized first, gains out of range leave the current maps untouched
+	vector<unsigned short> vecFixedOffset(unNumPixels);
+	vector<unsigned short> vecFixedGain(unNumPixels);
+	unsigned int unGainShift = 16;
+	int nProcResult = QuantizeMaps(pOffset, pGain, unNumPixels, vecFixedOffset.data(), vecFixedGain.data(), unGainShift);
+	if (STATUS_OK != nProcResult)
+	{
+		return nProcResult;
+	}
+
+	m_usHeight = usHeight;
+	m_usWidth = usWidth;
+	m_isFixedPoint = isFixedPoint;
+	m_unGainShift = unGainShift;
+	m_vecOffset.assign(pOffset, pOffset + unNumPixels);
+	m_vecGain.assign(pGain, pGain + unNumPixels);
+	m_vecFixedOffset.swap(vecFixedOffset);
+	m_vecFixedGain.swap(vecFixedGain);
+
+	m_pOffset = m_vecOffset.data();
+	m_pGain = m_vecGain.data();
+	m_pFixedOffset = isFixedPoint ? m_vecFixedOffset.data() : nullptr;
+	m_pFixedGain = isFixedPoint ? m_vecFixedGain.data() : nullptr;
+
+	return STATUS_OK;
+}
@@ -0,0 +1,152 @@
+/***************************************************
+ * @file		FlatField.h
+ * @section		Common
+ * @class		CFlatField
+ * @brief		offset and gain correction of detector frames, (raw - offset) * gain per pixel
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#ifndef __FLAT_FIELD_H__
+#define __FLAT_FIELD_H__
+
+#include <vector>
+
+#include "MacroDeclSpec.h"
+
+// rows of a frame corrected by one task
+#define FLAT_FIELD_BAND_HEIGHT	32
+
+// gains sampled for the fixed point range
+#define FLAT_FIELD_NUM_SAMPLES	65536
+
+// percentile of gains represented exactly in fixed point, larger gains saturate
+#define FLAT_FIELD_GAIN_PERCENTILE	99.9f
+
+// margin over the gain percentile before fraction bits are given up
+#define FLAT_FIELD_GAIN_HEADROOM	1.25f
+
+/*
+ * @class	CFlatField
+ * @brief	maps are prepared once by SetMaps, then each frame is corrected in one pass fusing
+ *			subtraction, multiplication, rounding, clamping and conversion to the output type
+*/
+class _DLL_EXPORT_ CFlatField
+{
+public:
+	/*
+	 * @brief	constructor
+	*/
+	CFlatField();
+
+	/*
+	 * @brief	destructor
+	*/
+	~CFlatField();
+
+	/*
+	 * @brief	use maps held elsewhere, e.g. mapped from a file, without copying them
+	 * @param	pOffset: height x width, must outlive their use
+	 * @param	pGain: height x width
+	 * @param	pFixedOffset: height x width, from QuantizeMaps, nullptr to compute 16-bit output in float
+	 * @param	pFixedGain: height x width, from QuantizeMaps, nullptr to compute 16-bit output in float
+	 * @param	unGainShift: fraction bits of pFixedGain, from QuantizeMaps
+	 * @param	usHeight
+	 * @param	usWidth
+	 * @return	error code
+	*/
+	int AttachMaps(const float* pOffset, const float* pGain, const unsigned short* pFixedOffset, const unsigned short* pFixedGain, unsigned int unGainShift,
+		unsigned short usHeight, unsigned short usWidth);
+
+	/*
+	 * @brief	correct a frame to 16-bit, in fixed point if enabled by SetMaps or AttachMaps, results clamped to [0, 65535]
+	 * @param	pRaw: height x width pixels
+	 * @param	pDst: height x width pixels, may be pRaw
+	 * @return	error code
+	*/
+	int Correct(const unsigned short* pRaw, unsigned short* pDst) const;
+
+	/*
+	 * @brief	correct a frame to float, not clamped
+	 * @param	pRaw: height x width pixels
+	 * @param	pDst: height x width values
+	 * @return	error code
+	*/
+	int Correct(const unsigned short* pRaw, float* pDst) const;
+
+	/*
+	 * @brief	height of maps
+	 * @return	rows, 0 if no maps
+	*/
+	unsigned short GetHeight() const;
+
+	/*
+	 * @brief	width of maps
+	 * @return	columns, 0 if no maps
+	*/
+	unsigned short GetWidth() const;
+
+	/*
+	 * @brief	whether 16-bit output is computed in fixed point
+	 * @return	true if fixed point
+	*/
+	bool IsFixedPoint() const;
+
+	/*
+	 * @brief	fixed point maps, offsets rounded to integers and gains with as many fraction bits as a robust maximum
+	 *			(FLAT_FIELD_GAIN_PERCENTILE times FLAT_FIELD_GAIN_HEADROOM) leaves in 16 bits, gains above saturate
+	 * @param	pOffset
+	 * @param	pGain: in [0, 32768)
+	 * @param	unNumPixels
+	 * @param	pFixedOffset: output
+	 * @param	pFixedGain: output
+	 * @param	unGainShift: output, fraction bits of pFixedGain
+	 * @return	error code
+	*/
+	static int QuantizeMaps(const float* pOffset, const float* pGain, size_t unNumPixels, unsigned short* pFixedOffset, unsigned short* pFixedGain, unsigned int& unGainShift);
+
+	/*
+	 * @brief	copy and prepare maps. fixed point rounds offsets to integers and keeps gains with
+	 *			as many fraction bits as a robust maximum leaves in 16 bits, outliers saturate
+	 * @param	pOffset: height x width, dark level
+	 * @param	pGain: height x width, in [0, 32768)
+	 * @param	usHeight
+	 * @param	usWidth
+	 * @param	isFixedPoint: false to compute 16-bit output in float too
+	 * @return	error code
+	*/
+	int SetMaps(const float* pOffset, const float* pGain, unsigned short usHeight, unsigned short usWidth, bool isFixedPoint = true);
+
+private:
+	unsigned short m_usHeight;
+	unsigned short m_usWidth;
+
+	bool m_isFixedPoint;
+
+	unsigned int m_unGainShift;		///< fraction bits of m_pFixedGain
+
+	// maps in use, owned by the vectors below after SetMaps
+	const float* m_pOffset;
+	const float* m_pGain;
+	const unsigned short* m_pFixedOffset;
+	const unsigned short* m_pFixedGain;
+
+	std::vector<float> m_vecOffset;
+	std::vector<float> m_vecGain;
+	std::vector<unsigned short> m_vecFixedOffset;
+	std::vector<unsigned short> m_vecFixedGain;
+};
+
+//#ifdef __cplusplus
+//extern "C"
+//{
+//#endif // __cplusplus
+//
+//
+//#ifdef __cplusplus
+//};
+//#endif // __cplusplus
+
+#endif	// __FLAT_FIELD_H__
@@ -0,0 +1,340 @@
+/***************************************************
+ * @file		FrameAccumulator.cpp
+ * @section		Common
+ * @class		CFrameAccumulator
+ * @brief		per-pixel running mean and variance of a stream of frames, source of offset, gain and noise maps
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#include <algorithm>
+
+#include <math.h>
+
+#include "DefectDetection.h"
+#include "FrameAccumulator.h"
+#include "IntlMsgAliasID.h"
+#include "MacroSimd.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+/*
+ * @brief	Welford update of one row in float, delta = x - mean, mean += delta / n, squares += delta * (x - mean)
+ * @param	pFrame
+ * @param	unLen
+ * @param	fInvNumFrames: 1 / n, frame included
+ * @param	pMean
+ * @param	pSquares
+*/
+static void AccumulateRow(const unsigned short* pFrame, size_t unLen, float fInvNumFrames, float* pMean, float* pSquares)
+{
+	size_t unIdx = 0;
+
+#ifdef _SIMD_SSE2_
+	__m128i nZero = _mm_setzero_si128();
+	__m128 fInv = _mm_set1_ps(fInvNumFrames);
+	for (; unIdx + 8 <= unLen; unIdx += 8)
+	{
+		__m128i nValue = _mm_loadu_si128((const __m128i*)(pFrame + unIdx));
+		__m128 fValues[2] = { _mm_cvtepi32_ps(_mm_unpacklo_epi16(nValue, nZero)), _mm_cvtepi32_ps(_mm_unpackhi_epi16(nValue, nZero)) };
+
+		for (size_t unHalf = 0; unHalf < 2; unHalf++)
+		{
+			float* pHalfMean = pMean + unIdx + 4 * unHalf;
+			float* pHalfSquares = pSquares + unIdx + 4 * unHalf;
+
+			__m128 fMean = _mm_loadu_ps(pHalfMean);
+			__m128 fDelta = _mm_sub_ps(fValues[unHalf], fMean);
+			fMean = _mm_add_ps(fMean, _mm_mul_ps(fDelta, fInv));
+			_mm_storeu_ps(pHalfMean, fMean);
+			_mm_storeu_ps(pHalfSquares, _mm_add_ps(_mm_loadu_ps(pHalfSquares), _mm_mul_ps(fDelta, _mm_sub_ps(fValues[unHalf], fMean))));
+		}
+	}
+#endif	// _SIMD_SSE2_
+
+	for (; unIdx < unLen; unIdx++)
+	{
+		float fDelta = pFrame[unIdx] - pMean[unIdx];
+		pMean[unIdx] += fDelta * fInvNumFrames;
+		pSquares[unIdx] += fDelta * (pFrame[unIdx] - pMean[unIdx]);
+	}
+}
+
+/*
+ * @brief	Welford update of one row in double
+ * @param	pFrame
+ * @param	unLen
+ * @param	dInvNumFrames: 1 / n, frame included
+ * @param	pMean
+ * @param	pSquares
+*/
+static void AccumulateRow(const unsigned short* pFrame, size_t unLen, double dInvNumFrames, double* pMean, double* pSquares)
+{
+	size_t unIdx = 0;
+
+#ifdef _SIMD_SSE2_
+	__m128i nZero = _mm_setzero_si128();
+	__m128d dInv = _mm_set1_pd(dInvNumFrames);
+	for (; unIdx + 4 <= unLen; unIdx += 4)
+	{
+		__m128i nValue = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)(pFrame + unIdx)), nZero);
+		__m128d dValues[2] = { _mm_cvtepi32_pd(nValue), _mm_cvtepi32_pd(_mm_srli_si128(nValue, 8)) };
+
+		for (size_t unHalf = 0; unHalf < 2; unHalf++)
+		{
+			double* pHalfMean = pMean + unIdx + 2 * unHalf;
+			double* pHalfSquares = pSquares + unIdx + 2 * unHalf;
+
+			__m128d dMean = _mm_loadu_pd(pHalfMean);
+			__m128d dDelta = _mm_sub_pd(dValues[unHalf], dMean);
+			dMean = _mm_add_pd(dMean, _mm_mul_pd(dDelta, dInv));
+			_mm_storeu_pd(pHalfMean, dMean);
+			_mm_storeu_pd(pHalfSquares, _mm_add_pd(_mm_loadu_pd(pHalfSquares), _mm_mul_pd(dDelta, _mm_sub_pd(dValues[unHalf], dMean))));
+		}
+	}
+#endif	// _SIMD_SSE2_
+
+	for (; unIdx < unLen; unIdx++)
+	{
+		double dDelta = pFrame[unIdx] - pMean[unIdx];
+		pMean[unIdx] += dDelta * dInvNumFrames;
+		pSquares[unIdx] += dDelta * (pFrame[unIdx] - pMean[unIdx]);
+	}
+}
+
+/*
+ * @brief	constructor
+*/
+CFrameAccumulator::CFrameAccumulator()
+{
+	m_usHeight = 0;
+	m_usWidth = 0;
+	m_isDoublePrecision = false;
+	m_unNumFrames = 0;
+}
+
+/*
+ * @brief	destructor
+*/
+CFrameAccumulator::~CFrameAccumulator()
+{
+}
+
+/*
+ * @brief	add one frame
+ * @param	pFrame: height x width pixels
+ * @return	error code
+*/
+int CFrameAccumulator::AddFrame(const unsigned short* pFrame)
+{
+	if (nullptr == pFrame || 0 == m_usHeight)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	m_unNumFrames++;
+
+	size_t unWidth = m_usWidth;
+	CThreadPool::GetInstance()->ParallelFor(m_usHeight, [&](size_t unBegin, size_t unEnd)
+	{
+		// rows of a band are contiguous, accumulated as one long row
+		size_t unFirst = unBegin * unWidth;
+		size_t unLen = (unEnd - unBegin) * unWidth;
+		if (m_isDoublePrecision)
+		{
+			AccumulateRow(pFrame + unFirst, unLen, 1.0 / m_unNumFrames, &m_vecMeanDouble[unFirst], &m_vecSquaresDouble[unFirst]);
+		}
+		else
+		{
+			AccumulateRow(pFrame + unFirst, unLen, 1.0f / m_unNumFrames, &m_vecMean[unFirst], &m_vecSquares[unFirst]);
+		}
+	}, ACCUMULATOR_BAND_HEIGHT);
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	gain normalizing (flat - offset) to its mean over the frame, in [0, ACCUMULATOR_MAX_GAIN]. pixels whose
+ *			gain would exceed ACCUMULATOR_MAX_GAIN, including flat not above offset, get 0 and are flagged
+ * @param	pOffset: height x width, e.g. from GetOffsetMap of a dark accumulator
+ * @param	pGain: output, height x width
+ * @param	pDefectMap: height x width, DEFECT_GAIN_OUTLIER or'ed in for pixels of gain 0, nullptr to skip
+ * @return	error code
+*/
+int CFrameAccumulator::GetGainMap(const float* pOffset, float* pGain, unsigned char* pDefectMap) const
+{
+	int nProcResult = GetOffsetMap(pGain);
+	if (STATUS_OK != nProcResult || nullptr == pOffset)
+	{
+		return STATUS_OK != nProcResult ? nProcResult : INVALID_PARAMETER;
+	}
+
+	size_t unNumPixels = (size_t)m_usHeight * m_usWidth;
+	double dSum = 0;
+	size_t unNumValid = 0;
+	for (size_t unIdx = 0; unIdx < unNumPixels; unIdx++)
+	{
+		pGain[unIdx] -= pOffset[unIdx];
+		if (pGain[unIdx] > 0)
+		{
+			dSum += pGain[unIdx];
+			unNumValid++;
+		}
+	}
+
+	// a response near 0 would give an unbounded gain that SetMaps of CFlatField rejects, such pixels are dead
+	float fMean = 0 == unNumValid ? 0 : (float)(dSum / unNumValid);
+	float fMinResponse = fMean / ACCUMULATOR_MAX_GAIN;
+	for (size_t unIdx = 0; unIdx < unNumPixels; unIdx++)
+	{
+		if (pGain[unIdx] > 0 && pGain[unIdx] >= fMinResponse)
+		{
+			pGain[unIdx] = min(fMean / pGain[unIdx], ACCUMULATOR_MAX_GAIN);
+			continue;
+		}
+
+		pGain[unIdx] = 0;
+		if (nullptr != pDefectMap)
+		{
+			pDefectMap[unIdx] |= DEFECT_GAIN_OUTLIER;
+		}
+	}
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	height of frames
+ * @return	rows
+*/
+unsigned short CFrameAccumulator::GetHeight() const
+{
+	return m_usHeight;
+}
+
+/*
+ * @brief	standard deviation of each pixel over frames, the temporal noise
+ * @param	pNoise: output, height x width
+ * @return	error code, at least 2 frames needed
+*/
+int CFrameAccumulator::GetNoiseMap(float* pNoise) const
+{
+	int nProcResult = GetVarianceMap(pNoise);
+	if (STATUS_OK != nProcResult)
+	{
+		return nProcResult;
+	}
+
+	size_t unNumPixels = (size_t)m_usHeight * m_usWidth;
+	for (size_t unIdx = 0; unIdx < unNumPixels; unIdx++)
+	{
+		pNoise[unIdx] = sqrt(pNoise[unIdx]);
+	}
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	frames added since Reset
+ * @return	number of frames
+*/
+unsigned int CFrameAccumulator::GetNumFrames() const
+{
+	return m_unNumFrames;
+}
+
+/*
+ * @brief	mean of each pixel over frames
+ * @param	pOffset: output, height x width
+ * @return	error code, at least 1 frame needed
+*/
+int CFrameAccumulator::GetOffsetMap(float* pOffset) const
+{
+	if (nullptr == pOffset || 0 == m_unNumFrames)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	size_t unNumPixels = (size_t)m_usHeight * m_usWidth;
+	for (size_t unIdx = 0; unIdx < unNumPixels; unIdx++)
+	{
+		pOffset[unIdx] = m_isDoublePrecision ? (float)m_vecMeanDouble[unIdx] : m_vecMean[unIdx];
+	}
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	sample variance of each pixel over frames
+ * @param	pVariance: output, height x width
+ * @return	error code, at least 2 frames needed
+*/
+int CFrameAccumulator::GetVarianceMap(float* pVariance) const
+{
+	if (nullptr == pVariance || m_unNumFrames < 2)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	// rounding may leave tiny negative sums for constant pixels
+	size_t unNumPixels = (size_t)m_usHeight * m_usWidth;
+	double dInvDegrees = 1.0 / (m_unNumFrames - 1);
+	for (size_t unIdx = 0; unIdx < unNumPixels; unIdx++)
+	{
+		double dSquares = m_isDoublePrecision ? m_vecSquaresDouble[unIdx] : m_vecSquares[unIdx];
+		pVariance[unIdx] = dSquares > 0 ? (float)(dSquares * dInvDegrees) : 0;
+	}
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	width of frames
+ * @return	columns
+*/
+unsigned short CFrameAccumulator::GetWidth() const
+{
+	return m_usWidth;
+}
+
+/*
+ * @brief	drop all frames and set frame size
+ * @param	usHeight
+ * @param	usWidth
+ * @param	isDoublePrecision: 64-bit accumulators, for thousands of frames or when variance is tiny relative to mean
+ * @return	error code
+*/
+int CFrameAccumulator::Reset(unsigned short usHeight, unsigned short usWidth, bool isDoublePrecision)
+{
+	size_t unNumPixels = (size_t)usHeight * usWidth;
+	if (0 == unNumPixels)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	m_usHeight = usHeight;
+	m_usWidth = usWidth;
+	m_isDoublePrecision = isDoublePrecision;
+	m_unNumFrames = 0;
+
+	// only the buffers of the chosen precision hold memory
+	vector<float>().swap(m_vecMean);
+	vector<float>().swap(m_vecSquares);
+	vector<double>().swap(m_vecMeanDouble);
+	vector<double>().swap(m_vecSquaresDouble);
+	if (m_isDoublePrecision)
+	{
+		m_vecMeanDouble.resize(unNumPixels, 0);
+		m_vecSquaresDouble.resize(unNumPixels, 0);
+	}
+	else
+	{
+		m_vecMean.resize(unNumPixels, 0);
+		m_vecSquares.resize(unNumPixels, 0);
+	}
+
+	return STATUS_OK;
+}
@@ -0,0 +1,132 @@
+/***************************************************
+ * @file		FrameAccumulator.h
+ * @section		Common
+ * @class		CFrameAccumulator
+ * @brief		per-pixel running mean and variance of a stream of frames, source of offset, gain and noise maps
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#ifndef __FRAME_ACCUMULATOR_H__
+#define __FRAME_ACCUMULATOR_H__
+
+#include <vector>
+
+#include "MacroDeclSpec.h"
+
+// rows of a frame accumulated by one task
+#define ACCUMULATOR_BAND_HEIGHT	32
+
+// largest gain of GetGainMap, pixels responding less than the mean over it are dead
+#define ACCUMULATOR_MAX_GAIN	64.0f
+
+/*
+ * @class	CFrameAccumulator
+ * @brief	Welford updates, memory is a mean and a sum of squared deviations per pixel whatever the number of frames.
+ *			dark frames give the offset and noise maps, flat frames together with the offset give the gain map
+*/
+class _DLL_EXPORT_ CFrameAccumulator
+{
+public:
+	/*
+	 * @brief	constructor
+	*/
+	CFrameAccumulator();
+
+	/*
+	 * @brief	destructor
+	*/
+	~CFrameAccumulator();
+
+	/*
+	 * @brief	add one frame
+	 * @param	pFrame: height x width pixels
+	 * @return	error code
+	*/
+	int AddFrame(const unsigned short* pFrame);
+
+	/*
+	 * @brief	gain normalizing (flat - offset) to its mean over the frame, in [0, ACCUMULATOR_MAX_GAIN]. pixels whose
+	 *			gain would exceed ACCUMULATOR_MAX_GAIN, including flat not above offset, get 0 and are flagged
+	 * @param	pOffset: height x width, e.g. from GetOffsetMap of a dark accumulator
+	 * @param	pGain: output, height x width
+	 * @param	pDefectMap: height x width, DEFECT_GAIN_OUTLIER or'ed in for pixels of gain 0, nullptr to skip
+	 * @return	error code
+	*/
+	int GetGainMap(const float* pOffset, float* pGain, unsigned char* pDefectMap = nullptr) const;
+
+	/*
+	 * @brief	height of frames
+	 * @return	rows
+	*/
+	unsigned short GetHeight() const;
+
+	/*
+	 * @brief	standard deviation of each pixel over frames, the temporal noise
+	 * @param	pNoise: output, height x width
+	 * @return	error code, at least 2 frames needed
+	*/
+	int GetNoiseMap(float* pNoise) const;
+
+	/*
+	 * @brief	frames added since Reset
+	 * @return	number of frames
+	*/
+	unsigned int GetNumFrames() const;
+
+	/*
+	 * @brief	mean of each pixel over frames
+	 * @param	pOffset: output, height x width
+	 * @return	error code, at least 1 frame needed
+	*/
+	int GetOffsetMap(float* pOffset) const;
+
+	/*
+	 * @brief	sample variance of each pixel over frames
+	 * @param	pVariance: output, height x width
+	 * @return	error code, at least 2 frames needed
+	*/
+	int GetVarianceMap(float* pVariance) const;
+
+	/*
+	 * @brief	width of frames
+	 * @return	columns
+	*/
+	unsigned short GetWidth() const;
+
+	/*
+	 * @brief	drop all frames and set frame size
+	 * @param	usHeight
+	 * @param	usWidth
+	 * @param	isDoublePrecision: 64-bit accumulators, for thousands of frames or when variance is tiny relative to mean
+	 * @return	error code
+	*/
+	int Reset(unsigned short usHeight, unsigned short usWidth, bool isDoublePrecision = false);
+
+private:
+	unsigned short m_usHeight;
+	unsigned short m_usWidth;
+
+	bool m_isDoublePrecision;
+
+	unsigned int m_unNumFrames;
+
+	std::vector<float> m_vecMean;
+	std::vector<float> m_vecSquares;		///< sum of squared deviations from the mean
+	std::vector<double> m_vecMeanDouble;
+	std::vector<double> m_vecSquaresDouble;
+};
+
+//#ifdef __cplusplus
+//extern "C"
+//{
+//#endif // __cplusplus
+//
+//
+//#ifdef __cplusplus
+//};
+//#endif // __cplusplus
+
+#endif	// __FRAME_ACCUMULATOR_H__
@@ -0,0 +1,406 @@
+/***************************************************
+ * @file		GridSuppression.cpp
+ * @section		Common
+ * @class		CGridSuppression
+ * @brief		removal of anti-scatter grid lines by notch filtering 1D spectra across the lines
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+#include <math.h>
+
+#include "opencv/cv.h"
+
+#include "Constants.h"
+#include "CvFFT2D.h"
+#include "GridSuppression.h"
+#include "ImageFilter.h"
+#include "IntlMsgAliasID.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+/*
+ * @brief	least length of the transform of a line, long enough to hold the blend from its end back to its start
+ * @param	nLen: pixels of a line
+ * @return	length, padded further by the transform context
+*/
+static int GetGridPaddedLength(int nLen)
+{
+	return nLen + max(GRID_MIN_PADDING, nLen / 8);
+}
+
+/*
+ * @brief	copy lines across the grid into the rows of a transform buffer. the padding of each line blends smoothly from its
+ *			last value back to its first, so that the periodic extension seen by the transform has no step to leak into the notch
+ * @param	pFrame
+ * @param	usHeight
+ * @param	usWidth
+ * @param	nOrientation: rows are lines for vertical grid lines, columns otherwise
+ * @param	nFirstLine
+ * @param	nNumLines: at most the rows of cvLines, remaining rows are zeroed
+ * @param	cvLines: output, CV_32FC1, columns at least the line length
+*/
+static void LoadGridLines(const unsigned short* pFrame, unsigned short usHeight, unsigned short usWidth, GridOrientation nOrientation,
+	int nFirstLine, int nNumLines, cv::Mat& cvLines)
+{
+	int nLen = GridLinesVertical == nOrientation ? usWidth : usHeight;
+	if (GridLinesVertical == nOrientation)
+	{
+		for (int nLineIdx = 0; nLineIdx < nNumLines; nLineIdx++)
+		{
+			LoadFilterRow(pFrame + (size_t)(nFirstLine + nLineIdx) * usWidth, usWidth, cvLines.ptr<float>(nLineIdx));
+		}
+	}
+	else
+	{
+		// image rows are read in order, each giving one value to every line of the band
+		for (int nRowIdx = 0; nRowIdx < usHeight; nRowIdx++)
+		{
+			const unsigned short* pRow = pFrame + (size_t)nRowIdx * usWidth + nFirstLine;
+			for (int nLineIdx = 0; nLineIdx < nNumLines; nLineIdx++)
+			{
+				cvLines.ptr<float>(nLineIdx)[nRowIdx] = pRow[nLineIdx];
+			}
+		}
+	}
+
+	int nNumPadding = cvLines.cols - nLen;
+	for (int nLineIdx = 0; nLineIdx < nNumLines; nLineIdx++)
+	{
+		float* pLine = cvLines.ptr<float>(nLineIdx);
+		float fLast = pLine[nLen - 1];
+		float fJump = pLine[0] - fLast;
+		for (int nPadIdx = 0; nPadIdx < nNumPadding; nPadIdx++)
+		{
+			pLine[nLen + nPadIdx] = fLast + fJump * (float)(0.5 - 0.5 * cos(PI * (nPadIdx + 1) / (nNumPadding + 1)));
+		}
+	}
+
+	if (nNumLines < cvLines.rows)
+	{
+		cvLines.rowRange(nNumLines, cvLines.rows).setTo(0);
+	}
+}
+
+/*
+ * @brief	write filtered lines back, rounded and clamped
+ * @param	cvLines
+ * @param	usHeight
+ * @param	usWidth
+ * @param	nOrientation
+ * @param	nFirstLine
+ * @param	nNumLines
+ * @param	pFrame: output
+*/
+static void StoreGridLines(const cv::Mat& cvLines, unsigned short usHeight, unsigned short usWidth, GridOrientation nOrientation,
+	int nFirstLine, int nNumLines, unsigned short* pFrame)
+{
+	if (GridLinesVertical == nOrientation)
+	{
+		for (int nLineIdx = 0; nLineIdx < nNumLines; nLineIdx++)
+		{
+			StoreFilterRow(cvLines.ptr<float>(nLineIdx), usWidth, pFrame + (size_t)(nFirstLine + nLineIdx) * usWidth);
+		}
+		return;
+	}
+
+	for (int nRowIdx = 0; nRowIdx < usHeight; nRowIdx++)
+	{
+		unsigned short* pRow = pFrame + (size_t)nRowIdx * usWidth + nFirstLine;
+		for (int nLineIdx = 0; nLineIdx < nNumLines; nLineIdx++)
+		{
+			float fValue = cvLines.ptr<float>(nLineIdx)[nRowIdx];
+			pRow[nLineIdx] = fValue <= 0 ? 0 : (fValue >= 65535.0f ? 65535 : (unsigned short)(fValue + 0.5f));
+		}
+	}
+}
+
+/*
+ * @brief	gain of each entry of a packed 1D real spectrum, product of Gaussian notches at the grid frequency and its harmonics
+ * @param	nLen: transform length
+ * @param	fFrequency: cycles / pixel
+ * @param	fNotchWidth: cycles / pixel
+ * @param	vecGain: output, nLen gains in CCS order
+*/
+static void BuildNotch(int nLen, float fFrequency, float fNotchWidth, vector<float>& vecGain)
+{
+	// harmonics above Nyquist alias like the grid does, those folding onto low frequencies are left alone
+	vector<double> vecNotches;
+	for (int nHarmonic = 1; nHarmonic <= GRID_NUM_HARMONICS; nHarmonic++)
+	{
+		double dFreq = fmod((double)nHarmonic * fFrequency, 1.0);
+		dFreq = dFreq > 0.5 ? 1.0 - dFreq : dFreq;
+		if (1 == nHarmonic || dFreq > 3 * fNotchWidth)
+		{
+			vecNotches.push_back(dFreq);
+		}
+	}
+
+	auto funcGain = [&](int nBin) -> float
+	{
+		double dGain = 1;
+		for (size_t unNotchIdx = 0; unNotchIdx < vecNotches.size(); unNotchIdx++)
+		{
+			double dDist = (double)nBin / nLen - vecNotches[unNotchIdx];
+			dGain *= 1 - exp(-dDist * dDist / (2.0 * fNotchWidth * fNotchWidth));
+		}
+		return (float)dGain;
+	};
+
+	// packed as Re0, Re1, Im1, Re2, Im2, ..., and Re(n / 2) last for even lengths
+	vecGain.resize(nLen);
+	vecGain[0] = funcGain(0);
+	for (int nBin = 1; 2 * nBin - 1 < nLen; nBin++)
+	{
+		vecGain[2 * nBin - 1] = funcGain(nBin);
+		if (2 * nBin < nLen)
+		{
+			vecGain[2 * nBin] = vecGain[2 * nBin - 1];
+		}
+	}
+}
+
+/*
+ * @brief	constructor
+*/
+CGridSuppression::CGridSuppression()
+{
+	m_isEnabled = false;
+	m_nOrientation = GridLinesVertical;
+	m_fFrequency = 0;
+	m_fNotchWidth = GRID_NOTCH_WIDTH;
+}
+
+/*
+ * @brief	destructor
+*/
+CGridSuppression::~CGridSuppression()
+{
+}
+
+/*
+ * @brief	notch the grid out of a frame in place, nothing is done while disabled
+ * @param	pFrame: height x width pixels
+ * @param	usHeight
+ * @param	usWidth
+ * @return	error code
+*/
+int CGridSuppression::Apply(unsigned short* pFrame, unsigned short usHeight, unsigned short usWidth) const
+{
+	if (nullptr == pFrame || 0 == usHeight || 0 == usWidth)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	if (!m_isEnabled)
+	{
+		return STATUS_OK;
+	}
+
+	int nLen = GridLinesVertical == m_nOrientation ? usWidth : usHeight;
+	int nNumLines = GridLinesVertical == m_nOrientation ? usHeight : usWidth;
+	int nBandLines = min(nNumLines, GRID_BAND_LINES);
+
+	vector<float> vecGain;
+	BuildNotch(cv::getOptimalDFTSize(GetGridPaddedLength(nLen)), m_fFrequency, m_fNotchWidth, vecGain);
+
+	CThreadPool::GetInstance()->ParallelFor((nNumLines + nBandLines - 1) / nBandLines, [&](size_t unBandBegin, size_t unBandEnd)
+	{
+		CCvFFTContext oContext;
+		oContext.Prepare(nBandLines, GetGridPaddedLength(nLen), true, true, true);
+		cv::Mat& cvLines = oContext.GetSpectrum();
+
+		for (size_t unBandIdx = unBandBegin; unBandIdx < unBandEnd; unBandIdx++)
+		{
+			int nFirstLine = (int)unBandIdx * nBandLines;
+			int nNumBandLines = min(nBandLines, nNumLines - nFirstLine);
+
+			LoadGridLines(pFrame, usHeight, usWidth, m_nOrientation, nFirstLine, nNumBandLines, cvLines);
+			oContext.Transform(false);
+			for (int nLineIdx = 0; nLineIdx < nNumBandLines; nLineIdx++)
+			{
+				float* pLine = cvLines.ptr<float>(nLineIdx);
+				for (int nColIdx = 0; nColIdx < cvLines.cols; nColIdx++)
+				{
+					pLine[nColIdx] *= vecGain[nColIdx];
+				}
+			}
+			oContext.Transform(true);
+			StoreGridLines(cvLines, usHeight, usWidth, m_nOrientation, nFirstLine, nNumBandLines, pFrame);
+		}
+	}, 1);
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	find the grid as the strongest peak of the mean power spectrum of lines across it, relative to its
+ *			neighbourhood. enabled if the peak is strong enough, disabled otherwise
+ * @param	pFrame: height x width pixels, e.g. a flat frame taken with the grid
+ * @param	usHeight
+ * @param	usWidth
+ * @param	nOrientation
+ * @param	fMinFrequency: cycles / pixel, lower frequencies are anatomy and never taken for the grid
+ * @param	fMinPeakRatio: least ratio of the peak to the median power around it
+ * @return	error code
+*/
+int CGridSuppression::Detect(const unsigned short* pFrame, unsigned short usHeight, unsigned short usWidth, GridOrientation nOrientation,
+	float fMinFrequency, float fMinPeakRatio)
+{
+	if (nullptr == pFrame || 0 == usHeight || 0 == usWidth || !(fMinFrequency >= 0 && fMinFrequency < 0.5f) || !(fMinPeakRatio > 1))
+	{
+		return INVALID_PARAMETER;
+	}
+
+	Disable();
+
+	int nLen = GridLinesVertical == nOrientation ? usWidth : usHeight;
+	int nNumLines = GridLinesVertical == nOrientation ? usHeight : usWidth;
+	int nBandLines = min(nNumLines, GRID_BAND_LINES);
+	int nPadded = cv::getOptimalDFTSize(GetGridPaddedLength(nLen));
+	int nNumBins = nPadded / 2 + 1;
+
+	// mean power spectrum of all lines, summed per task and merged once
+	vector<double> vecPower(nNumBins, 0);
+	mutex oMergeLock;
+	CThreadPool::GetInstance()->ParallelFor((nNumLines + nBandLines - 1) / nBandLines, [&](size_t unBandBegin, size_t unBandEnd)
+	{
+		CCvFFTContext oContext;
+		oContext.Prepare(nBandLines, GetGridPaddedLength(nLen), true, true, true);
+		cv::Mat& cvLines = oContext.GetSpectrum();
+		vector<double> vecBandPower(nNumBins, 0);
+
+		for (size_t unBandIdx = unBandBegin; unBandIdx < unBandEnd; unBandIdx++)
+		{
+			int nFirstLine = (int)unBandIdx * nBandLines;
+			int nNumBandLines = min(nBandLines, nNumLines - nFirstLine);
+
+			LoadGridLines(pFrame, usHeight, usWidth, nOrientation, nFirstLine, nNumBandLines, cvLines);
+			oContext.Transform(false);
+			for (int nLineIdx = 0; nLineIdx < nNumBandLines; nLineIdx++)
+			{
+				const float* pLine = cvLines.ptr<float>(nLineIdx);
+				for (int nBin = 1; 2 * nBin - 1 < nPadded; nBin++)
+				{
+					double dImag = 2 * nBin < nPadded ? pLine[2 * nBin] : 0;
+					vecBandPower[nBin] += (double)pLine[2 * nBin - 1] * pLine[2 * nBin - 1] + dImag * dImag;
+				}
+			}
+		}
+
+		lock_guard<mutex> oLock(oMergeLock);
+		for (int nBin = 0; nBin < nNumBins; nBin++)
+		{
+			vecPower[nBin] += vecBandPower[nBin];
+		}
+	}, 1);
+
+	// local maxima compared to the median of their neighbourhood, the peak itself and its shoulders excluded
+	int nFirstBin = max(2, (int)ceil(fMinFrequency * nPadded));
+	int nPeakBin = -1;
+	double dPeakRatio = fMinPeakRatio;
+	vector<double> vecAround;
+	for (int nBin = nFirstBin; nBin + 1 < nNumBins; nBin++)
+	{
+		if (vecPower[nBin] < vecPower[nBin - 1] || vecPower[nBin] < vecPower[nBin + 1])
+		{
+			continue;
+		}
+
+		vecAround.clear();
+		for (int nNearBin = max(1, nBin - GRID_PEAK_WINDOW); nNearBin <= min(nNumBins - 1, nBin + GRID_PEAK_WINDOW); nNearBin++)
+		{
+			if (abs(nNearBin - nBin) > 2)
+			{
+				vecAround.push_back(vecPower[nNearBin]);
+			}
+		}
+		nth_element(vecAround.begin(), vecAround.begin() + vecAround.size() / 2, vecAround.end());
+
+		double dBackground = vecAround[vecAround.size() / 2];
+		if (vecPower[nBin] > dPeakRatio * dBackground)
+		{
+			dPeakRatio = 0 == dBackground ? HUGE_VAL : vecPower[nBin] / dBackground;
+			nPeakBin = nBin;
+		}
+	}
+
+	if (-1 == nPeakBin)
+	{
+		return STATUS_OK;
+	}
+
+	// parabola through the log power of the peak and its neighbours, for a frequency between bins
+	double dLeft = log(vecPower[nPeakBin - 1] + 1e-30);
+	double dCenter = log(vecPower[nPeakBin] + 1e-30);
+	double dRight = log(vecPower[nPeakBin + 1] + 1e-30);
+	double dCurvature = dLeft - 2 * dCenter + dRight;
+	double dShift = dCurvature < 0 ? 0.5 * (dLeft - dRight) / dCurvature : 0;
+
+	return SetGrid(nOrientation, (float)((nPeakBin + dShift) / nPadded), m_fNotchWidth);
+}
+
+/*
+ * @brief	stop filtering
+*/
+void CGridSuppression::Disable()
+{
+	m_isEnabled = false;
+	m_fFrequency = 0;
+}
+
+/*
+ * @brief	grid frequency
+ * @return	cycles / pixel, 0 if disabled
+*/
+float CGridSuppression::GetFrequency() const
+{
+	return m_fFrequency;
+}
+
+/*
+ * @brief	direction of grid lines
+ * @return	orientation
+*/
+GridOrientation CGridSuppression::GetOrientation() const
+{
+	return m_nOrientation;
+}
+
+/*
+ * @brief	whether Apply filters frames
+ * @return	true if a grid is set
+*/
+bool CGridSuppression::IsEnabled() const
+{
+	return m_isEnabled;
+}
+
+/*
+ * @brief	set a known grid and enable filtering
+ * @param	nOrientation
+ * @param	fFrequency: cycles / pixel, in (0, 0.5]
+ * @param	fNotchWidth: standard deviation of the notch, cycles / pixel
+ * @return	error code
+*/
+int CGridSuppression::SetGrid(GridOrientation nOrientation, float fFrequency, float fNotchWidth)
+{
+	if (!(fFrequency > 0 && fFrequency <= 0.5f) || !(fNotchWidth > 0))
+	{
+		return INVALID_PARAMETER;
+	}
+
+	m_isEnabled = true;
+	m_nOrientation = nOrientation;
+	m_fFrequency = fFrequency;
+	m_fNotchWidth = fNotchWidth;
+
+	return STATUS_OK;
+}
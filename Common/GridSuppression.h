@@ -0,0 +1,132 @@
+/***************************************************
+ * @file		GridSuppression.h
+ * @section		Common
+ * @class		CGridSuppression
+ * @brief		removal of anti-scatter grid lines by notch filtering 1D spectra across the lines
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#ifndef __GRID_SUPPRESSION_H__
+#define __GRID_SUPPRESSION_H__
+
+#include "MacroDeclSpec.h"
+
+// lines transformed together by one task
+#define GRID_BAND_LINES		32
+
+// least padding of a line, where it blends back to its start
+#define GRID_MIN_PADDING	32
+
+// default standard deviation of the Gaussian notch, cycles / pixel
+#define GRID_NOTCH_WIDTH	0.005f
+
+// harmonics of the grid frequency notched, aliased ones folded back below Nyquist
+#define GRID_NUM_HARMONICS	3
+
+// bins on each side of a candidate peak giving the background it is compared to
+#define GRID_PEAK_WINDOW	16
+
+/* direction of grid lines in the frame */
+enum GridOrientation
+{
+	GridLinesVertical,		///< lines along columns, rows are filtered
+	GridLinesHorizontal		///< lines along rows, columns are filtered
+};
+
+/*
+ * @class	CGridSuppression
+ * @brief	each row, or column, of a frame is transformed on its own, batches of GRID_BAND_LINES lines per cv::dft call,
+ *			multiplied by a notch at the grid frequency and its harmonics, and transformed back. the grid is found once by
+ *			Detect or given by SetGrid, Apply then costs two 1D transforms per line and does nothing while disabled
+*/
+class _DLL_EXPORT_ CGridSuppression
+{
+public:
+	/*
+	 * @brief	constructor
+	*/
+	CGridSuppression();
+
+	/*
+	 * @brief	destructor
+	*/
+	~CGridSuppression();
+
+	/*
+	 * @brief	notch the grid out of a frame in place, nothing is done while disabled
+	 * @param	pFrame: height x width pixels
+	 * @param	usHeight
+	 * @param	usWidth
+	 * @return	error code
+	*/
+	int Apply(unsigned short* pFrame, unsigned short usHeight, unsigned short usWidth) const;
+
+	/*
+	 * @brief	find the grid as the strongest peak of the mean power spectrum of lines across it, relative to its
+	 *			neighbourhood. enabled if the peak is strong enough, disabled otherwise
+	 * @param	pFrame: height x width pixels, e.g. a flat frame taken with the grid
+	 * @param	usHeight
+	 * @param	usWidth
+	 * @param	nOrientation
+	 * @param	fMinFrequency: cycles / pixel, lower frequencies are anatomy and never taken for the grid
+	 * @param	fMinPeakRatio: least ratio of the peak to the median power around it
+	 * @return	error code
+	*/
+	int Detect(const unsigned short* pFrame, unsigned short usHeight, unsigned short usWidth, GridOrientation nOrientation,
+		float fMinFrequency = 0.05f, float fMinPeakRatio = 10.0f);
+
+	/*
+	 * @brief	stop filtering
+	*/
+	void Disable();
+
+	/*
+	 * @brief	grid frequency
+	 * @return	cycles / pixel, 0 if disabled
+	*/
+	float GetFrequency() const;
+
+	/*
+	 * @brief	direction of grid lines
+	 * @return	orientation
+	*/
+	GridOrientation GetOrientation() const;
+
+	/*
+	 * @brief	whether Apply filters frames
+	 * @return	true if a grid is set
+	*/
+	bool IsEnabled() const;
+
+	/*
+	 * @brief	set a known grid and enable filtering
+	 * @param	nOrientation
+	 * @param	fFrequency: cycles / pixel, in (0, 0.5]
+	 * @param	fNotchWidth: standard deviation of the notch, cycles / pixel
+	 * @return	error code
+	*/
+	int SetGrid(GridOrientation nOrientation, float fFrequency, float fNotchWidth = GRID_NOTCH_WIDTH);
+
+private:
+	bool m_isEnabled;
+
+	GridOrientation m_nOrientation;
+
+	float m_fFrequency;
+	float m_fNotchWidth;
+};
+
+//#ifdef __cplusplus
+//extern "C"
+//{
+//#endif // __cplusplus
+//
+//
+//#ifdef __cplusplus
+//};
+//#endif // __cplusplus
+
+#endif	// __GRID_SUPPRESSION_H__
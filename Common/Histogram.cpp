@@ -0,0 +1,312 @@
+/***************************************************
+ * @file		Histogram.cpp
+ * @section		Common
+ * @class		CHistogram
+ * @brief		integer histogram of 8 to 16-bit images with percentile, auto window and exposure index queries
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#include <algorithm>
+
+#include <math.h>
+#include <string.h>
+
+#include "Histogram.h"
+#include "IntlMsgAliasID.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+/*
+ * @brief	count pixels into HISTOGRAM_NUM_COPIES interleaved arrays
+ * @param	pSrc
+ * @param	unNumPixels
+ * @param	unMaxValue: larger values are counted in this bin
+ * @param	pCounts: HISTOGRAM_NUM_COPIES x unNumBins, zeroed
+ * @param	unNumBins
+*/
+template<typename T>
+static void CountPixels(const T* pSrc, size_t unNumPixels, unsigned int unMaxValue, unsigned int* pCounts, size_t unNumBins)
+{
+	unsigned int* pCounts0 = pCounts;
+	unsigned int* pCounts1 = pCounts + unNumBins;
+	unsigned int* pCounts2 = pCounts + 2 * unNumBins;
+	unsigned int* pCounts3 = pCounts + 3 * unNumBins;
+
+	size_t unIdx = 0;
+	if (unMaxValue + 1 == unNumBins && unNumBins == (size_t)1 << (8 * sizeof(T)))
+	{
+		// every value has its bin
+		for (; unIdx + 4 <= unNumPixels; unIdx += 4)
+		{
+			pCounts0[pSrc[unIdx]]++;
+			pCounts1[pSrc[unIdx + 1]]++;
+			pCounts2[pSrc[unIdx + 2]]++;
+			pCounts3[pSrc[unIdx + 3]]++;
+		}
+	}
+	else
+	{
+		for (; unIdx + 4 <= unNumPixels; unIdx += 4)
+		{
+			pCounts0[min((unsigned int)pSrc[unIdx], unMaxValue)]++;
+			pCounts1[min((unsigned int)pSrc[unIdx + 1], unMaxValue)]++;
+			pCounts2[min((unsigned int)pSrc[unIdx + 2], unMaxValue)]++;
+			pCounts3[min((unsigned int)pSrc[unIdx + 3], unMaxValue)]++;
+		}
+	}
+
+	for (; unIdx < unNumPixels; unIdx++)
+	{
+		pCounts0[min((unsigned int)pSrc[unIdx], unMaxValue)]++;
+	}
+}
+
+/*
+ * @brief	split pixels between tasks, each counting into its own arrays
+ * @param	pSrc
+ * @param	unNumPixels
+ * @param	unNumBins
+ * @param	vecTaskCounts: output, HISTOGRAM_NUM_COPIES arrays of unNumBins per task
+ * @return	number of tasks
+*/
+template<typename T>
+static size_t CountTasks(const T* pSrc, size_t unNumPixels, size_t unNumBins, vector<unsigned int>& vecTaskCounts)
+{
+	size_t unNumTasks = unNumPixels < HISTOGRAM_MIN_PARALLEL ? 1 : CThreadPool::GetInstance()->GetNumWorkers() + 1;
+	size_t unTaskSize = HISTOGRAM_NUM_COPIES * unNumBins;
+	if (vecTaskCounts.size() < unNumTasks * unTaskSize)
+	{
+		vecTaskCounts.resize(unNumTasks * unTaskSize);
+	}
+
+	CThreadPool::GetInstance()->ParallelFor(unNumTasks, [&](size_t unBegin, size_t unEnd)
+	{
+		for (size_t unTaskIdx = unBegin; unTaskIdx < unEnd; unTaskIdx++)
+		{
+			// arrays are cleared by their task, while the caches they go to are warm
+			unsigned int* pCounts = vecTaskCounts.data() + unTaskIdx * unTaskSize;
+			memset(pCounts, 0, unTaskSize * sizeof(unsigned int));
+
+			size_t unFirst = unNumPixels * unTaskIdx / unNumTasks;
+			size_t unLast = unNumPixels * (unTaskIdx + 1) / unNumTasks;
+			CountPixels(pSrc + unFirst, unLast - unFirst, (unsigned int)unNumBins - 1, pCounts, unNumBins);
+		}
+	}, 1);
+
+	return unNumTasks;
+}
+
+/*
+ * @brief	constructor
+*/
+CHistogram::CHistogram()
+{
+	m_unNumBins = 0;
+	m_unNumPixels = 0;
+}
+
+/*
+ * @brief	destructor
+*/
+CHistogram::~CHistogram()
+{
+}
+
+/*
+ * @brief	count 8-bit pixels into 256 bins
+ * @param	pSrc
+ * @param	unNumPixels
+ * @return	error code
+*/
+int CHistogram::Compute(const unsigned char* pSrc, size_t unNumPixels)
+{
+	if (nullptr == pSrc || 0 == unNumPixels || unNumPixels > 0xFFFFFFFF)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	m_unNumBins = 256;
+	m_unNumPixels = unNumPixels;
+	Merge(CountTasks(pSrc, unNumPixels, m_unNumBins, m_vecTaskCounts));
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	count pixels into 2 ^ bit depth bins, values beyond go to the last bin
+ * @param	pSrc
+ * @param	unNumPixels
+ * @param	unBitDepth: stored bits of pixels, in [1, 16]
+ * @return	error code
+*/
+int CHistogram::Compute(const unsigned short* pSrc, size_t unNumPixels, unsigned int unBitDepth)
+{
+	if (nullptr == pSrc || 0 == unNumPixels || unNumPixels > 0xFFFFFFFF || 0 == unBitDepth || unBitDepth > 16)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	m_unNumBins = (size_t)1 << unBitDepth;
+	m_unNumPixels = unNumPixels;
+	Merge(CountTasks(pSrc, unNumPixels, m_unNumBins, m_vecTaskCounts));
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	window covering the pixels between two percentiles, for CWindowLevel
+ * @param	fCenter: output, (low + high + 1) / 2
+ * @param	fWidth: output, high - low + 1
+ * @param	fLowPercent
+ * @param	fHighPercent: above fLowPercent
+ * @return	error code
+*/
+int CHistogram::GetAutoWindow(float& fCenter, float& fWidth, float fLowPercent, float fHighPercent) const
+{
+	if (0 == m_unNumPixels || !(fLowPercent >= 0 && fLowPercent < fHighPercent && fHighPercent <= 100))
+	{
+		return INVALID_PARAMETER;
+	}
+
+	unsigned short usLow = GetPercentile(fLowPercent);
+	unsigned short usHigh = GetPercentile(fHighPercent);
+	fCenter = (usLow + usHigh + 1) / 2.0f;
+	fWidth = usHigh - usLow + 1.0f;
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	pixel count of each bin
+ * @return	2 ^ bit depth counts
+*/
+const std::vector<unsigned int>& CHistogram::GetCounts() const
+{
+	return m_vecCounts;
+}
+
+/*
+ * @brief	pixels up to each bin, included
+ * @return	2 ^ bit depth counts
+*/
+const std::vector<unsigned int>& CHistogram::GetCumulative() const
+{
+	return m_vecCumulative;
+}
+
+/*
+ * @brief	exposure index of IEC 62494-1, 100 times the air kerma in uGy at the value of interest. the value of interest
+ *			is the median of the pixels between two percentiles, leaving out collimated and direct exposure areas
+ * @param	fKermaPerValue: uGy per pixel value above fOffset, from detector calibration
+ * @param	fOffset: pixel value without exposure
+ * @param	fLowPercent
+ * @param	fHighPercent: above fLowPercent
+ * @return	exposure index, negative without pixels
+*/
+float CHistogram::GetExposureIndex(float fKermaPerValue, float fOffset, float fLowPercent, float fHighPercent) const
+{
+	if (0 == m_unNumPixels || !(fLowPercent >= 0 && fLowPercent < fHighPercent && fHighPercent <= 100))
+	{
+		return -1.0f;
+	}
+
+	// median of the pixels with values in [low, high]
+	unsigned short usLow = GetPercentile(fLowPercent);
+	unsigned short usHigh = GetPercentile(fHighPercent);
+	size_t unBelow = 0 == usLow ? 0 : m_vecCumulative[usLow - 1];
+	size_t unRank = unBelow + (m_vecCumulative[usHigh] - unBelow + 1) / 2;
+	float fValueOfInterest = FindRank(unRank);
+
+	return 100.0f * fKermaPerValue * max(fValueOfInterest - fOffset, 0.0f);
+}
+
+/*
+ * @brief	largest pixel value
+ * @return	value, 0 without pixels
+*/
+unsigned short CHistogram::GetMax() const
+{
+	return 0 == m_unNumPixels ? 0 : FindRank(m_unNumPixels);
+}
+
+/*
+ * @brief	smallest pixel value
+ * @return	value, 0 without pixels
+*/
+unsigned short CHistogram::GetMin() const
+{
+	return 0 == m_unNumPixels ? 0 : FindRank(1);
+}
+
+/*
+ * @brief	pixels counted
+ * @return	number of pixels
+*/
+size_t CHistogram::GetNumPixels() const
+{
+	return m_unNumPixels;
+}
+
+/*
+ * @brief	smallest value with at least fPercent of pixels not above it, a binary search of the cumulative table
+ * @param	fPercent: in [0, 100]
+ * @return	value, 0 without pixels
+*/
+unsigned short CHistogram::GetPercentile(float fPercent) const
+{
+	if (0 == m_unNumPixels)
+	{
+		return 0;
+	}
+
+	double dRank = ceil(min(max((double)fPercent, 0.0), 100.0) / 100.0 * m_unNumPixels);
+	return FindRank(max((size_t)dRank, (size_t)1));
+}
+
+/*
+ * @brief	smallest value whose cumulative count reaches a rank
+ * @param	unRank: in [1, number of pixels]
+ * @return	value
+*/
+unsigned short CHistogram::FindRank(size_t unRank) const
+{
+	return (unsigned short)(lower_bound(m_vecCumulative.begin(), m_vecCumulative.end(), (unsigned int)unRank) - m_vecCumulative.begin());
+}
+
+/*
+ * @brief	sum the counts of tasks and build the cumulative table
+ * @param	unNumTasks
+*/
+void CHistogram::Merge(size_t unNumTasks)
+{
+	m_vecCounts.resize(m_unNumBins);
+	m_vecCumulative.resize(m_unNumBins);
+
+	size_t unNumArrays = unNumTasks * HISTOGRAM_NUM_COPIES;
+	const unsigned int* pTaskCounts = m_vecTaskCounts.data();
+	unsigned int* pCounts = m_vecCounts.data();
+	size_t unNumBins = m_unNumBins;
+	CThreadPool::GetInstance()->ParallelFor(unNumBins, [&](size_t unBegin, size_t unEnd)
+	{
+		memcpy(pCounts + unBegin, pTaskCounts + unBegin, (unEnd - unBegin) * sizeof(unsigned int));
+		for (size_t unArrayIdx = 1; unArrayIdx < unNumArrays; unArrayIdx++)
+		{
+			const unsigned int* pArray = pTaskCounts + unArrayIdx * unNumBins;
+			for (size_t unBinIdx = unBegin; unBinIdx < unEnd; unBinIdx++)
+			{
+				pCounts[unBinIdx] += pArray[unBinIdx];
+			}
+		}
+	}, 4096);
+
+	unsigned int unSum = 0;
+	for (size_t unBinIdx = 0; unBinIdx < m_unNumBins; unBinIdx++)
+	{
+		unSum += m_vecCounts[unBinIdx];
+		m_vecCumulative[unBinIdx] = unSum;
+	}
+}
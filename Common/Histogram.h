@@ -0,0 +1,152 @@
+/***************************************************
+ * @file		Histogram.h
+ * @section		Common
+ * @class		CHistogram
+ * @brief		integer histogram of 8 to 16-bit images with percentile, auto window and exposure index queries
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#ifndef __HISTOGRAM_H__
+#define __HISTOGRAM_H__
+
+#include <vector>
+
+#include <stddef.h>
+
+#include "MacroDeclSpec.h"
+
+// count arrays per task, consecutive pixels go to different arrays so repeated values do not wait on the previous store
+#define HISTOGRAM_NUM_COPIES	4
+
+// images smaller than this are counted on the calling thread only
+#define HISTOGRAM_MIN_PARALLEL	65536
+
+/*
+ * @class	CHistogram
+ * @brief	each task counts its share of the image into private interleaved arrays, the arrays are summed bin by bin in
+ *			parallel and a cumulative table is built, so that percentiles are binary searches
+*/
+class _DLL_EXPORT_ CHistogram
+{
+public:
+	/*
+	 * @brief	constructor
+	*/
+	CHistogram();
+
+	/*
+	 * @brief	destructor
+	*/
+	~CHistogram();
+
+	/*
+	 * @brief	count 8-bit pixels into 256 bins
+	 * @param	pSrc
+	 * @param	unNumPixels
+	 * @return	error code
+	*/
+	int Compute(const unsigned char* pSrc, size_t unNumPixels);
+
+	/*
+	 * @brief	count pixels into 2 ^ bit depth bins, values beyond go to the last bin
+	 * @param	pSrc
+	 * @param	unNumPixels
+	 * @param	unBitDepth: stored bits of pixels, in [1, 16]
+	 * @return	error code
+	*/
+	int Compute(const unsigned short* pSrc, size_t unNumPixels, unsigned int unBitDepth = 16);
+
+	/*
+	 * @brief	window covering the pixels between two percentiles, for CWindowLevel
+	 * @param	fCenter: output, (low + high + 1) / 2
+	 * @param	fWidth: output, high - low + 1
+	 * @param	fLowPercent
+	 * @param	fHighPercent: above fLowPercent
+	 * @return	error code
+	*/
+	int GetAutoWindow(float& fCenter, float& fWidth, float fLowPercent = 0.5f, float fHighPercent = 99.5f) const;
+
+	/*
+	 * @brief	pixel count of each bin
+	 * @return	2 ^ bit depth counts
+	*/
+	const std::vector<unsigned int>& GetCounts() const;
+
+	/*
+	 * @brief	pixels up to each bin, included
+	 * @return	2 ^ bit depth counts
+	*/
+	const std::vector<unsigned int>& GetCumulative() const;
+
+	/*
+	 * @brief	exposure index of IEC 62494-1, 100 times the air kerma in uGy at the value of interest. the value of interest
+	 *			is the median of the pixels between two percentiles, leaving out collimated and direct exposure areas
+	 * @param	fKermaPerValue: uGy per pixel value above fOffset, from detector calibration
+	 * @param	fOffset: pixel value without exposure
+	 * @param	fLowPercent
+	 * @param	fHighPercent: above fLowPercent
+	 * @return	exposure index, negative without pixels
+	*/
+	float GetExposureIndex(float fKermaPerValue, float fOffset = 0, float fLowPercent = 5.0f, float fHighPercent = 95.0f) const;
+
+	/*
+	 * @brief	largest pixel value
+	 * @return	value, 0 without pixels
+	*/
+	unsigned short GetMax() const;
+
+	/*
+	 * @brief	smallest pixel value
+	 * @return	value, 0 without pixels
+	*/
+	unsigned short GetMin() const;
+
+	/*
+	 * @brief	pixels counted
+	 * @return	number of pixels
+	*/
+	size_t GetNumPixels() const;
+
+	/*
+	 * @brief	smallest value with at least fPercent of pixels not above it, a binary search of the cumulative table
+	 * @param	fPercent: in [0, 100]
+	 * @return	value, 0 without pixels
+	*/
+	unsigned short GetPercentile(float fPercent) const;
+
+private:
+	/*
+	 * @brief	smallest value whose cumulative count reaches a rank
+	 * @param	unRank: in [1, number of pixels]
+	 * @return	value
+	*/
+	unsigned short FindRank(size_t unRank) const;
+
+	/*
+	 * @brief	sum the counts of tasks and build the cumulative table
+	 * @param	unNumTasks
+	*/
+	void Merge(size_t unNumTasks);
+
+	size_t m_unNumBins;
+	size_t m_unNumPixels;
+
+	std::vector<unsigned int> m_vecTaskCounts;	///< HISTOGRAM_NUM_COPIES arrays of each task, reused by calls
+	std::vector<unsigned int> m_vecCounts;
+	std::vector<unsigned int> m_vecCumulative;
+};
+
+//#ifdef __cplusplus
+//extern "C"
+//{
+//#endif // __cplusplus
+//
+//
+//#ifdef __cplusplus
+//};
+//#endif // __cplusplus
+
+#endif	// __HISTOGRAM_H__
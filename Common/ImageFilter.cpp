@@ -0,0 +1,313 @@
+/***************************************************
+ * @file		ImageFilter.cpp
+ * @section		Common
+ * @class		CFilterWindow
+ * @brief		building blocks of 2D convolution, kernel decomposition, rolling window of rows and row conversions
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#include <algorithm>
+
+#include <math.h>
+
+#include "ImageFilter.h"
+#include "IntlMsgAliasID.h"
+#include "MacroSimd.h"
+
+using namespace std;
+
+/*
+ * @brief	pAcc += fWeight * pSrc
+ * @param	pSrc
+ * @param	unLen
+ * @param	fWeight
+ * @param	pAcc
+*/
+void AccumulateScaledRow(const float* pSrc, size_t unLen, float fWeight, float* pAcc)
+{
+	size_t unIdx = 0;
+
+#ifdef _SIMD_SSE2_
+	__m128 fWeights = _mm_set1_ps(fWeight);
+	for (; unIdx + 8 <= unLen; unIdx += 8)
+	{
+		__m128 fFirst = _mm_add_ps(_mm_loadu_ps(pAcc + unIdx), _mm_mul_ps(_mm_loadu_ps(pSrc + unIdx), fWeights));
+		__m128 fSecond = _mm_add_ps(_mm_loadu_ps(pAcc + unIdx + 4), _mm_mul_ps(_mm_loadu_ps(pSrc + unIdx + 4), fWeights));
+		_mm_storeu_ps(pAcc + unIdx, fFirst);
+		_mm_storeu_ps(pAcc + unIdx + 4, fSecond);
+	}
+#endif	// _SIMD_SSE2_
+
+	for (; unIdx < unLen; unIdx++)
+	{
+		pAcc[unIdx] += fWeight * pSrc[unIdx];
+	}
+}
+
+/*
+ * @brief	convert a row of pixels to float
+ * @param	pSrc
+ * @param	unLen
+ * @param	pDst
+*/
+void LoadFilterRow(const unsigned char* pSrc, size_t unLen, float* pDst)
+{
+	for (size_t unIdx = 0; unIdx < unLen; unIdx++)
+	{
+		pDst[unIdx] = pSrc[unIdx];
+	}
+}
+
+void LoadFilterRow(const short* pSrc, size_t unLen, float* pDst)
+{
+	for (size_t unIdx = 0; unIdx < unLen; unIdx++)
+	{
+		pDst[unIdx] = pSrc[unIdx];
+	}
+}
+
+void LoadFilterRow(const unsigned short* pSrc, size_t unLen, float* pDst)
+{
+	size_t unIdx = 0;
+
+#ifdef _SIMD_SSE2_
+	__m128i nZero = _mm_setzero_si128();
+	for (; unIdx + 8 <= unLen; unIdx += 8)
+	{
+		__m128i nValue = _mm_loadu_si128((const __m128i*)(pSrc + unIdx));
+		_mm_storeu_ps(pDst + unIdx, _mm_cvtepi32_ps(_mm_unpacklo_epi16(nValue, nZero)));
+		_mm_storeu_ps(pDst + unIdx + 4, _mm_cvtepi32_ps(_mm_unpackhi_epi16(nValue, nZero)));
+	}
+#endif	// _SIMD_SSE2_
+
+	for (; unIdx < unLen; unIdx++)
+	{
+		pDst[unIdx] = pSrc[unIdx];
+	}
+}
+
+void LoadFilterRow(const float* pSrc, size_t unLen, float* pDst)
+{
+	copy(pSrc, pSrc + unLen, pDst);
+}
+
+/*
+ * @brief	check kernel size and split it into a column and a row when possible
+ * @param	pWeights: usHeight x usWidth, row major
+ * @param	usHeight: odd
+ * @param	usWidth: odd
+ * @param	oKernel: output kernel
+ * @return	error code
+*/
+int PrepareFilterKernel(const float* pWeights, unsigned short usHeight, unsigned short usWidth, FilterKernel& oKernel)
+{
+	if (nullptr == pWeights || 0 == usHeight % 2 || 0 == usWidth % 2)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	oKernel.usHeight = usHeight;
+	oKernel.usWidth = usWidth;
+	oKernel.vecWeights.assign(pWeights, pWeights + usHeight * usWidth);
+	oKernel.vecColumn.clear();
+	oKernel.vecRow.clear();
+
+	// rank 1 if every weight is the product of its column and row through the largest weight
+	size_t unPivot = 0;
+	for (size_t unIdx = 1; unIdx < oKernel.vecWeights.size(); unIdx++)
+	{
+		unPivot = fabs(oKernel.vecWeights[unIdx]) > fabs(oKernel.vecWeights[unPivot]) ? unIdx : unPivot;
+	}
+
+	float fPivot = oKernel.vecWeights[unPivot];
+	oKernel.isSeparable = 0 != fPivot && usHeight * usWidth > 1;
+	if (!oKernel.isSeparable)
+	{
+		return STATUS_OK;
+	}
+
+	for (unsigned short usRowIdx = 0; usRowIdx < usHeight; usRowIdx++)
+	{
+		oKernel.vecColumn.push_back(oKernel.vecWeights[usRowIdx * usWidth + unPivot % usWidth]);
+	}
+	for (unsigned short usColIdx = 0; usColIdx < usWidth; usColIdx++)
+	{
+		oKernel.vecRow.push_back(oKernel.vecWeights[unPivot / usWidth * usWidth + usColIdx] / fPivot);
+	}
+
+	for (size_t unIdx = 0; unIdx < oKernel.vecWeights.size() && oKernel.isSeparable; unIdx++)
+	{
+		float fProduct = oKernel.vecColumn[unIdx / usWidth] * oKernel.vecRow[unIdx % usWidth];
+		oKernel.isSeparable = fabs(fProduct - oKernel.vecWeights[unIdx]) <= 1e-6f * fabs(fPivot);
+	}
+
+	if (!oKernel.isSeparable)
+	{
+		oKernel.vecColumn.clear();
+		oKernel.vecRow.clear();
+	}
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	round a row of float to pixels, clamped to the range of the pixel type
+ * @param	pSrc
+ * @param	unLen
+ * @param	pDst
+*/
+void StoreFilterRow(const float* pSrc, size_t unLen, unsigned char* pDst)
+{
+	for (size_t unIdx = 0; unIdx < unLen; unIdx++)
+	{
+		float fValue = pSrc[unIdx] < 0 ? 0 : (pSrc[unIdx] > 255.0f ? 255.0f : pSrc[unIdx]);
+		pDst[unIdx] = (unsigned char)(fValue + 0.5f);
+	}
+}
+
+void StoreFilterRow(const float* pSrc, size_t unLen, short* pDst)
+{
+	for (size_t unIdx = 0; unIdx < unLen; unIdx++)
+	{
+		float fValue = pSrc[unIdx] < -32768.0f ? -32768.0f : (pSrc[unIdx] > 32767.0f ? 32767.0f : pSrc[unIdx]);
+		pDst[unIdx] = (short)floor(fValue + 0.5f);
+	}
+}
+
+void StoreFilterRow(const float* pSrc, size_t unLen, unsigned short* pDst)
+{
+	size_t unIdx = 0;
+
+#ifdef _SIMD_SSE2_
+	__m128 fZero = _mm_setzero_ps();
+	__m128 fMax = _mm_set1_ps(65535.0f);
+	__m128 fHalf = _mm_set1_ps(0.5f);
+	__m128i nBias = _mm_set1_epi32(0x8000);
+	for (; unIdx + 8 <= unLen; unIdx += 8)
+	{
+		// no unsigned saturating pack before SSE4.1, values are biased into the signed range and back
+		__m128 fLow = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(pSrc + unIdx), fZero), fMax);
+		__m128 fHigh = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(pSrc + unIdx + 4), fZero), fMax);
+		__m128i nLow = _mm_sub_epi32(_mm_cvttps_epi32(_mm_add_ps(fLow, fHalf)), nBias);
+		__m128i nHigh = _mm_sub_epi32(_mm_cvttps_epi32(_mm_add_ps(fHigh, fHalf)), nBias);
+		_mm_storeu_si128((__m128i*)(pDst + unIdx), _mm_add_epi16(_mm_packs_epi32(nLow, nHigh), _mm_set1_epi16((short)0x8000)));
+	}
+#endif	// _SIMD_SSE2_
+
+	for (; unIdx < unLen; unIdx++)
+	{
+		float fValue = pSrc[unIdx] < 0 ? 0 : (pSrc[unIdx] > 65535.0f ? 65535.0f : pSrc[unIdx]);
+		pDst[unIdx] = (unsigned short)(fValue + 0.5f);
+	}
+}
+
+void StoreFilterRow(const float* pSrc, size_t unLen, float* pDst)
+{
+	copy(pSrc, pSrc + unLen, pDst);
+}
+
+/*
+ * @brief	constructor
+ * @param	oKernel: kept by reference, must outlive the window
+ * @param	usImgWidth
+*/
+CFilterWindow::CFilterWindow(const FilterKernel& oKernel, unsigned short usImgWidth)
+{
+	m_pKernel = &oKernel;
+	m_unWidth = usImgWidth;
+	m_unRadiusX = oKernel.usWidth / 2;
+	m_unNumPushed = 0;
+
+	// rows of separable kernels are filtered horizontally while pushed, only the padded row being pushed is wider
+	m_unRowStride = oKernel.isSeparable ? m_unWidth : m_unWidth + 2 * m_unRadiusX;
+	m_vecRows.resize((size_t)m_unRowStride * oKernel.usHeight);
+	if (oKernel.isSeparable)
+	{
+		m_vecPadded.resize(m_unWidth + 2 * m_unRadiusX);
+	}
+}
+
+/*
+ * @brief	destructor
+*/
+CFilterWindow::~CFilterWindow()
+{
+}
+
+/*
+ * @brief	filter the row at the center of the window, kernel height rows must have been pushed
+ * @param	pDst: image width values
+*/
+void CFilterWindow::FilterRow(float* pDst) const
+{
+	fill(pDst, pDst + m_unWidth, 0.0f);
+
+	unsigned int unHeight = m_pKernel->usHeight;
+	for (unsigned int unTapY = 0; unTapY < unHeight; unTapY++)
+	{
+		const float* pRow = m_vecRows.data() + (size_t)((m_unNumPushed + unTapY) % unHeight) * m_unRowStride;
+		if (m_pKernel->isSeparable)
+		{
+			AccumulateScaledRow(pRow, m_unWidth, m_pKernel->vecColumn[unTapY], pDst);
+			continue;
+		}
+
+		// zero weights, common in edge kernels, cost nothing
+		const float* pWeights = m_pKernel->vecWeights.data() + unTapY * m_pKernel->usWidth;
+		for (unsigned int unTapX = 0; unTapX < m_pKernel->usWidth; unTapX++)
+		{
+			if (0 != pWeights[unTapX])
+			{
+				AccumulateScaledRow(pRow + unTapX, m_unWidth, pWeights[unTapX], pDst);
+			}
+		}
+	}
+}
+
+/*
+ * @brief	where to write the next row before PushRow
+ * @return	image width values
+*/
+float* CFilterWindow::GetLoadRow()
+{
+	if (m_pKernel->isSeparable)
+	{
+		return m_vecPadded.data() + m_unRadiusX;
+	}
+
+	return m_vecRows.data() + (size_t)(m_unNumPushed % m_pKernel->usHeight) * m_unRowStride + m_unRadiusX;
+}
+
+/*
+ * @brief	add the row written at GetLoadRow to the window, dropping the oldest one
+*/
+void CFilterWindow::PushRow()
+{
+	// pixels beyond the border repeat the border
+	float* pPadded = GetLoadRow() - m_unRadiusX;
+	fill(pPadded, pPadded + m_unRadiusX, pPadded[m_unRadiusX]);
+	fill(pPadded + m_unRadiusX + m_unWidth, pPadded + 2 * m_unRadiusX + m_unWidth, pPadded[m_unRadiusX + m_unWidth - 1]);
+
+	if (m_pKernel->isSeparable)
+	{
+		float* pRow = m_vecRows.data() + (size_t)(m_unNumPushed % m_pKernel->usHeight) * m_unRowStride;
+		fill(pRow, pRow + m_unWidth, 0.0f);
+		for (unsigned int unTapX = 0; unTapX < m_pKernel->usWidth; unTapX++)
+		{
+			AccumulateScaledRow(pPadded + unTapX, m_unWidth, m_pKernel->vecRow[unTapX], pRow);
+		}
+	}
+
+	m_unNumPushed++;
+}
+
+/*
+ * @brief	empty the window
+*/
+void CFilterWindow::Reset()
+{
+	m_unNumPushed = 0;
+}
@@ -0,0 +1,229 @@
+/***************************************************
+ * @file		ImageFilter.h
+ * @section		Common
+ * @class		CFilterWindow
+ * @brief		building blocks of 2D convolution, kernel decomposition, rolling window of rows and row conversions
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#ifndef __IMAGE_FILTER_H__
+#define __IMAGE_FILTER_H__
+
+#include <algorithm>
+#include <vector>
+
+#include <string.h>
+
+#include "MacroDeclSpec.h"
+
+// rows of an image filtered by one task
+#define FILTER_BAND_HEIGHT	64
+
+// largest half kernel height saved as halos, beyond it the halos of all bands outgrow one copy of the image
+#define FILTER_MAX_HALO_RADIUS	(FILTER_BAND_HEIGHT / 2)
+
+/* kernel of a 2D convolution, split into a column and a row if its rank is 1 */
+struct FilterKernel
+{
+	unsigned short usHeight;
+	unsigned short usWidth;
+	bool isSeparable;
+	std::vector<float> vecWeights;	///< usHeight x usWidth, row major
+	std::vector<float> vecColumn;	///< vertical factor, separable only
+	std::vector<float> vecRow;		///< horizontal factor, separable only
+};
+
+/*
+ * @brief	pAcc += fWeight * pSrc
+ * @param	pSrc
+ * @param	unLen
+ * @param	fWeight
+ * @param	pAcc
+*/
+_DLL_EXPORT_ void AccumulateScaledRow(const float* pSrc, size_t unLen, float fWeight, float* pAcc);
+
+/*
+ * @brief	convert a row of pixels to float
+ * @param	pSrc
+ * @param	unLen
+ * @param	pDst
+*/
+_DLL_EXPORT_ void LoadFilterRow(const unsigned char* pSrc, size_t unLen, float* pDst);
+_DLL_EXPORT_ void LoadFilterRow(const short* pSrc, size_t unLen, float* pDst);
+_DLL_EXPORT_ void LoadFilterRow(const unsigned short* pSrc, size_t unLen, float* pDst);
+_DLL_EXPORT_ void LoadFilterRow(const float* pSrc, size_t unLen, float* pDst);
+
+/*
+ * @brief	check kernel size and split it into a column and a row when possible
+ * @param	pWeights: usHeight x usWidth, row major
+ * @param	usHeight: odd
+ * @param	usWidth: odd
+ * @param	oKernel: output kernel
+ * @return	error code
+*/
+_DLL_EXPORT_ int PrepareFilterKernel(const float* pWeights, unsigned short usHeight, unsigned short usWidth, FilterKernel& oKernel);
+
+/*
+ * @brief	round a row of float to pixels, clamped to the range of the pixel type
+ * @param	pSrc
+ * @param	unLen
+ * @param	pDst
+*/
+_DLL_EXPORT_ void StoreFilterRow(const float* pSrc, size_t unLen, unsigned char* pDst);
+_DLL_EXPORT_ void StoreFilterRow(const float* pSrc, size_t unLen, short* pDst);
+_DLL_EXPORT_ void StoreFilterRow(const float* pSrc, size_t unLen, unsigned short* pDst);
+_DLL_EXPORT_ void StoreFilterRow(const float* pSrc, size_t unLen, float* pDst);
+
+/*
+ * @brief	saved rows used by a band
+ * @param	vecHaloRows: saved by SaveFilterHalo
+ * @param	unBandIdx
+ * @param	usImgWidth
+ * @param	nRadiusY: half height of kernel
+ * @return	halo of the band, or the copy of the image shared by all bands beyond FILTER_MAX_HALO_RADIUS
+*/
+template<typename T>
+const T* GetFilterHaloRows(const std::vector<T>& vecHaloRows, size_t unBandIdx, unsigned short usImgWidth, int nRadiusY)
+{
+	return nRadiusY > FILTER_MAX_HALO_RADIUS ? vecHaloRows.data() : vecHaloRows.data() + unBandIdx * 2 * nRadiusY * usImgWidth;
+}
+
+/*
+ * @brief	the row nRowIdx as seen by the band [nBandBegin, nBandEnd) of an image filtered in place
+ * @param	pImgPtr: image being filtered
+ * @param	pHaloRows: from GetFilterHaloRows
+ * @param	usImgWidth
+ * @param	nBandBegin
+ * @param	nBandEnd
+ * @param	nRadiusY: half height of kernel
+ * @param	nRowIdx: in [nBandBegin - nRadiusY, nBandEnd + nRadiusY)
+ * @return	pointer to usImgWidth pixels
+*/
+template<typename T>
+const T* GetFilterSourceRow(const T* pImgPtr, const T* pHaloRows, unsigned short usImgWidth, int nBandBegin, int nBandEnd, int nRadiusY, int nRowIdx)
+{
+	if (nRadiusY > FILTER_MAX_HALO_RADIUS)
+	{
+		return pHaloRows + (size_t)(nRowIdx + nRadiusY) * usImgWidth;
+	}
+
+	if (nRowIdx < nBandBegin)
+	{
+		return pHaloRows + (size_t)(nRowIdx - nBandBegin + nRadiusY) * usImgWidth;
+	}
+
+	return nRowIdx < nBandEnd ? pImgPtr + (size_t)nRowIdx * usImgWidth : pHaloRows + (size_t)(nRowIdx - nBandEnd + nRadiusY) * usImgWidth;
+}
+
+/*
+ * @brief	save the nRadiusY rows above and below each band of FILTER_BAND_HEIGHT rows before bands overwrite their own rows,
+ *			rows beyond the border repeat the border. beyond FILTER_MAX_HALO_RADIUS the image is copied once instead
+ * @param	pImgPtr
+ * @param	usImgHeight
+ * @param	usImgWidth
+ * @param	nRadiusY: half height of kernel
+ * @param	vecHaloRows: output, 2 * nRadiusY rows per band, or the image with nRadiusY rows above and below
+ * @return	number of bands
+*/
+template<typename T>
+size_t SaveFilterHalo(const T* pImgPtr, unsigned short usImgHeight, unsigned short usImgWidth, int nRadiusY, std::vector<T>& vecHaloRows)
+{
+	int nHeight = usImgHeight;
+	size_t unNumBands = (nHeight + FILTER_BAND_HEIGHT - 1) / FILTER_BAND_HEIGHT;
+	if (nRadiusY > FILTER_MAX_HALO_RADIUS)
+	{
+		vecHaloRows.resize((size_t)(nHeight + 2 * nRadiusY) * usImgWidth);
+		for (int nRowIdx = -nRadiusY; nRowIdx < nHeight + nRadiusY; nRowIdx++)
+		{
+			int nSrcIdx = (std::max)(0, (std::min)(nRowIdx, nHeight - 1));
+			memcpy(&vecHaloRows[(size_t)(nRowIdx + nRadiusY) * usImgWidth], pImgPtr + (size_t)nSrcIdx * usImgWidth, usImgWidth * sizeof(T));
+		}
+
+		return unNumBands;
+	}
+
+	vecHaloRows.resize(unNumBands * 2 * nRadiusY * usImgWidth);
+
+	for (size_t unBandIdx = 0; unBandIdx < unNumBands; unBandIdx++)
+	{
+		int nBandBegin = (int)unBandIdx * FILTER_BAND_HEIGHT;
+		int nBandEnd = (std::min)(nBandBegin + FILTER_BAND_HEIGHT, nHeight);
+		for (int nHaloIdx = 0; nHaloIdx < 2 * nRadiusY; nHaloIdx++)
+		{
+			int nRowIdx = nHaloIdx < nRadiusY ? nBandBegin - nRadiusY + nHaloIdx : nBandEnd + nHaloIdx - nRadiusY;
+			nRowIdx = (std::max)(0, (std::min)(nRowIdx, nHeight - 1));
+			memcpy(&vecHaloRows[(unBandIdx * 2 * nRadiusY + nHaloIdx) * usImgWidth], pImgPtr + (size_t)nRowIdx * usImgWidth, usImgWidth * sizeof(T));
+		}
+	}
+
+	return unNumBands;
+}
+
+/*
+ * @class	CFilterWindow
+ * @brief	the last kernel height rows pushed, an output row is filtered from them.
+ *			separable kernels store rows already filtered horizontally, others store rows padded on both sides
+*/
+class _DLL_EXPORT_ CFilterWindow
+{
+public:
+	/*
+	 * @brief	constructor
+	 * @param	oKernel: kept by reference, must outlive the window
+	 * @param	usImgWidth
+	*/
+	CFilterWindow(const FilterKernel& oKernel, unsigned short usImgWidth);
+
+	/*
+	 * @brief	destructor
+	*/
+	~CFilterWindow();
+
+	/*
+	 * @brief	filter the row at the center of the window, kernel height rows must have been pushed
+	 * @param	pDst: image width values
+	*/
+	void FilterRow(float* pDst) const;
+
+	/*
+	 * @brief	where to write the next row before PushRow
+	 * @return	image width values
+	*/
+	float* GetLoadRow();
+
+	/*
+	 * @brief	add the row written at GetLoadRow to the window, dropping the oldest one
+	*/
+	void PushRow();
+
+	/*
+	 * @brief	empty the window
+	*/
+	void Reset();
+
+private:
+	const FilterKernel* m_pKernel;
+
+	unsigned int m_unWidth;
+	unsigned int m_unRadiusX;
+	unsigned int m_unRowStride;
+	unsigned int m_unNumPushed;
+
+	std::vector<float> m_vecRows;	///< kernel height rows, a ring
+	std::vector<float> m_vecPadded;	///< row being pushed, separable only
+};
+
+//#ifdef __cplusplus
+//extern "C"
+//{
+//#endif // __cplusplus
+//
+//
+//#ifdef __cplusplus
+//};
+//#endif // __cplusplus
+
+#endif	// __IMAGE_FILTER_H__
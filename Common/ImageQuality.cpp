@@ -0,0 +1,470 @@
+/***************************************************
+ * @file		ImageQuality.cpp
+ * @section		Common
+ * @class		CNoisePowerSpectrum
+ * @brief		detector quality metrics, noise power spectrum of flat frames and MTF by the slanted edge method
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#include <algorithm>
+#include <mutex>
+
+#include <math.h>
+
+#include "opencv/cv.h"
+
+#include "Constants.h"
+#include "CvFFT2D.h"
+#include "ImageQuality.h"
+#include "IntlMsgAliasID.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+/*
+ * @brief	remove the least squares plane of a ROI read in place, writing the residual to a transform buffer
+ * @param	pRoi: top left pixel
+ * @param	usStride: pixels between rows
+ * @param	nRoiSize
+ * @param	pDst: output, size x size
+*/
+static void DetrendROI(const unsigned short* pRoi, unsigned short usStride, int nRoiSize, float* pDst)
+{
+	// coordinates centered on the ROI make the mean and both slopes independent
+	double dCenter = (nRoiSize - 1) / 2.0;
+	double dSum = 0;
+	double dSumX = 0;
+	double dSumY = 0;
+	for (int nRowIdx = 0; nRowIdx < nRoiSize; nRowIdx++)
+	{
+		const unsigned short* pRow = pRoi + (size_t)nRowIdx * usStride;
+		double dRowSum = 0;
+		double dRowSumX = 0;
+		for (int nColIdx = 0; nColIdx < nRoiSize; nColIdx++)
+		{
+			dRowSum += pRow[nColIdx];
+			dRowSumX += (nColIdx - dCenter) * pRow[nColIdx];
+		}
+		dSum += dRowSum;
+		dSumX += dRowSumX;
+		dSumY += (nRowIdx - dCenter) * dRowSum;
+	}
+
+	double dNumPixels = (double)nRoiSize * nRoiSize;
+	double dSquares = dNumPixels * ((double)nRoiSize * nRoiSize - 1) / 12;
+	double dMean = dSum / dNumPixels;
+	double dSlopeX = dSumX / dSquares;
+	double dSlopeY = dSumY / dSquares;
+
+	for (int nRowIdx = 0; nRowIdx < nRoiSize; nRowIdx++)
+	{
+		const unsigned short* pRow = pRoi + (size_t)nRowIdx * usStride;
+		float* pDstRow = pDst + (size_t)nRowIdx * nRoiSize;
+		double dRowBase = dMean + dSlopeY * (nRowIdx - dCenter) - dSlopeX * dCenter;
+		for (int nColIdx = 0; nColIdx < nRoiSize; nColIdx++)
+		{
+			pDstRow[nColIdx] = (float)(pRow[nColIdx] - (dRowBase + dSlopeX * nColIdx));
+		}
+	}
+}
+
+/*
+ * @brief	add |F|^2 of a packed real spectrum of an even square size to the half plane of non negative horizontal frequencies
+ * @param	cvSpectrum: CCS layout of cv::dft
+ * @param	nRoiSize
+ * @param	pPower: size x (size / 2 + 1)
+*/
+static void AccumulatePower(const cv::Mat& cvSpectrum, int nRoiSize, double* pPower)
+{
+	int nHalf = nRoiSize / 2;
+	int nNumCols = nHalf + 1;
+
+	// inner columns hold complex pairs for every vertical frequency
+	for (int nRowIdx = 0; nRowIdx < nRoiSize; nRowIdx++)
+	{
+		const float* pRow = cvSpectrum.ptr<float>(nRowIdx);
+		double* pPowerRow = pPower + (size_t)nRowIdx * nNumCols;
+		for (int nFreqX = 1; nFreqX < nHalf; nFreqX++)
+		{
+			double dReal = pRow[2 * nFreqX - 1];
+			double dImag = pRow[2 * nFreqX];
+			pPowerRow[nFreqX] += dReal * dReal + dImag * dImag;
+		}
+	}
+
+	// the first and last columns pack a real column transform each, vertically symmetric
+	for (int nFreqX = 0; nFreqX <= nHalf; nFreqX += nHalf)
+	{
+		int nColIdx = 0 == nFreqX ? 0 : nRoiSize - 1;
+		double dFirst = cvSpectrum.ptr<float>(0)[nColIdx];
+		double dLast = cvSpectrum.ptr<float>(nRoiSize - 1)[nColIdx];
+		pPower[nFreqX] += dFirst * dFirst;
+		pPower[(size_t)nHalf * nNumCols + nFreqX] += dLast * dLast;
+		for (int nFreqY = 1; nFreqY < nHalf; nFreqY++)
+		{
+			double dReal = cvSpectrum.ptr<float>(2 * nFreqY - 1)[nColIdx];
+			double dImag = cvSpectrum.ptr<float>(2 * nFreqY)[nColIdx];
+			double dPower = dReal * dReal + dImag * dImag;
+			pPower[(size_t)nFreqY * nNumCols + nFreqX] += dPower;
+			pPower[(size_t)(nRoiSize - nFreqY) * nNumCols + nFreqX] += dPower;
+		}
+
+		if (0 == nHalf)
+		{
+			break;
+		}
+	}
+}
+
+/*
+ * @brief	constructor
+*/
+CNoisePowerSpectrum::CNoisePowerSpectrum()
+{
+	m_usRoiSize = 0;
+	m_fPixelSpacing = 1.0f;
+	m_unNumROIs = 0;
+}
+
+/*
+ * @brief	destructor
+*/
+CNoisePowerSpectrum::~CNoisePowerSpectrum()
+{
+}
+
+/*
+ * @brief	add the ROIs of a flat frame region
+ * @param	pRegion: top left pixel of the region
+ * @param	usStride: pixels between rows, width of the frame
+ * @param	usRegionHeight: at least the ROI size
+ * @param	usRegionWidth: at least the ROI size
+ * @return	error code
+*/
+int CNoisePowerSpectrum::AddFrame(const unsigned short* pRegion, unsigned short usStride, unsigned short usRegionHeight, unsigned short usRegionWidth)
+{
+	int nRoiSize = m_usRoiSize;
+	if (nullptr == pRegion || 0 == nRoiSize || usStride < usRegionWidth || usRegionHeight < nRoiSize || usRegionWidth < nRoiSize)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	// ROIs overlap by half
+	int nStep = nRoiSize / 2;
+	size_t unNumX = (usRegionWidth - nRoiSize) / nStep + 1;
+	size_t unNumROIs = unNumX * ((usRegionHeight - nRoiSize) / nStep + 1);
+	size_t unPowerLen = m_vecPower.size();
+
+	mutex oMergeLock;
+	CThreadPool::GetInstance()->ParallelFor(unNumROIs, [&](size_t unBegin, size_t unEnd)
+	{
+		CCvFFTContext oContext;
+		oContext.Prepare(nRoiSize, nRoiSize, true, false);
+		vector<float> vecRoi((size_t)nRoiSize * nRoiSize);
+		vector<double> vecPower(unPowerLen, 0);
+
+		for (size_t unRoiIdx = unBegin; unRoiIdx < unEnd; unRoiIdx++)
+		{
+			const unsigned short* pRoi = pRegion + (unRoiIdx / unNumX) * nStep * usStride + (unRoiIdx % unNumX) * nStep;
+			DetrendROI(pRoi, usStride, nRoiSize, vecRoi.data());
+			oContext.Forward(vecRoi.data());
+			AccumulatePower(oContext.GetSpectrum(), nRoiSize, vecPower.data());
+		}
+
+		lock_guard<mutex> oLock(oMergeLock);
+		for (size_t unIdx = 0; unIdx < unPowerLen; unIdx++)
+		{
+			m_vecPower[unIdx] += vecPower[unIdx];
+		}
+	}, NPS_BATCH_SIZE);
+
+	m_unNumROIs += (unsigned int)unNumROIs;
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	ROIs added since Reset
+ * @return	number of ROIs
+*/
+unsigned int CNoisePowerSpectrum::GetNumROIs() const
+{
+	return m_unNumROIs;
+}
+
+/*
+ * @brief	radial average of the spectrum, zero frequency excluded, up to the Nyquist frequency
+ * @param	fBinWidth: cycles / mm
+ * @param	vecFrequencies: output, mean radial frequency of each non empty bin, cycles / mm
+ * @param	vecNps: output, units^2 mm^2
+ * @return	error code
+*/
+int CNoisePowerSpectrum::GetRadialSpectrum(float fBinWidth, std::vector<float>& vecFrequencies, std::vector<float>& vecNps) const
+{
+	int nRoiSize = m_usRoiSize;
+	int nNumCols = nRoiSize / 2 + 1;
+	vector<float> vecSpectrum((size_t)nRoiSize * nNumCols);
+	int nProcResult = GetSpectrum(vecSpectrum.data());
+	if (STATUS_OK != nProcResult || !(fBinWidth > 0))
+	{
+		return STATUS_OK != nProcResult ? nProcResult : INVALID_PARAMETER;
+	}
+
+	double dFreqStep = 1.0 / (nRoiSize * m_fPixelSpacing);
+	double dNyquist = 0.5 / m_fPixelSpacing;
+	size_t unNumBins = (size_t)ceil(dNyquist / fBinWidth);
+	vector<double> vecSum(unNumBins, 0);
+	vector<double> vecFreqSum(unNumBins, 0);
+	vector<double> vecWeight(unNumBins, 0);
+
+	// inner columns stand for themselves and their mirror in the other half plane
+	for (int nRowIdx = 0; nRowIdx < nRoiSize; nRowIdx++)
+	{
+		double dFreqY = (nRowIdx <= nRoiSize / 2 ? nRowIdx : nRowIdx - nRoiSize) * dFreqStep;
+		for (int nColIdx = 0; nColIdx < nNumCols; nColIdx++)
+		{
+			double dFreq = sqrt(dFreqY * dFreqY + nColIdx * dFreqStep * nColIdx * dFreqStep);
+			size_t unBinIdx = (size_t)(dFreq / fBinWidth);
+			if ((0 == nRowIdx && 0 == nColIdx) || dFreq > dNyquist || unBinIdx >= unNumBins)
+			{
+				continue;
+			}
+
+			double dWeight = 0 == nColIdx || nRoiSize / 2 == nColIdx ? 1 : 2;
+			vecSum[unBinIdx] += dWeight * vecSpectrum[(size_t)nRowIdx * nNumCols + nColIdx];
+			vecFreqSum[unBinIdx] += dWeight * dFreq;
+			vecWeight[unBinIdx] += dWeight;
+		}
+	}
+
+	vecFrequencies.clear();
+	vecNps.clear();
+	for (size_t unBinIdx = 0; unBinIdx < unNumBins; unBinIdx++)
+	{
+		if (vecWeight[unBinIdx] > 0)
+		{
+			vecFrequencies.push_back((float)(vecFreqSum[unBinIdx] / vecWeight[unBinIdx]));
+			vecNps.push_back((float)(vecSum[unBinIdx] / vecWeight[unBinIdx]));
+		}
+	}
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	2D spectrum, row v holds vertical frequency v / (size x spacing) for v up to size / 2 and (v - size) / (size x spacing)
+ *			beyond, column u horizontal frequency u / (size x spacing)
+ * @param	pNps: output, size x (size / 2 + 1), units^2 mm^2
+ * @return	error code
+*/
+int CNoisePowerSpectrum::GetSpectrum(float* pNps) const
+{
+	if (nullptr == pNps || 0 == m_unNumROIs)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	// NPS = spacing^2 / (size^2 x ROIs) x sum of |F|^2
+	double dScale = (double)m_fPixelSpacing * m_fPixelSpacing / ((double)m_usRoiSize * m_usRoiSize * m_unNumROIs);
+	for (size_t unIdx = 0; unIdx < m_vecPower.size(); unIdx++)
+	{
+		pNps[unIdx] = (float)(m_vecPower[unIdx] * dScale);
+	}
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	drop all ROIs and set the ROI size
+ * @param	usRoiSize: even, e.g. 256
+ * @param	fPixelSpacing: mm
+ * @return	error code
+*/
+int CNoisePowerSpectrum::Reset(unsigned short usRoiSize, float fPixelSpacing)
+{
+	if (usRoiSize < 2 || 0 != usRoiSize % 2 || !(fPixelSpacing > 0))
+	{
+		return INVALID_PARAMETER;
+	}
+
+	m_usRoiSize = usRoiSize;
+	m_fPixelSpacing = fPixelSpacing;
+	m_unNumROIs = 0;
+	m_vecPower.assign((size_t)usRoiSize * (usRoiSize / 2 + 1), 0);
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	MTF by the slanted edge method. the edge is located on each line by the centroid of the derivative and fitted by
+ *			a line, pixels are binned by their distance to it into an oversampled edge spread function, whose derivative,
+ *			Hamming windowed, is transformed. the finite difference is compensated
+ * @param	pRoi: top left pixel of a ROI holding one straight edge, slanted by a few degrees
+ * @param	usStride: pixels between rows
+ * @param	usRoiHeight
+ * @param	usRoiWidth
+ * @param	fPixelSpacing: mm
+ * @param	isVerticalEdge: true for an edge running along columns, MTF of the horizontal direction
+ * @param	vecFrequencies: output, cycles / mm, up to the sampling frequency
+ * @param	vecMtf: output, 1 at zero frequency
+ * @return	error code
+*/
+int MeasureEdgeMTF(const unsigned short* pRoi, unsigned short usStride, unsigned short usRoiHeight, unsigned short usRoiWidth, float fPixelSpacing,
+	bool isVerticalEdge, std::vector<float>& vecFrequencies, std::vector<float>& vecMtf)
+{
+	int nNumLines = isVerticalEdge ? usRoiHeight : usRoiWidth;
+	int nNumAcross = isVerticalEdge ? usRoiWidth : usRoiHeight;
+	if (nullptr == pRoi || usStride < usRoiWidth || nNumLines < 2 || nNumAcross < 4 || !(fPixelSpacing > 0))
+	{
+		return INVALID_PARAMETER;
+	}
+
+	// lines run along the edge, positions across it
+	auto funcPixel = [&](int nLineIdx, int nPos) -> double
+	{
+		return isVerticalEdge ? pRoi[(size_t)nLineIdx * usStride + nPos] : pRoi[(size_t)nPos * usStride + nLineIdx];
+	};
+
+	// edge of each line at the centroid of the derivative, then a least squares line through them
+	double dSumLine = 0;
+	double dSumEdge = 0;
+	double dSumLineEdge = 0;
+	double dSumLineSquare = 0;
+	for (int nLineIdx = 0; nLineIdx < nNumLines; nLineIdx++)
+	{
+		double dWeightSum = 0;
+		double dPosSum = 0;
+		for (int nPos = 0; nPos + 1 < nNumAcross; nPos++)
+		{
+			double dWeight = fabs(funcPixel(nLineIdx, nPos + 1) - funcPixel(nLineIdx, nPos));
+			dWeightSum += dWeight;
+			dPosSum += dWeight * (nPos + 0.5);
+		}
+		if (0 == dWeightSum)
+		{
+			return INVALID_PARAMETER;
+		}
+
+		double dEdge = dPosSum / dWeightSum;
+		dSumLine += nLineIdx;
+		dSumEdge += dEdge;
+		dSumLineEdge += nLineIdx * dEdge;
+		dSumLineSquare += (double)nLineIdx * nLineIdx;
+	}
+
+	double dSlope = (nNumLines * dSumLineEdge - dSumLine * dSumEdge) / (nNumLines * dSumLineSquare - dSumLine * dSumLine);
+	double dIntercept = (dSumEdge - dSlope * dSumLine) / nNumLines;
+	double dCos = 1.0 / sqrt(1 + dSlope * dSlope);
+
+	// distances covered by every line, so that all bins see the same mix of lines
+	double dHalfSpan = nNumAcross;
+	for (int nLineIdx = 0; nLineIdx < nNumLines; nLineIdx += nNumLines - 1)
+	{
+		double dEdge = dIntercept + dSlope * nLineIdx;
+		dHalfSpan = min(dHalfSpan, min(dEdge, nNumAcross - 1 - dEdge) * dCos);
+	}
+
+	int nHalfBins = (int)(dHalfSpan * MTF_OVERSAMPLING);
+	if (nHalfBins < 2)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	int nNumBins = 2 * nHalfBins;
+	vector<double> vecEsf(nNumBins, 0);
+	vector<unsigned int> vecCount(nNumBins, 0);
+	for (int nLineIdx = 0; nLineIdx < nNumLines; nLineIdx++)
+	{
+		double dEdge = dIntercept + dSlope * nLineIdx;
+		for (int nPos = 0; nPos < nNumAcross; nPos++)
+		{
+			int nBinIdx = (int)floor((nPos - dEdge) * dCos * MTF_OVERSAMPLING) + nHalfBins;
+			if (nBinIdx >= 0 && nBinIdx < nNumBins)
+			{
+				vecEsf[nBinIdx] += funcPixel(nLineIdx, nPos);
+				vecCount[nBinIdx]++;
+			}
+		}
+	}
+
+	if (find_if(vecCount.begin(), vecCount.end(), [](unsigned int unCount) { return unCount > 0; }) == vecCount.end())
+	{
+		return INVALID_PARAMETER;
+	}
+
+	// bins missed by a nearly straight edge are interpolated from their filled neighbours
+	int nPrevFilled = -1;
+	for (int nBinIdx = 0; nBinIdx <= nNumBins; nBinIdx++)
+	{
+		if (nBinIdx < nNumBins && 0 == vecCount[nBinIdx])
+		{
+			continue;
+		}
+
+		if (nBinIdx < nNumBins)
+		{
+			vecEsf[nBinIdx] /= vecCount[nBinIdx];
+		}
+		for (int nGapIdx = nPrevFilled + 1; nGapIdx < nBinIdx; nGapIdx++)
+		{
+			if (-1 == nPrevFilled || nNumBins == nBinIdx)
+			{
+				vecEsf[nGapIdx] = -1 == nPrevFilled ? vecEsf[nBinIdx] : vecEsf[nPrevFilled];
+			}
+			else
+			{
+				vecEsf[nGapIdx] = vecEsf[nPrevFilled] + (vecEsf[nBinIdx] - vecEsf[nPrevFilled]) * (nGapIdx - nPrevFilled) / (nBinIdx - nPrevFilled);
+			}
+		}
+		nPrevFilled = nBinIdx;
+	}
+
+	// central difference, windowed around the edge
+	vector<float> vecLsf(nNumBins);
+	for (int nBinIdx = 0; nBinIdx < nNumBins; nBinIdx++)
+	{
+		double dDiff = (vecEsf[min(nBinIdx + 1, nNumBins - 1)] - vecEsf[max(nBinIdx - 1, 0)]) / 2;
+		double dWindow = 0.54 + 0.46 * cos(PI * (nBinIdx + 0.5 - nHalfBins) / nHalfBins);
+		vecLsf[nBinIdx] = (float)(dDiff * dWindow);
+	}
+
+	CCvFFTContext oContext;
+	int nProcResult = oContext.Prepare(1, nNumBins, true);
+	if (STATUS_OK != nProcResult)
+	{
+		return nProcResult;
+	}
+	oContext.Forward(vecLsf.data());
+
+	// packed as Re0, Re1, Im1, Re2, Im2, ...
+	const float* pSpectrum = oContext.GetSpectrum().ptr<float>(0);
+	int nLen = oContext.GetSpectrum().cols;
+	double dDC = fabs(pSpectrum[0]);
+	if (0 == dDC)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	double dBinWidth = fPixelSpacing / MTF_OVERSAMPLING;
+	int nNumFreqs = min(nLen / 2, nLen / MTF_OVERSAMPLING) + 1;
+	vecFrequencies.resize(nNumFreqs);
+	vecMtf.resize(nNumFreqs);
+	for (int nFreqIdx = 0; nFreqIdx < nNumFreqs; nFreqIdx++)
+	{
+		double dReal = 0 == nFreqIdx ? pSpectrum[0] : pSpectrum[2 * nFreqIdx - 1];
+		double dImag = 0 == nFreqIdx || 2 * nFreqIdx >= nLen ? 0 : pSpectrum[2 * nFreqIdx];
+		double dFreq = nFreqIdx / (nLen * dBinWidth);
+
+		// the central difference over 2 bins multiplies the spectrum by sinc(2 pi f bin)
+		double dPhase = 2 * PI * dFreq * dBinWidth;
+		double dDiffResponse = 0 == nFreqIdx ? 1 : sin(dPhase) / dPhase;
+
+		vecFrequencies[nFreqIdx] = (float)dFreq;
+		vecMtf[nFreqIdx] = (float)(sqrt(dReal * dReal + dImag * dImag) / dDC / dDiffResponse);
+	}
+
+	return STATUS_OK;
+}
@@ -0,0 +1,122 @@
+/***************************************************
+ * @file		ImageQuality.h
+ * @section		Common
+ * @class		CNoisePowerSpectrum
+ * @brief		detector quality metrics, noise power spectrum of flat frames and MTF by the slanted edge method
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#ifndef __IMAGE_QUALITY_H__
+#define __IMAGE_QUALITY_H__
+
+#include <vector>
+
+#include "MacroDeclSpec.h"
+
+// ROIs transformed by one task, sharing its transform buffers and partial sums
+#define NPS_BATCH_SIZE		8
+
+// bins of the edge spread function per pixel
+#define MTF_OVERSAMPLING	4
+
+/*
+ * @class	CNoisePowerSpectrum
+ * @brief	2D noise power spectrum averaged over square ROIs overlapping by half, IEC 62220-1 style. each ROI is read in place,
+ *			its fitted plane removed while it is written to the transform buffer, and |F|^2 is accumulated from the packed
+ *			real spectrum. only the half plane of non negative horizontal frequencies is kept, the other half is symmetric
+*/
+class _DLL_EXPORT_ CNoisePowerSpectrum
+{
+public:
+	/*
+	 * @brief	constructor
+	*/
+	CNoisePowerSpectrum();
+
+	/*
+	 * @brief	destructor
+	*/
+	~CNoisePowerSpectrum();
+
+	/*
+	 * @brief	add the ROIs of a flat frame region
+	 * @param	pRegion: top left pixel of the region
+	 * @param	usStride: pixels between rows, width of the frame
+	 * @param	usRegionHeight: at least the ROI size
+	 * @param	usRegionWidth: at least the ROI size
+	 * @return	error code
+	*/
+	int AddFrame(const unsigned short* pRegion, unsigned short usStride, unsigned short usRegionHeight, unsigned short usRegionWidth);
+
+	/*
+	 * @brief	ROIs added since Reset
+	 * @return	number of ROIs
+	*/
+	unsigned int GetNumROIs() const;
+
+	/*
+	 * @brief	radial average of the spectrum, zero frequency excluded, up to the Nyquist frequency
+	 * @param	fBinWidth: cycles / mm
+	 * @param	vecFrequencies: output, mean radial frequency of each non empty bin, cycles / mm
+	 * @param	vecNps: output, units^2 mm^2
+	 * @return	error code
+	*/
+	int GetRadialSpectrum(float fBinWidth, std::vector<float>& vecFrequencies, std::vector<float>& vecNps) const;
+
+	/*
+	 * @brief	2D spectrum, row v holds vertical frequency v / (size x spacing) for v up to size / 2 and (v - size) / (size x spacing)
+	 *			beyond, column u horizontal frequency u / (size x spacing)
+	 * @param	pNps: output, size x (size / 2 + 1), units^2 mm^2
+	 * @return	error code
+	*/
+	int GetSpectrum(float* pNps) const;
+
+	/*
+	 * @brief	drop all ROIs and set the ROI size
+	 * @param	usRoiSize: even, e.g. 256
+	 * @param	fPixelSpacing: mm
+	 * @return	error code
+	*/
+	int Reset(unsigned short usRoiSize, float fPixelSpacing);
+
+private:
+	unsigned short m_usRoiSize;
+
+	float m_fPixelSpacing;
+
+	unsigned int m_unNumROIs;
+
+	std::vector<double> m_vecPower;		///< size x (size / 2 + 1), sum of |F|^2
+};
+
+/*
+ * @brief	MTF by the slanted edge method. the edge is located on each line by the centroid of the derivative and fitted by
+ *			a line, pixels are binned by their distance to it into an oversampled edge spread function, whose derivative,
+ *			Hamming windowed, is transformed. the finite difference is compensated
+ * @param	pRoi: top left pixel of a ROI holding one straight edge, slanted by a few degrees
+ * @param	usStride: pixels between rows
+ * @param	usRoiHeight
+ * @param	usRoiWidth
+ * @param	fPixelSpacing: mm
+ * @param	isVerticalEdge: true for an edge running along columns, MTF of the horizontal direction
+ * @param	vecFrequencies: output, cycles / mm, up to the sampling frequency
+ * @param	vecMtf: output, 1 at zero frequency
+ * @return	error code
+*/
+_DLL_EXPORT_ int MeasureEdgeMTF(const unsigned short* pRoi, unsigned short usStride, unsigned short usRoiHeight, unsigned short usRoiWidth, float fPixelSpacing,
+	bool isVerticalEdge, std::vector<float>& vecFrequencies, std::vector<float>& vecMtf);
+
+//#ifdef __cplusplus
+//extern "C"
+//{
+//#endif // __cplusplus
+//
+//
+//#ifdef __cplusplus
+//};
+//#endif // __cplusplus
+
+#endif	// __IMAGE_QUALITY_H__
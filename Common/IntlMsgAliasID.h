@@ -43,6 +43,15 @@
 #define RING_BUFFER_EPTY			201004
 #define RING_BUFFER_FULL			201004
 
+#define READ_CANCELLED				101005
+#define INVALID_PARAMETER			201006
+#define ALLOCATE_MEMORY_ERR			201007
+#define INCONSISTENT_SLICE			201008
+#define MAP_FILE_ERR				201009
+#define WRITE_FILE_ERR				201010
+#define CACHE_OUT_OF_DATE			101011
+#define INVALID_FILE_FORMAT			201012
+
 // [LogisticRegression]
 
 // [ExpectationMaximization]
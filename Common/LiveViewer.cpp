@@ -0,0 +1,247 @@
+/***************************************************
+ * @file		LiveViewer.cpp
+ * @section		Common
+ * @class		CLiveViewer
+ * @brief		non-blocking display of a live frame stream on its own thread
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#include <string.h>
+
+#include "opencv/cv.h"
+#include "opencv2/highgui/highgui.hpp"
+
+#include "IntlMsgAliasID.h"
+#include "LiveViewer.h"
+
+using namespace std;
+
+/*
+ * @brief	constructor, frames auto windowed
+*/
+CLiveViewer::CLiveViewer()
+{
+	m_isRunning = false;
+	m_unPeriod = 1000 / LIVE_VIEWER_REFRESH_RATE;
+
+	for (int nIdx = 0; nIdx < LIVE_VIEWER_NUM_SLOTS; nIdx++)
+	{
+		m_oSlots[nIdx].usHeight = 0;
+		m_oSlots[nIdx].usWidth = 0;
+	}
+	m_nWriteIdx = 0;
+	m_nReadyIdx = 1;
+	m_nDisplayIdx = 2;
+
+	m_unNumDropped = 0;
+	m_unNumShown = 0;
+
+	m_isAutoWindow = true;
+	m_isWindowChanged = false;
+	m_fCenter = 32768.0f;
+	m_fWidth = 65536.0f;
+	m_unBitDepth = 16;
+}
+
+/*
+ * @brief	destructor, stop the viewer thread
+*/
+CLiveViewer::~CLiveViewer()
+{
+	Stop();
+}
+
+/*
+ * @brief	frames replaced in the ready slot before being displayed
+ * @return	number of frames
+*/
+unsigned long long CLiveViewer::GetNumDropped() const
+{
+	return m_unNumDropped;
+}
+
+/*
+ * @brief	frames displayed since Start
+ * @return	number of frames
+*/
+unsigned long long CLiveViewer::GetNumShown() const
+{
+	return m_unNumShown;
+}
+
+/*
+ * @brief	whether the viewer thread runs
+ * @return	true if running
+*/
+bool CLiveViewer::IsRunning() const
+{
+	return m_isRunning;
+}
+
+/*
+ * @brief	window frames from 0.5 to 99.5 percentiles of a subsampled histogram decayed over frames
+*/
+void CLiveViewer::SetAutoWindow()
+{
+	lock_guard<mutex> oGuard(m_oWindowLock);
+	m_isAutoWindow = true;
+	m_isWindowChanged = true;
+}
+
+/*
+ * @brief	fixed window, applied from the next refresh
+ * @param	fCenter
+ * @param	fWidth: at least 1
+ * @param	unBitDepth: stored bits of pixels, in [1, 16]
+ * @return	error code
+*/
+int CLiveViewer::SetWindow(float fCenter, float fWidth, unsigned int unBitDepth)
+{
+	if (!(fWidth >= 1) || 0 == unBitDepth || unBitDepth > 16)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	lock_guard<mutex> oGuard(m_oWindowLock);
+	m_isAutoWindow = false;
+	m_isWindowChanged = true;
+	m_fCenter = fCenter;
+	m_fWidth = fWidth;
+	m_unBitDepth = unBitDepth;
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	open the window and start the viewer thread
+ * @param	strWindowName: window's name
+ * @param	unRefreshRate: refreshes per second
+ * @return	error code
+*/
+int CLiveViewer::Start(const std::string& strWindowName, unsigned int unRefreshRate)
+{
+	if (m_isRunning || 0 == unRefreshRate || unRefreshRate > 1000)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	m_strWindowName = strWindowName;
+	m_unPeriod = 1000 / unRefreshRate;
+	m_unNumShown = 0;
+	m_isRunning = true;
+	m_oThread = thread(&CLiveViewer::Render, this);
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	stop the viewer thread and close the window
+*/
+void CLiveViewer::Stop()
+{
+	m_isRunning = false;
+	if (m_oThread.joinable())
+	{
+		m_oThread.join();
+	}
+}
+
+/*
+ * @brief	hand a frame to the viewer without waiting, it is copied
+ * @param	pFrame: height x width pixels
+ * @param	usHeight
+ * @param	usWidth
+ * @return	error code
+*/
+int CLiveViewer::Submit(const unsigned short* pFrame, unsigned short usHeight, unsigned short usWidth)
+{
+	if (nullptr == pFrame || 0 == usHeight || 0 == usWidth)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	// the write slot belongs to the producer until it is published
+	LiveFrame& oSlot = m_oSlots[m_nWriteIdx];
+	oSlot.usHeight = usHeight;
+	oSlot.usWidth = usWidth;
+	oSlot.vecPixels.resize((size_t)usHeight * usWidth);
+	memcpy(oSlot.vecPixels.data(), pFrame, oSlot.vecPixels.size() * sizeof(unsigned short));
+
+	int nPrevIdx = m_nReadyIdx.exchange(m_nWriteIdx | LIVE_VIEWER_NEW_FRAME);
+	if (0 != (nPrevIdx & LIVE_VIEWER_NEW_FRAME))
+	{
+		m_unNumDropped++;
+	}
+	m_nWriteIdx = nPrevIdx & ~LIVE_VIEWER_NEW_FRAME;
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	loop of viewer thread
+*/
+void CLiveViewer::Render()
+{
+	// HighGUI windows are driven by the thread that created them
+	cv::namedWindow(m_strWindowName.c_str(), 0);
+
+	cv::Mat cvMatShow;
+	while (m_isRunning)
+	{
+		bool isNewFrame = 0 != (m_nReadyIdx.load() & LIVE_VIEWER_NEW_FRAME);
+		if (isNewFrame)
+		{
+			m_nDisplayIdx = m_nReadyIdx.exchange(m_nDisplayIdx) & ~LIVE_VIEWER_NEW_FRAME;
+		}
+
+		bool isAutoWindow = false;
+		bool isWindowChanged = false;
+		{
+			lock_guard<mutex> oGuard(m_oWindowLock);
+			isAutoWindow = m_isAutoWindow;
+			isWindowChanged = m_isWindowChanged;
+			m_isWindowChanged = false;
+			if (!isAutoWindow)
+			{
+				m_oWindowLevel.SetWindow(m_fCenter, m_fWidth, m_unBitDepth);
+			}
+		}
+
+		// a new window redraws the frame on screen
+		const LiveFrame& oFrame = m_oSlots[m_nDisplayIdx];
+		if ((isNewFrame || isWindowChanged) && !oFrame.vecPixels.empty())
+		{
+			// the histogram restarts when auto window is switched on or the frame size changes
+			if (isAutoWindow)
+			{
+				if (isWindowChanged || oFrame.usHeight != m_oHistogram.GetHeight() || oFrame.usWidth != m_oHistogram.GetWidth())
+				{
+					m_oHistogram.Reset(oFrame.usHeight, oFrame.usWidth, SLIDING_HISTOGRAM_STEP, LIVE_VIEWER_WINDOW_DECAY);
+				}
+				if (isNewFrame || 0 == m_oHistogram.GetNumFrames())
+				{
+					m_oHistogram.Update(oFrame.vecPixels.data());
+				}
+
+				float fCenter = 0;
+				float fWidth = 0;
+				m_oHistogram.GetAutoWindow(fCenter, fWidth);
+				m_oWindowLevel.SetWindow(fCenter, fWidth);
+			}
+
+			// mapped on this thread, the pool may be busy with the acquisition pipeline and a frame is cheap
+			cvMatShow.create(oFrame.usHeight, oFrame.usWidth, CV_8UC1);
+			m_oWindowLevel.Apply(oFrame.vecPixels.data(), oFrame.vecPixels.size(), cvMatShow.data, false);
+			cv::imshow(m_strWindowName.c_str(), cvMatShow);
+			m_unNumShown++;
+		}
+
+		// paces the loop at the refresh rate and keeps the window responsive
+		cv::waitKey(m_unPeriod);
+	}
+
+	cv::destroyWindow(m_strWindowName.c_str());
+}
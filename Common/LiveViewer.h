@@ -0,0 +1,166 @@
+/***************************************************
+ * @file		LiveViewer.h
+ * @section		Common
+ * @class		CLiveViewer
+ * @brief		non-blocking display of a live frame stream on its own thread
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#ifndef __LIVE_VIEWER_H__
+#define __LIVE_VIEWER_H__
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MacroDeclSpec.h"
+#include "SlidingHistogram.h"
+#include "WindowLevel.h"
+
+// default refresh rate of the window in Hz
+#define LIVE_VIEWER_REFRESH_RATE	30
+
+// number of frame slots, one written, one ready, one displayed
+#define LIVE_VIEWER_NUM_SLOTS		3
+
+// flag of the ready slot, set when it holds a frame not displayed yet
+#define LIVE_VIEWER_NEW_FRAME		0x4
+
+// weight of previous frames in the histogram of auto window
+#define LIVE_VIEWER_WINDOW_DECAY	0.8f
+
+/* frame slot of the viewer */
+struct LiveFrame
+{
+	unsigned short usHeight;
+	unsigned short usWidth;
+	std::vector<unsigned short> vecPixels;
+};
+
+/*
+ * @class	CLiveViewer
+ * @brief	frames go through a triple buffer: the producer copies into its own slot and swaps it with the ready slot, the
+ *			viewer thread swaps the ready slot with its own at each refresh. nobody waits, a frame replaced before the
+ *			viewer took it is dropped. Submit is meant to be called from one acquisition thread
+*/
+class _DLL_EXPORT_ CLiveViewer
+{
+public:
+	/*
+	 * @brief	constructor, frames auto windowed
+	*/
+	CLiveViewer();
+
+	/*
+	 * @brief	destructor, stop the viewer thread
+	*/
+	~CLiveViewer();
+
+	/*
+	 * @brief	frames replaced in the ready slot before being displayed
+	 * @return	number of frames
+	*/
+	unsigned long long GetNumDropped() const;
+
+	/*
+	 * @brief	frames displayed since Start
+	 * @return	number of frames
+	*/
+	unsigned long long GetNumShown() const;
+
+	/*
+	 * @brief	whether the viewer thread runs
+	 * @return	true if running
+	*/
+	bool IsRunning() const;
+
+	/*
+	 * @brief	window frames from 0.5 to 99.5 percentiles of a subsampled histogram decayed over frames
+	*/
+	void SetAutoWindow();
+
+	/*
+	 * @brief	fixed window, applied from the next refresh
+	 * @param	fCenter
+	 * @param	fWidth: at least 1
+	 * @param	unBitDepth: stored bits of pixels, in [1, 16]
+	 * @return	error code
+	*/
+	int SetWindow(float fCenter, float fWidth, unsigned int unBitDepth = 16);
+
+	/*
+	 * @brief	open the window and start the viewer thread
+	 * @param	strWindowName: window's name
+	 * @param	unRefreshRate: refreshes per second
+	 * @return	error code
+	*/
+	int Start(const std::string& strWindowName, unsigned int unRefreshRate = LIVE_VIEWER_REFRESH_RATE);
+
+	/*
+	 * @brief	stop the viewer thread and close the window
+	*/
+	void Stop();
+
+	/*
+	 * @brief	hand a frame to the viewer without waiting, it is copied
+	 * @param	pFrame: height x width pixels
+	 * @param	usHeight
+	 * @param	usWidth
+	 * @return	error code
+	*/
+	int Submit(const unsigned short* pFrame, unsigned short usHeight, unsigned short usWidth);
+
+private:
+	/*
+	 * @brief	copy is not allowed, the viewer thread refers to this
+	*/
+	CLiveViewer(const CLiveViewer&);
+	CLiveViewer& operator=(const CLiveViewer&);
+
+	/*
+	 * @brief	loop of viewer thread
+	*/
+	void Render();
+
+	std::atomic<bool> m_isRunning;
+
+	std::string m_strWindowName;
+	unsigned int m_unPeriod;					///< ms between refreshes
+
+	LiveFrame m_oSlots[LIVE_VIEWER_NUM_SLOTS];
+	int m_nWriteIdx;							///< slot of producer
+	std::atomic<int> m_nReadyIdx;				///< slot in between, with LIVE_VIEWER_NEW_FRAME
+	int m_nDisplayIdx;							///< slot of viewer thread
+
+	std::atomic<unsigned long long> m_unNumDropped;
+	std::atomic<unsigned long long> m_unNumShown;
+
+	std::mutex m_oWindowLock;					///< guards window settings below
+	bool m_isAutoWindow;
+	bool m_isWindowChanged;
+	float m_fCenter;
+	float m_fWidth;
+	unsigned int m_unBitDepth;
+
+	CWindowLevel m_oWindowLevel;				///< used by viewer thread only
+	CSlidingHistogram m_oHistogram;				///< used by viewer thread only
+
+	std::thread m_oThread;
+};
+
+//#ifdef __cplusplus
+//extern "C"
+//{
+//#endif // __cplusplus
+//
+//
+//#ifdef __cplusplus
+//};
+//#endif // __cplusplus
+
+#endif	// __LIVE_VIEWER_H__
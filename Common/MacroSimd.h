@@ -0,0 +1,43 @@
+/***************************************************
+ * @file		MacroSimd.h
+ * @section		Common
+ * @class		N/A
+ * @brief		macro of SIMD instruction sets and alignment
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#ifndef __MACRO_SIMD_H__
+#define __MACRO_SIMD_H__
+
+// SSE2 is the baseline of x64 and of /arch:SSE2 (default of v110) on win32
+#if (defined _M_X64 || defined _M_IX86 || defined __x86_64__ || defined __i386__) && (defined _MSC_VER || defined __SSE2__)
+#	define _SIMD_SSE2_
+#	include <emmintrin.h>
+#endif
+
+#if (defined _MSC_VER)
+
+#	include <intrin.h>
+
+#	define _ALIGN_(x)		__declspec(align(x))
+#	define _TARGET_SSE42_
+
+#else
+
+#	if (defined __x86_64__ || defined __i386__)
+#		include <cpuid.h>
+#		include <x86intrin.h>
+#	endif
+
+#	define _ALIGN_(x)		__attribute__((aligned(x)))
+#	define _TARGET_SSE42_	__attribute__((target("sse4.2")))
+
+#endif	// _MSC_VER
+
+// alignment of buffers processed by SIMD
+#define SIMD_ALIGN_BYTES	64
+
+#endif	// __MACRO_SIMD_H__
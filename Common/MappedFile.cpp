@@ -0,0 +1,171 @@
+/***************************************************
+ * @file		MappedFile.cpp
+ * @section		Common
+ * @class		CMappedFile
+ * @brief		read-only memory mapping of a whole file, pages are loaded on first access
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#include <vector>
+
+#include <stdio.h>
+
+#if (defined _MSC_VER)
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif	// _MSC_VER
+
+#include "ErrorMsg.h"
+#include "IntlMsgAliasID.h"
+#include "MappedFile.h"
+
+using namespace std;
+
+/*
+ * @brief	constructor
+*/
+CMappedFile::CMappedFile()
+{
+	m_pData = nullptr;
+	m_unSize = 0;
+
+#if (defined _MSC_VER)
+	m_hFile = INVALID_HANDLE_VALUE;
+	m_hMapping = nullptr;
+#else
+	m_nFileDesc = -1;
+#endif	// _MSC_VER
+}
+
+/*
+ * @brief	destructor
+*/
+CMappedFile::~CMappedFile()
+{
+	Close();
+}
+
+/*
+ * @brief	unmap and close file
+*/
+void CMappedFile::Close()
+{
+#if (defined _MSC_VER)
+	if (nullptr != m_pData)
+	{
+		UnmapViewOfFile(m_pData);
+	}
+
+	if (nullptr != m_hMapping)
+	{
+		CloseHandle(m_hMapping);
+		m_hMapping = nullptr;
+	}
+
+	if (INVALID_HANDLE_VALUE != m_hFile)
+	{
+		CloseHandle(m_hFile);
+		m_hFile = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (nullptr != m_pData)
+	{
+		munmap((void*)m_pData, m_unSize);
+	}
+
+	if (-1 != m_nFileDesc)
+	{
+		close(m_nFileDesc);
+		m_nFileDesc = -1;
+	}
+#endif	// _MSC_VER
+
+	m_pData = nullptr;
+	m_unSize = 0;
+}
+
+/*
+ * @brief	start of mapping, page aligned
+ * @return	pointer, nullptr if not mapped
+*/
+const char* CMappedFile::GetData() const
+{
+	return m_pData;
+}
+
+/*
+ * @brief	size of mapped file
+ * @return	number of bytes
+*/
+size_t CMappedFile::GetSize() const
+{
+	return m_unSize;
+}
+
+/*
+ * @brief	map a file read-only
+ * @param	strFileName
+ * @return	error code
+*/
+int CMappedFile::Open(const std::string& strFileName)
+{
+	Close();
+
+	vector<string> vecErrorReplacer(1, strFileName);
+
+#if (defined _MSC_VER)
+	m_hFile = CreateFileA(strFileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (INVALID_HANDLE_VALUE == m_hFile)
+	{
+		printf("%s\n", CErrorMsg::GetInstance()->GetMsgString(OPEN_FILE_ERR, vecErrorReplacer).c_str());
+		return OPEN_FILE_ERR;
+	}
+
+	LARGE_INTEGER oFileSize;
+	if (!GetFileSizeEx(m_hFile, &oFileSize) || 0 == oFileSize.QuadPart || (unsigned long long)oFileSize.QuadPart > (size_t)-1)
+	{
+		printf("%s\n", CErrorMsg::GetInstance()->GetMsgString(MAP_FILE_ERR, vecErrorReplacer).c_str());
+		Close();
+		return MAP_FILE_ERR;
+	}
+	m_unSize = (size_t)oFileSize.QuadPart;
+
+	m_hMapping = CreateFileMappingA(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	m_pData = nullptr == m_hMapping ? nullptr : (const char*)MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+#else
+	m_nFileDesc = open(strFileName.c_str(), O_RDONLY);
+	if (-1 == m_nFileDesc)
+	{
+		printf("%s\n", CErrorMsg::GetInstance()->GetMsgString(OPEN_FILE_ERR, vecErrorReplacer).c_str());
+		return OPEN_FILE_ERR;
+	}
+
+	struct stat oFileStat;
+	if (0 != fstat(m_nFileDesc, &oFileStat) || 0 == oFileStat.st_size)
+	{
+		printf("%s\n", CErrorMsg::GetInstance()->GetMsgString(MAP_FILE_ERR, vecErrorReplacer).c_str());
+		Close();
+		return MAP_FILE_ERR;
+	}
+	m_unSize = (size_t)oFileStat.st_size;
+
+	void* pMapping = mmap(nullptr, m_unSize, PROT_READ, MAP_SHARED, m_nFileDesc, 0);
+	m_pData = MAP_FAILED == pMapping ? nullptr : (const char*)pMapping;
+#endif	// _MSC_VER
+
+	if (nullptr == m_pData)
+	{
+		printf("%s\n", CErrorMsg::GetInstance()->GetMsgString(MAP_FILE_ERR, vecErrorReplacer).c_str());
+		Close();
+		return MAP_FILE_ERR;
+	}
+
+	return STATUS_OK;
+}
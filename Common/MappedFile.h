@@ -0,0 +1,87 @@
+/***************************************************
+ * @file		MappedFile.h
+ * @section		Common
+ * @class		CMappedFile
+ * @brief		read-only memory mapping of a whole file, pages are loaded on first access
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#ifndef __MAPPED_FILE_H__
+#define __MAPPED_FILE_H__
+
+#include <string>
+
+#include "MacroDeclSpec.h"
+
+/*
+ * @class	CMappedFile
+ * @brief	mapping is released on Close or destruction, pointers into it become invalid then
+*/
+class _DLL_EXPORT_ CMappedFile
+{
+public:
+	/*
+	 * @brief	constructor
+	*/
+	CMappedFile();
+
+	/*
+	 * @brief	destructor
+	*/
+	~CMappedFile();
+
+	/*
+	 * @brief	unmap and close file
+	*/
+	void Close();
+
+	/*
+	 * @brief	start of mapping, page aligned
+	 * @return	pointer, nullptr if not mapped
+	*/
+	const char* GetData() const;
+
+	/*
+	 * @brief	size of mapped file
+	 * @return	number of bytes
+	*/
+	size_t GetSize() const;
+
+	/*
+	 * @brief	map a file read-only
+	 * @param	strFileName
+	 * @return	error code
+	*/
+	int Open(const std::string& strFileName);
+
+private:
+	// not copyable, mapping is owned
+	CMappedFile(const CMappedFile&);
+	CMappedFile& operator=(const CMappedFile&);
+
+	const char* m_pData;
+
+	size_t m_unSize;
+
+#if (defined _MSC_VER)
+	void* m_hFile;
+	void* m_hMapping;
+#else
+	int m_nFileDesc;
+#endif	// _MSC_VER
+};
+
+//#ifdef __cplusplus
+//extern "C"
+//{
+//#endif // __cplusplus
+//
+//
+//#ifdef __cplusplus
+//};
+//#endif // __cplusplus
+
+#endif	// __MAPPED_FILE_H__
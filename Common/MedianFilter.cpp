@@ -0,0 +1,316 @@
+/***************************************************
+ * @file		MedianFilter.cpp
+ * @section		Common
+ * @class		N/A
+ * @brief		in-place median filtering of 16-bit images, sorting networks for small windows, sliding histogram for large ones
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#include <algorithm>
+#include <vector>
+
+#include "ImageFilter.h"
+#include "IntlMsgAliasID.h"
+#include "MacroSimd.h"
+#include "MedianFilter.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+// values of one coarse bin of the sliding histogram is 1 << MEDIAN_COARSE_SHIFT
+#define MEDIAN_COARSE_SHIFT	4
+
+// compare-exchange pairs leaving the median of 9 values at index 4
+static const unsigned char s_ucMedian9Network[][2] = {
+	{1, 2}, {4, 5}, {7, 8}, {0, 1}, {3, 4}, {6, 7}, {1, 2}, {4, 5}, {7, 8}, {0, 3},
+	{5, 8}, {4, 7}, {3, 6}, {1, 4}, {2, 5}, {4, 7}, {4, 2}, {6, 4}, {4, 2}
+};
+
+// compare-exchange pairs leaving the median of 25 values at index 12
+static const unsigned char s_ucMedian25Network[][2] = {
+	{0, 1}, {3, 4}, {2, 4}, {2, 3}, {6, 7}, {5, 7}, {5, 6}, {9, 10}, {8, 10}, {8, 9},
+	{12, 13}, {11, 13}, {11, 12}, {15, 16}, {14, 16}, {14, 15}, {18, 19}, {17, 19}, {17, 18}, {21, 22},
+	{20, 22}, {20, 21}, {23, 24}, {2, 5}, {3, 6}, {0, 6}, {0, 3}, {4, 7}, {1, 7}, {1, 4},
+	{11, 14}, {8, 14}, {8, 11}, {12, 15}, {9, 15}, {9, 12}, {13, 16}, {10, 16}, {10, 13}, {20, 23},
+	{17, 23}, {17, 20}, {21, 24}, {18, 24}, {18, 21}, {19, 22}, {8, 17}, {9, 18}, {0, 18}, {0, 9},
+	{10, 19}, {1, 19}, {1, 10}, {11, 20}, {2, 20}, {2, 11}, {12, 21}, {3, 21}, {3, 12}, {13, 22},
+	{4, 22}, {4, 13}, {14, 23}, {5, 23}, {5, 14}, {15, 24}, {6, 24}, {6, 15}, {7, 16}, {7, 19},
+	{13, 21}, {15, 23}, {7, 13}, {7, 15}, {1, 9}, {3, 11}, {5, 17}, {11, 17}, {9, 17}, {4, 10},
+	{6, 12}, {7, 14}, {4, 6}, {4, 7}, {12, 14}, {10, 14}, {6, 7}, {10, 12}, {6, 10}, {6, 17},
+	{12, 17}, {7, 17}, {7, 10}, {12, 18}, {7, 12}, {10, 18}, {12, 20}, {10, 20}, {10, 12}
+};
+
+/* sliding histogram of a window, two levels so that the median is found by short scans */
+struct MedianHistogram
+{
+	std::vector<unsigned short> vecCoarse;
+	std::vector<unsigned short> vecFine;
+	unsigned int unBin;		///< coarse bin holding the last median
+	unsigned int unBelow;	///< number of values in coarse bins below unBin
+};
+
+/*
+ * @brief	add or remove one column of the window
+ * @param	pRows: padded rows of the window
+ * @param	unNumRows
+ * @param	unColIdx: padded column
+ * @param	nDelta: 1 to add, -1 to remove
+ * @param	oHistogram
+*/
+static void UpdateHistogram(const unsigned short* const* pRows, unsigned int unNumRows, unsigned int unColIdx, int nDelta, MedianHistogram& oHistogram)
+{
+	for (unsigned int unRowIdx = 0; unRowIdx < unNumRows; unRowIdx++)
+	{
+		unsigned short usValue = pRows[unRowIdx][unColIdx];
+		unsigned int unBin = usValue >> MEDIAN_COARSE_SHIFT;
+
+		oHistogram.vecFine[usValue] = (unsigned short)(oHistogram.vecFine[usValue] + nDelta);
+		oHistogram.vecCoarse[unBin] = (unsigned short)(oHistogram.vecCoarse[unBin] + nDelta);
+		if (unBin < oHistogram.unBin)
+		{
+			oHistogram.unBelow += nDelta;
+		}
+	}
+}
+
+/*
+ * @brief	value of given rank, starting from the coarse bin of the last median since neighbouring medians are close
+ * @param	oHistogram
+ * @param	unRank: 0 for the smallest value
+ * @return	value
+*/
+static unsigned short FindRank(MedianHistogram& oHistogram, unsigned int unRank)
+{
+	while (oHistogram.unBelow > unRank)
+	{
+		oHistogram.unBin--;
+		oHistogram.unBelow -= oHistogram.vecCoarse[oHistogram.unBin];
+	}
+
+	while (oHistogram.unBelow + oHistogram.vecCoarse[oHistogram.unBin] <= unRank)
+	{
+		oHistogram.unBelow += oHistogram.vecCoarse[oHistogram.unBin];
+		oHistogram.unBin++;
+	}
+
+	unsigned int unValue = oHistogram.unBin << MEDIAN_COARSE_SHIFT;
+	unsigned int unCount = oHistogram.unBelow + oHistogram.vecFine[unValue];
+	while (unCount <= unRank)
+	{
+		unValue++;
+		unCount += oHistogram.vecFine[unValue];
+	}
+
+	return (unsigned short)unValue;
+}
+
+/*
+ * @brief	median filter one row with a sliding histogram, O(radius) per pixel
+ * @param	pRows: 2 * radius + 1 padded rows around the row
+ * @param	unRadius
+ * @param	usImgWidth
+ * @param	oHistogram: empty on entry and on return
+ * @param	pDst: usImgWidth pixels
+*/
+static void MedianRowByHistogram(const unsigned short* const* pRows, unsigned int unRadius, unsigned short usImgWidth, MedianHistogram& oHistogram, unsigned short* pDst)
+{
+	unsigned int unSize = 2 * unRadius + 1;
+	unsigned int unRank = unSize * unSize / 2;
+
+	for (unsigned int unColIdx = 0; unColIdx < unSize; unColIdx++)
+	{
+		UpdateHistogram(pRows, unSize, unColIdx, 1, oHistogram);
+	}
+
+	for (unsigned int unColIdx = 0; unColIdx < usImgWidth; unColIdx++)
+	{
+		if (0 != unColIdx)
+		{
+			UpdateHistogram(pRows, unSize, unColIdx - 1, -1, oHistogram);
+			UpdateHistogram(pRows, unSize, unColIdx + unSize - 1, 1, oHistogram);
+		}
+
+		pDst[unColIdx] = FindRank(oHistogram, unRank);
+	}
+
+	for (unsigned int unColIdx = usImgWidth - 1; unColIdx < usImgWidth + unSize - 1; unColIdx++)
+	{
+		UpdateHistogram(pRows, unSize, unColIdx, -1, oHistogram);
+	}
+}
+
+/*
+ * @brief	order two values
+*/
+static inline void SortPair(unsigned short& usFirst, unsigned short& usSecond)
+{
+	unsigned short usMin = min(usFirst, usSecond);
+	usSecond = max(usFirst, usSecond);
+	usFirst = usMin;
+}
+
+#ifdef _SIMD_SSE2_
+/*
+ * @brief	order two vectors of 8 values lane by lane, values are sign flipped since SSE2 compares signed 16-bit only
+*/
+static inline void SortPair(__m128i& nFirst, __m128i& nSecond)
+{
+	__m128i nMin = _mm_min_epi16(nFirst, nSecond);
+	nSecond = _mm_max_epi16(nFirst, nSecond);
+	nFirst = nMin;
+}
+#endif	// _SIMD_SSE2_
+
+/*
+ * @brief	run a network of compare-exchange pairs
+ * @param	pValues
+ * @param	pNetwork
+ * @param	unNumPairs
+*/
+template<typename V>
+static void RunNetwork(V* pValues, const unsigned char (*pNetwork)[2], size_t unNumPairs)
+{
+	for (size_t unPairIdx = 0; unPairIdx < unNumPairs; unPairIdx++)
+	{
+		SortPair(pValues[pNetwork[unPairIdx][0]], pValues[pNetwork[unPairIdx][1]]);
+	}
+}
+
+/*
+ * @brief	median filter one row with a sorting network, 8 pixels at a time
+ * @param	pRows: 2 * radius + 1 padded rows around the row
+ * @param	unRadius: 1 or 2
+ * @param	usImgWidth
+ * @param	pDst: usImgWidth pixels
+*/
+static void MedianRowByNetwork(const unsigned short* const* pRows, unsigned int unRadius, unsigned short usImgWidth, unsigned short* pDst)
+{
+	unsigned int unSize = 2 * unRadius + 1;
+	const unsigned char (*pNetwork)[2] = 1 == unRadius ? s_ucMedian9Network : s_ucMedian25Network;
+	size_t unNumPairs = 1 == unRadius ? sizeof(s_ucMedian9Network) / 2 : sizeof(s_ucMedian25Network) / 2;
+
+	unsigned int unColIdx = 0;
+
+#ifdef _SIMD_SSE2_
+	__m128i nFlip = _mm_set1_epi16((short)0x8000);
+	__m128i nWindow[25];
+	for (; unColIdx + 8 <= usImgWidth; unColIdx += 8)
+	{
+		for (unsigned int unRowIdx = 0; unRowIdx < unSize; unRowIdx++)
+		{
+			for (unsigned int unTapIdx = 0; unTapIdx < unSize; unTapIdx++)
+			{
+				nWindow[unRowIdx * unSize + unTapIdx] = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(pRows[unRowIdx] + unColIdx + unTapIdx)), nFlip);
+			}
+		}
+
+		RunNetwork(nWindow, pNetwork, unNumPairs);
+		_mm_storeu_si128((__m128i*)(pDst + unColIdx), _mm_xor_si128(nWindow[unSize * unSize / 2], nFlip));
+	}
+#endif	// _SIMD_SSE2_
+
+	unsigned short usWindow[25];
+	for (; unColIdx < usImgWidth; unColIdx++)
+	{
+		for (unsigned int unRowIdx = 0; unRowIdx < unSize; unRowIdx++)
+		{
+			copy(pRows[unRowIdx] + unColIdx, pRows[unRowIdx] + unColIdx + unSize, usWindow + unRowIdx * unSize);
+		}
+
+		RunNetwork(usWindow, pNetwork, unNumPairs);
+		pDst[unColIdx] = usWindow[unSize * unSize / 2];
+	}
+}
+
+/*
+ * @brief	replace each pixel by the median of the (2 * radius + 1)^2 pixels around it, pixels beyond the border repeat the border.
+ *			radius 1 and 2 use SIMD sorting networks, larger radii a sliding histogram
+ * @param	pImgPtr: overwritten by the filtered image
+ * @param	usImgHeight
+ * @param	usImgWidth
+ * @param	usRadius: pixels on each side, at most MEDIAN_MAX_RADIUS, 0 leaves the image untouched
+ * @return	error code
+*/
+int MedianFilter(unsigned short* pImgPtr, unsigned short usImgHeight, unsigned short usImgWidth, unsigned short usRadius)
+{
+	if (nullptr == pImgPtr || 0 == usImgWidth || usRadius > MEDIAN_MAX_RADIUS)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	if (0 == usRadius)
+	{
+		return STATUS_OK;
+	}
+
+	int nHeight = usImgHeight;
+	int nRadius = usRadius;
+	unsigned int unSize = 2 * nRadius + 1;
+	size_t unPaddedWidth = usImgWidth + 2 * nRadius;
+
+	// bands overwrite their own rows only, so the rows around each band are saved before any band starts
+	vector<unsigned short> vecHaloRows;
+	size_t unNumBands = SaveFilterHalo(pImgPtr, usImgHeight, usImgWidth, nRadius, vecHaloRows);
+
+	CThreadPool::GetInstance()->ParallelFor(unNumBands, [&](size_t unBandBegin, size_t unBandEnd)
+	{
+		// the 2 * radius + 1 source rows of the current output row, padded by radius pixels on each side
+		vector<unsigned short> vecPaddedRows(unSize * unPaddedWidth);
+		vector<const unsigned short*> vecRows(unSize);
+
+		MedianHistogram oHistogram;
+		if (usRadius > 2)
+		{
+			oHistogram.vecCoarse.assign(65536 >> MEDIAN_COARSE_SHIFT, 0);
+			oHistogram.vecFine.assign(65536, 0);
+			oHistogram.unBin = 0;
+			oHistogram.unBelow = 0;
+		}
+
+		for (size_t unBandIdx = unBandBegin; unBandIdx < unBandEnd; unBandIdx++)
+		{
+			int nBandBegin = (int)unBandIdx * FILTER_BAND_HEIGHT;
+			int nBandEnd = min(nBandBegin + FILTER_BAND_HEIGHT, nHeight);
+			const unsigned short* pHaloRows = GetFilterHaloRows(vecHaloRows, unBandIdx, usImgWidth, nRadius);
+
+			// row r lives in slot (r + radius) % size, rows of the band are read before being overwritten
+			auto funcLoadRow = [&](int nRowIdx)
+			{
+				unsigned short* pPadded = &vecPaddedRows[(size_t)((nRowIdx + nRadius) % unSize) * unPaddedWidth];
+				const unsigned short* pRow = GetFilterSourceRow(pImgPtr, pHaloRows, usImgWidth, nBandBegin, nBandEnd, nRadius, nRowIdx);
+				copy(pRow, pRow + usImgWidth, pPadded + nRadius);
+				fill(pPadded, pPadded + nRadius, pRow[0]);
+				fill(pPadded + nRadius + usImgWidth, pPadded + unPaddedWidth, pRow[usImgWidth - 1]);
+			};
+
+			for (int nRowIdx = nBandBegin - nRadius; nRowIdx < nBandBegin + nRadius; nRowIdx++)
+			{
+				funcLoadRow(nRowIdx);
+			}
+
+			for (int nRowIdx = nBandBegin; nRowIdx < nBandEnd; nRowIdx++)
+			{
+				funcLoadRow(nRowIdx + nRadius);
+				for (unsigned int unTapIdx = 0; unTapIdx < unSize; unTapIdx++)
+				{
+					vecRows[unTapIdx] = &vecPaddedRows[(size_t)((nRowIdx + unTapIdx) % unSize) * unPaddedWidth];
+				}
+
+				unsigned short* pDst = pImgPtr + (size_t)nRowIdx * usImgWidth;
+				if (usRadius > 2)
+				{
+					MedianRowByHistogram(vecRows.data(), nRadius, usImgWidth, oHistogram, pDst);
+				}
+				else
+				{
+					MedianRowByNetwork(vecRows.data(), nRadius, usImgWidth, pDst);
+				}
+			}
+		}
+	}, 1);
+
+	return STATUS_OK;
+}
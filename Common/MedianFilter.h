@@ -0,0 +1,41 @@
+/***************************************************
+ * @file		MedianFilter.h
+ * @section		Common
+ * @class		N/A
+ * @brief		in-place median filtering of 16-bit images, sorting networks for small windows, sliding histogram for large ones
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#ifndef __MEDIAN_FILTER_H__
+#define __MEDIAN_FILTER_H__
+
+#include "MacroDeclSpec.h"
+
+// largest radius, counts of the sliding histogram are 16-bit
+#define MEDIAN_MAX_RADIUS	127
+
+/*
+ * @brief	replace each pixel by the median of the (2 * radius + 1)^2 pixels around it, pixels beyond the border repeat the border.
+ *			radius 1 and 2 use SIMD sorting networks, larger radii a sliding histogram
+ * @param	pImgPtr: overwritten by the filtered image
+ * @param	usImgHeight
+ * @param	usImgWidth
+ * @param	usRadius: pixels on each side, at most MEDIAN_MAX_RADIUS, 0 leaves the image untouched
+ * @return	error code
+*/
+_DLL_EXPORT_ int MedianFilter(unsigned short* pImgPtr, unsigned short usImgHeight, unsigned short usImgWidth, unsigned short usRadius);
+
+//#ifdef __cplusplus
+//extern "C"
+//{
+//#endif // __cplusplus
+//
+//
+//#ifdef __cplusplus
+//};
+//#endif // __cplusplus
+
+#endif	// __MEDIAN_FILTER_H__
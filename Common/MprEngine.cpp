@@ -0,0 +1,635 @@
+/***************************************************
+ * @file		MprEngine.cpp
+ * @section		Common
+ * @class		N/A
+ * @brief		multi-planar reformation and slab projection of a volume on axial, coronal, sagittal and oblique planes
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <math.h>
+
+#include "IntlMsgAliasID.h"
+#include "MacroSimd.h"
+#include "MprEngine.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+/* what a row needs to sample the volume, positions in voxels */
+struct MprSampler
+{
+	const unsigned short* pVoxels;
+	const size_t* pOffsets[NumVolumeAxes];
+	float fMaxIdx[NumVolumeAxes];	///< dim - 1
+	float fStart[NumVolumeAxes];	///< position of pixel 0 of the row
+	float fStep[NumVolumeAxes];		///< move from a pixel to the next
+	float fBackground;
+};
+
+/*
+ * @brief	trilinear sample at a position in voxels
+ * @param	oSampler
+ * @param	fPos: position, already inside the volume
+ * @return	value
+*/
+static float SampleTrilinear(const MprSampler& oSampler, const float fPos[NumVolumeAxes])
+{
+	size_t unOffsets[NumVolumeAxes][2];
+	float fFracs[NumVolumeAxes];
+	for (int nAxis = 0; nAxis < NumVolumeAxes; nAxis++)
+	{
+		int nIdx = (int)fPos[nAxis];
+		fFracs[nAxis] = fPos[nAxis] - nIdx;
+		unOffsets[nAxis][0] = oSampler.pOffsets[nAxis][nIdx];
+		unOffsets[nAxis][1] = oSampler.pOffsets[nAxis][nIdx + 1];
+	}
+
+	const unsigned short* pVoxels = oSampler.pVoxels;
+	float fValue[2][2];
+	for (int nZ = 0; nZ < 2; nZ++)
+	{
+		for (int nY = 0; nY < 2; nY++)
+		{
+			size_t unRowOffset = unOffsets[AxisY][nY] + unOffsets[AxisZ][nZ];
+			float fLeft = pVoxels[unRowOffset + unOffsets[AxisX][0]];
+			float fRight = pVoxels[unRowOffset + unOffsets[AxisX][1]];
+			fValue[nZ][nY] = fLeft + (fRight - fLeft) * fFracs[AxisX];
+		}
+	}
+
+	float fNear = fValue[0][0] + (fValue[0][1] - fValue[0][0]) * fFracs[AxisY];
+	float fFar = fValue[1][0] + (fValue[1][1] - fValue[1][0]) * fFracs[AxisY];
+
+	return fNear + (fFar - fNear) * fFracs[AxisZ];
+}
+
+/*
+ * @brief	sample pixels [unBegin, unEnd) of a row one by one
+ * @param	oSampler
+ * @param	unBegin
+ * @param	unEnd
+ * @param	pDstRow: fBackground where outside the volume
+*/
+static void SampleRowScalar(const MprSampler& oSampler, size_t unBegin, size_t unEnd, float* pDstRow)
+{
+	for (size_t unColIdx = unBegin; unColIdx < unEnd; unColIdx++)
+	{
+		float fPos[NumVolumeAxes];
+		bool isInside = true;
+		for (int nAxis = 0; nAxis < NumVolumeAxes; nAxis++)
+		{
+			fPos[nAxis] = oSampler.fStart[nAxis] + oSampler.fStep[nAxis] * unColIdx;
+			isInside = isInside && fPos[nAxis] >= 0 && fPos[nAxis] <= oSampler.fMaxIdx[nAxis];
+		}
+
+		pDstRow[unColIdx] = isInside ? SampleTrilinear(oSampler, fPos) : oSampler.fBackground;
+	}
+}
+
+#ifdef _SIMD_SSE2_
+/*
+ * @brief	sample a row 4 pixels at a time, the 8 corners are gathered through the offset tables of the volume
+ * @param	oSampler
+ * @param	unWidth
+ * @param	pDstRow: fBackground where outside the volume
+*/
+static void SampleRow(const MprSampler& oSampler, size_t unWidth, float* pDstRow)
+{
+	_ALIGN_(16) int nIdx[NumVolumeAxes][4];
+	_ALIGN_(16) float fCorners[8][4];
+
+	__m128 fZero = _mm_setzero_ps();
+	__m128 fBackground = _mm_set1_ps(oSampler.fBackground);
+	__m128 fLanes = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+
+	size_t unColIdx = 0;
+	for (; unColIdx + 4 <= unWidth; unColIdx += 4)
+	{
+		__m128 fCols = _mm_add_ps(_mm_set1_ps((float)unColIdx), fLanes);
+		__m128 fInside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		__m128 fFracs[NumVolumeAxes];
+
+		for (int nAxis = 0; nAxis < NumVolumeAxes; nAxis++)
+		{
+			__m128 fMaxIdx = _mm_set1_ps(oSampler.fMaxIdx[nAxis]);
+			__m128 fPos = _mm_add_ps(_mm_set1_ps(oSampler.fStart[nAxis]), _mm_mul_ps(_mm_set1_ps(oSampler.fStep[nAxis]), fCols));
+			fInside = _mm_and_ps(fInside, _mm_and_ps(_mm_cmpge_ps(fPos, fZero), _mm_cmple_ps(fPos, fMaxIdx)));
+
+			// outside lanes are clamped so that their gathers stay in the volume, the mask discards them
+			fPos = _mm_min_ps(_mm_max_ps(fPos, fZero), fMaxIdx);
+			__m128i nFloor = _mm_cvttps_epi32(fPos);
+			fFracs[nAxis] = _mm_sub_ps(fPos, _mm_cvtepi32_ps(nFloor));
+			_mm_store_si128((__m128i*)nIdx[nAxis], nFloor);
+		}
+
+		if (0 == _mm_movemask_ps(fInside))
+		{
+			_mm_storeu_ps(pDstRow + unColIdx, fBackground);
+			continue;
+		}
+
+		for (int nLane = 0; nLane < 4; nLane++)
+		{
+			const size_t* pOffsetX = oSampler.pOffsets[AxisX] + nIdx[AxisX][nLane];
+			const size_t* pOffsetY = oSampler.pOffsets[AxisY] + nIdx[AxisY][nLane];
+			const size_t* pOffsetZ = oSampler.pOffsets[AxisZ] + nIdx[AxisZ][nLane];
+			for (int nCorner = 0; nCorner < 4; nCorner++)
+			{
+				const unsigned short* pRow = oSampler.pVoxels + pOffsetY[nCorner & 1] + pOffsetZ[nCorner >> 1];
+				fCorners[2 * nCorner][nLane] = pRow[pOffsetX[0]];
+				fCorners[2 * nCorner + 1][nLane] = pRow[pOffsetX[1]];
+			}
+		}
+
+		__m128 fRows[4];
+		for (int nCorner = 0; nCorner < 4; nCorner++)
+		{
+			__m128 fLeft = _mm_load_ps(fCorners[2 * nCorner]);
+			__m128 fRight = _mm_load_ps(fCorners[2 * nCorner + 1]);
+			fRows[nCorner] = _mm_add_ps(fLeft, _mm_mul_ps(_mm_sub_ps(fRight, fLeft), fFracs[AxisX]));
+		}
+		__m128 fNear = _mm_add_ps(fRows[0], _mm_mul_ps(_mm_sub_ps(fRows[1], fRows[0]), fFracs[AxisY]));
+		__m128 fFar = _mm_add_ps(fRows[2], _mm_mul_ps(_mm_sub_ps(fRows[3], fRows[2]), fFracs[AxisY]));
+		__m128 fValue = _mm_add_ps(fNear, _mm_mul_ps(_mm_sub_ps(fFar, fNear), fFracs[AxisZ]));
+		_mm_storeu_ps(pDstRow + unColIdx, _mm_or_ps(_mm_and_ps(fInside, fValue), _mm_andnot_ps(fInside, fBackground)));
+	}
+
+	SampleRowScalar(oSampler, unColIdx, unWidth, pDstRow);
+}
+
+/*
+ * @brief	round a row of samples in [0, 65535] to unsigned short
+ * @param	pSrcRow
+ * @param	unWidth
+ * @param	pDstRow
+*/
+static void StoreRow(const float* pSrcRow, size_t unWidth, unsigned short* pDstRow)
+{
+	__m128 fHalf = _mm_set1_ps(0.5f);
+	__m128i nBias = _mm_set1_epi32(0x8000);
+
+	size_t unColIdx = 0;
+	for (; unColIdx + 8 <= unWidth; unColIdx += 8)
+	{
+		// half up and truncated like the scalar tail, rather than rounded half to even by the current rounding mode
+		// no unsigned saturating pack before SSE4.1, values are biased into the signed range and back
+		__m128i nLow = _mm_sub_epi32(_mm_cvttps_epi32(_mm_add_ps(_mm_loadu_ps(pSrcRow + unColIdx), fHalf)), nBias);
+		__m128i nHigh = _mm_sub_epi32(_mm_cvttps_epi32(_mm_add_ps(_mm_loadu_ps(pSrcRow + unColIdx + 4), fHalf)), nBias);
+		__m128i nValue = _mm_add_epi16(_mm_packs_epi32(nLow, nHigh), _mm_set1_epi16((short)0x8000));
+		_mm_storeu_si128((__m128i*)(pDstRow + unColIdx), nValue);
+	}
+
+	for (; unColIdx < unWidth; unColIdx++)
+	{
+		pDstRow[unColIdx] = (unsigned short)(pSrcRow[unColIdx] + 0.5f);
+	}
+}
+#else
+/*
+ * @brief	sample a row
+ * @param	oSampler
+ * @param	unWidth
+ * @param	pDstRow: fBackground where outside the volume
+*/
+static void SampleRow(const MprSampler& oSampler, size_t unWidth, float* pDstRow)
+{
+	SampleRowScalar(oSampler, 0, unWidth, pDstRow);
+}
+
+/*
+ * @brief	round a row of samples in [0, 65535] to unsigned short
+ * @param	pSrcRow
+ * @param	unWidth
+ * @param	pDstRow
+*/
+static void StoreRow(const float* pSrcRow, size_t unWidth, unsigned short* pDstRow)
+{
+	for (size_t unColIdx = 0; unColIdx < unWidth; unColIdx++)
+	{
+		pDstRow[unColIdx] = (unsigned short)(pSrcRow[unColIdx] + 0.5f);
+	}
+}
+#endif	// _SIMD_SSE2_
+
+/*
+ * @brief	fold a run of contiguous voxels into the accumulators of a slab
+ * @param	nMode
+ * @param	pSrc: voxels
+ * @param	unLen: number of voxels
+ * @param	pAcc: running maximum or minimum
+ * @param	pSum: running sum for average
+*/
+static void AccumulateRun(ProjectionMode nMode, const unsigned short* pSrc, size_t unLen, unsigned short* pAcc, unsigned int* pSum)
+{
+	size_t unIdx = 0;
+
+#ifdef _SIMD_SSE2_
+	// SSE2 compares signed 16-bit only, flipping the top bit keeps the order of unsigned values
+	__m128i nFlip = _mm_set1_epi16((short)0x8000);
+	__m128i nZero = _mm_setzero_si128();
+
+	for (; unIdx + 8 <= unLen; unIdx += 8)
+	{
+		__m128i nValue = _mm_loadu_si128((const __m128i*)(pSrc + unIdx));
+		if (ProjectAverage == nMode)
+		{
+			__m128i* pSum4 = (__m128i*)(pSum + unIdx);
+			_mm_storeu_si128(pSum4, _mm_add_epi32(_mm_loadu_si128(pSum4), _mm_unpacklo_epi16(nValue, nZero)));
+			_mm_storeu_si128(pSum4 + 1, _mm_add_epi32(_mm_loadu_si128(pSum4 + 1), _mm_unpackhi_epi16(nValue, nZero)));
+			continue;
+		}
+
+		__m128i* pAcc8 = (__m128i*)(pAcc + unIdx);
+		__m128i nAcc = _mm_xor_si128(_mm_loadu_si128(pAcc8), nFlip);
+		nValue = _mm_xor_si128(nValue, nFlip);
+		nAcc = ProjectMaximum == nMode ? _mm_max_epi16(nAcc, nValue) : _mm_min_epi16(nAcc, nValue);
+		_mm_storeu_si128(pAcc8, _mm_xor_si128(nAcc, nFlip));
+	}
+#endif	// _SIMD_SSE2_
+
+	for (; unIdx < unLen; unIdx++)
+	{
+		switch (nMode)
+		{
+		case ProjectMaximum:
+			pAcc[unIdx] = pSrc[unIdx] > pAcc[unIdx] ? pSrc[unIdx] : pAcc[unIdx];
+			break;
+		case ProjectMinimum:
+			pAcc[unIdx] = pSrc[unIdx] < pAcc[unIdx] ? pSrc[unIdx] : pAcc[unIdx];
+			break;
+		default:
+			pSum[unIdx] += pSrc[unIdx];
+			break;
+		}
+	}
+}
+
+/*
+ * @brief	fold a row of samples into the accumulators of a slab, NaN samples are outside the volume and skipped
+ * @param	nMode
+ * @param	pSample
+ * @param	unWidth
+ * @param	pAcc: running maximum, minimum or sum
+ * @param	pCount: number of samples inside the volume, average only
+*/
+static void CombineRow(ProjectionMode nMode, const float* pSample, size_t unWidth, float* pAcc, float* pCount)
+{
+	size_t unColIdx = 0;
+
+#ifdef _SIMD_SSE2_
+	__m128 fOne = _mm_set1_ps(1.0f);
+
+	for (; unColIdx + 4 <= unWidth; unColIdx += 4)
+	{
+		__m128 fValue = _mm_loadu_ps(pSample + unColIdx);
+		__m128 fAcc = _mm_loadu_ps(pAcc + unColIdx);
+
+		// maxps and minps return the second operand when the first is NaN
+		if (ProjectMaximum == nMode)
+		{
+			fAcc = _mm_max_ps(fValue, fAcc);
+		}
+		else if (ProjectMinimum == nMode)
+		{
+			fAcc = _mm_min_ps(fValue, fAcc);
+		}
+		else
+		{
+			__m128 fInside = _mm_cmpord_ps(fValue, fValue);
+			fAcc = _mm_add_ps(fAcc, _mm_and_ps(fInside, fValue));
+			_mm_storeu_ps(pCount + unColIdx, _mm_add_ps(_mm_loadu_ps(pCount + unColIdx), _mm_and_ps(fInside, fOne)));
+		}
+		_mm_storeu_ps(pAcc + unColIdx, fAcc);
+	}
+#endif	// _SIMD_SSE2_
+
+	for (; unColIdx < unWidth; unColIdx++)
+	{
+		float fValue = pSample[unColIdx];
+		if (fValue != fValue)
+		{
+			continue;
+		}
+
+		switch (nMode)
+		{
+		case ProjectMaximum:
+			pAcc[unColIdx] = fValue > pAcc[unColIdx] ? fValue : pAcc[unColIdx];
+			break;
+		case ProjectMinimum:
+			pAcc[unColIdx] = fValue < pAcc[unColIdx] ? fValue : pAcc[unColIdx];
+			break;
+		default:
+			pAcc[unColIdx] += fValue;
+			pCount[unColIdx] += 1.0f;
+			break;
+		}
+	}
+}
+
+/*
+ * @brief	set up the sampler of a plane and the step from a row to the next, in voxels
+ * @param	oVolume
+ * @param	oPlane
+ * @param	fBackground: value of samples outside the volume
+ * @param	oSampler: output sampler of row 0
+ * @param	fRowStep: output step between rows
+*/
+static void InitSampler(const CVolume& oVolume, const MprPlane& oPlane, float fBackground, MprSampler& oSampler, float fRowStep[NumVolumeAxes])
+{
+	oSampler.pVoxels = oVolume.GetData();
+	oSampler.fBackground = fBackground;
+
+	for (int nAxis = 0; nAxis < NumVolumeAxes; nAxis++)
+	{
+		float fSpacing = oVolume.GetSpacing((VolumeAxis)nAxis);
+		oSampler.pOffsets[nAxis] = oVolume.GetAxisOffsets((VolumeAxis)nAxis);
+		oSampler.fMaxIdx[nAxis] = (float)(oVolume.GetDim((VolumeAxis)nAxis) - 1);
+		oSampler.fStart[nAxis] = oPlane.fOrigin[nAxis] / fSpacing;
+		oSampler.fStep[nAxis] = oPlane.fAxisU[nAxis] * oPlane.fPixelSize / fSpacing;
+		fRowStep[nAxis] = oPlane.fAxisV[nAxis] * oPlane.fPixelSize / fSpacing;
+	}
+}
+
+/*
+ * @brief	check whether pixels of a plane are voxels of the volume, columns along x and rows along y or z
+ * @param	oVolume
+ * @param	oPlane
+ * @param	nOrigin: output voxel of pixel (0, 0), may lie outside the volume
+ * @param	nAxisV: output axis of rows
+ * @return	true if aligned
+*/
+static bool IsAlignedPlane(const CVolume& oVolume, const MprPlane& oPlane, int nOrigin[NumVolumeAxes], VolumeAxis& nAxisV)
+{
+	if (1.0f != oPlane.fAxisU[AxisX] || 0.0f != oPlane.fAxisU[AxisY] || 0.0f != oPlane.fAxisU[AxisZ] || 0.0f != oPlane.fAxisV[AxisX])
+	{
+		return false;
+	}
+
+	if (1.0f == oPlane.fAxisV[AxisY] && 0.0f == oPlane.fAxisV[AxisZ])
+	{
+		nAxisV = AxisY;
+	}
+	else if (0.0f == oPlane.fAxisV[AxisY] && 1.0f == oPlane.fAxisV[AxisZ])
+	{
+		nAxisV = AxisZ;
+	}
+	else
+	{
+		return false;
+	}
+
+	VolumeAxis nInPlane[2] = { AxisX, nAxisV };
+	for (int nIdx = 0; nIdx < 2; nIdx++)
+	{
+		float fSpacing = oVolume.GetSpacing(nInPlane[nIdx]);
+		float fOrigin = oPlane.fOrigin[nInPlane[nIdx]] / fSpacing;
+		nOrigin[nInPlane[nIdx]] = (int)floor(fOrigin + 0.5f);
+		if (fabs(oPlane.fPixelSize - fSpacing) > 1e-4f * fSpacing || fabs(fOrigin - nOrigin[nInPlane[nIdx]]) > 1e-3f)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * @brief	plane through the volume perpendicular to an axis, covering the volume at its finest in-plane spacing
+ * @param	oVolume
+ * @param	nOrientation
+ * @param	fPosition: distance in mm from the first voxel along the normal
+ * @param	oPlane: output plane
+*/
+void GetOrthogonalPlane(const CVolume& oVolume, MprOrientation nOrientation, float fPosition, MprPlane& oPlane)
+{
+	// axes of columns and rows, the remaining one is the normal
+	VolumeAxis nAxisU = MprSagittal == nOrientation ? AxisY : AxisX;
+	VolumeAxis nAxisV = MprAxial == nOrientation ? AxisY : AxisZ;
+	VolumeAxis nAxisN = (VolumeAxis)(NumVolumeAxes - nAxisU - nAxisV);
+
+	for (int nAxis = 0; nAxis < NumVolumeAxes; nAxis++)
+	{
+		oPlane.fOrigin[nAxis] = nAxis == nAxisN ? fPosition : 0.0f;
+		oPlane.fAxisU[nAxis] = nAxis == nAxisU ? 1.0f : 0.0f;
+		oPlane.fAxisV[nAxis] = nAxis == nAxisV ? 1.0f : 0.0f;
+	}
+
+	float fSpacingU = oVolume.GetSpacing(nAxisU);
+	float fSpacingV = oVolume.GetSpacing(nAxisV);
+	oPlane.fPixelSize = fSpacingU < fSpacingV ? fSpacingU : fSpacingV;
+
+	float fExtentU = (oVolume.GetDim(nAxisU) > 0 ? oVolume.GetDim(nAxisU) - 1 : 0) * fSpacingU;
+	float fExtentV = (oVolume.GetDim(nAxisV) > 0 ? oVolume.GetDim(nAxisV) - 1 : 0) * fSpacingV;
+	float fWidth = floor(fExtentU / oPlane.fPixelSize + 0.5f) + 1;
+	float fHeight = floor(fExtentV / oPlane.fPixelSize + 0.5f) + 1;
+	oPlane.usWidth = (unsigned short)(fWidth < 65535.0f ? fWidth : 65535.0f);
+	oPlane.usHeight = (unsigned short)(fHeight < 65535.0f ? fHeight : 65535.0f);
+}
+
+/*
+ * @brief	maximum, minimum or average of a slab centered on a plane, along the normal of the plane
+ * @param	oVolume
+ * @param	oPlane
+ * @param	fThickness: mm, 0 for the plane only
+ * @param	nMode
+ * @param	pDst: usWidth x usHeight pixels
+ * @param	usBackground: value of pixels whose slab lies outside the volume
+ * @return	error code
+*/
+int ProjectSlab(const CVolume& oVolume, const MprPlane& oPlane, float fThickness, ProjectionMode nMode, unsigned short* pDst, unsigned short usBackground)
+{
+	if (nullptr == oVolume.GetData() || nullptr == pDst || oPlane.fPixelSize <= 0)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	size_t unWidth = oPlane.usWidth;
+	CThreadPool* pThreadPool = CThreadPool::GetInstance();
+
+	int nOrigin[NumVolumeAxes];
+	VolumeAxis nAxisV;
+	if (IsAlignedPlane(oVolume, oPlane, nOrigin, nAxisV))
+	{
+		// pixels are voxels, the slab is the slices along the normal whose centers are within half the thickness
+		VolumeAxis nAxisN = (VolumeAxis)(NumVolumeAxes - nAxisV);
+		float fCenter = oPlane.fOrigin[nAxisN] / oVolume.GetSpacing(nAxisN);
+		float fHalfSlab = (fThickness > 0 ? fThickness : 0) / 2 / oVolume.GetSpacing(nAxisN);
+		int nFirst = (int)ceil(fCenter - fHalfSlab - 1e-3f);
+		int nLast = (int)floor(fCenter + fHalfSlab + 1e-3f);
+		if (nFirst > nLast)
+		{
+			nFirst = nLast = (int)floor(fCenter + 0.5f);
+		}
+		nFirst = nFirst > 0 ? nFirst : 0;
+		nLast = nLast < (int)oVolume.GetDim(nAxisN) - 1 ? nLast : (int)oVolume.GetDim(nAxisN) - 1;
+
+		int nColBegin = nOrigin[AxisX] < 0 ? -nOrigin[AxisX] : 0;
+		int nColEnd = (int)oVolume.GetDim(AxisX) - nOrigin[AxisX] < (int)unWidth ? (int)oVolume.GetDim(AxisX) - nOrigin[AxisX] : (int)unWidth;
+
+		const unsigned short* pVoxels = oVolume.GetData();
+		const size_t* pOffsetX = oVolume.GetAxisOffsets(AxisX);
+		const size_t* pOffsetV = oVolume.GetAxisOffsets(nAxisV);
+		const size_t* pOffsetN = oVolume.GetAxisOffsets(nAxisN);
+		unsigned int unRunLen = VolumeBricked == oVolume.GetLayout() ? VOLUME_BRICK_DIM : oVolume.GetDim(AxisX);
+
+		// a band of rows shares the bricks of its slices
+		pThreadPool->ParallelFor(oPlane.usHeight, [&](size_t unBegin, size_t unEnd)
+		{
+			vector<unsigned short> vecAcc(unWidth);
+			vector<unsigned int> vecSum(unWidth);
+
+			for (size_t unRowIdx = unBegin; unRowIdx < unEnd; unRowIdx++)
+			{
+				unsigned short* pDstRow = pDst + unRowIdx * unWidth;
+				int nRow = nOrigin[nAxisV] + (int)unRowIdx;
+				if (nFirst > nLast || nRow < 0 || nRow >= (int)oVolume.GetDim(nAxisV) || nColBegin >= nColEnd)
+				{
+					fill(pDstRow, pDstRow + unWidth, usBackground);
+					continue;
+				}
+
+				fill(vecAcc.begin(), vecAcc.end(), (unsigned short)(ProjectMaximum == nMode ? 0 : 0xFFFF));
+				fill(vecSum.begin(), vecSum.end(), 0);
+				for (int nSliceIdx = nFirst; nSliceIdx <= nLast; nSliceIdx++)
+				{
+					const unsigned short* pSrcRow = pVoxels + pOffsetV[nRow] + pOffsetN[nSliceIdx];
+					for (int nColIdx = nColBegin; nColIdx < nColEnd;)
+					{
+						unsigned int unX = nOrigin[AxisX] + nColIdx;
+						int nLen = (int)(unRunLen - unX % unRunLen) < nColEnd - nColIdx ? (int)(unRunLen - unX % unRunLen) : nColEnd - nColIdx;
+						AccumulateRun(nMode, pSrcRow + pOffsetX[unX], nLen, &vecAcc[nColIdx], &vecSum[nColIdx]);
+						nColIdx += nLen;
+					}
+				}
+
+				unsigned int unNumSlices = nLast - nFirst + 1;
+				fill(pDstRow, pDstRow + nColBegin, usBackground);
+				for (int nColIdx = nColBegin; nColIdx < nColEnd; nColIdx++)
+				{
+					pDstRow[nColIdx] = ProjectAverage == nMode ? (unsigned short)((vecSum[nColIdx] + unNumSlices / 2) / unNumSlices) : vecAcc[nColIdx];
+				}
+				fill(pDstRow + nColEnd, pDstRow + unWidth, usBackground);
+			}
+		}, VOLUME_BRICK_DIM);
+
+		return STATUS_OK;
+	}
+
+	// oblique slab, sampled along the normal at the finest spacing of the volume
+	float fNormal[NumVolumeAxes];
+	for (int nAxis = 0; nAxis < NumVolumeAxes; nAxis++)
+	{
+		int nNext = (nAxis + 1) % NumVolumeAxes;
+		int nLast = (nAxis + 2) % NumVolumeAxes;
+		fNormal[nAxis] = oPlane.fAxisU[nNext] * oPlane.fAxisV[nLast] - oPlane.fAxisU[nLast] * oPlane.fAxisV[nNext];
+	}
+	float fNormalLen = sqrt(fNormal[AxisX] * fNormal[AxisX] + fNormal[AxisY] * fNormal[AxisY] + fNormal[AxisZ] * fNormal[AxisZ]);
+	if (fNormalLen < 1e-6f)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	float fSampleStep = oVolume.GetSpacing(AxisX);
+	for (int nAxis = AxisY; nAxis < NumVolumeAxes; nAxis++)
+	{
+		fSampleStep = oVolume.GetSpacing((VolumeAxis)nAxis) < fSampleStep ? oVolume.GetSpacing((VolumeAxis)nAxis) : fSampleStep;
+	}
+	int nNumSamples = fThickness > 0 ? (int)(fThickness / fSampleStep) + 1 : 1;
+
+	// samples outside the volume are NaN and skipped
+	MprSampler oSampler;
+	float fRowStep[NumVolumeAxes];
+	float fSlabStep[NumVolumeAxes];
+	InitSampler(oVolume, oPlane, numeric_limits<float>::quiet_NaN(), oSampler, fRowStep);
+	for (int nAxis = 0; nAxis < NumVolumeAxes; nAxis++)
+	{
+		fSlabStep[nAxis] = fNormal[nAxis] / fNormalLen * fSampleStep / oVolume.GetSpacing((VolumeAxis)nAxis);
+	}
+
+	float fAccInit = ProjectMaximum == nMode ? -1.0f : (ProjectMinimum == nMode ? 65536.0f : 0.0f);
+	pThreadPool->ParallelFor(oPlane.usHeight, [&](size_t unBegin, size_t unEnd)
+	{
+		MprSampler oRowSampler = oSampler;
+		vector<float> vecSample(unWidth);
+		vector<float> vecAcc(unWidth);
+		vector<float> vecCount(unWidth);
+
+		for (size_t unRowIdx = unBegin; unRowIdx < unEnd; unRowIdx++)
+		{
+			fill(vecAcc.begin(), vecAcc.end(), fAccInit);
+			fill(vecCount.begin(), vecCount.end(), 0.0f);
+
+			for (int nSampleIdx = 0; nSampleIdx < nNumSamples; nSampleIdx++)
+			{
+				float fSlabPos = nSampleIdx - (nNumSamples - 1) / 2.0f;
+				for (int nAxis = 0; nAxis < NumVolumeAxes; nAxis++)
+				{
+					oRowSampler.fStart[nAxis] = oSampler.fStart[nAxis] + fRowStep[nAxis] * unRowIdx + fSlabStep[nAxis] * fSlabPos;
+				}
+				SampleRow(oRowSampler, unWidth, vecSample.data());
+				CombineRow(nMode, vecSample.data(), unWidth, vecAcc.data(), vecCount.data());
+			}
+
+			unsigned short* pDstRow = pDst + unRowIdx * unWidth;
+			for (size_t unColIdx = 0; unColIdx < unWidth; unColIdx++)
+			{
+				float fValue = vecAcc[unColIdx];
+				bool isInside = ProjectMaximum == nMode ? fValue >= 0 : (ProjectMinimum == nMode ? fValue <= 65535.0f : vecCount[unColIdx] > 0);
+				if (ProjectAverage == nMode && isInside)
+				{
+					fValue /= vecCount[unColIdx];
+				}
+				pDstRow[unColIdx] = isInside ? (unsigned short)(fValue + 0.5f) : usBackground;
+			}
+		}
+	});
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	trilinear sampling of a plane, rows are spread over the thread pool
+ * @param	oVolume
+ * @param	oPlane
+ * @param	pDst: usWidth x usHeight pixels
+ * @param	usBackground: value of pixels outside the volume
+ * @return	error code
+*/
+int ReformatPlane(const CVolume& oVolume, const MprPlane& oPlane, unsigned short* pDst, unsigned short usBackground)
+{
+	if (nullptr == oVolume.GetData() || nullptr == pDst || oPlane.fPixelSize <= 0)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	// the plane is walked in voxels, each row is a straight line with a constant step
+	MprSampler oSampler;
+	float fRowStep[NumVolumeAxes];
+	InitSampler(oVolume, oPlane, usBackground, oSampler, fRowStep);
+
+	size_t unWidth = oPlane.usWidth;
+	CThreadPool::GetInstance()->ParallelFor(oPlane.usHeight, [&](size_t unBegin, size_t unEnd)
+	{
+		MprSampler oRowSampler = oSampler;
+		vector<float> vecSample(unWidth);
+		for (size_t unRowIdx = unBegin; unRowIdx < unEnd; unRowIdx++)
+		{
+			for (int nAxis = 0; nAxis < NumVolumeAxes; nAxis++)
+			{
+				oRowSampler.fStart[nAxis] = oSampler.fStart[nAxis] + fRowStep[nAxis] * unRowIdx;
+			}
+			SampleRow(oRowSampler, unWidth, vecSample.data());
+			StoreRow(vecSample.data(), unWidth, pDst + unRowIdx * unWidth);
+		}
+	});
+
+	return STATUS_OK;
+}
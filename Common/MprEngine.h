@@ -0,0 +1,87 @@
+/***************************************************
+ * @file		MprEngine.h
+ * @section		Common
+ * @class		N/A
+ * @brief		multi-planar reformation and slab projection of a volume on axial, coronal, sagittal and oblique planes
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#ifndef __MPR_ENGINE_H__
+#define __MPR_ENGINE_H__
+
+#include "MacroDeclSpec.h"
+#include "Volume.h"
+
+/* enum for orthogonal planes */
+enum MprOrientation
+{
+	MprAxial = 0,	///< plane of a slice, x to the right, y downward
+	MprCoronal,		///< x to the right, z downward
+	MprSagittal		///< y to the right, z downward
+};
+
+/* enum for reduction of a slab */
+enum ProjectionMode
+{
+	ProjectMaximum = 0,	///< MIP
+	ProjectMinimum,		///< MinIP
+	ProjectAverage		///< AvgIP
+};
+
+/* plane sampled from a volume, positions in mm with the center of voxel (0, 0, 0) at the origin */
+struct MprPlane
+{
+	float fOrigin[3];	///< center of pixel (0, 0)
+	float fAxisU[3];	///< unit direction of columns
+	float fAxisV[3];	///< unit direction of rows
+	float fPixelSize;	///< mm between neighbouring pixels
+	unsigned short usWidth;
+	unsigned short usHeight;
+};
+
+/*
+ * @brief	plane through the volume perpendicular to an axis, covering the volume at its finest in-plane spacing
+ * @param	oVolume
+ * @param	nOrientation
+ * @param	fPosition: distance in mm from the first voxel along the normal
+ * @param	oPlane: output plane
+*/
+_DLL_EXPORT_ void GetOrthogonalPlane(const CVolume& oVolume, MprOrientation nOrientation, float fPosition, MprPlane& oPlane);
+
+/*
+ * @brief	maximum, minimum or average of a slab centered on a plane, along the normal of the plane.
+ *			planes of GetOrthogonalPlane on the voxel grid of x reduce voxels directly, others are sampled trilinearly
+ * @param	oVolume
+ * @param	oPlane
+ * @param	fThickness: mm, 0 for the plane only
+ * @param	nMode
+ * @param	pDst: usWidth x usHeight pixels
+ * @param	usBackground: value of pixels whose slab lies outside the volume
+ * @return	error code
+*/
+_DLL_EXPORT_ int ProjectSlab(const CVolume& oVolume, const MprPlane& oPlane, float fThickness, ProjectionMode nMode, unsigned short* pDst, unsigned short usBackground = 0);
+
+/*
+ * @brief	trilinear sampling of a plane, rows are spread over the thread pool
+ * @param	oVolume
+ * @param	oPlane
+ * @param	pDst: usWidth x usHeight pixels
+ * @param	usBackground: value of pixels outside the volume
+ * @return	error code
+*/
+_DLL_EXPORT_ int ReformatPlane(const CVolume& oVolume, const MprPlane& oPlane, unsigned short* pDst, unsigned short usBackground = 0);
+
+//#ifdef __cplusplus
+//extern "C"
+//{
+//#endif // __cplusplus
+//
+//
+//#ifdef __cplusplus
+//};
+//#endif // __cplusplus
+
+#endif	// __MPR_ENGINE_H__
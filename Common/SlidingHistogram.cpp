@@ -0,0 +1,249 @@
+/***************************************************
+ * @file		SlidingHistogram.cpp
+ * @section		Common
+ * @class		CSlidingHistogram
+ * @brief		histogram of a frame stream updated incrementally from a subsampled grid, optionally decayed over time
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#include <algorithm>
+
+#include <float.h>
+
+#include "IntlMsgAliasID.h"
+#include "SlidingHistogram.h"
+
+using namespace std;
+
+/*
+ * @brief	greatest common divisor by Euclid's algorithm
+ * @param	unA
+ * @param	unB
+ * @return	gcd of unA and unB, unA when unB is 0
+*/
+static unsigned int GreatestCommonDivisor(unsigned int unA, unsigned int unB)
+{
+	while (0 != unB)
+	{
+		unsigned int unRemainder = unA % unB;
+		unA = unB;
+		unB = unRemainder;
+	}
+
+	return unA;
+}
+
+/*
+ * @brief	constructor
+*/
+CSlidingHistogram::CSlidingHistogram()
+{
+	m_usHeight = 0;
+	m_usWidth = 0;
+	m_unStep = SLIDING_HISTOGRAM_STEP;
+	m_unMaxValue = 65535;
+	m_unNumFrames = 0;
+	m_fDecay = 0;
+}
+
+/*
+ * @brief	destructor
+*/
+CSlidingHistogram::~CSlidingHistogram()
+{
+}
+
+/*
+ * @brief	window covering the samples between two percentiles, for CWindowLevel
+ * @param	fCenter: output, (low + high + 1) / 2
+ * @param	fWidth: output, high - low + 1
+ * @param	fLowPercent
+ * @param	fHighPercent: above fLowPercent
+ * @return	error code
+*/
+int CSlidingHistogram::GetAutoWindow(float& fCenter, float& fWidth, float fLowPercent, float fHighPercent) const
+{
+	if (0 == m_unNumFrames || !(fLowPercent >= 0 && fLowPercent < fHighPercent && fHighPercent <= 100))
+	{
+		return INVALID_PARAMETER;
+	}
+
+	unsigned short usLow = GetPercentile(fLowPercent);
+	unsigned short usHigh = GetPercentile(fHighPercent);
+	fCenter = (usLow + usHigh + 1) / 2.0f;
+	fWidth = usHigh - usLow + 1.0f;
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	height of frames
+ * @return	rows
+*/
+unsigned short CSlidingHistogram::GetHeight() const
+{
+	return m_usHeight;
+}
+
+/*
+ * @brief	frames added since Reset
+ * @return	number of frames
+*/
+unsigned int CSlidingHistogram::GetNumFrames() const
+{
+	return m_unNumFrames;
+}
+
+/*
+ * @brief	pixels sampled from each frame
+ * @return	number of samples
+*/
+size_t CSlidingHistogram::GetNumSamples() const
+{
+	return m_vecSampleIdx.size();
+}
+
+/*
+ * @brief	smallest value with at least fPercent of the histogram not above it, a binary search of the cumulative table
+ * @param	fPercent: in [0, 100]
+ * @return	value, 0 without frames
+*/
+unsigned short CSlidingHistogram::GetPercentile(float fPercent) const
+{
+	if (0 == m_unNumFrames)
+	{
+		return 0;
+	}
+
+	// empty bins have the cumulative value of the bin before, the rank is kept above 0 to skip leading ones
+	float fRank = max(min(max(fPercent, 0.0f), 100.0f) / 100.0f * m_vecCumulative.back(), FLT_MIN);
+	size_t unValue = lower_bound(m_vecCumulative.begin(), m_vecCumulative.end(), fRank) - m_vecCumulative.begin();
+
+	return (unsigned short)min(unValue, (size_t)m_unMaxValue);
+}
+
+/*
+ * @brief	width of frames
+ * @return	columns
+*/
+unsigned short CSlidingHistogram::GetWidth() const
+{
+	return m_usWidth;
+}
+
+/*
+ * @brief	drop all frames and set frame size
+ * @param	usHeight
+ * @param	usWidth
+ * @param	unStep: distance between samples, 1 samples every pixel
+ * @param	fDecay: weight of previous frames in [0, 1), 0 for the current frame only
+ * @param	unBitDepth: stored bits of pixels, in [1, 16], values beyond go to the last bin
+ * @return	error code
+*/
+int CSlidingHistogram::Reset(unsigned short usHeight, unsigned short usWidth, unsigned int unStep, float fDecay, unsigned int unBitDepth)
+{
+	if (0 == usHeight || 0 == usWidth || 0 == unStep || !(fDecay >= 0 && fDecay < 1) || 0 == unBitDepth || unBitDepth > 16)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	m_usHeight = usHeight;
+	m_usWidth = usWidth;
+	m_unStep = min(unStep, (unsigned int)min(usHeight, usWidth));
+	m_unMaxValue = (1u << unBitDepth) - 1;
+	m_unNumFrames = 0;
+	m_fDecay = fDecay;
+
+	// one sample per block, its column moves by the smallest shift of at least half a block that is coprime with the
+	// block size, so consecutive sample rows visit every column of the block before repeating
+	unsigned int unColShift = (m_unStep + 1) / 2;
+	while (1 != GreatestCommonDivisor(unColShift, m_unStep))
+	{
+		unColShift++;
+	}
+
+	m_vecSampleIdx.clear();
+	unsigned int unShift = 0;
+	for (unsigned int unRowIdx = m_unStep / 2; unRowIdx < usHeight; unRowIdx += m_unStep)
+	{
+		for (unsigned int unColIdx = unShift; unColIdx < usWidth; unColIdx += m_unStep)
+		{
+			m_vecSampleIdx.push_back(unRowIdx * usWidth + unColIdx);
+		}
+		unShift = (unShift + unColShift) % m_unStep;
+	}
+
+	m_vecSamples.assign(m_vecSampleIdx.size(), 0);
+	m_vecCounts.assign(m_unMaxValue + 1, 0);
+	m_vecCumulative.assign(m_unMaxValue + 1, 0);
+	if (m_fDecay > 0)
+	{
+		m_vecDecayed.assign(m_unMaxValue + 1, 0);
+	}
+	else
+	{
+		vector<float>().swap(m_vecDecayed);
+	}
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	add one frame
+ * @param	pFrame: height x width pixels
+ * @return	error code
+*/
+int CSlidingHistogram::Update(const unsigned short* pFrame)
+{
+	if (nullptr == pFrame || 0 == m_usHeight)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	// unchanged samples cost a load and a compare, in fluoroscopy most of the scene
+	size_t unNumSamples = m_vecSampleIdx.size();
+	for (size_t unIdx = 0; unIdx < unNumSamples; unIdx++)
+	{
+		unsigned short usValue = (unsigned short)min((unsigned int)pFrame[m_vecSampleIdx[unIdx]], m_unMaxValue);
+		if (0 == m_unNumFrames)
+		{
+			m_vecCounts[usValue]++;
+		}
+		else if (usValue != m_vecSamples[unIdx])
+		{
+			m_vecCounts[m_vecSamples[unIdx]]--;
+			m_vecCounts[usValue]++;
+		}
+		m_vecSamples[unIdx] = usValue;
+	}
+
+	// the decayed histogram starts from the first frame, not from zero
+	float fSum = 0;
+	size_t unNumBins = m_vecCounts.size();
+	if (m_fDecay > 0)
+	{
+		float fWeight = 0 == m_unNumFrames ? 1.0f : 1.0f - m_fDecay;
+		float fKeep = 1.0f - fWeight;
+		for (size_t unBinIdx = 0; unBinIdx < unNumBins; unBinIdx++)
+		{
+			m_vecDecayed[unBinIdx] = fKeep * m_vecDecayed[unBinIdx] + fWeight * m_vecCounts[unBinIdx];
+			fSum += m_vecDecayed[unBinIdx];
+			m_vecCumulative[unBinIdx] = fSum;
+		}
+	}
+	else
+	{
+		for (size_t unBinIdx = 0; unBinIdx < unNumBins; unBinIdx++)
+		{
+			fSum += m_vecCounts[unBinIdx];
+			m_vecCumulative[unBinIdx] = fSum;
+		}
+	}
+
+	m_unNumFrames++;
+
+	return STATUS_OK;
+}
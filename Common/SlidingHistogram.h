@@ -0,0 +1,130 @@
+/***************************************************
+ * @file		SlidingHistogram.h
+ * @section		Common
+ * @class		CSlidingHistogram
+ * @brief		histogram of a frame stream updated incrementally from a subsampled grid, optionally decayed over time
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#ifndef __SLIDING_HISTOGRAM_H__
+#define __SLIDING_HISTOGRAM_H__
+
+#include <vector>
+
+#include <stddef.h>
+
+#include "MacroDeclSpec.h"
+
+// default distance between sampled pixels in rows and columns
+#define SLIDING_HISTOGRAM_STEP	4
+
+/*
+ * @class	CSlidingHistogram
+ * @brief	one pixel of each step x step block is sampled, the column shifting from one block row to the next so that
+ *			the grid does not lock onto line patterns. sampled values of the previous frame are kept, a frame only
+ *			moves the samples that changed from their old bin to their new one. with a decay the histogram queried is
+ *			decay x previous + (1 - decay) x current frame, so windows follow the scene smoothly instead of flickering
+*/
+class _DLL_EXPORT_ CSlidingHistogram
+{
+public:
+	/*
+	 * @brief	constructor
+	*/
+	CSlidingHistogram();
+
+	/*
+	 * @brief	destructor
+	*/
+	~CSlidingHistogram();
+
+	/*
+	 * @brief	window covering the samples between two percentiles, for CWindowLevel
+	 * @param	fCenter: output, (low + high + 1) / 2
+	 * @param	fWidth: output, high - low + 1
+	 * @param	fLowPercent
+	 * @param	fHighPercent: above fLowPercent
+	 * @return	error code
+	*/
+	int GetAutoWindow(float& fCenter, float& fWidth, float fLowPercent = 0.5f, float fHighPercent = 99.5f) const;
+
+	/*
+	 * @brief	height of frames
+	 * @return	rows
+	*/
+	unsigned short GetHeight() const;
+
+	/*
+	 * @brief	frames added since Reset
+	 * @return	number of frames
+	*/
+	unsigned int GetNumFrames() const;
+
+	/*
+	 * @brief	pixels sampled from each frame
+	 * @return	number of samples
+	*/
+	size_t GetNumSamples() const;
+
+	/*
+	 * @brief	smallest value with at least fPercent of the histogram not above it, a binary search of the cumulative table
+	 * @param	fPercent: in [0, 100]
+	 * @return	value, 0 without frames
+	*/
+	unsigned short GetPercentile(float fPercent) const;
+
+	/*
+	 * @brief	width of frames
+	 * @return	columns
+	*/
+	unsigned short GetWidth() const;
+
+	/*
+	 * @brief	drop all frames and set frame size
+	 * @param	usHeight
+	 * @param	usWidth
+	 * @param	unStep: distance between samples, 1 samples every pixel
+	 * @param	fDecay: weight of previous frames in [0, 1), 0 for the current frame only
+	 * @param	unBitDepth: stored bits of pixels, in [1, 16], values beyond go to the last bin
+	 * @return	error code
+	*/
+	int Reset(unsigned short usHeight, unsigned short usWidth, unsigned int unStep = SLIDING_HISTOGRAM_STEP, float fDecay = 0, unsigned int unBitDepth = 16);
+
+	/*
+	 * @brief	add one frame
+	 * @param	pFrame: height x width pixels
+	 * @return	error code
+	*/
+	int Update(const unsigned short* pFrame);
+
+private:
+	unsigned short m_usHeight;
+	unsigned short m_usWidth;
+
+	unsigned int m_unStep;
+	unsigned int m_unMaxValue;
+	unsigned int m_unNumFrames;
+
+	float m_fDecay;
+
+	std::vector<unsigned int> m_vecSampleIdx;	///< sampled pixels in memory order
+	std::vector<unsigned short> m_vecSamples;	///< their values in the last frame
+	std::vector<unsigned int> m_vecCounts;		///< histogram of the last frame
+	std::vector<float> m_vecDecayed;			///< decayed histogram, empty without decay
+	std::vector<float> m_vecCumulative;			///< of the histogram queried
+};
+
+//#ifdef __cplusplus
+//extern "C"
+//{
+//#endif // __cplusplus
+//
+//
+//#ifdef __cplusplus
+//};
+//#endif // __cplusplus
+
+#endif	// __SLIDING_HISTOGRAM_H__
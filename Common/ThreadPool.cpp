@@ -0,0 +1,245 @@
+/***************************************************
+ * @file		ThreadPool.cpp
+ * @section		Common
+ * @class		CThreadPool, a singleton
+ * @brief		worker threads shared by all asynchronous and parallel jobs
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#include <atomic>
+#include <memory>
+
+#include "Logger.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+/*
+ * @brief	state of a ParallelFor shared by the caller and helper tasks
+*/
+struct ParallelForState
+{
+	atomic<size_t> unNextChunk;
+	size_t unNumChunks;
+	size_t unNumChunksDone;
+	size_t unNumItems;
+	size_t unGrainSize;
+	function<void(size_t, size_t)> funcBody;
+	mutex oDoneLock;
+	condition_variable oDoneCond;
+};
+
+/*
+ * @brief	claim and run chunks until none is left
+ * @param	pState
+*/
+static void RunParallelChunks(ParallelForState* pState)
+{
+	size_t unNumDone = 0;
+	while (true)
+	{
+		size_t unChunkIdx = pState->unNextChunk++;
+		if (unChunkIdx >= pState->unNumChunks)
+		{
+			break;
+		}
+
+		size_t unBegin = unChunkIdx * pState->unGrainSize;
+		size_t unEnd = unBegin + pState->unGrainSize < pState->unNumItems ? unBegin + pState->unGrainSize : pState->unNumItems;
+
+		// a throwing chunk still counts as done, or the caller would wait forever
+		try
+		{
+			pState->funcBody(unBegin, unEnd);
+		}
+		catch (...)
+		{
+			__LOG_ERROR__("exception thrown by chunk of parallel for");
+		}
+
+		unNumDone++;
+	}
+
+	if (unNumDone > 0)
+	{
+		lock_guard<mutex> oLock(pState->oDoneLock);
+		pState->unNumChunksDone += unNumDone;
+		if (pState->unNumChunksDone == pState->unNumChunks)
+		{
+			pState->oDoneCond.notify_all();
+		}
+	}
+}
+
+CThreadPool* CThreadPool::m_pInstance = nullptr;
+CThreadPool::CGarbo CThreadPool::m_oGarbo;
+mutex m_oThreadPoolInstanceLock;
+
+/*
+ * @brief	constructor, one worker per hardware thread
+*/
+CThreadPool::CThreadPool()
+{
+	m_isStopping = false;
+	m_ullSeqNo = 0;
+
+	unsigned int unNumWorkers = thread::hardware_concurrency();
+	if (0 == unNumWorkers)
+	{
+		unNumWorkers = 2;
+	}
+
+	for (unsigned int unIdx = 0; unIdx < unNumWorkers; unIdx++)
+	{
+		m_vecWorkers.push_back(thread(&CThreadPool::WorkerLoop, this));
+	}
+}
+
+/*
+ * @brief	destructor, wait for running tasks, queued ones are dropped
+*/
+CThreadPool::~CThreadPool()
+{
+	m_oQueueLock.lock();
+	m_isStopping = true;
+	m_oQueueLock.unlock();
+
+	m_oQueueCond.notify_all();
+
+	for (size_t unIdx = 0; unIdx < m_vecWorkers.size(); unIdx++)
+	{
+		if (m_vecWorkers[unIdx].joinable())
+		{
+			m_vecWorkers[unIdx].join();
+		}
+	}
+}
+
+/*
+ * @brief	instance of singleton
+ * @return	pointer
+*/
+CThreadPool* CThreadPool::GetInstance()
+{
+	if (nullptr == m_pInstance)
+	{
+		m_oThreadPoolInstanceLock.lock();
+		if (nullptr == m_pInstance)
+		{
+			m_pInstance = new CThreadPool();
+		}
+		m_oThreadPoolInstanceLock.unlock();
+	}
+
+	return m_pInstance;
+}
+
+/*
+ * @brief	number of worker threads
+ * @return	number of worker threads
+*/
+unsigned int CThreadPool::GetNumWorkers() const
+{
+	return (unsigned int)m_vecWorkers.size();
+}
+
+/*
+ * @brief	run funcBody over [0, unNumItems) in chunks on workers and the calling thread, return when all chunks are done
+ * @param	unNumItems: number of items
+ * @param	funcBody: called with [unBegin, unEnd) of each chunk
+ * @param	unGrainSize: items per chunk, 0 for about 4 chunks per worker
+ * @param	nPriority: priority of helper tasks
+*/
+void CThreadPool::ParallelFor(size_t unNumItems, std::function<void(size_t, size_t)> funcBody, size_t unGrainSize, TaskPriority nPriority)
+{
+	if (0 == unNumItems)
+	{
+		return;
+	}
+
+	size_t unNumWorkers = m_vecWorkers.size();
+	if (0 == unGrainSize)
+	{
+		unGrainSize = (unNumItems + 4 * unNumWorkers - 1) / (4 * unNumWorkers);
+	}
+
+	shared_ptr<ParallelForState> pState = make_shared<ParallelForState>();
+	pState->unNextChunk = 0;
+	pState->unNumChunks = (unNumItems + unGrainSize - 1) / unGrainSize;
+	pState->unNumChunksDone = 0;
+	pState->unNumItems = unNumItems;
+	pState->unGrainSize = unGrainSize;
+	pState->funcBody = funcBody;
+
+	// the caller takes chunks too, so nested calls from workers cannot dead lock
+	size_t unNumHelpers = pState->unNumChunks - 1 < unNumWorkers ? pState->unNumChunks - 1 : unNumWorkers;
+	for (size_t unIdx = 0; unIdx < unNumHelpers; unIdx++)
+	{
+		Submit([pState]() { RunParallelChunks(pState.get()); }, nPriority);
+	}
+
+	RunParallelChunks(pState.get());
+
+	unique_lock<mutex> oLock(pState->oDoneLock);
+	while (pState->unNumChunksDone < pState->unNumChunks)
+	{
+		pState->oDoneCond.wait(oLock);
+	}
+}
+
+/*
+ * @brief	queue a task, tasks of the same priority run in submitting order
+ * @param	funcTask: task to run
+ * @param	nPriority: priority of task
+*/
+void CThreadPool::Submit(std::function<void()> funcTask, TaskPriority nPriority)
+{
+	PoolTask oTask;
+	oTask.nPriority = nPriority;
+	oTask.funcTask = funcTask;
+
+	m_oQueueLock.lock();
+	oTask.ullSeqNo = m_ullSeqNo++;
+	m_queTasks.push(oTask);
+	m_oQueueLock.unlock();
+
+	m_oQueueCond.notify_one();
+}
+
+/*
+ * @brief	loop of worker thread
+*/
+void CThreadPool::WorkerLoop()
+{
+	while (true)
+	{
+		PoolTask oTask;
+		{
+			unique_lock<mutex> oLock(m_oQueueLock);
+			while (!m_isStopping && m_queTasks.empty())
+			{
+				m_oQueueCond.wait(oLock);
+			}
+
+			if (m_isStopping)
+			{
+				return;
+			}
+
+			oTask = m_queTasks.top();
+			m_queTasks.pop();
+		}
+
+		try
+		{
+			oTask.funcTask();
+		}
+		catch (...)
+		{
+			__LOG_ERROR__("exception thrown by task of thread pool");
+		}
+	}
+}
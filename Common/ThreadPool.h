@@ -0,0 +1,145 @@
+/***************************************************
+ * @file		ThreadPool.h
+ * @section		Common
+ * @class		CThreadPool, a singleton
+ * @brief		worker threads shared by all asynchronous and parallel jobs
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "MacroDeclSpec.h"
+
+/* enum for priority of tasks, higher one is run first */
+enum TaskPriority
+{
+	PriorityBackground = 0,	///< prefetch and batch jobs
+	PriorityNormal,			///< default
+	PriorityVisible			///< data shown on screen
+};
+
+/*
+ * @class	CThreadPool
+ * @brief	fixed number of workers taking tasks from a priority queue
+*/
+class _DLL_EXPORT_ CThreadPool
+{
+public:
+	/*
+	 * @brief	instance of singleton
+	 * @return	pointer
+	*/
+	static CThreadPool* GetInstance();
+
+	/*
+	 * @brief	number of worker threads
+	 * @return	number of worker threads
+	*/
+	unsigned int GetNumWorkers() const;
+
+	/*
+	 * @brief	run funcBody over [0, unNumItems) in chunks on workers and the calling thread, return when all chunks are done
+	 * @param	unNumItems: number of items
+	 * @param	funcBody: called with [unBegin, unEnd) of each chunk
+	 * @param	unGrainSize: items per chunk, 0 for about 4 chunks per worker
+	 * @param	nPriority: priority of helper tasks
+	*/
+	void ParallelFor(size_t unNumItems, std::function<void(size_t, size_t)> funcBody, size_t unGrainSize = 0, TaskPriority nPriority = PriorityNormal);
+
+	/*
+	 * @brief	queue a task, tasks of the same priority run in submitting order
+	 * @param	funcTask: task to run
+	 * @param	nPriority: priority of task
+	*/
+	void Submit(std::function<void()> funcTask, TaskPriority nPriority = PriorityNormal);
+
+private:
+	/*
+	 * @brief	constructor, one worker per hardware thread
+	*/
+	CThreadPool();
+
+	/*
+	 * @brief	destructor, wait for running tasks, queued ones are dropped
+	*/
+	~CThreadPool();
+
+	/*
+	 * @brief	loop of worker thread
+	*/
+	void WorkerLoop();
+
+	struct PoolTask
+	{
+		int nPriority;
+		unsigned long long ullSeqNo;
+		std::function<void()> funcTask;
+	};
+
+	struct PoolTaskCompare
+	{
+		bool operator()(const PoolTask& oLeft, const PoolTask& oRight) const
+		{
+			if (oLeft.nPriority != oRight.nPriority)
+			{
+				return oLeft.nPriority < oRight.nPriority;
+			}
+
+			return oLeft.ullSeqNo > oRight.ullSeqNo;
+		}
+	};
+
+	/*
+	 * @class	CGarbo
+	 * @brief	destructor of singleton
+	*/
+	class CGarbo
+	{
+	public:
+		~CGarbo()
+		{
+			if (nullptr != m_pInstance)
+			{
+				delete m_pInstance;
+				m_pInstance = nullptr;
+			}
+		}
+	};
+
+	bool m_isStopping;
+
+	unsigned long long m_ullSeqNo;
+
+	std::mutex m_oQueueLock;
+	std::condition_variable m_oQueueCond;
+
+	std::priority_queue<PoolTask, std::vector<PoolTask>, PoolTaskCompare> m_queTasks;
+
+	std::vector<std::thread> m_vecWorkers;
+
+	static CThreadPool* m_pInstance;
+	static CGarbo m_oGarbo;
+};
+
+//#ifdef __cplusplus
+//extern "C"
+//{
+//#endif // __cplusplus
+//
+//
+//#ifdef __cplusplus
+//};
+//#endif // __cplusplus
+
+#endif	// __THREAD_POOL_H__
@@ -0,0 +1,674 @@
+/***************************************************
+ * @file		Volume.cpp
+ * @section		Common
+ * @class		CVolume
+ * @brief		16-bit volume stored slice by slice or in cubic bricks
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "CommonMethod.h"
+#include "DicomAsyncRead.h"
+#include "ErrorMsg.h"
+#include "Checksum.h"
+#include "IntlMsgAliasID.h"
+#include "MacroSimd.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include "Volume.h"
+
+using namespace std;
+
+#define VOLUME_CACHE_VERSION	2
+#define VOLUME_CACHE_ALIGN		4096
+
+/* header of a volume cache file, voxels follow at ullDataOffset in native byte order */
+struct VolumeCacheHeader
+{
+	char czMagic[8];
+	unsigned int unVersion;
+	unsigned int unLayout;
+	unsigned int unDims[NumVolumeAxes];
+	float fSpacing[NumVolumeAxes];
+	unsigned int unPixelDepth;		///< stored bits of source slices, 8 or 16
+	unsigned int unSignedData;		///< 1 if source slices are signed
+	float fRescaleSlope;
+	float fRescaleIntercept;
+	unsigned int unNumSources;
+	unsigned int unSourceStamp;		///< CRC-32C of names, sizes and modification times of source files
+	unsigned long long ullNumVoxels;	///< including padding of bricks
+	unsigned long long ullDataOffset;	///< multiple of VOLUME_CACHE_ALIGN
+};
+
+static const char VOLUME_CACHE_MAGIC[8] = { 'V', 'O', 'L', 'C', 'A', 'C', 'H', 'E' };
+
+/*
+ * @brief	constructor
+*/
+CVolume::CVolume()
+{
+	m_unNumVoxels = 0;
+	m_pVoxels = nullptr;
+	m_nLayout = VolumeSliceMajor;
+	m_pCacheFile = nullptr;
+	m_isSignedData = false;
+	m_usPixelDepth = 16;
+	m_fRescaleSlope = 1.0f;
+	m_fRescaleIntercept = 0;
+
+	for (int nAxis = 0; nAxis < NumVolumeAxes; nAxis++)
+	{
+		m_unDims[nAxis] = 0;
+		m_fSpacing[nAxis] = 1.0f;
+	}
+}
+
+/*
+ * @brief	destructor
+*/
+CVolume::~CVolume()
+{
+	Release();
+}
+
+/*
+ * @brief	allocate voxels, content is undefined until slices are set
+ * @param	unWidth: voxels along x
+ * @param	unHeight: voxels along y
+ * @param	unDepth: voxels along z
+ * @param	nLayout: memory layout
+ * @return	error code
+*/
+int CVolume::Allocate(unsigned int unWidth, unsigned int unHeight, unsigned int unDepth, VolumeLayout nLayout)
+{
+	Release();
+
+	if (0 == unWidth || 0 == unHeight || 0 == unDepth)
+	{
+		vector<string> vecErrorReplacer(1, "size of volume");
+		printf("%s\n", CErrorMsg::GetInstance()->GetMsgString(INVALID_PARAMETER, vecErrorReplacer).c_str());
+		return INVALID_PARAMETER;
+	}
+
+	m_unDims[AxisX] = unWidth;
+	m_unDims[AxisY] = unHeight;
+	m_unDims[AxisZ] = unDepth;
+	m_nLayout = nLayout;
+
+	m_unNumVoxels = GetNumStoredVoxels(m_unDims, nLayout);
+	m_pVoxels = (unsigned short*)AlignedMalloc(m_unNumVoxels * sizeof(unsigned short), SIMD_ALIGN_BYTES);
+	if (nullptr == m_pVoxels)
+	{
+		vector<string> vecErrorReplacer(1, to_string((unsigned long long)(m_unNumVoxels * sizeof(unsigned short))));
+		printf("%s\n", CErrorMsg::GetInstance()->GetMsgString(ALLOCATE_MEMORY_ERR, vecErrorReplacer).c_str());
+
+		Release();
+		return ALLOCATE_MEMORY_ERR;
+	}
+
+	BuildAxisOffsets();
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	offsets of voxels along an axis, entry [dim] repeats entry [dim - 1] so that index + 1 never leaves the volume
+ * @param	nAxis
+ * @return	dim + 1 offsets
+*/
+const size_t* CVolume::GetAxisOffsets(VolumeAxis nAxis) const
+{
+	return m_vecAxisOffsets[nAxis].data();
+}
+
+/*
+ * @brief	voxels, addressed with GetAxisOffsets
+ * @return	pointer
+*/
+const unsigned short* CVolume::GetData() const
+{
+	return m_pVoxels;
+}
+
+/*
+ * @brief	number of voxels along an axis
+ * @param	nAxis
+ * @return	number of voxels
+*/
+unsigned int CVolume::GetDim(VolumeAxis nAxis) const
+{
+	return m_unDims[nAxis];
+}
+
+/*
+ * @brief	memory layout
+ * @return	layout
+*/
+VolumeLayout CVolume::GetLayout() const
+{
+	return m_nLayout;
+}
+
+/*
+ * @brief	stored bits of the slices the volume was loaded from, 8-bit slices are widened to 16-bit voxels
+ * @return	8 or 16
+*/
+unsigned short CVolume::GetPixelDepth() const
+{
+	return m_usPixelDepth;
+}
+
+/*
+ * @brief	rescale intercept of the slices, voxels already have it applied
+ * @return	intercept
+*/
+float CVolume::GetRescaleIntercept() const
+{
+	return m_fRescaleIntercept;
+}
+
+/*
+ * @brief	rescale slope of the slices, voxels already have it applied
+ * @return	slope
+*/
+float CVolume::GetRescaleSlope() const
+{
+	return m_fRescaleSlope;
+}
+
+/*
+ * @brief	copy a row out of the volume
+ * @param	unRowIdx
+ * @param	unSliceIdx
+ * @param	pRow: width voxels
+ * @return	error code
+*/
+int CVolume::GetRow(unsigned int unRowIdx, unsigned int unSliceIdx, unsigned short* pRow) const
+{
+	if (nullptr == m_pVoxels || unRowIdx >= m_unDims[AxisY] || unSliceIdx >= m_unDims[AxisZ])
+	{
+		return INVALID_PARAMETER;
+	}
+
+	const size_t* pOffsetX = m_vecAxisOffsets[AxisX].data();
+	const unsigned short* pSrcRow = m_pVoxels + m_vecAxisOffsets[AxisY][unRowIdx] + m_vecAxisOffsets[AxisZ][unSliceIdx];
+
+	// voxels of a row are contiguous within a brick, VOLUME_BRICK_DIM at a time
+	unsigned int unRunLen = VolumeBricked == m_nLayout ? VOLUME_BRICK_DIM : m_unDims[AxisX];
+	for (unsigned int unColIdx = 0; unColIdx < m_unDims[AxisX]; unColIdx += unRunLen)
+	{
+		unsigned int unNumCopied = m_unDims[AxisX] - unColIdx < unRunLen ? m_unDims[AxisX] - unColIdx : unRunLen;
+		::memcpy(pRow + unColIdx, pSrcRow + pOffsetX[unColIdx], unNumCopied * sizeof(unsigned short));
+	}
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	copy a slice out of the volume
+ * @param	unSliceIdx
+ * @param	pSlice: width x height voxels
+ * @return	error code
+*/
+int CVolume::GetSlice(unsigned int unSliceIdx, unsigned short* pSlice) const
+{
+	if (nullptr == m_pVoxels || unSliceIdx >= m_unDims[AxisZ])
+	{
+		return INVALID_PARAMETER;
+	}
+
+	for (unsigned int unRowIdx = 0; unRowIdx < m_unDims[AxisY]; unRowIdx++)
+	{
+		GetRow(unRowIdx, unSliceIdx, pSlice);
+		pSlice += m_unDims[AxisX];
+	}
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	distance between centers of neighbouring voxels
+ * @param	nAxis
+ * @return	spacing in mm
+*/
+float CVolume::GetSpacing(VolumeAxis nAxis) const
+{
+	return m_fSpacing[nAxis];
+}
+
+/*
+ * @brief	whether the slices are signed, voxels then hold values shifted by 128 for 8-bit or 32768 for 16-bit slices
+ * @return	true for signed
+*/
+bool CVolume::IsSignedData() const
+{
+	return m_isSignedData;
+}
+
+/*
+ * @brief	map a cache file written by SaveCache, voxels are paged in on first access and read-only
+ * @param	strCacheFile
+ * @param	vecFileNames: slices the cache was built from, any change of them invalidates the cache
+ * @return	error code, CACHE_OUT_OF_DATE if the cache does not match the slices
+*/
+int CVolume::LoadCache(const std::string& strCacheFile, const std::vector<std::string>& vecFileNames)
+{
+	Release();
+
+	unsigned int unSourceStamp = 0;
+	int nProcResult = GetSourceStamp(vecFileNames, unSourceStamp);
+	if (STATUS_OK != nProcResult)
+	{
+		return nProcResult;
+	}
+
+	unique_ptr<CMappedFile> pCacheFile(new CMappedFile());
+	nProcResult = pCacheFile->Open(strCacheFile);
+	if (STATUS_OK != nProcResult)
+	{
+		return nProcResult;
+	}
+
+	if (pCacheFile->GetSize() < sizeof(VolumeCacheHeader))
+	{
+		return CACHE_OUT_OF_DATE;
+	}
+
+	// a cache of other sources, another version or a truncated write is rebuilt
+	const VolumeCacheHeader* pHeader = (const VolumeCacheHeader*)pCacheFile->GetData();
+	if (0 != memcmp(pHeader->czMagic, VOLUME_CACHE_MAGIC, sizeof(VOLUME_CACHE_MAGIC)) || VOLUME_CACHE_VERSION != pHeader->unVersion
+		|| vecFileNames.size() != pHeader->unNumSources || unSourceStamp != pHeader->unSourceStamp
+		|| (VolumeSliceMajor != pHeader->unLayout && VolumeBricked != pHeader->unLayout)
+		|| (8 != pHeader->unPixelDepth && 16 != pHeader->unPixelDepth) || pHeader->unSignedData > 1
+		|| 0 == pHeader->unDims[AxisX] || 0 == pHeader->unDims[AxisY] || 0 == pHeader->unDims[AxisZ]
+		|| GetNumStoredVoxels(pHeader->unDims, (VolumeLayout)pHeader->unLayout) != pHeader->ullNumVoxels
+		|| 0 != pHeader->ullDataOffset % VOLUME_CACHE_ALIGN || pHeader->ullDataOffset < sizeof(VolumeCacheHeader)
+		|| pCacheFile->GetSize() < pHeader->ullDataOffset + pHeader->ullNumVoxels * sizeof(unsigned short))
+	{
+		return CACHE_OUT_OF_DATE;
+	}
+
+	for (int nAxis = 0; nAxis < NumVolumeAxes; nAxis++)
+	{
+		m_unDims[nAxis] = pHeader->unDims[nAxis];
+		m_fSpacing[nAxis] = pHeader->fSpacing[nAxis];
+	}
+	m_nLayout = (VolumeLayout)pHeader->unLayout;
+	m_unNumVoxels = (size_t)pHeader->ullNumVoxels;
+	m_isSignedData = 1 == pHeader->unSignedData;
+	m_usPixelDepth = (unsigned short)pHeader->unPixelDepth;
+	m_fRescaleSlope = pHeader->fRescaleSlope;
+	m_fRescaleIntercept = pHeader->fRescaleIntercept;
+
+	// voxels are used in place, the mapping is page aligned and so is the offset
+	m_pVoxels = (unsigned short*)(pCacheFile->GetData() + pHeader->ullDataOffset);
+	m_pCacheFile = pCacheFile.release();
+
+	BuildAxisOffsets();
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	load a series of dicom slices, spacing comes from pixel spacing and slice spacing or thickness of the first slice
+ * @param	vecFileNames: slices in order
+ * @param	nLayout: memory layout
+ * @param	strCacheFile: cache file mapped instead of loading the slices if up to date, and rewritten otherwise, empty for no cache
+ * @return	error code
+*/
+int CVolume::LoadSeries(const std::vector<std::string>& vecFileNames, VolumeLayout nLayout, const std::string& strCacheFile)
+{
+	if (vecFileNames.empty())
+	{
+		return INVALID_FILE_NAME;
+	}
+
+	unsigned long long ullCacheSize = 0;
+	long long llCacheTime = 0;
+	if (!strCacheFile.empty() && GetFileStamp(strCacheFile, ullCacheSize, llCacheTime))
+	{
+		if (STATUS_OK == LoadCache(strCacheFile, vecFileNames) && nLayout == m_nLayout)
+		{
+			return STATUS_OK;
+		}
+
+		vector<string> vecErrorReplacer(1, strCacheFile);
+		printf("%s\n", CErrorMsg::GetInstance()->GetMsgString(CACHE_OUT_OF_DATE, vecErrorReplacer).c_str());
+	}
+
+	// size and geometry of the series come from its first slice
+	CDicomRead oReadDicom;
+	DicomInfo oFirstInfo;
+	int nProcResult = oReadDicom.GetInfo(vecFileNames[0], &oFirstInfo);
+	if (STATUS_OK != nProcResult)
+	{
+		return nProcResult;
+	}
+
+	nProcResult = Allocate(oFirstInfo.usImageWidth, oFirstInfo.usImageHeight, (unsigned int)vecFileNames.size(), nLayout);
+	if (STATUS_OK != nProcResult)
+	{
+		return nProcResult;
+	}
+
+	// slice spacing is the distance between slices, thickness only equals it for contiguous slices
+	float fSpacingZ = oFirstInfo.fSliceSpacing > 0 ? oFirstInfo.fSliceSpacing : oFirstInfo.fSliceThickness;
+	SetSpacing(oFirstInfo.fPixelSpacing[1] > 0 ? oFirstInfo.fPixelSpacing[1] : 1.0f, oFirstInfo.fPixelSpacing[0] > 0 ? oFirstInfo.fPixelSpacing[0] : 1.0f, fSpacingZ > 0 ? fSpacingZ : 1.0f);
+
+	// voxels of the series share one meaning, every slice must match the first one in depth, sign and rescale
+	m_isSignedData = oFirstInfo.isSignedData;
+	m_usPixelDepth = oFirstInfo.usPixelDepth;
+	m_fRescaleSlope = oFirstInfo.fRescaleSlope;
+	m_fRescaleIntercept = oFirstInfo.fRescaleIntercept;
+
+	// slices are decoded on the thread pool, a few in flight
+	size_t unSliceLen = (size_t)oFirstInfo.usImageWidth * oFirstInfo.usImageHeight;
+	size_t unNumSlots = 2 * CThreadPool::GetInstance()->GetNumWorkers();
+	vector<vector<unsigned short> > vecSliceBufs(unNumSlots, vector<unsigned short>(unSliceLen));
+	vector<shared_ptr<CDicomLoadRequest> > vecRequests(unNumSlots);
+
+	for (size_t unLoadIdx = 0; unLoadIdx < vecFileNames.size() + unNumSlots; unLoadIdx++)
+	{
+		size_t unSlotIdx = unLoadIdx % unNumSlots;
+		if (vecRequests[unSlotIdx])
+		{
+			int nSliceResult = vecRequests[unSlotIdx]->Wait();
+			const DicomInfo& oInfo = vecRequests[unSlotIdx]->GetInfo();
+			size_t unSliceIdx = unLoadIdx - unNumSlots;
+
+			if (STATUS_OK == nSliceResult && (oInfo.usImageWidth != oFirstInfo.usImageWidth || oInfo.usImageHeight != oFirstInfo.usImageHeight
+				|| oInfo.usSamplesPerPixel != 1 || (8 != oInfo.usPixelDepth && 16 != oInfo.usPixelDepth)
+				|| oInfo.usPixelDepth != oFirstInfo.usPixelDepth || oInfo.isSignedData != oFirstInfo.isSignedData
+				|| oInfo.fRescaleSlope != oFirstInfo.fRescaleSlope || oInfo.fRescaleIntercept != oFirstInfo.fRescaleIntercept))
+			{
+				vector<string> vecErrorReplacer(1, vecFileNames[unSliceIdx]);
+				printf("%s\n", CErrorMsg::GetInstance()->GetMsgString(INCONSISTENT_SLICE, vecErrorReplacer).c_str());
+				nSliceResult = INCONSISTENT_SLICE;
+			}
+
+			if (STATUS_OK == nSliceResult)
+			{
+				// 8-bit slices are widened in place, from the end
+				if (8 == oInfo.usPixelDepth)
+				{
+					unsigned short* pSlice = vecSliceBufs[unSlotIdx].data();
+					const unsigned char* pBytes = (const unsigned char*)pSlice;
+					for (size_t unIdx = unSliceLen; unIdx > 0; unIdx--)
+					{
+						pSlice[unIdx - 1] = pBytes[unIdx - 1];
+					}
+				}
+
+				SetSlice((unsigned int)unSliceIdx, vecSliceBufs[unSlotIdx].data());
+			}
+			else if (STATUS_OK == nProcResult)
+			{
+				nProcResult = nSliceResult;
+			}
+
+			vecRequests[unSlotIdx].reset();
+		}
+
+		if (unLoadIdx < vecFileNames.size())
+		{
+			vecRequests[unSlotIdx] = GetInfoAndDataAsync(vecFileNames[unLoadIdx], (char*)vecSliceBufs[unSlotIdx].data(), unSliceLen * sizeof(unsigned short));
+		}
+	}
+
+	if (STATUS_OK != nProcResult)
+	{
+		Release();
+		return nProcResult;
+	}
+
+	// a failed write only costs the next open a full load
+	if (!strCacheFile.empty())
+	{
+		SaveCache(strCacheFile, vecFileNames);
+	}
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	release voxels
+*/
+void CVolume::Release()
+{
+	if (nullptr != m_pCacheFile)
+	{
+		delete m_pCacheFile;
+		m_pCacheFile = nullptr;
+	}
+	else
+	{
+		AlignedFree(m_pVoxels);
+	}
+	m_pVoxels = nullptr;
+	m_unNumVoxels = 0;
+	m_isSignedData = false;
+	m_usPixelDepth = 16;
+	m_fRescaleSlope = 1.0f;
+	m_fRescaleIntercept = 0;
+
+	for (int nAxis = 0; nAxis < NumVolumeAxes; nAxis++)
+	{
+		m_unDims[nAxis] = 0;
+		m_vecAxisOffsets[nAxis].clear();
+	}
+}
+
+/*
+ * @brief	write voxels and geometry to a cache file, voxels start on a page boundary so that they can be mapped in place
+ * @param	strCacheFile
+ * @param	vecFileNames: slices the volume was built from
+ * @return	error code
+*/
+int CVolume::SaveCache(const std::string& strCacheFile, const std::vector<std::string>& vecFileNames) const
+{
+	if (nullptr == m_pVoxels)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	VolumeCacheHeader oHeader;
+	memset(&oHeader, 0, sizeof(oHeader));
+	int nProcResult = GetSourceStamp(vecFileNames, oHeader.unSourceStamp);
+	if (STATUS_OK != nProcResult)
+	{
+		return nProcResult;
+	}
+
+	memcpy(oHeader.czMagic, VOLUME_CACHE_MAGIC, sizeof(VOLUME_CACHE_MAGIC));
+	oHeader.unVersion = VOLUME_CACHE_VERSION;
+	oHeader.unLayout = m_nLayout;
+	for (int nAxis = 0; nAxis < NumVolumeAxes; nAxis++)
+	{
+		oHeader.unDims[nAxis] = m_unDims[nAxis];
+		oHeader.fSpacing[nAxis] = m_fSpacing[nAxis];
+	}
+	oHeader.unPixelDepth = m_usPixelDepth;
+	oHeader.unSignedData = m_isSignedData ? 1 : 0;
+	oHeader.fRescaleSlope = m_fRescaleSlope;
+	oHeader.fRescaleIntercept = m_fRescaleIntercept;
+	oHeader.unNumSources = (unsigned int)vecFileNames.size();
+	oHeader.ullNumVoxels = m_unNumVoxels;
+	oHeader.ullDataOffset = VOLUME_CACHE_ALIGN;
+
+	// written aside and renamed, a reader never maps a partial file
+	string strTempFile = strCacheFile + ".tmp";
+	vector<string> vecErrorReplacer(1, strCacheFile);
+
+	ofstream oCacheFile(strTempFile.c_str(), ios::out | ios::binary);
+	if (!oCacheFile.good())
+	{
+		printf("%s\n", CErrorMsg::GetInstance()->GetMsgString(OPEN_FILE_ERR, vecErrorReplacer).c_str());
+		return OPEN_FILE_ERR;
+	}
+
+	vector<char> vecPadding(VOLUME_CACHE_ALIGN - sizeof(oHeader), 0);
+	oCacheFile.write((const char*)&oHeader, sizeof(oHeader));
+	oCacheFile.write(vecPadding.data(), vecPadding.size());
+	oCacheFile.write((const char*)m_pVoxels, m_unNumVoxels * sizeof(unsigned short));
+	oCacheFile.close();
+
+	// the previous file stays in place unless the new one is complete
+	if (oCacheFile.fail() || !RenameFile(strTempFile, strCacheFile))
+	{
+		remove(strTempFile.c_str());
+		printf("%s\n", CErrorMsg::GetInstance()->GetMsgString(WRITE_FILE_ERR, vecErrorReplacer).c_str());
+		return WRITE_FILE_ERR;
+	}
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	copy a row into the volume, fails on a volume mapped from a cache file
+ * @param	unRowIdx
+ * @param	unSliceIdx
+ * @param	pRow: width voxels
+ * @return	error code
+*/
+int CVolume::SetRow(unsigned int unRowIdx, unsigned int unSliceIdx, const unsigned short* pRow)
+{
+	if (nullptr == m_pVoxels || nullptr != m_pCacheFile || unRowIdx >= m_unDims[AxisY] || unSliceIdx >= m_unDims[AxisZ])
+	{
+		return INVALID_PARAMETER;
+	}
+
+	const size_t* pOffsetX = m_vecAxisOffsets[AxisX].data();
+	unsigned short* pDstRow = m_pVoxels + m_vecAxisOffsets[AxisY][unRowIdx] + m_vecAxisOffsets[AxisZ][unSliceIdx];
+
+	unsigned int unRunLen = VolumeBricked == m_nLayout ? VOLUME_BRICK_DIM : m_unDims[AxisX];
+	for (unsigned int unColIdx = 0; unColIdx < m_unDims[AxisX]; unColIdx += unRunLen)
+	{
+		unsigned int unNumCopied = m_unDims[AxisX] - unColIdx < unRunLen ? m_unDims[AxisX] - unColIdx : unRunLen;
+		::memcpy(pDstRow + pOffsetX[unColIdx], pRow + unColIdx, unNumCopied * sizeof(unsigned short));
+	}
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	copy a slice into the volume, fails on a volume mapped from a cache file
+ * @param	unSliceIdx
+ * @param	pSlice: width x height voxels
+ * @return	error code
+*/
+int CVolume::SetSlice(unsigned int unSliceIdx, const unsigned short* pSlice)
+{
+	if (nullptr == m_pVoxels || nullptr != m_pCacheFile || unSliceIdx >= m_unDims[AxisZ])
+	{
+		return INVALID_PARAMETER;
+	}
+
+	for (unsigned int unRowIdx = 0; unRowIdx < m_unDims[AxisY]; unRowIdx++)
+	{
+		SetRow(unRowIdx, unSliceIdx, pSlice);
+		pSlice += m_unDims[AxisX];
+	}
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	set distance between centers of neighbouring voxels
+ * @param	fSpacingX
+ * @param	fSpacingY
+ * @param	fSpacingZ
+*/
+void CVolume::SetSpacing(float fSpacingX, float fSpacingY, float fSpacingZ)
+{
+	m_fSpacing[AxisX] = fSpacingX;
+	m_fSpacing[AxisY] = fSpacingY;
+	m_fSpacing[AxisZ] = fSpacingZ;
+}
+
+/*
+ * @brief	fill offset tables of the three axes for current layout
+*/
+void CVolume::BuildAxisOffsets()
+{
+	size_t unBrickLen = VOLUME_BRICK_DIM * VOLUME_BRICK_DIM * VOLUME_BRICK_DIM;
+	size_t unNumBricksX = (m_unDims[AxisX] + VOLUME_BRICK_DIM - 1) >> VOLUME_BRICK_SHIFT;
+	size_t unNumBricksY = (m_unDims[AxisY] + VOLUME_BRICK_DIM - 1) >> VOLUME_BRICK_SHIFT;
+
+	// strides of one brick and of one voxel inside a brick along each axis
+	size_t unBrickStrides[NumVolumeAxes] = { unBrickLen, unNumBricksX * unBrickLen, unNumBricksX * unNumBricksY * unBrickLen };
+	size_t unInnerStrides[NumVolumeAxes] = { 1, VOLUME_BRICK_DIM, VOLUME_BRICK_DIM * VOLUME_BRICK_DIM };
+	size_t unSliceStrides[NumVolumeAxes] = { 1, m_unDims[AxisX], (size_t)m_unDims[AxisX] * m_unDims[AxisY] };
+
+	for (int nAxis = 0; nAxis < NumVolumeAxes; nAxis++)
+	{
+		m_vecAxisOffsets[nAxis].resize(m_unDims[nAxis] + 1);
+		for (size_t unIdx = 0; unIdx < m_unDims[nAxis]; unIdx++)
+		{
+			if (VolumeBricked == m_nLayout)
+			{
+				m_vecAxisOffsets[nAxis][unIdx] = (unIdx >> VOLUME_BRICK_SHIFT) * unBrickStrides[nAxis] + (unIdx & (VOLUME_BRICK_DIM - 1)) * unInnerStrides[nAxis];
+			}
+			else
+			{
+				m_vecAxisOffsets[nAxis][unIdx] = unIdx * unSliceStrides[nAxis];
+			}
+		}
+		m_vecAxisOffsets[nAxis][m_unDims[nAxis]] = m_vecAxisOffsets[nAxis][m_unDims[nAxis] - 1];
+	}
+}
+
+/*
+ * @brief	number of voxels to store a volume, including padding of bricks
+ * @param	unDims: voxels along x, y and z
+ * @param	nLayout
+ * @return	number of voxels
+*/
+size_t CVolume::GetNumStoredVoxels(const unsigned int unDims[NumVolumeAxes], VolumeLayout nLayout)
+{
+	// bricks on the border are padded to full size
+	size_t unNumVoxels = 1;
+	for (int nAxis = 0; nAxis < NumVolumeAxes; nAxis++)
+	{
+		unNumVoxels *= VolumeBricked == nLayout ? (unDims[nAxis] + VOLUME_BRICK_DIM - 1) & ~(size_t)(VOLUME_BRICK_DIM - 1) : unDims[nAxis];
+	}
+
+	return unNumVoxels;
+}
+
+/*
+ * @brief	CRC-32C of names, sizes and modification times of source files
+ * @param	vecFileNames
+ * @param	unSourceStamp: output stamp
+ * @return	error code
+*/
+int CVolume::GetSourceStamp(const std::vector<std::string>& vecFileNames, unsigned int& unSourceStamp)
+{
+	unSourceStamp = 0;
+	for (size_t unFileIdx = 0; unFileIdx < vecFileNames.size(); unFileIdx++)
+	{
+		unsigned long long ullFileSize = 0;
+		long long llModifyTime = 0;
+		if (!GetFileStamp(vecFileNames[unFileIdx], ullFileSize, llModifyTime))
+		{
+			vector<string> vecErrorReplacer(1, vecFileNames[unFileIdx]);
+			printf("%s\n", CErrorMsg::GetInstance()->GetMsgString(INVALID_FILE_NAME, vecErrorReplacer).c_str());
+			return INVALID_FILE_NAME;
+		}
+
+		// the terminating zero separates names
+		unSourceStamp = UpdateCrc32c(unSourceStamp, vecFileNames[unFileIdx].c_str(), vecFileNames[unFileIdx].size() + 1);
+		unSourceStamp = UpdateCrc32c(unSourceStamp, &ullFileSize, sizeof(ullFileSize));
+		unSourceStamp = UpdateCrc32c(unSourceStamp, &llModifyTime, sizeof(llModifyTime));
+	}
+
+	return STATUS_OK;
+}
@@ -0,0 +1,267 @@
+/***************************************************
+ * @file		Volume.h
+ * @section		Common
+ * @class		CVolume
+ * @brief		16-bit volume stored slice by slice or in cubic bricks
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#ifndef __VOLUME_H__
+#define __VOLUME_H__
+
+#include <string>
+#include <vector>
+
+#include "MacroDeclSpec.h"
+
+class CMappedFile;
+
+// bricks are 8 x 8 x 8 voxels, 1 KiB, neighbours in all three directions share a few cache lines
+#define VOLUME_BRICK_SHIFT	3
+#define VOLUME_BRICK_DIM	(1 << VOLUME_BRICK_SHIFT)
+
+/* enum for memory layout of voxels */
+enum VolumeLayout
+{
+	VolumeSliceMajor = 0,	///< x fastest, then y, then z, as slices are loaded
+	VolumeBricked			///< bricks in slice-major order, voxels slice-major inside a brick
+};
+
+/* enum for axis of volume */
+enum VolumeAxis
+{
+	AxisX = 0,		///< column of slice
+	AxisY,			///< row of slice
+	AxisZ,			///< slice
+	NumVolumeAxes
+};
+
+/*
+ * @class	CVolume
+ * @brief	the offset of voxel (x, y, z) is the sum of three per-axis offsets, whatever the layout
+*/
+class _DLL_EXPORT_ CVolume
+{
+public:
+	/*
+	 * @brief	constructor
+	*/
+	CVolume();
+
+	/*
+	 * @brief	destructor
+	*/
+	~CVolume();
+
+	/*
+	 * @brief	allocate voxels, content is undefined until slices are set
+	 * @param	unWidth: voxels along x
+	 * @param	unHeight: voxels along y
+	 * @param	unDepth: voxels along z
+	 * @param	nLayout: memory layout
+	 * @return	error code
+	*/
+	int Allocate(unsigned int unWidth, unsigned int unHeight, unsigned int unDepth, VolumeLayout nLayout);
+
+	/*
+	 * @brief	offsets of voxels along an axis, entry [dim] repeats entry [dim - 1] so that index + 1 never leaves the volume
+	 * @param	nAxis
+	 * @return	dim + 1 offsets
+	*/
+	const size_t* GetAxisOffsets(VolumeAxis nAxis) const;
+
+	/*
+	 * @brief	voxels, addressed with GetAxisOffsets
+	 * @return	pointer
+	*/
+	const unsigned short* GetData() const;
+
+	/*
+	 * @brief	number of voxels along an axis
+	 * @param	nAxis
+	 * @return	number of voxels
+	*/
+	unsigned int GetDim(VolumeAxis nAxis) const;
+
+	/*
+	 * @brief	memory layout
+	 * @return	layout
+	*/
+	VolumeLayout GetLayout() const;
+
+	/*
+	 * @brief	stored bits of the slices the volume was loaded from, 8-bit slices are widened to 16-bit voxels
+	 * @return	8 or 16
+	*/
+	unsigned short GetPixelDepth() const;
+
+	/*
+	 * @brief	rescale intercept of the slices, voxels already have it applied
+	 * @return	intercept
+	*/
+	float GetRescaleIntercept() const;
+
+	/*
+	 * @brief	rescale slope of the slices, voxels already have it applied
+	 * @return	slope
+	*/
+	float GetRescaleSlope() const;
+
+	/*
+	 * @brief	copy a row out of the volume
+	 * @param	unRowIdx
+	 * @param	unSliceIdx
+	 * @param	pRow: width voxels
+	 * @return	error code
+	*/
+	int GetRow(unsigned int unRowIdx, unsigned int unSliceIdx, unsigned short* pRow) const;
+
+	/*
+	 * @brief	copy a slice out of the volume
+	 * @param	unSliceIdx
+	 * @param	pSlice: width x height voxels
+	 * @return	error code
+	*/
+	int GetSlice(unsigned int unSliceIdx, unsigned short* pSlice) const;
+
+	/*
+	 * @brief	distance between centers of neighbouring voxels
+	 * @param	nAxis
+	 * @return	spacing in mm
+	*/
+	float GetSpacing(VolumeAxis nAxis) const;
+
+	/*
+	 * @brief	value of a voxel, no bounds check
+	 * @param	unX
+	 * @param	unY
+	 * @param	unZ
+	 * @return	value
+	*/
+	unsigned short GetVoxel(unsigned int unX, unsigned int unY, unsigned int unZ) const
+	{
+		return m_pVoxels[m_vecAxisOffsets[AxisX][unX] + m_vecAxisOffsets[AxisY][unY] + m_vecAxisOffsets[AxisZ][unZ]];
+	}
+
+	/*
+	 * @brief	whether the slices are signed, voxels then hold values shifted by 128 for 8-bit or 32768 for 16-bit slices
+	 * @return	true for signed
+	*/
+	bool IsSignedData() const;
+
+	/*
+	 * @brief	map a cache file written by SaveCache, voxels are paged in on first access and read-only
+	 * @param	strCacheFile
+	 * @param	vecFileNames: slices the cache was built from, any change of them invalidates the cache
+	 * @return	error code, CACHE_OUT_OF_DATE if the cache does not match the slices
+	*/
+	int LoadCache(const std::string& strCacheFile, const std::vector<std::string>& vecFileNames);
+
+	/*
+	 * @brief	load a series of dicom slices, spacing comes from pixel spacing and slice spacing or thickness of the first slice
+	 * @param	vecFileNames: slices in order
+	 * @param	nLayout: memory layout
+	 * @param	strCacheFile: cache file mapped instead of loading the slices if up to date, and rewritten otherwise, empty for no cache
+	 * @return	error code
+	*/
+	int LoadSeries(const std::vector<std::string>& vecFileNames, VolumeLayout nLayout, const std::string& strCacheFile = "");
+
+	/*
+	 * @brief	release voxels
+	*/
+	void Release();
+
+	/*
+	 * @brief	write voxels and geometry to a cache file, voxels start on a page boundary so that they can be mapped in place
+	 * @param	strCacheFile
+	 * @param	vecFileNames: slices the volume was built from
+	 * @return	error code
+	*/
+	int SaveCache(const std::string& strCacheFile, const std::vector<std::string>& vecFileNames) const;
+
+	/*
+	 * @brief	copy a row into the volume, fails on a volume mapped from a cache file
+	 * @param	unRowIdx
+	 * @param	unSliceIdx
+	 * @param	pRow: width voxels
+	 * @return	error code
+	*/
+	int SetRow(unsigned int unRowIdx, unsigned int unSliceIdx, const unsigned short* pRow);
+
+	/*
+	 * @brief	copy a slice into the volume, fails on a volume mapped from a cache file
+	 * @param	unSliceIdx
+	 * @param	pSlice: width x height voxels
+	 * @return	error code
+	*/
+	int SetSlice(unsigned int unSliceIdx, const unsigned short* pSlice);
+
+	/*
+	 * @brief	set distance between centers of neighbouring voxels
+	 * @param	fSpacingX
+	 * @param	fSpacingY
+	 * @param	fSpacingZ
+	*/
+	void SetSpacing(float fSpacingX, float fSpacingY, float fSpacingZ);
+
+private:
+	// not copyable, voxels are owned
+	CVolume(const CVolume&);
+	CVolume& operator=(const CVolume&);
+
+	/*
+	 * @brief	fill offset tables of the three axes for current layout
+	*/
+	void BuildAxisOffsets();
+
+	/*
+	 * @brief	number of voxels to store a volume, including padding of bricks
+	 * @param	unDims: voxels along x, y and z
+	 * @param	nLayout
+	 * @return	number of voxels
+	*/
+	static size_t GetNumStoredVoxels(const unsigned int unDims[NumVolumeAxes], VolumeLayout nLayout);
+
+	/*
+	 * @brief	CRC-32C of names, sizes and modification times of source files
+	 * @param	vecFileNames
+	 * @param	unSourceStamp: output stamp
+	 * @return	error code
+	*/
+	static int GetSourceStamp(const std::vector<std::string>& vecFileNames, unsigned int& unSourceStamp);
+
+	unsigned int m_unDims[NumVolumeAxes];
+
+	size_t m_unNumVoxels;	///< including padding of bricks
+
+	float m_fSpacing[NumVolumeAxes];
+
+	// pixel format of the source slices, so that voxels can be mapped back to modality values
+	bool m_isSignedData;
+	unsigned short m_usPixelDepth;
+	float m_fRescaleSlope;
+	float m_fRescaleIntercept;
+
+	unsigned short* m_pVoxels;
+
+	VolumeLayout m_nLayout;
+
+	CMappedFile* m_pCacheFile;	///< voxels point into it when loaded from a cache file
+
+	std::vector<size_t> m_vecAxisOffsets[NumVolumeAxes];
+};
+
+//#ifdef __cplusplus
+//extern "C"
+//{
+//#endif // __cplusplus
+//
+//
+//#ifdef __cplusplus
+//};
+//#endif // __cplusplus
+
+#endif	// __VOLUME_H__
@@ -0,0 +1,357 @@
+/***************************************************
+ * @file		VolumeFilter.cpp
+ * @section		Common
+ * @class		N/A
+ * @brief		isotropic resampling and separable 3D filtering of volumes
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#include <algorithm>
+
+#include <math.h>
+
+#include "ImageFilter.h"
+#include "IntlMsgAliasID.h"
+#include "MacroSimd.h"
+#include "ThreadPool.h"
+#include "VolumeFilter.h"
+
+using namespace std;
+
+// rows of a slice filtered together, the z and y passes of a band stay in L2
+#define VOLUME_FILTER_BAND	32
+
+/*
+ * @brief	pAcc += fWeight * pSrc
+ * @param	pSrc: voxels
+ * @param	unLen
+ * @param	fWeight
+ * @param	pAcc
+*/
+static void AccumulateVoxels(const unsigned short* pSrc, size_t unLen, float fWeight, float* pAcc)
+{
+	size_t unIdx = 0;
+
+#ifdef _SIMD_SSE2_
+	__m128 fWeights = _mm_set1_ps(fWeight);
+	__m128i nZero = _mm_setzero_si128();
+	for (; unIdx + 8 <= unLen; unIdx += 8)
+	{
+		__m128i nValue = _mm_loadu_si128((const __m128i*)(pSrc + unIdx));
+		__m128 fLow = _mm_cvtepi32_ps(_mm_unpacklo_epi16(nValue, nZero));
+		__m128 fHigh = _mm_cvtepi32_ps(_mm_unpackhi_epi16(nValue, nZero));
+		_mm_storeu_ps(pAcc + unIdx, _mm_add_ps(_mm_loadu_ps(pAcc + unIdx), _mm_mul_ps(fLow, fWeights)));
+		_mm_storeu_ps(pAcc + unIdx + 4, _mm_add_ps(_mm_loadu_ps(pAcc + unIdx + 4), _mm_mul_ps(fHigh, fWeights)));
+	}
+#endif	// _SIMD_SSE2_
+
+	for (; unIdx < unLen; unIdx++)
+	{
+		pAcc[unIdx] += fWeight * pSrc[unIdx];
+	}
+}
+
+/*
+ * @brief	pDst[x] = sum of pKernel[k] * pPadded[x + k], pPadded holds radius extra values on both sides
+ * @param	pPadded
+ * @param	unLen
+ * @param	vecKernel
+ * @param	pDst
+*/
+static void ConvolveRow(const float* pPadded, size_t unLen, const std::vector<float>& vecKernel, float* pDst)
+{
+	fill(pDst, pDst + unLen, 0.0f);
+	for (size_t unTapIdx = 0; unTapIdx < vecKernel.size(); unTapIdx++)
+	{
+		AccumulateScaledRow(pPadded + unTapIdx, unLen, vecKernel[unTapIdx], pDst);
+	}
+}
+
+/*
+ * @brief	copy voxels and spacing of a volume
+ * @param	oSrc
+ * @param	oDst: output, allocated with the size and layout of oSrc
+ * @return	error code
+*/
+static int CopyVolume(const CVolume& oSrc, CVolume& oDst)
+{
+	unsigned int unWidth = oSrc.GetDim(AxisX);
+	unsigned int unHeight = oSrc.GetDim(AxisY);
+	unsigned int unDepth = oSrc.GetDim(AxisZ);
+	int nProcResult = oDst.Allocate(unWidth, unHeight, unDepth, oSrc.GetLayout());
+	if (STATUS_OK != nProcResult)
+	{
+		return nProcResult;
+	}
+	oDst.SetSpacing(oSrc.GetSpacing(AxisX), oSrc.GetSpacing(AxisY), oSrc.GetSpacing(AxisZ));
+
+	vector<unsigned short> vecSlice((size_t)unWidth * unHeight);
+	for (unsigned int unSliceIdx = 0; unSliceIdx < unDepth; unSliceIdx++)
+	{
+		oSrc.GetSlice(unSliceIdx, vecSlice.data());
+		oDst.SetSlice(unSliceIdx, vecSlice.data());
+	}
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	normalized gaussian, truncated at 3 sigma
+ * @param	fSigma: voxels
+ * @param	vecKernel: output weights
+*/
+static void GetGaussianKernel(float fSigma, std::vector<float>& vecKernel)
+{
+	// sigma 0 is the identity, exp would give 0 / 0
+	int nRadius = fSigma > 0 ? (int)ceil(3 * fSigma) : 0;
+	if (0 == nRadius)
+	{
+		vecKernel.assign(1, 1.0f);
+		return;
+	}
+	vecKernel.resize(2 * nRadius + 1);
+
+	float fSum = 0;
+	for (int nTap = -nRadius; nTap <= nRadius; nTap++)
+	{
+		vecKernel[nTap + nRadius] = exp(-0.5f * nTap * nTap / (fSigma * fSigma));
+		fSum += vecKernel[nTap + nRadius];
+	}
+
+	for (size_t unTapIdx = 0; unTapIdx < vecKernel.size(); unTapIdx++)
+	{
+		vecKernel[unTapIdx] /= fSum;
+	}
+}
+
+/*
+ * @brief	convolve a volume with one 1D kernel per axis, voxels beyond the border repeat the border
+ * @param	oSrc
+ * @param	vecKernelX: odd number of weights, centered
+ * @param	vecKernelY: odd number of weights, centered
+ * @param	vecKernelZ: odd number of weights, centered
+ * @param	oDst: output, allocated with the size and layout of oSrc, must not be oSrc
+ * @return	error code
+*/
+int FilterVolume(const CVolume& oSrc, const std::vector<float>& vecKernelX, const std::vector<float>& vecKernelY, const std::vector<float>& vecKernelZ, CVolume& oDst)
+{
+	if (nullptr == oSrc.GetData() || &oSrc == &oDst || 0 == vecKernelX.size() % 2 || 0 == vecKernelY.size() % 2 || 0 == vecKernelZ.size() % 2)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	int nWidth = oSrc.GetDim(AxisX);
+	int nHeight = oSrc.GetDim(AxisY);
+	int nDepth = oSrc.GetDim(AxisZ);
+	int nProcResult = oDst.Allocate(nWidth, nHeight, nDepth, oSrc.GetLayout());
+	if (STATUS_OK != nProcResult)
+	{
+		return nProcResult;
+	}
+	oDst.SetSpacing(oSrc.GetSpacing(AxisX), oSrc.GetSpacing(AxisY), oSrc.GetSpacing(AxisZ));
+
+	int nRadiusX = (int)vecKernelX.size() / 2;
+	int nRadiusY = (int)vecKernelY.size() / 2;
+	int nRadiusZ = (int)vecKernelZ.size() / 2;
+	int nNumBands = (nHeight + VOLUME_FILTER_BAND - 1) / VOLUME_FILTER_BAND;
+
+	// each band of a slice runs the three passes at once, z into rows of the band and its margins, then y, then x
+	CThreadPool::GetInstance()->ParallelFor((size_t)nDepth * nNumBands, [&](size_t unBegin, size_t unEnd)
+	{
+		vector<unsigned short> vecVoxels(nWidth);
+		vector<float> vecBand((VOLUME_FILTER_BAND + 2 * nRadiusY) * nWidth);
+		vector<float> vecPadded(nWidth + 2 * nRadiusX);
+		vector<float> vecFiltered(nWidth);
+
+		for (size_t unItemIdx = unBegin; unItemIdx < unEnd; unItemIdx++)
+		{
+			int nSliceIdx = (int)(unItemIdx / nNumBands);
+			int nFirstRow = (int)(unItemIdx % nNumBands) * VOLUME_FILTER_BAND;
+			int nLastRow = nFirstRow + VOLUME_FILTER_BAND < nHeight ? nFirstRow + VOLUME_FILTER_BAND : nHeight;
+
+			int nNumBandRows = nLastRow - nFirstRow + 2 * nRadiusY;
+			fill(vecBand.begin(), vecBand.begin() + nNumBandRows * nWidth, 0.0f);
+			for (int nBandRow = 0; nBandRow < nNumBandRows; nBandRow++)
+			{
+				int nRowIdx = min(max(nFirstRow - nRadiusY + nBandRow, 0), nHeight - 1);
+				for (int nTap = -nRadiusZ; nTap <= nRadiusZ; nTap++)
+				{
+					oSrc.GetRow(nRowIdx, min(max(nSliceIdx + nTap, 0), nDepth - 1), vecVoxels.data());
+					AccumulateVoxels(vecVoxels.data(), nWidth, vecKernelZ[nTap + nRadiusZ], &vecBand[nBandRow * nWidth]);
+				}
+			}
+
+			for (int nRowIdx = nFirstRow; nRowIdx < nLastRow; nRowIdx++)
+			{
+				float* pRow = vecPadded.data() + nRadiusX;
+				fill(pRow, pRow + nWidth, 0.0f);
+				for (int nTap = 0; nTap < (int)vecKernelY.size(); nTap++)
+				{
+					AccumulateScaledRow(&vecBand[(nRowIdx - nFirstRow + nTap) * nWidth], nWidth, vecKernelY[nTap], pRow);
+				}
+
+				fill(vecPadded.begin(), vecPadded.begin() + nRadiusX, pRow[0]);
+				fill(vecPadded.end() - nRadiusX, vecPadded.end(), pRow[nWidth - 1]);
+				ConvolveRow(vecPadded.data(), nWidth, vecKernelX, vecFiltered.data());
+
+				StoreFilterRow(vecFiltered.data(), nWidth, vecVoxels.data());
+				oDst.SetRow(nRowIdx, nSliceIdx, vecVoxels.data());
+			}
+		}
+	});
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	mean of the (2 * radius + 1)^3 voxels around each voxel
+ * @param	oSrc
+ * @param	unRadius: voxels on each side
+ * @param	oDst: output, must not be oSrc
+ * @return	error code
+*/
+int FilterVolumeBox(const CVolume& oSrc, unsigned int unRadius, CVolume& oDst)
+{
+	vector<float> vecKernel(2 * unRadius + 1, 1.0f / (2 * unRadius + 1));
+
+	return FilterVolume(oSrc, vecKernel, vecKernel, vecKernel, oDst);
+}
+
+/*
+ * @brief	gaussian smoothing, the same sigma in mm on all axes whatever the spacing, truncated at 3 sigma
+ * @param	oSrc
+ * @param	fSigma: mm
+ * @param	oDst: output, must not be oSrc
+ * @return	error code
+*/
+int FilterVolumeGaussian(const CVolume& oSrc, float fSigma, CVolume& oDst)
+{
+	if (nullptr == oSrc.GetData() || &oSrc == &oDst || !(fSigma >= 0))
+	{
+		return INVALID_PARAMETER;
+	}
+
+	vector<float> vecKernels[NumVolumeAxes];
+	for (int nAxis = 0; nAxis < NumVolumeAxes; nAxis++)
+	{
+		GetGaussianKernel(fSigma / oSrc.GetSpacing((VolumeAxis)nAxis), vecKernels[nAxis]);
+	}
+
+	// kernels of a single tap on every axis leave the volume unchanged
+	if (1 == vecKernels[AxisX].size() && 1 == vecKernels[AxisY].size() && 1 == vecKernels[AxisZ].size())
+	{
+		return CopyVolume(oSrc, oDst);
+	}
+
+	return FilterVolume(oSrc, vecKernels[AxisX], vecKernels[AxisY], vecKernels[AxisZ], oDst);
+}
+
+/*
+ * @brief	trilinear resampling to cubic voxels, the first voxel keeps its position
+ * @param	oSrc
+ * @param	fVoxelSize: mm, 0 for the finest spacing of oSrc
+ * @param	oDst: output, allocated with the layout of oSrc, must not be oSrc
+ * @return	error code
+*/
+int ResampleIsotropic(const CVolume& oSrc, float fVoxelSize, CVolume& oDst)
+{
+	if (nullptr == oSrc.GetData() || &oSrc == &oDst || fVoxelSize < 0)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	if (0 == fVoxelSize)
+	{
+		fVoxelSize = min(oSrc.GetSpacing(AxisX), min(oSrc.GetSpacing(AxisY), oSrc.GetSpacing(AxisZ)));
+	}
+
+	// the two source voxels and the weight of the second one, for every output voxel along each axis
+	unsigned int unDstDims[NumVolumeAxes];
+	vector<unsigned int> vecFirstIdx[NumVolumeAxes];
+	vector<unsigned int> vecSecondIdx[NumVolumeAxes];
+	vector<float> vecFracs[NumVolumeAxes];
+	for (int nAxis = 0; nAxis < NumVolumeAxes; nAxis++)
+	{
+		unsigned int unSrcDim = oSrc.GetDim((VolumeAxis)nAxis);
+		float fScale = fVoxelSize / oSrc.GetSpacing((VolumeAxis)nAxis);
+		unDstDims[nAxis] = (unsigned int)((unSrcDim - 1) / fScale + 1e-3f) + 1;
+
+		vecFirstIdx[nAxis].resize(unDstDims[nAxis]);
+		vecSecondIdx[nAxis].resize(unDstDims[nAxis]);
+		vecFracs[nAxis].resize(unDstDims[nAxis]);
+		for (unsigned int unIdx = 0; unIdx < unDstDims[nAxis]; unIdx++)
+		{
+			float fPos = min(unIdx * fScale, (float)(unSrcDim - 1));
+			vecFirstIdx[nAxis][unIdx] = (unsigned int)fPos;
+			vecSecondIdx[nAxis][unIdx] = min(vecFirstIdx[nAxis][unIdx] + 1, unSrcDim - 1);
+			vecFracs[nAxis][unIdx] = fPos - vecFirstIdx[nAxis][unIdx];
+		}
+	}
+
+	int nProcResult = oDst.Allocate(unDstDims[AxisX], unDstDims[AxisY], unDstDims[AxisZ], oSrc.GetLayout());
+	if (STATUS_OK != nProcResult)
+	{
+		return nProcResult;
+	}
+	oDst.SetSpacing(fVoxelSize, fVoxelSize, fVoxelSize);
+
+	unsigned int unSrcWidth = oSrc.GetDim(AxisX);
+	CThreadPool::GetInstance()->ParallelFor(unDstDims[AxisZ], [&](size_t unBegin, size_t unEnd)
+	{
+		vector<unsigned short> vecVoxels(max(unSrcWidth, unDstDims[AxisX]));
+		vector<float> vecBlended(unSrcWidth);
+		vector<float> vecResampled(unDstDims[AxisX]);
+
+		// source rows blended along z, consecutive output rows mostly reuse them
+		vector<float> vecSlotRows[2] = { vector<float>(unSrcWidth), vector<float>(unSrcWidth) };
+
+		for (size_t unSliceIdx = unBegin; unSliceIdx < unEnd; unSliceIdx++)
+		{
+			unsigned int unSrcSlices[2] = { vecFirstIdx[AxisZ][unSliceIdx], vecSecondIdx[AxisZ][unSliceIdx] };
+			float fFracZ = vecFracs[AxisZ][unSliceIdx];
+			int nSlotRowIdx[2] = { -1, -1 };
+
+			for (unsigned int unRowIdx = 0; unRowIdx < unDstDims[AxisY]; unRowIdx++)
+			{
+				int nSrcRows[2] = { (int)vecFirstIdx[AxisY][unRowIdx], (int)vecSecondIdx[AxisY][unRowIdx] };
+				const float* pBlendedRows[2];
+				for (int nIdx = 0; nIdx < 2; nIdx++)
+				{
+					int nSlot = nSlotRowIdx[0] == nSrcRows[nIdx] ? 0 : (nSlotRowIdx[1] == nSrcRows[nIdx] ? 1 : -1);
+					if (-1 == nSlot)
+					{
+						// the slot not holding the other row of this output row
+						nSlot = nSlotRowIdx[0] == nSrcRows[1 - nIdx] ? 1 : 0;
+						fill(vecSlotRows[nSlot].begin(), vecSlotRows[nSlot].end(), 0.0f);
+						oSrc.GetRow(nSrcRows[nIdx], unSrcSlices[0], vecVoxels.data());
+						AccumulateVoxels(vecVoxels.data(), unSrcWidth, 1.0f - fFracZ, vecSlotRows[nSlot].data());
+						oSrc.GetRow(nSrcRows[nIdx], unSrcSlices[1], vecVoxels.data());
+						AccumulateVoxels(vecVoxels.data(), unSrcWidth, fFracZ, vecSlotRows[nSlot].data());
+						nSlotRowIdx[nSlot] = nSrcRows[nIdx];
+					}
+					pBlendedRows[nIdx] = vecSlotRows[nSlot].data();
+				}
+
+				float fFracY = vecFracs[AxisY][unRowIdx];
+				fill(vecBlended.begin(), vecBlended.end(), 0.0f);
+				AccumulateScaledRow(pBlendedRows[0], unSrcWidth, 1.0f - fFracY, vecBlended.data());
+				AccumulateScaledRow(pBlendedRows[1], unSrcWidth, fFracY, vecBlended.data());
+
+				for (unsigned int unColIdx = 0; unColIdx < unDstDims[AxisX]; unColIdx++)
+				{
+					float fLeft = vecBlended[vecFirstIdx[AxisX][unColIdx]];
+					float fRight = vecBlended[vecSecondIdx[AxisX][unColIdx]];
+					vecResampled[unColIdx] = fLeft + (fRight - fLeft) * vecFracs[AxisX][unColIdx];
+				}
+
+				StoreFilterRow(vecResampled.data(), unDstDims[AxisX], vecVoxels.data());
+				oDst.SetRow(unRowIdx, (unsigned int)unSliceIdx, vecVoxels.data());
+			}
+		}
+	}, 1);
+
+	return STATUS_OK;
+}
@@ -0,0 +1,68 @@
+/***************************************************
+ * @file		VolumeFilter.h
+ * @section		Common
+ * @class		N/A
+ * @brief		isotropic resampling and separable 3D filtering of volumes
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#ifndef __VOLUME_FILTER_H__
+#define __VOLUME_FILTER_H__
+
+#include <vector>
+
+#include "MacroDeclSpec.h"
+#include "Volume.h"
+
+/*
+ * @brief	convolve a volume with one 1D kernel per axis, voxels beyond the border repeat the border
+ * @param	oSrc
+ * @param	vecKernelX: odd number of weights, centered
+ * @param	vecKernelY: odd number of weights, centered
+ * @param	vecKernelZ: odd number of weights, centered
+ * @param	oDst: output, allocated with the size and layout of oSrc, must not be oSrc
+ * @return	error code
+*/
+_DLL_EXPORT_ int FilterVolume(const CVolume& oSrc, const std::vector<float>& vecKernelX, const std::vector<float>& vecKernelY, const std::vector<float>& vecKernelZ, CVolume& oDst);
+
+/*
+ * @brief	mean of the (2 * radius + 1)^3 voxels around each voxel
+ * @param	oSrc
+ * @param	unRadius: voxels on each side
+ * @param	oDst: output, must not be oSrc
+ * @return	error code
+*/
+_DLL_EXPORT_ int FilterVolumeBox(const CVolume& oSrc, unsigned int unRadius, CVolume& oDst);
+
+/*
+ * @brief	gaussian smoothing, the same sigma in mm on all axes whatever the spacing, truncated at 3 sigma
+ * @param	oSrc
+ * @param	fSigma: mm, at least 0, a sigma too small for any neighbour copies the volume
+ * @param	oDst: output, must not be oSrc
+ * @return	error code
+*/
+_DLL_EXPORT_ int FilterVolumeGaussian(const CVolume& oSrc, float fSigma, CVolume& oDst);
+
+/*
+ * @brief	trilinear resampling to cubic voxels, the first voxel keeps its position
+ * @param	oSrc
+ * @param	fVoxelSize: mm, 0 for the finest spacing of oSrc
+ * @param	oDst: output, allocated with the layout of oSrc, must not be oSrc
+ * @return	error code
+*/
+_DLL_EXPORT_ int ResampleIsotropic(const CVolume& oSrc, float fVoxelSize, CVolume& oDst);
+
+//#ifdef __cplusplus
+//extern "C"
+//{
+//#endif // __cplusplus
+//
+//
+//#ifdef __cplusplus
+//};
+//#endif // __cplusplus
+
+#endif	// __VOLUME_FILTER_H__
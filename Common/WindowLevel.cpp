@@ -0,0 +1,212 @@
+/***************************************************
+ * @file		WindowLevel.cpp
+ * @section		Common
+ * @class		CWindowLevel
+ * @brief		window / level mapping of 16-bit pixels to 8-bit display pixels through a lookup table
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#include <algorithm>
+
+#include <string.h>
+
+#include "IntlMsgAliasID.h"
+#include "MacroSimd.h"
+#include "ThreadPool.h"
+#include "WindowLevel.h"
+
+using namespace std;
+
+/*
+ * @brief	map a run of pixels through the table
+ * @param	pLut: WINDOW_LEVEL_LUT_SIZE display values
+ * @param	pSrc
+ * @param	unBegin: first pixel
+ * @param	unEnd: one past the last pixel
+ * @param	pDst: output
+*/
+static void MapPixels(const unsigned char* pLut, const unsigned short* pSrc, size_t unBegin, size_t unEnd, unsigned char* pDst)
+{
+	// x86 has no byte gather, 4 independent lookups per iteration keep the load ports busy and the 64 KB table stays in L2
+	size_t unIdx = unBegin;
+	for (; unIdx + 4 <= unEnd; unIdx += 4)
+	{
+		unsigned char ucValue0 = pLut[pSrc[unIdx]];
+		unsigned char ucValue1 = pLut[pSrc[unIdx + 1]];
+		unsigned char ucValue2 = pLut[pSrc[unIdx + 2]];
+		unsigned char ucValue3 = pLut[pSrc[unIdx + 3]];
+		pDst[unIdx] = ucValue0;
+		pDst[unIdx + 1] = ucValue1;
+		pDst[unIdx + 2] = ucValue2;
+		pDst[unIdx + 3] = ucValue3;
+	}
+	for (; unIdx < unEnd; unIdx++)
+	{
+		pDst[unIdx] = pLut[pSrc[unIdx]];
+	}
+}
+
+/*
+ * @brief	constructor, full 16-bit range
+*/
+CWindowLevel::CWindowLevel()
+{
+	m_fCenter = 0;
+	m_fWidth = 0;
+	m_unBitDepth = 0;
+	SetWindow(32768.0f, 65536.0f, 16);
+}
+
+/*
+ * @brief	destructor
+*/
+CWindowLevel::~CWindowLevel()
+{
+}
+
+/*
+ * @brief	map pixels to display values
+ * @param	pSrc
+ * @param	unNumPixels
+ * @param	pDst: output, may not overlap pSrc
+ * @param	isParallel: chunks mapped by the thread pool, false to map on the calling thread, e.g. a display thread
+ *			that must not wait behind batch work queued in the pool
+ * @return	error code
+*/
+int CWindowLevel::Apply(const unsigned short* pSrc, size_t unNumPixels, unsigned char* pDst, bool isParallel) const
+{
+	if (nullptr == pSrc || nullptr == pDst)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	const unsigned char* pLut = m_vecLut.data();
+	if (!isParallel)
+	{
+		MapPixels(pLut, pSrc, 0, unNumPixels, pDst);
+		return STATUS_OK;
+	}
+
+	CThreadPool::GetInstance()->ParallelFor((unNumPixels + WINDOW_LEVEL_CHUNK - 1) / WINDOW_LEVEL_CHUNK, [&](size_t unBegin, size_t unEnd)
+	{
+		MapPixels(pLut, pSrc, unBegin * WINDOW_LEVEL_CHUNK, min(unEnd * WINDOW_LEVEL_CHUNK, unNumPixels), pDst);
+	}, 1);
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	window center
+ * @return	center
+*/
+float CWindowLevel::GetCenter() const
+{
+	return m_fCenter;
+}
+
+/*
+ * @brief	window width
+ * @return	width
+*/
+float CWindowLevel::GetWidth() const
+{
+	return m_fWidth;
+}
+
+/*
+ * @brief	set the window, the table is rebuilt only if it changes. values beyond the bit depth map like its largest value
+ * @param	fCenter
+ * @param	fWidth: at least 1
+ * @param	unBitDepth: stored bits of pixels, in [1, 16]
+ * @return	error code
+*/
+int CWindowLevel::SetWindow(float fCenter, float fWidth, unsigned int unBitDepth)
+{
+	if (!(fWidth >= 1) || 0 == unBitDepth || unBitDepth > 16)
+	{
+		return INVALID_PARAMETER;
+	}
+
+	if (fCenter == m_fCenter && fWidth == m_fWidth && unBitDepth == m_unBitDepth && !m_vecLut.empty())
+	{
+		return STATUS_OK;
+	}
+
+	m_fCenter = fCenter;
+	m_fWidth = fWidth;
+	m_unBitDepth = unBitDepth;
+	m_vecLut.resize(WINDOW_LEVEL_LUT_SIZE);
+
+	// linear VOI function of DICOM PS3.3 C.11.2.1.2, 0 below the window, 255 above it
+	double dLower = fCenter - 0.5 - (fWidth - 1) / 2.0;
+	double dUpper = fCenter - 0.5 + (fWidth - 1) / 2.0;
+	double dScale = fWidth > 1 ? 255.0 / (fWidth - 1) : 0;
+	size_t unNumValues = (size_t)1 << unBitDepth;
+	for (size_t unValue = 0; unValue < unNumValues; unValue++)
+	{
+		if (unValue <= dLower)
+		{
+			m_vecLut[unValue] = 0;
+		}
+		else if (unValue > dUpper)
+		{
+			m_vecLut[unValue] = 255;
+		}
+		else
+		{
+			m_vecLut[unValue] = (unsigned char)min(255.0, ((unValue - (fCenter - 0.5)) * dScale + 127.5) + 0.5);
+		}
+	}
+	memset(m_vecLut.data() + unNumValues, m_vecLut[unNumValues - 1], WINDOW_LEVEL_LUT_SIZE - unNumValues);
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	smallest and largest pixel, to window a frame to its full range with center (min + max + 1) / 2 and width max - min + 1
+ * @param	pSrc
+ * @param	unNumPixels: at least 1
+ * @param	usMin: output
+ * @param	usMax: output
+*/
+void GetPixelRange(const unsigned short* pSrc, size_t unNumPixels, unsigned short& usMin, unsigned short& usMax)
+{
+	usMin = 65535;
+	usMax = 0;
+	size_t unIdx = 0;
+
+#ifdef _SIMD_SSE2_
+	// SSE2 compares signed 16-bit only, values are biased by 0x8000
+	if (unNumPixels >= 8)
+	{
+		__m128i nBias = _mm_set1_epi16((short)0x8000);
+		__m128i nMin = _mm_set1_epi16(0x7FFF);
+		__m128i nMax = _mm_set1_epi16((short)0x8000);
+		for (; unIdx + 8 <= unNumPixels; unIdx += 8)
+		{
+			__m128i nValue = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(pSrc + unIdx)), nBias);
+			nMin = _mm_min_epi16(nMin, nValue);
+			nMax = _mm_max_epi16(nMax, nValue);
+		}
+
+		_ALIGN_(16) unsigned short usMins[8];
+		_ALIGN_(16) unsigned short usMaxs[8];
+		_mm_store_si128((__m128i*)usMins, _mm_xor_si128(nMin, nBias));
+		_mm_store_si128((__m128i*)usMaxs, _mm_xor_si128(nMax, nBias));
+		for (size_t unLane = 0; unLane < 8; unLane++)
+		{
+			usMin = min(usMin, usMins[unLane]);
+			usMax = max(usMax, usMaxs[unLane]);
+		}
+	}
+#endif	// _SIMD_SSE2_
+
+	for (; unIdx < unNumPixels; unIdx++)
+	{
+		usMin = min(usMin, pSrc[unIdx]);
+		usMax = max(usMax, pSrc[unIdx]);
+	}
+}
@@ -0,0 +1,106 @@
+/***************************************************
+ * @file		WindowLevel.h
+ * @section		Common
+ * @class		CWindowLevel
+ * @brief		window / level mapping of 16-bit pixels to 8-bit display pixels through a lookup table
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#ifndef __WINDOW_LEVEL_H__
+#define __WINDOW_LEVEL_H__
+
+#include <vector>
+
+#include <stddef.h>
+
+#include "MacroDeclSpec.h"
+
+// entries of the lookup table, one per 16-bit value
+#define WINDOW_LEVEL_LUT_SIZE	65536
+
+// pixels mapped by one task
+#define WINDOW_LEVEL_CHUNK		65536
+
+/*
+ * @class	CWindowLevel
+ * @brief	the linear VOI function of DICOM is evaluated once per window into a table of 8-bit values, mapping a frame is
+ *			then one table lookup per pixel, with no float conversion and no temporary image. dragging the window only
+ *			rebuilds the table
+*/
+class _DLL_EXPORT_ CWindowLevel
+{
+public:
+	/*
+	 * @brief	constructor, full 16-bit range
+	*/
+	CWindowLevel();
+
+	/*
+	 * @brief	destructor
+	*/
+	~CWindowLevel();
+
+	/*
+	 * @brief	map pixels to display values
+	 * @param	pSrc
+	 * @param	unNumPixels
+	 * @param	pDst: output, may not overlap pSrc
+	 * @param	isParallel: chunks mapped by the thread pool, false to map on the calling thread, e.g. a display thread
+	 *			that must not wait behind batch work queued in the pool
+	 * @return	error code
+	*/
+	int Apply(const unsigned short* pSrc, size_t unNumPixels, unsigned char* pDst, bool isParallel = true) const;
+
+	/*
+	 * @brief	window center
+	 * @return	center
+	*/
+	float GetCenter() const;
+
+	/*
+	 * @brief	window width
+	 * @return	width
+	*/
+	float GetWidth() const;
+
+	/*
+	 * @brief	set the window, the table is rebuilt only if it changes. values beyond the bit depth map like its largest value
+	 * @param	fCenter
+	 * @param	fWidth: at least 1
+	 * @param	unBitDepth: stored bits of pixels, in [1, 16]
+	 * @return	error code
+	*/
+	int SetWindow(float fCenter, float fWidth, unsigned int unBitDepth = 16);
+
+private:
+	float m_fCenter;
+	float m_fWidth;
+
+	unsigned int m_unBitDepth;
+
+	std::vector<unsigned char> m_vecLut;	///< WINDOW_LEVEL_LUT_SIZE display values
+};
+
+/*
+ * @brief	smallest and largest pixel, to window a frame to its full range with center (min + max + 1) / 2 and width max - min + 1
+ * @param	pSrc
+ * @param	unNumPixels: at least 1
+ * @param	usMin: output
+ * @param	usMax: output
+*/
+_DLL_EXPORT_ void GetPixelRange(const unsigned short* pSrc, size_t unNumPixels, unsigned short& usMin, unsigned short& usMax);
+
+//#ifdef __cplusplus
+//extern "C"
+//{
+//#endif // __cplusplus
+//
+//
+//#ifdef __cplusplus
+//};
+//#endif // __cplusplus
+
+#endif	// __WINDOW_LEVEL_H__
@@ -0,0 +1,136 @@
+/***************************************************
+ * @file		DicomFuzz.cpp
+ * @section		DicomBench
+ * @class		N/A
+ * @brief		fuzz entry point of the tag walker of CDicomRead
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "DicomFuzz.h"
+#include "DicomRead.h"
+#include "DicomSynth.h"
+#include "IntlMsgAliasID.h"
+
+using namespace std;
+
+/*
+ * @brief	walk the tags of an arbitrary input, must return on any input without crash or hang
+ * @param	pData: content of a file
+ * @param	unDataLen: size of content
+ * @return	error code of CDicomRead
+*/
+int FuzzDicomHeader(const unsigned char* pData, size_t unDataLen)
+{
+	// building the dictionary costs more than walking a header, the reader is kept between inputs
+	static CDicomRead* s_pReader = new CDicomRead();
+
+	DicomInfo oDcmInfo;
+
+	return s_pReader->GetInfoFromMemory((const char*)pData, unDataLen, &oDcmInfo);
+}
+
+/*
+ * @brief	corrupt a file, bit flips, random bytes, extreme lengths, truncation and duplicated chunks
+ * @param	vecFileData: content of file
+ * @param	oRandEngine: random engine
+*/
+void MutateDicom(std::vector<char>& vecFileData, std::mt19937& oRandEngine)
+{
+	static const unsigned int EXTREME_LENGTHS[] = { 0, 1, 13, 0x7FFF, 0xFFFF, 0x7FFFFFFF, 0xFFFFFFFE, 0xFFFFFFFF };
+
+	unsigned int unNumMutations = 1 + oRandEngine() % 8;
+	for (unsigned int unIdx = 0; unIdx < unNumMutations && !vecFileData.empty(); unIdx++)
+	{
+		size_t unPos = oRandEngine() % vecFileData.size();
+
+		switch (oRandEngine() % 5)
+		{
+		case 0:
+			vecFileData[unPos] ^= (char)(1 << (oRandEngine() % 8));
+			break;
+		case 1:
+			vecFileData[unPos] = (char)oRandEngine();
+			break;
+		case 2:
+			// length fields are where tag walkers break
+			if (unPos + 4 <= vecFileData.size())
+			{
+				unsigned int unLen = EXTREME_LENGTHS[oRandEngine() % (sizeof(EXTREME_LENGTHS) / sizeof(EXTREME_LENGTHS[0]))];
+				::memcpy(&vecFileData[unPos], &unLen, 4);
+			}
+			break;
+		case 3:
+			vecFileData.resize(unPos);
+			break;
+		default:
+		{
+			size_t unChunkLen = 1 + oRandEngine() % 64;
+			if (unPos + unChunkLen <= vecFileData.size())
+			{
+				vector<char> vecChunk(vecFileData.begin() + unPos, vecFileData.begin() + unPos + unChunkLen);
+				vecFileData.insert(vecFileData.begin() + unPos, vecChunk.begin(), vecChunk.end());
+			}
+			break;
+		}
+		}
+	}
+}
+
+/*
+ * @brief	mutate synthetic files and feed them to FuzzDicomHeader, iteration i uses seed unSeed + i
+ * @param	unNumIterations
+ * @param	unSeed: first seed, rerun a single iteration with its seed to reproduce it
+*/
+void RunFuzzLoop(unsigned int unNumIterations, unsigned int unSeed)
+{
+	CDicomSynth oSynth;
+	vector<char> vecFileData;
+
+	unsigned int unNumParsed = 0;
+	for (unsigned int unIterIdx = 0; unIterIdx < unNumIterations; unIterIdx++)
+	{
+		unsigned int unIterSeed = unSeed + unIterIdx;
+		mt19937 oRandEngine(unIterSeed);
+
+		// small images, the header is what is fuzzed
+		SynthConfig oConfig;
+		CDicomSynth::GetDefaultConfig(oConfig);
+		oConfig.nSyntax = (SynthSyntax)(oRandEngine() % NumSynthSyntaxes);
+		oConfig.isUndefinedLength = 0 != oRandEngine() % 2;
+		oConfig.usImageHeight = (unsigned short)(1 + oRandEngine() % 32);
+		oConfig.usImageWidth = (unsigned short)(1 + oRandEngine() % 32);
+		oConfig.usPixelDepth = 0 == oRandEngine() % 2 ? 8 : 16;
+		oConfig.unNumExtraTags = oRandEngine() % 64;
+		oConfig.unSequenceDepth = oRandEngine() % 5;
+		oConfig.unSeed = unIterSeed;
+
+		oSynth.Generate(oConfig, vecFileData);
+		MutateDicom(vecFileData, oRandEngine);
+
+		// printed ahead of parsing, the last seed shown identifies an input that crashes or hangs
+		printf("fuzz seed %u, %u bytes\n", unIterSeed, (unsigned int)vecFileData.size());
+		fflush(stdout);
+
+		if (STATUS_OK == FuzzDicomHeader((const unsigned char*)vecFileData.data(), vecFileData.size()))
+		{
+			unNumParsed++;
+		}
+	}
+
+	printf("%u input(s) walked, %u parsed as dicom\n", unNumIterations, unNumParsed);
+}
+
+#ifdef _LIB_FUZZER_
+extern "C" int LLVMFuzzerTestOneInput(const unsigned char* pData, size_t unDataLen)
+{
+	FuzzDicomHeader(pData, unDataLen);
+
+	return 0;
+}
+#endif	// _LIB_FUZZER_
@@ -0,0 +1,45 @@
+/***************************************************
+ * @file		DicomFuzz.h
+ * @section		DicomBench
+ * @class		N/A
+ * @brief		fuzz entry point of the tag walker of CDicomRead
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#ifndef __DICOM_FUZZ_H__
+#define __DICOM_FUZZ_H__
+
+#include <random>
+#include <vector>
+
+/*
+ * @brief	walk the tags of an arbitrary input, must return on any input without crash or hang
+ * @param	pData: content of a file
+ * @param	unDataLen: size of content
+ * @return	error code of CDicomRead
+*/
+int FuzzDicomHeader(const unsigned char* pData, size_t unDataLen);
+
+/*
+ * @brief	corrupt a file, bit flips, random bytes, extreme lengths, truncation and duplicated chunks
+ * @param	vecFileData: content of file
+ * @param	oRandEngine: random engine
+*/
+void MutateDicom(std::vector<char>& vecFileData, std::mt19937& oRandEngine);
+
+/*
+ * @brief	mutate synthetic files and feed them to FuzzDicomHeader, iteration i uses seed unSeed + i
+ * @param	unNumIterations
+ * @param	unSeed: first seed, rerun a single iteration with its seed to reproduce it
+*/
+void RunFuzzLoop(unsigned int unNumIterations, unsigned int unSeed);
+
+// entry point of libFuzzer, build with clang -fsanitize=fuzzer -D_LIB_FUZZER_
+#ifdef _LIB_FUZZER_
+extern "C" int LLVMFuzzerTestOneInput(const unsigned char* pData, size_t unDataLen);
+#endif	// _LIB_FUZZER_
+
+#endif	// __DICOM_FUZZ_H__
@@ -0,0 +1,303 @@
+/***************************************************
+ * @file		MainFunction.cpp
+ * @section		DicomBench
+ * @class		N/A
+ * @brief		generate synthetic dicom files, benchmark and fuzz CDicomRead
+ * @author		bqrmtao@gmail.com
+ * @date		2026/10/19
+ * @version		1.0
+ * @copyright	bqrmtao@gmail.com
+***************************************************/
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "CommonMethod.h"
+#include "DicomAsyncRead.h"
+#include "DicomFuzz.h"
+#include "DicomRead.h"
+#include "DicomSynth.h"
+#include "HiResTimer.h"
+#include "IntlMsgAliasID.h"
+#include "Logger.h"
+#include "ThreadPool.h"
+
+using namespace std;
+namespace sf = std::tr2::sys;
+
+/*
+ * @brief	throughput of a benchmark mode
+*/
+struct BenchResult
+{
+	const char* pModeName;
+	unsigned int unNumFiles;
+	unsigned int unNumFailed;
+	unsigned long long ullNumBytes;	///< header bytes for header-only, file bytes otherwise
+	unsigned long long ullMicroSec;
+};
+
+/*
+ * @brief	print usage
+*/
+static void PrintUsage()
+{
+	printf("usage:\n");
+	printf("\tDicomBench gen <output folder> [count]\n");
+	printf("\t\tsynthetic files sweeping transfer syntax, size, tag count and sequence nesting, 96 by default\n");
+	printf("\tDicomBench bench <input folder | list file | dicom file> [repeat]\n");
+	printf("\t\tMB/s and files/s of header-only, full-decode and batch reading\n");
+	printf("\tDicomBench fuzz [iterations] [seed]\n");
+	printf("\t\twalk tags of mutated synthetic files, 10000 iterations by default\n");
+}
+
+/*
+ * @brief	write a corpus of synthetic files, each parameter cycles with its own period. every value of every parameter
+ *			appears once the count reaches the longest period (8), combinations of parameters are not all covered
+ * @param	strOutputFolder
+ * @param	unNumFiles
+ * @return	error code
+*/
+static int GenerateCorpus(const string& strOutputFolder, unsigned int unNumFiles)
+{
+	static const unsigned short IMAGE_SIZES[] = { 64, 256, 512, 1024, 2048 };
+	static const unsigned int SEQUENCE_DEPTHS[] = { 0, 1, 4 };
+	static const unsigned int EXTRA_TAGS[] = { 0, 4, 16, 64, 256, 1024, 4096 };
+
+	sf::create_directories(sf::path(strOutputFolder));
+
+	CDicomSynth oSynth;
+	for (unsigned int unFileIdx = 0; unFileIdx < unNumFiles; unFileIdx++)
+	{
+		SynthConfig oConfig;
+		CDicomSynth::GetDefaultConfig(oConfig);
+		oConfig.nSyntax = (SynthSyntax)(unFileIdx % NumSynthSyntaxes);
+		oConfig.isUndefinedLength = 0 != (unFileIdx / NumSynthSyntaxes) % 2;
+		oConfig.usImageHeight = IMAGE_SIZES[unFileIdx % 5];
+		oConfig.usImageWidth = IMAGE_SIZES[unFileIdx % 5];
+		oConfig.usPixelDepth = 0 == unFileIdx % 6 ? 8 : 16;
+		oConfig.unSequenceDepth = SEQUENCE_DEPTHS[unFileIdx % 3];
+		oConfig.unNumExtraTags = EXTRA_TAGS[unFileIdx % 7];
+		oConfig.unSeed = unFileIdx;
+
+		string strIdx = to_string((unsigned long long)unFileIdx);
+		string strFileName = "synth_" + string(strIdx.size() < 5 ? 5 - strIdx.size() : 0, '0') + strIdx + "_" + CDicomSynth::GetSyntaxName(oConfig.nSyntax)
+			+ "_" + to_string((unsigned long long)oConfig.usImageWidth) + "x" + to_string((unsigned long long)oConfig.usImageHeight) + ".dcm";
+
+		int nProcResult = oSynth.WriteFile(oConfig, (sf::path(strOutputFolder) / strFileName).string());
+		if (STATUS_OK != nProcResult)
+		{
+			return nProcResult;
+		}
+	}
+
+	printf("%u synthetic file(s) written to %s\n", unNumFiles, strOutputFolder.c_str());
+
+	return STATUS_OK;
+}
+
+/*
+ * @brief	read headers only
+ * @param	vecFileNames
+ * @param	unNumRepeats
+ * @param	oResult
+*/
+static void BenchHeaderOnly(const vector<string>& vecFileNames, unsigned int unNumRepeats, BenchResult& oResult)
+{
+	CDicomRead oReadDicom;
+	DicomInfo oDcmInfo;
+
+	CHiResTimer oTimer(MicroSecond);
+	oTimer.Start();
+
+	for (unsigned int unRepeatIdx = 0; unRepeatIdx < unNumRepeats; unRepeatIdx++)
+	{
+		for (size_t unFileIdx = 0; unFileIdx < vecFileNames.size(); unFileIdx++)
+		{
+			if (STATUS_OK != oReadDicom.GetInfo(vecFileNames[unFileIdx], &oDcmInfo))
+			{
+				oResult.unNumFailed++;
+			}
+			oResult.unNumFiles++;
+			oResult.ullNumBytes += oDcmInfo.unDataOffset;
+		}
+	}
+
+	oResult.ullMicroSec = oTimer.Stop();
+}
+
+/*
+ * @brief	read headers and pixel data, one file after another
+ * @param	vecFileNames
+ * @param	unNumRepeats
+ * @param	unBuffLen: size of image buffer
+ * @param	oResult
+*/
+static void BenchFullDecode(const vector<string>& vecFileNames, unsigned int unNumRepeats, size_t unBuffLen, BenchResult& oResult)
+{
+	CDicomRead oReadDicom;
+	DicomInfo oDcmInfo;
+	vector<char> vecDataBuf(unBuffLen);
+
+	CHiResTimer oTimer(MicroSecond);
+	oTimer.Start();
+
+	for (unsigned int unRepeatIdx = 0; unRepeatIdx < unNumRepeats; unRepeatIdx++)
+	{
+		for (size_t unFileIdx = 0; unFileIdx < vecFileNames.size(); unFileIdx++)
+		{
+			if (STATUS_OK != oReadDicom.GetInfoAndData(vecFileNames[unFileIdx], &oDcmInfo, vecDataBuf.data(), vecDataBuf.size()))
+			{
+				oResult.unNumFailed++;
+			}
+			oResult.unNumFiles++;
+		}
+	}
+
+	oResult.ullMicroSec = oTimer.Stop();
+}
+
+/*
+ * @brief	read headers and pixel data of several files at once on the shared thread pool
+ * @param	vecFileNames
+ * @param	unNumRepeats
+ * @param	unBuffLen: size of each image buffer
+ * @param	oResult
+*/
+static void BenchBatch(const vector<string>& vecFileNames, unsigned int unNumRepeats, size_t unBuffLen, BenchResult& oResult)
+{
+	// two requests in flight per worker keep the pool busy while memory stays bounded
+	size_t unNumSlots = 2 * CThreadPool::GetInstance()->GetNumWorkers();
+	vector<vector<char> > vecDataBufs(unNumSlots, vector<char>(unBuffLen));
+	vector<shared_ptr<CDicomLoadRequest> > vecRequests(unNumSlots);
+
+	CHiResTimer oTimer(MicroSecond);
+	oTimer.Start();
+
+	size_t unNumLoads = vecFileNames.size() * unNumRepeats;
+	for (size_t unLoadIdx = 0; unLoadIdx < unNumLoads + unNumSlots; unLoadIdx++)
+	{
+		size_t unSlotIdx = unLoadIdx % unNumSlots;
+		if (vecRequests[unSlotIdx])
+		{
+			if (STATUS_OK != vecRequests[unSlotIdx]->Wait())
+			{
+				oResult.unNumFailed++;
+			}
+			oResult.unNumFiles++;
+			vecRequests[unSlotIdx].reset();
+		}
+
+		if (unLoadIdx < unNumLoads)
+		{
+			vecRequests[unSlotIdx] = GetInfoAndDataAsync(vecFileNames[unLoadIdx % vecFileNames.size()], vecDataBufs[unSlotIdx].data(), unBuffLen);
+		}
+	}
+
+	oResult.ullMicroSec = oTimer.Stop();
+}
+
+/*
+ * @brief	benchmark header-only, full-decode and batch reading of the same files
+ * @param	vecFileNames
+ * @param	unNumRepeats
+ * @return	error code
+*/
+static int RunBenchmark(const vector<string>& vecFileNames, unsigned int unNumRepeats)
+{
+	if (vecFileNames.empty())
+	{
+		return INVALID_FILE_NAME;
+	}
+
+	// progress printed per file would be timed with the reads
+	CDicomRead::SetVerbose(false);
+
+	// bytes read per pass and largest image, from file sizes and headers
+	CDicomRead oReadDicom;
+	DicomInfo oDcmInfo;
+	unsigned long long ullBytesPerPass = 0;
+	size_t unBuffLen = 0;
+	for (size_t unFileIdx = 0; unFileIdx < vecFileNames.size(); unFileIdx++)
+	{
+		ullBytesPerPass += sf::file_size(sf::path(vecFileNames[unFileIdx]));
+
+		if (STATUS_OK == oReadDicom.GetInfo(vecFileNames[unFileIdx], &oDcmInfo))
+		{
+			size_t unImageBytes = (size_t)oDcmInfo.usImageHeight * oDcmInfo.usImageWidth * oDcmInfo.usSamplesPerPixel * oDcmInfo.usPixelDepth / 8;
+			unBuffLen = unImageBytes > unBuffLen ? unImageBytes : unBuffLen;
+		}
+	}
+
+	BenchResult oResults[3];
+	::memset(oResults, 0, sizeof(oResults));
+	oResults[0].pModeName = "header-only";
+	oResults[1].pModeName = "full-decode";
+	oResults[2].pModeName = "batch";
+
+	BenchHeaderOnly(vecFileNames, unNumRepeats, oResults[0]);
+	BenchFullDecode(vecFileNames, unNumRepeats, unBuffLen, oResults[1]);
+	BenchBatch(vecFileNames, unNumRepeats, unBuffLen, oResults[2]);
+	oResults[1].ullNumBytes = ullBytesPerPass * unNumRepeats;
+	oResults[2].ullNumBytes = ullBytesPerPass * unNumRepeats;
+
+	CDicomRead::SetVerbose(true);
+
+	printf("\n%-12s %8s %8s %10s %10s %10s\n", "mode", "files", "failed", "seconds", "files/s", "MB/s");
+	for (int nModeIdx = 0; nModeIdx < 3; nModeIdx++)
+	{
+		double dSeconds = oResults[nModeIdx].ullMicroSec / 1e6;
+		double dMegaBytes = oResults[nModeIdx].ullNumBytes / (1024.0 * 1024.0);
+		printf("%-12s %8u %8u %10.3f %10.1f %10.1f\n", oResults[nModeIdx].pModeName, oResults[nModeIdx].unNumFiles, oResults[nModeIdx].unNumFailed,
+			dSeconds, dSeconds > 0 ? oResults[nModeIdx].unNumFiles / dSeconds : 0, dSeconds > 0 ? dMegaBytes / dSeconds : 0);
+	}
+
+	return STATUS_OK;
+}
+
+int main(int argc, char** argv)
+{
+	// load property of log4cxx
+	log4cxx::PropertyConfigurator::configure("logcfg.properties");
+
+	__LOG_FUNC_START__;
+
+	if (argc < 2)
+	{
+		PrintUsage();
+		return 0;
+	}
+
+	string strMode = argv[1];
+	int nProcResult = STATUS_OK;
+
+	if ("gen" == strMode && argc >= 3)
+	{
+		nProcResult = GenerateCorpus(argv[2], argc >= 4 ? atoi(argv[3]) : 96);
+	}
+	else if ("bench" == strMode && argc >= 3)
+	{
+		vector<string> vecFileNames;
+		CollectInputFiles(argv[2], vecFileNames);
+
+		unsigned int unNumRepeats = argc >= 4 ? atoi(argv[3]) : 1;
+		nProcResult = RunBenchmark(vecFileNames, unNumRepeats > 0 ? unNumRepeats : 1);
+	}
+	else if ("fuzz" == strMode)
+	{
+		RunFuzzLoop(argc >= 3 ? atoi(argv[2]) : 10000, argc >= 4 ? atoi(argv[3]) : 0);
+	}
+	else
+	{
+		PrintUsage();
+	}
+
+	__LOG_FUNC_END__;
+
+	return STATUS_OK == nProcResult ? 0 : 1;
+}
@@ -16,6 +16,7 @@
 
 #include "DicomRead.h"
 #include "ErrorMsg.h"
+#include "Histogram.h"
 #include "Logger.h"
 #include "ReadConfig.h"
 
@@ -53,39 +54,12 @@ int main(int argc, char** argv)
 		cv::Mat oImgMat(oDcmInfo.usImageHeight, oDcmInfo.usImageWidth, CV_16U);
 		memcpy(oImgMat.data, czImgData, oDcmInfo.usImageHeight * oDcmInfo.usImageWidth * oDcmInfo.usPixelDepth / 8);
 
-		int nNumHistSize = 65536;
-		int nChannels = 0;
-		float czHistRange[2] = {0, 65535};
-		const float* pRanges[1] = {czHistRange};
-
-		cv::MatND oHistMat;
-
-		// calculate histogram
-		cv::calcHist(&oImgMat,1, &nChannels, cv::Mat(), oHistMat, 1, &nNumHistSize, pRanges);
-
-		int nMinPixelVal = 0;
-		int nMaxPixelVal = 65535;
-		int nTotalPixels = oImgMat.rows * oImgMat.cols;
-
-		// find minimum pixel value
-		for (int nIdx = 0; nIdx < nNumHistSize; nIdx++)
-		{
-			if (oHistMat.at<float>(nIdx) > 0)
-			{
-				nMinPixelVal = nIdx;
-				break;
-			}
-		}
-
-		// find maximum pixel value
-		for (int nIdx = nNumHistSize - 1; nIdx >= 0; nIdx--)
-		{
-			if (oHistMat.at<float>(nIdx) > 0)
-			{
-				nMaxPixelVal = nIdx;
-				break;
-			}
-		}
+		// calculate histogram, extremes are found by binary search of its cumulative table
+		CHistogram oHistogram;
+		oHistogram.Compute((const unsigned short*)oImgMat.data, (size_t)oImgMat.rows * oImgMat.cols);
+
+		int nMinPixelVal = oHistogram.GetMin();
+		int nMaxPixelVal = oHistogram.GetMax();
 
 		// map pixel values to 0-65535
 		cv::Mat oShownMat;